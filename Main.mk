@@ -7,6 +7,10 @@ GENERIC_CXXFLAGS+=-I$(NNFORGE_PATH)
 LDLIBSDEPEND+=-lnnforge_plain -lnnforge
 VPATH+=$(NNFORGE_PATH)/lib
 LDFLAGS+=-L$(NNFORGE_PATH)/lib
+# shm_open used by shared_memory_allreducer in nnforge lives in librt on Linux with glibc older than 2.17
+ifeq ($(shell uname -s),Linux)
+LDFLAGS+=$(RT_LIBS)
+endif
 endif
 
 ifeq ($(USE_BOOST),yes)
@@ -23,6 +23,7 @@ OPENCV_LIBS?=-lopencv_highgui -lopencv_imgproc -lopencv_core
 CUDA_LIBS?=-lcudnn -lcurand -lcusparse -lcublas -lcudart
 NETCDF_LIBS?=-lnetcdf
 MATIO_LIBS?=-lmatio
+RT_LIBS?=-lrt
 
 CPP_HW_ARCHITECTURE?=-march=native # set this to -march=corei7 if you see AVX related errors
 CPP_FLAGS_COMMON?=-ffast-math $(CPP_HW_ARCHITECTURE) -mfpmath=sse -msse2 # -mavx
@@ -0,0 +1,452 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "kernel_checker.h"
+
+#include <nnforge/neuron_value_set_data_bunch_reader.h>
+#include <nnforge/neuron_value_set_data_bunch_writer.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <numeric>
+#include <boost/format.hpp>
+
+const float kernel_checker::gradient_check_base_step = 1.0e-2F;
+const int kernel_checker::gradient_check_direction_count = 4;
+const float kernel_checker::training_step_learning_rate = 1.0e+6F;
+
+kernel_checker::kernel_checker(nnforge::factory_generator::ptr factory)
+	: forward_prop_factory(factory->create_forward_propagation_factory())
+	, backward_prop_factory(factory->create_backward_propagation_factory())
+	, debug(new nnforge::debug_state(false, boost::filesystem::path()))
+	, profile(new nnforge::profile_state(false, boost::filesystem::path()))
+	, check_count(0)
+	, failed_check_count(0)
+{
+}
+
+kernel_checker::output_map kernel_checker::run_forward(
+	const nnforge::network_schema& schema,
+	const nnforge::network_data& data,
+	const input_map& inputs,
+	const std::vector<std::string>& output_layer_names) const
+{
+	return run_forward_sequence(schema, data, std::vector<input_map>(1, inputs), output_layer_names, false).front();
+}
+
+std::vector<kernel_checker::output_map> kernel_checker::run_forward_sequence(
+	const nnforge::network_schema& schema,
+	const nnforge::network_data& data,
+	const std::vector<input_map>& inputs_list,
+	const std::vector<std::string>& output_layer_names,
+	bool shape_bucketing) const
+{
+	nnforge::forward_propagation::ptr forward_prop = forward_prop_factory->create(schema, output_layer_names, debug, profile);
+	forward_prop->set_data(data);
+	forward_prop->set_shape_bucketing(shape_bucketing);
+
+	std::vector<output_map> res;
+	for(std::vector<input_map>::const_iterator it = inputs_list.begin(); it != inputs_list.end(); ++it)
+	{
+		nnforge::neuron_value_set_data_bunch_reader reader(*it);
+		nnforge::neuron_value_set_data_bunch_writer writer;
+		forward_prop->run(reader, writer);
+
+		output_map& outputs = *res.insert(res.end(), output_map());
+		for(std::map<std::string, std::pair<nnforge::layer_configuration_specific, nnforge::neuron_value_set::ptr> >::const_iterator it2 = writer.layer_name_to_config_and_value_set_map.begin(); it2 != writer.layer_name_to_config_and_value_set_map.end(); ++it2)
+		{
+			std::vector<float>& values = outputs.insert(std::make_pair(it2->first, std::vector<float>())).first->second;
+			const std::vector<std::shared_ptr<std::vector<float> > >& neuron_value_list = it2->second.second->neuron_value_list;
+			for(std::vector<std::shared_ptr<std::vector<float> > >::const_iterator it3 = neuron_value_list.begin(); it3 != neuron_value_list.end(); ++it3)
+				values.insert(values.end(), (*it3)->begin(), (*it3)->end());
+		}
+	}
+
+	return res;
+}
+
+kernel_checker::gradient_map kernel_checker::run_backward(
+	const nnforge::network_schema& schema,
+	const nnforge::network_data& data,
+	const input_map& inputs,
+	const std::vector<std::string>& error_source_layer_names,
+	double& error) const
+{
+	nnforge::network_data::ptr updated_data = run_training_step(schema, data, inputs, error_source_layer_names, nnforge::shared_memory_allreducer::ptr(), error);
+	return get_gradients(data, *updated_data);
+}
+
+nnforge::network_data::ptr kernel_checker::run_training_step(
+	const nnforge::network_schema& schema,
+	const nnforge::network_data& data,
+	const input_map& inputs,
+	const std::vector<std::string>& error_source_layer_names,
+	nnforge::shared_memory_allreducer::ptr allreducer,
+	double& error) const
+{
+	return run_training_step(
+		schema,
+		data,
+		nnforge::network_data::ptr(),
+		nnforge::network_data::ptr(),
+		inputs,
+		error_source_layer_names,
+		training_step_learning_rate,
+		0.0F,
+		nnforge::training_momentum(nnforge::training_momentum::no_momentum),
+		allreducer,
+		error);
+}
+
+nnforge::network_data::ptr kernel_checker::run_training_step(
+	const nnforge::network_schema& schema,
+	const nnforge::network_data& data,
+	nnforge::network_data::ptr momentum_data,
+	nnforge::network_data::ptr momentum_data2,
+	const input_map& inputs,
+	const std::vector<std::string>& error_source_layer_names,
+	float learning_rate,
+	float weight_decay,
+	nnforge::training_momentum momentum,
+	nnforge::shared_memory_allreducer::ptr allreducer,
+	double& error) const
+{
+	nnforge::backward_propagation::ptr backward_prop = backward_prop_factory->create(
+		schema,
+		error_source_layer_names,
+		error_source_layer_names,
+		std::vector<std::string>(),
+		debug,
+		profile);
+	backward_prop->set_gradient_allreducer(allreducer);
+
+	nnforge::network_data::ptr updated_data = get_data_copy(schema, data);
+	std::map<std::string, std::vector<float> > learning_rates;
+	std::vector<std::string> data_layer_names = updated_data->data_list.get_data_layer_name_list();
+	for(std::vector<std::string>::const_iterator it = data_layer_names.begin(); it != data_layer_names.end(); ++it)
+		learning_rates.insert(std::make_pair(*it, std::vector<float>(updated_data->data_list.get(*it)->size(), learning_rate)));
+
+	unsigned int entry_count = inputs.begin()->second.second->neuron_value_list.size();
+	nnforge::neuron_value_set_data_bunch_reader reader(inputs);
+	nnforge::neuron_value_set_data_bunch_writer writer;
+	backward_prop->run(
+		reader,
+		writer,
+		*updated_data,
+		momentum_data,
+		momentum_data2,
+		learning_rates,
+		entry_count,
+		weight_decay,
+		momentum,
+		0);
+
+	error = 0.0;
+	for(std::vector<std::string>::const_iterator it = error_source_layer_names.begin(); it != error_source_layer_names.end(); ++it)
+	{
+		std::shared_ptr<std::vector<double> > averages = writer.layer_name_to_config_and_value_set_map.find(*it)->second.second->get_average();
+		error += std::accumulate(averages->begin(), averages->end(), 0.0);
+	}
+
+	return updated_data;
+}
+
+kernel_checker::gradient_map kernel_checker::get_gradients(
+	const nnforge::network_data& data,
+	const nnforge::network_data& updated_data)
+{
+	gradient_map res;
+	std::vector<std::string> data_layer_names = data.data_list.get_data_layer_name_list();
+	for(std::vector<std::string>::const_iterator it = data_layer_names.begin(); it != data_layer_names.end(); ++it)
+	{
+		nnforge::layer_data::const_ptr original_weights = data.data_list.get(*it);
+		nnforge::layer_data::const_ptr updated_weights = updated_data.data_list.get(*it);
+		std::vector<std::vector<float> >& gradients = res.insert(std::make_pair(*it, std::vector<std::vector<float> >(original_weights->size()))).first->second;
+		for(unsigned int weight_set = 0; weight_set < static_cast<unsigned int>(original_weights->size()); ++weight_set)
+		{
+			const nnforge::layer_data_part& original_weight_list = original_weights->at(weight_set);
+			const nnforge::layer_data_part& updated_weight_list = updated_weights->at(weight_set);
+			std::vector<float>& gradient = gradients[weight_set];
+			gradient.resize(original_weight_list.size());
+			for(unsigned int weight_id = 0; weight_id < static_cast<unsigned int>(gradient.size()); ++weight_id)
+				gradient[weight_id] = -(updated_weight_list[weight_id] - original_weight_list[weight_id]) / training_step_learning_rate;
+		}
+	}
+
+	return res;
+}
+
+void kernel_checker::check_equivalence(
+	const std::string& check_name,
+	const nnforge::network_schema& schema,
+	const nnforge::network_data& data,
+	const input_map& inputs,
+	const nnforge::network_schema& reference_schema,
+	const nnforge::network_data& reference_data,
+	const input_map& reference_inputs,
+	const std::vector<std::string>& output_layer_names,
+	const std::vector<std::string>& error_source_layer_names,
+	float tolerance)
+{
+	output_map outputs = run_forward(schema, data, inputs, output_layer_names);
+	output_map reference_outputs = run_forward(reference_schema, reference_data, reference_inputs, output_layer_names);
+	for(std::vector<std::string>::const_iterator it = output_layer_names.begin(); it != output_layer_names.end(); ++it)
+		check_values(check_name + " forward " + *it, outputs[*it], reference_outputs[*it], tolerance);
+
+	if (error_source_layer_names.empty())
+		return;
+
+	double error;
+	double reference_error;
+	gradient_map gradients = run_backward(schema, data, inputs, error_source_layer_names, error);
+	gradient_map reference_gradients = run_backward(reference_schema, reference_data, reference_inputs, error_source_layer_names, reference_error);
+	check_gradients(check_name + " backward", gradients, reference_gradients, tolerance);
+}
+
+void kernel_checker::check_outputs(
+	const std::string& check_name,
+	const nnforge::network_schema& schema,
+	const nnforge::network_data& data,
+	const input_map& inputs,
+	const output_map& expected_outputs,
+	float tolerance)
+{
+	std::vector<std::string> output_layer_names;
+	for(output_map::const_iterator it = expected_outputs.begin(); it != expected_outputs.end(); ++it)
+		output_layer_names.push_back(it->first);
+
+	output_map outputs = run_forward(schema, data, inputs, output_layer_names);
+	for(output_map::const_iterator it = expected_outputs.begin(); it != expected_outputs.end(); ++it)
+		check_values(check_name + " forward " + it->first, outputs[it->first], it->second, tolerance);
+}
+
+void kernel_checker::check_gradient(
+	const std::string& check_name,
+	const nnforge::network_schema& schema,
+	const nnforge::network_data& data,
+	const input_map& inputs,
+	const std::vector<std::string>& error_source_layer_names,
+	float tolerance)
+{
+	double original_error;
+	gradient_map gradients = run_backward(schema, data, inputs, error_source_layer_names, original_error);
+
+	nnforge::network_data::ptr perturbed_data = get_data_copy(schema, data);
+	nnforge::random_generator direction_gen = nnforge::rnd::get_random_generator(637463);
+	std::normal_distribution<float> direction_dist(0.0F, 1.0F);
+	for(gradient_map::const_iterator it = gradients.begin(); it != gradients.end(); ++it)
+	{
+		nnforge::layer_data::ptr weights = perturbed_data->data_list.get(it->first);
+		for(unsigned int weight_set = 0; weight_set < static_cast<unsigned int>(it->second.size()); ++weight_set)
+		{
+			const std::vector<float>& gradient = it->second[weight_set];
+			if (gradient.empty())
+				continue;
+			nnforge::layer_data_part& weight_list = weights->at(weight_set);
+			const std::vector<float> original_weights(weight_list.begin(), weight_list.end());
+
+			std::vector<float> direction(gradient.size());
+			float max_relative_diff = 0.0F;
+			std::string max_relative_diff_details;
+			for(int direction_id = 0; direction_id < gradient_check_direction_count; ++direction_id)
+			{
+				double direction_norm_squared = 0.0;
+				for(std::vector<float>::iterator it2 = direction.begin(); it2 != direction.end(); ++it2)
+				{
+					*it2 = direction_dist(direction_gen);
+					direction_norm_squared += static_cast<double>(*it2) * static_cast<double>(*it2);
+				}
+				float direction_mult = static_cast<float>(1.0 / sqrt(direction_norm_squared));
+				double gradient_backprop = 0.0;
+				for(unsigned int weight_id = 0; weight_id < static_cast<unsigned int>(direction.size()); ++weight_id)
+				{
+					direction[weight_id] *= direction_mult;
+					gradient_backprop += static_cast<double>(gradient[weight_id]) * static_cast<double>(direction[weight_id]);
+				}
+
+				double errors[2];
+				for(int sign_id = 0; sign_id < 2; ++sign_id)
+				{
+					float step = (sign_id == 0) ? -gradient_check_base_step : gradient_check_base_step;
+					for(unsigned int weight_id = 0; weight_id < static_cast<unsigned int>(weight_list.size()); ++weight_id)
+						weight_list[weight_id] = original_weights[weight_id] + step * direction[weight_id];
+					run_backward(schema, *perturbed_data, inputs, error_source_layer_names, errors[sign_id]);
+				}
+				std::copy(original_weights.begin(), original_weights.end(), weight_list.begin());
+
+				double gradient_checked = (errors[1] - errors[0]) / (2.0 * static_cast<double>(gradient_check_base_step));
+				double base = std::max(std::max(fabs(gradient_checked), fabs(gradient_backprop)), 1.0e-3 * std::max(fabs(original_error), 1.0));
+				float relative_diff = static_cast<float>(fabs(gradient_checked - gradient_backprop) / base);
+				// NaN is kept as the maximum so that it fails the check
+				if ((relative_diff >= max_relative_diff) || (relative_diff != relative_diff))
+				{
+					max_relative_diff = relative_diff;
+					max_relative_diff_details = (boost::format("backprop %1%, finite differences %2%") % gradient_backprop % gradient_checked).str();
+				}
+			}
+
+			report(
+				(boost::format("%1% gradient %2%:%3%") % check_name % it->first % weight_set).str(),
+				max_relative_diff <= tolerance,
+				(boost::format("relative diff %1% (%2%)") % max_relative_diff % max_relative_diff_details).str());
+		}
+	}
+}
+
+void kernel_checker::check_gradients(
+	const std::string& check_name,
+	const gradient_map& gradients,
+	const gradient_map& reference_gradients,
+	float tolerance)
+{
+	float max_abs_gradient = 0.0F;
+	for(gradient_map::const_iterator it = reference_gradients.begin(); it != reference_gradients.end(); ++it)
+	{
+		gradient_map::const_iterator gradient_it = gradients.find(it->first);
+		if (gradient_it == gradients.end())
+			continue;
+
+		for(unsigned int weight_set = 0; weight_set < static_cast<unsigned int>(it->second.size()); ++weight_set)
+		{
+			const std::vector<float>& reference_gradient = it->second[weight_set];
+			for(std::vector<float>::const_iterator it2 = reference_gradient.begin(); it2 != reference_gradient.end(); ++it2)
+				max_abs_gradient = std::max(max_abs_gradient, fabsf(*it2));
+			check_values(
+				(boost::format("%1% gradient %2%:%3%") % check_name % it->first % weight_set).str(),
+				gradient_it->second.at(weight_set),
+				reference_gradient,
+				tolerance);
+		}
+	}
+
+	// Gradients which are zero everywhere would match each other trivially
+	report(check_name + " gradient is not zero", max_abs_gradient > 0.0F, (boost::format("max abs gradient %1%") % max_abs_gradient).str());
+}
+
+void kernel_checker::check_values(
+	const std::string& check_name,
+	const std::vector<float>& values,
+	const std::vector<float>& reference_values,
+	float tolerance)
+{
+	if (reference_values.empty() || (values.size() != reference_values.size()))
+	{
+		report(check_name, false, (boost::format("%1% values while %2% expected") % values.size() % reference_values.size()).str());
+		return;
+	}
+
+	float max_abs_reference_value = 0.0F;
+	float max_abs_diff = 0.0F;
+	unsigned int nan_count = 0;
+	for(unsigned int i = 0; i < static_cast<unsigned int>(values.size()); ++i)
+	{
+		// NaN in either values or reference fails the check, it would be lost by comparisons otherwise
+		if (is_nan(values[i]) || is_nan(reference_values[i]))
+		{
+			++nan_count;
+			continue;
+		}
+		max_abs_reference_value = std::max(max_abs_reference_value, fabsf(reference_values[i]));
+		max_abs_diff = std::max(max_abs_diff, fabsf(values[i] - reference_values[i]));
+	}
+
+	float relative_diff = max_abs_diff / std::max(max_abs_reference_value, 1.0e-20F);
+	report(
+		check_name,
+		(nan_count == 0) && ((max_abs_diff == 0.0F) || (relative_diff <= tolerance)),
+		(boost::format("max abs diff %1% (%2% relative to max abs value %3%) in %4% values, %5% NaN") % max_abs_diff % relative_diff % max_abs_reference_value % values.size() % nan_count).str());
+}
+
+unsigned int kernel_checker::get_failed_check_count() const
+{
+	return failed_check_count;
+}
+
+unsigned int kernel_checker::get_check_count() const
+{
+	return check_count;
+}
+
+bool kernel_checker::is_nan(float val)
+{
+	unsigned int bits;
+	std::memcpy(&bits, &val, sizeof(bits));
+	return ((bits & 0x7FFFFFFFU) > 0x7F800000U);
+}
+
+nnforge::neuron_value_set::ptr kernel_checker::get_random_values(
+	unsigned int neuron_count,
+	unsigned int entry_count,
+	float min_value,
+	float max_value,
+	nnforge::random_generator& gen)
+{
+	nnforge::neuron_value_set::ptr res(new nnforge::neuron_value_set(neuron_count, entry_count));
+	std::uniform_real_distribution<float> dist(min_value, max_value);
+	for(std::vector<std::shared_ptr<std::vector<float> > >::iterator it = res->neuron_value_list.begin(); it != res->neuron_value_list.end(); ++it)
+		for(std::vector<float>::iterator it2 = (*it)->begin(); it2 != (*it)->end(); ++it2)
+			*it2 = dist(gen);
+
+	return res;
+}
+
+nnforge::network_data::ptr kernel_checker::get_random_data(
+	const nnforge::network_schema& schema,
+	nnforge::random_generator& gen)
+{
+	nnforge::network_data::ptr res(new nnforge::network_data(schema.get_layers()));
+	res->randomize(schema.get_layers(), gen);
+	res->data_list.random_fill(-0.5F, 0.5F, gen);
+
+	return res;
+}
+
+nnforge::network_data::ptr kernel_checker::get_data_copy(
+	const nnforge::network_schema& schema,
+	const nnforge::network_data& other)
+{
+	std::vector<nnforge::layer::const_ptr> layer_list = schema.get_layers();
+	nnforge::network_data::ptr res(new nnforge::network_data(layer_list));
+	for(std::vector<nnforge::layer::const_ptr>::const_iterator it = layer_list.begin(); it != layer_list.end(); ++it)
+	{
+		const std::string& layer_name = (*it)->instance_name;
+		nnforge::layer_data::ptr dt = res->data_list.find(layer_name);
+		nnforge::layer_data::ptr other_dt = other.data_list.find(layer_name);
+		if (dt && other_dt)
+			*dt = *other_dt;
+		nnforge::layer_data_custom::ptr dt_custom = res->data_custom_list.find(layer_name);
+		nnforge::layer_data_custom::ptr other_dt_custom = other.data_custom_list.find(layer_name);
+		if (dt_custom && other_dt_custom)
+			*dt_custom = *other_dt_custom;
+	}
+	res->check_network_data_consistency(layer_list);
+
+	return res;
+}
+
+void kernel_checker::report(
+	const std::string& check_name,
+	bool success,
+	const std::string& details)
+{
+	++check_count;
+	if (!success)
+		++failed_check_count;
+
+	std::cout << (success ? "OK     " : "FAILED ") << check_name << ": " << details << std::endl;
+}
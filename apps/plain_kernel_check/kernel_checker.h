@@ -0,0 +1,186 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <nnforge/factory_generator.h>
+#include <nnforge/network_schema.h>
+#include <nnforge/network_data.h>
+#include <nnforge/neuron_value_set.h>
+#include <nnforge/debug_state.h>
+#include <nnforge/profile_state.h>
+#include <nnforge/rnd.h>
+#include <nnforge/shared_memory_allreducer.h>
+#include <nnforge/training_momentum.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+// Runs networks with plain backend and compares the results against reference values.
+// The reference is either another network computing the same function through generic code,
+// or values computed by the caller, or finite differences for gradients
+class kernel_checker
+{
+public:
+	typedef std::map<std::string, std::pair<nnforge::layer_configuration_specific, nnforge::neuron_value_set::ptr> > input_map;
+
+	// Layer name to values of all the entries, or to gradients of all the weight sets
+	typedef std::map<std::string, std::vector<float> > output_map;
+	typedef std::map<std::string, std::vector<std::vector<float> > > gradient_map;
+
+	kernel_checker(nnforge::factory_generator::ptr factory);
+
+	~kernel_checker() = default;
+
+	output_map run_forward(
+		const nnforge::network_schema& schema,
+		const nnforge::network_data& data,
+		const input_map& inputs,
+		const std::vector<std::string>& output_layer_names) const;
+
+	// Inputs are run one after another through the same forward prop, which keeps plans for the input shapes it has seen
+	std::vector<output_map> run_forward_sequence(
+		const nnforge::network_schema& schema,
+		const nnforge::network_data& data,
+		const std::vector<input_map>& inputs_list,
+		const std::vector<std::string>& output_layer_names,
+		bool shape_bucketing) const;
+
+	// Gradients are obtained from a single training step with huge learning rate, data is left intact
+	gradient_map run_backward(
+		const nnforge::network_schema& schema,
+		const nnforge::network_data& data,
+		const input_map& inputs,
+		const std::vector<std::string>& error_source_layer_names,
+		double& error) const;
+
+	// Single training step as in run_backward, gradients are summed across data-parallel workers through allreducer unless it is empty.
+	// Weights after the step are returned
+	nnforge::network_data::ptr run_training_step(
+		const nnforge::network_schema& schema,
+		const nnforge::network_data& data,
+		const input_map& inputs,
+		const std::vector<std::string>& error_source_layer_names,
+		nnforge::shared_memory_allreducer::ptr allreducer,
+		double& error) const;
+
+	// Single training step with momentum as set by the caller, momentum data is updated in place. Weights after the step are returned
+	nnforge::network_data::ptr run_training_step(
+		const nnforge::network_schema& schema,
+		const nnforge::network_data& data,
+		nnforge::network_data::ptr momentum_data,
+		nnforge::network_data::ptr momentum_data2,
+		const input_map& inputs,
+		const std::vector<std::string>& error_source_layer_names,
+		float learning_rate,
+		float weight_decay,
+		nnforge::training_momentum momentum,
+		nnforge::shared_memory_allreducer::ptr allreducer,
+		double& error) const;
+
+	// Gradients of the training step which has turned data into updated_data
+	static gradient_map get_gradients(
+		const nnforge::network_data& data,
+		const nnforge::network_data& updated_data);
+
+	// Both forward outputs and gradients of the layers present in both networks should match,
+	// gradients should not be all zero
+	void check_equivalence(
+		const std::string& check_name,
+		const nnforge::network_schema& schema,
+		const nnforge::network_data& data,
+		const input_map& inputs,
+		const nnforge::network_schema& reference_schema,
+		const nnforge::network_data& reference_data,
+		const input_map& reference_inputs,
+		const std::vector<std::string>& output_layer_names,
+		const std::vector<std::string>& error_source_layer_names,
+		float tolerance);
+
+	void check_outputs(
+		const std::string& check_name,
+		const nnforge::network_schema& schema,
+		const nnforge::network_data& data,
+		const input_map& inputs,
+		const output_map& expected_outputs,
+		float tolerance);
+
+	// Backprop gradient of each weight set is compared with finite differences along random directions
+	void check_gradient(
+		const std::string& check_name,
+		const nnforge::network_schema& schema,
+		const nnforge::network_data& data,
+		const input_map& inputs,
+		const std::vector<std::string>& error_source_layer_names,
+		float tolerance);
+
+	void check_gradients(
+		const std::string& check_name,
+		const gradient_map& gradients,
+		const gradient_map& reference_gradients,
+		float tolerance);
+
+	// Difference is measured relative to the largest absolute reference value
+	void check_values(
+		const std::string& check_name,
+		const std::vector<float>& values,
+		const std::vector<float>& reference_values,
+		float tolerance);
+
+	unsigned int get_failed_check_count() const;
+
+	unsigned int get_check_count() const;
+
+	// Records the result of the check done by the caller
+	void report(
+		const std::string& check_name,
+		bool success,
+		const std::string& details);
+
+	// Bitwise test, the application is built with -ffast-math which folds away NaN != NaN
+	static bool is_nan(float val);
+
+	static nnforge::neuron_value_set::ptr get_random_values(
+		unsigned int neuron_count,
+		unsigned int entry_count,
+		float min_value,
+		float max_value,
+		nnforge::random_generator& gen);
+
+	// Layer data is randomized with the layers themselves, weights are then refilled uniformly so that biases are not zero
+	static nnforge::network_data::ptr get_random_data(
+		const nnforge::network_schema& schema,
+		nnforge::random_generator& gen);
+
+	// Deep copy of the data of the layers from other which are present in the schema
+	static nnforge::network_data::ptr get_data_copy(
+		const nnforge::network_schema& schema,
+		const nnforge::network_data& other);
+
+private:
+	nnforge::forward_propagation_factory::ptr forward_prop_factory;
+	nnforge::backward_propagation_factory::ptr backward_prop_factory;
+	nnforge::debug_state::ptr debug;
+	nnforge::profile_state::ptr profile;
+
+	unsigned int check_count;
+	unsigned int failed_check_count;
+
+	static const float gradient_check_base_step;
+	static const int gradient_check_direction_count;
+	static const float training_step_learning_rate;
+};
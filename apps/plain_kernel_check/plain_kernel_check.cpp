@@ -0,0 +1,1895 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "kernel_checker.h"
+
+#include <nnforge/nnforge.h>
+#include <nnforge/plain/plain.h>
+#include <nnforge/plain/factory_generator_plain.h>
+#include <nnforge/plain/vector_math.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <set>
+#include <cstdlib>
+#include <boost/format.hpp>
+
+#ifndef _WIN32
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+// Specialized plain kernels are checked against generic code computing the same function,
+// typically the same layer with a trailing dimension of size 1 added, or against finite differences.
+// Data enters the checked layer through a 1x1 convolution, so backward data of the checked layer is covered by the gradients of the convolution
+
+enum relu_placement
+{
+	relu_none,
+	relu_before_checked_layer,
+	relu_after_checked_layer
+};
+
+static void add_layer(
+	std::vector<nnforge::layer::const_ptr>& layer_list,
+	nnforge::layer::ptr new_layer,
+	const std::string& instance_name,
+	const std::string& input_layer_name = std::string(),
+	const std::string& second_input_layer_name = std::string())
+{
+	new_layer->instance_name = instance_name;
+	if (!input_layer_name.empty())
+		new_layer->input_layer_instance_names.push_back(input_layer_name);
+	if (!second_input_layer_name.empty())
+		new_layer->input_layer_instance_names.push_back(second_input_layer_name);
+	layer_list.push_back(new_layer);
+}
+
+static nnforge::layer_configuration_specific get_configuration(
+	unsigned int feature_map_count,
+	unsigned int width,
+	unsigned int height,
+	bool trailing_dimension)
+{
+	nnforge::layer_configuration_specific res(feature_map_count);
+	res.dimension_sizes.push_back(width);
+	res.dimension_sizes.push_back(height);
+	if (trailing_dimension)
+		res.dimension_sizes.push_back(1);
+
+	return res;
+}
+
+// images -> conv -> checked layer -> error against targets, ReLU is put before or after the checked layer optionally
+static std::vector<nnforge::layer::const_ptr> get_layer_list(
+	nnforge::layer::ptr checked_layer,
+	const nnforge::layer_configuration_specific& input_configuration_specific,
+	unsigned int feature_map_count,
+	relu_placement relu,
+	nnforge::layer::ptr error_layer,
+	nnforge::layer_configuration_specific& output_configuration_specific)
+{
+	std::vector<nnforge::layer::const_ptr> layer_list;
+	add_layer(layer_list, nnforge::layer::ptr(new nnforge::data_layer()), "images");
+	nnforge::layer::ptr conv(new nnforge::convolution_layer(
+		std::vector<unsigned int>(input_configuration_specific.dimension_sizes.size(), 1),
+		input_configuration_specific.feature_map_count,
+		feature_map_count));
+	add_layer(layer_list, conv, "conv", "images");
+	std::string checked_input_layer_name = "conv";
+	if (relu == relu_before_checked_layer)
+	{
+		add_layer(layer_list, nnforge::layer::ptr(new nnforge::rectified_linear_layer()), "relu", "conv");
+		checked_input_layer_name = "relu";
+	}
+	add_layer(layer_list, checked_layer, (relu == relu_after_checked_layer) ? "checked_no_relu" : "checked", checked_input_layer_name);
+	if (relu == relu_after_checked_layer)
+		add_layer(layer_list, nnforge::layer::ptr(new nnforge::rectified_linear_layer()), "checked", "checked_no_relu");
+	add_layer(layer_list, nnforge::layer::ptr(new nnforge::data_layer()), "targets");
+	add_layer(layer_list, error_layer, "error", "checked", "targets");
+
+	output_configuration_specific = checked_layer->get_output_layer_configuration_specific(
+		std::vector<nnforge::layer_configuration_specific>(1, conv->get_output_layer_configuration_specific(
+			std::vector<nnforge::layer_configuration_specific>(1, input_configuration_specific))));
+
+	return layer_list;
+}
+
+static nnforge::network_schema::ptr get_schema(
+	nnforge::layer::ptr checked_layer,
+	const nnforge::layer_configuration_specific& input_configuration_specific,
+	unsigned int feature_map_count,
+	relu_placement relu,
+	nnforge::layer_configuration_specific& output_configuration_specific)
+{
+	return nnforge::network_schema::ptr(new nnforge::network_schema(get_layer_list(
+		checked_layer,
+		input_configuration_specific,
+		feature_map_count,
+		relu,
+		nnforge::layer::ptr(new nnforge::lerror_layer()),
+		output_configuration_specific)));
+}
+
+// Checked layer is compared with the reference layer, which is run on the same data laid out in reference input configuration
+static void check_against_reference(
+	kernel_checker& checker,
+	const std::string& check_name,
+	nnforge::layer::ptr checked_layer,
+	relu_placement relu,
+	const nnforge::layer_configuration_specific& input_configuration_specific,
+	nnforge::layer::ptr reference_layer,
+	relu_placement reference_relu,
+	const nnforge::layer_configuration_specific& reference_input_configuration_specific,
+	unsigned int feature_map_count,
+	bool backward,
+	nnforge::random_generator& gen)
+{
+	const unsigned int entry_count = 3;
+	nnforge::layer_configuration_specific output_configuration_specific;
+	nnforge::layer_configuration_specific reference_output_configuration_specific;
+	nnforge::network_schema::ptr schema = get_schema(checked_layer, input_configuration_specific, feature_map_count, relu, output_configuration_specific);
+	nnforge::network_schema::ptr reference_schema = get_schema(reference_layer, reference_input_configuration_specific, feature_map_count, reference_relu, reference_output_configuration_specific);
+
+	nnforge::neuron_value_set::ptr images = kernel_checker::get_random_values(input_configuration_specific.get_neuron_count(), entry_count, -1.0F, 1.0F, gen);
+	nnforge::neuron_value_set::ptr targets = kernel_checker::get_random_values(output_configuration_specific.get_neuron_count(), entry_count, -1.0F, 1.0F, gen);
+	kernel_checker::input_map inputs;
+	inputs.insert(std::make_pair("images", std::make_pair(input_configuration_specific, images)));
+	inputs.insert(std::make_pair("targets", std::make_pair(output_configuration_specific, targets)));
+	kernel_checker::input_map reference_inputs;
+	reference_inputs.insert(std::make_pair("images", std::make_pair(reference_input_configuration_specific, images)));
+	reference_inputs.insert(std::make_pair("targets", std::make_pair(reference_output_configuration_specific, targets)));
+
+	nnforge::network_data::ptr data = kernel_checker::get_random_data(*schema, gen);
+	nnforge::network_data::ptr reference_data = kernel_checker::get_data_copy(*reference_schema, *data);
+
+	checker.check_equivalence(
+		check_name,
+		*schema,
+		*data,
+		inputs,
+		*reference_schema,
+		*reference_data,
+		reference_inputs,
+		std::vector<std::string>(1, "checked"),
+		backward ? std::vector<std::string>(1, "error") : std::vector<std::string>(),
+		1.0e-5F);
+}
+
+// Backprop gradients of the network with the checked layer are compared with finite differences
+static void check_layer_gradient(
+	kernel_checker& checker,
+	const std::string& check_name,
+	nnforge::layer::ptr checked_layer,
+	const nnforge::layer_configuration_specific& input_configuration_specific,
+	unsigned int feature_map_count,
+	unsigned int entry_count,
+	nnforge::random_generator& gen)
+{
+	nnforge::layer_configuration_specific output_configuration_specific;
+	nnforge::network_schema::ptr schema = get_schema(checked_layer, input_configuration_specific, feature_map_count, relu_none, output_configuration_specific);
+
+	kernel_checker::input_map inputs;
+	inputs.insert(std::make_pair("images", std::make_pair(input_configuration_specific, kernel_checker::get_random_values(input_configuration_specific.get_neuron_count(), entry_count, -1.0F, 1.0F, gen))));
+	inputs.insert(std::make_pair("targets", std::make_pair(output_configuration_specific, kernel_checker::get_random_values(output_configuration_specific.get_neuron_count(), entry_count, -1.0F, 1.0F, gen))));
+
+	nnforge::network_data::ptr data = kernel_checker::get_random_data(*schema, gen);
+
+	checker.check_gradient(check_name, *schema, *data, inputs, std::vector<std::string>(1, "error"), 1.0e-2F);
+}
+
+// 2D checked layer is compared with the reference layer, which is run on the same data with a trailing dimension of size 1
+static void check_against_3d(
+	kernel_checker& checker,
+	const std::string& check_name,
+	nnforge::layer::ptr checked_layer,
+	relu_placement relu,
+	nnforge::layer::ptr reference_layer,
+	relu_placement reference_relu,
+	unsigned int input_feature_map_count,
+	unsigned int feature_map_count,
+	unsigned int width,
+	unsigned int height,
+	bool backward,
+	nnforge::random_generator& gen)
+{
+	check_against_reference(
+		checker,
+		check_name,
+		checked_layer,
+		relu,
+		get_configuration(input_feature_map_count, width, height, false),
+		reference_layer,
+		reference_relu,
+		get_configuration(input_feature_map_count, width, height, true),
+		feature_map_count,
+		backward,
+		gen);
+}
+
+static std::vector<unsigned int> get_sizes(
+	unsigned int width,
+	unsigned int height,
+	bool trailing_dimension)
+{
+	std::vector<unsigned int> res;
+	res.push_back(width);
+	res.push_back(height);
+	if (trailing_dimension)
+		res.push_back(1);
+
+	return res;
+}
+
+// Trailing dimensions of the reference layer are not padded
+static std::vector<unsigned int> get_padding(
+	unsigned int padding,
+	unsigned int padded_dimension_count,
+	unsigned int dimension_count)
+{
+	std::vector<unsigned int> res(dimension_count, 0);
+	std::fill(res.begin(), res.begin() + padded_dimension_count, padding);
+
+	return res;
+}
+
+// Generic code shares the scale factor with the kernels, so it is checked against averages computed here
+static void check_average_subsampling_values(
+	kernel_checker& checker,
+	unsigned int subsampling_size,
+	nnforge::random_generator& gen)
+{
+	const unsigned int entry_count = 2;
+	const unsigned int output_width = 4;
+	const unsigned int output_height = 3;
+	nnforge::layer_configuration_specific input_configuration_specific = get_configuration(3, output_width * subsampling_size, output_height * subsampling_size, false);
+	nnforge::layer_configuration_specific output_configuration_specific;
+	nnforge::network_schema::ptr schema = get_schema(
+		nnforge::layer::ptr(new nnforge::average_subsampling_layer(std::vector<nnforge::average_subsampling_factor>(2, nnforge::average_subsampling_factor(subsampling_size)))),
+		input_configuration_specific,
+		5,
+		relu_none,
+		output_configuration_specific);
+	nnforge::network_data::ptr data = kernel_checker::get_random_data(*schema, gen);
+	kernel_checker::input_map inputs;
+	inputs.insert(std::make_pair("images", std::make_pair(input_configuration_specific, kernel_checker::get_random_values(input_configuration_specific.get_neuron_count(), entry_count, -1.0F, 1.0F, gen))));
+
+	std::vector<std::string> output_layer_names;
+	output_layer_names.push_back("conv");
+	output_layer_names.push_back("checked");
+	kernel_checker::output_map outputs = checker.run_forward(*schema, *data, inputs, output_layer_names);
+
+	const std::vector<float>& conv_values = outputs["conv"];
+	const unsigned int input_width = output_width * subsampling_size;
+	const unsigned int input_neuron_count_per_feature_map = input_width * output_height * subsampling_size;
+	std::vector<float> expected_values(output_configuration_specific.get_neuron_count() * entry_count);
+	for(unsigned int output_id = 0; output_id < static_cast<unsigned int>(expected_values.size()); ++output_id)
+	{
+		unsigned int x = output_id % output_width;
+		unsigned int y = (output_id / output_width) % output_height;
+		unsigned int feature_map_id = output_id / (output_width * output_height);
+		float sum = 0.0F;
+		for(unsigned int window_y = 0; window_y < subsampling_size; ++window_y)
+			for(unsigned int window_x = 0; window_x < subsampling_size; ++window_x)
+				sum += conv_values[feature_map_id * input_neuron_count_per_feature_map + (y * subsampling_size + window_y) * input_width + x * subsampling_size + window_x];
+		expected_values[output_id] = sum / static_cast<float>(subsampling_size * subsampling_size);
+	}
+
+	checker.check_values((boost::format("average subsampling %1%x%1% values") % subsampling_size).str(), outputs["checked"], expected_values, 1.0e-5F);
+}
+
+static void check_subsampling(
+	kernel_checker& checker,
+	nnforge::random_generator& gen)
+{
+	const unsigned int max_shapes[][4] = { { 2, 2, 13, 11 }, { 3, 2, 13, 11 }, { 3, 1, 13, 11 } };
+	for(unsigned int i = 0; i < sizeof(max_shapes) / sizeof(max_shapes[0]); ++i)
+	{
+		const unsigned int * shape = max_shapes[i];
+		for(int fused_relu = 0; fused_relu < 2; ++fused_relu)
+		{
+			check_against_3d(
+				checker,
+				(boost::format("max subsampling %1%x%1% stride %2%%3%") % shape[0] % shape[1] % (fused_relu ? " with ReLU" : "")).str(),
+				nnforge::layer::ptr(new nnforge::max_subsampling_layer(get_sizes(shape[0], shape[0], false), 1, 1, false, false, std::vector<bool>(), get_sizes(shape[1], shape[1], false))),
+				fused_relu ? relu_before_checked_layer : relu_none,
+				nnforge::layer::ptr(new nnforge::max_subsampling_layer(get_sizes(shape[0], shape[0], true), 1, 1, false, false, std::vector<bool>(), get_sizes(shape[1], shape[1], true))),
+				fused_relu ? relu_after_checked_layer : relu_none,
+				3,
+				5,
+				shape[2],
+				shape[3],
+				false,
+				gen);
+		}
+	}
+
+	for(unsigned int subsampling_size = 2; subsampling_size <= 3; ++subsampling_size)
+	{
+		std::vector<nnforge::average_subsampling_factor> subsampling_sizes(2, nnforge::average_subsampling_factor(subsampling_size));
+		std::vector<nnforge::average_subsampling_factor> reference_subsampling_sizes(subsampling_sizes);
+		reference_subsampling_sizes.push_back(nnforge::average_subsampling_factor(1));
+		check_against_3d(
+			checker,
+			(boost::format("average subsampling %1%x%1%") % subsampling_size).str(),
+			nnforge::layer::ptr(new nnforge::average_subsampling_layer(subsampling_sizes)),
+			relu_none,
+			nnforge::layer::ptr(new nnforge::average_subsampling_layer(reference_subsampling_sizes)),
+			relu_none,
+			3,
+			5,
+			subsampling_size * 4,
+			subsampling_size * 3,
+			false,
+			gen);
+		check_average_subsampling_values(checker, subsampling_size, gen);
+	}
+}
+
+// Blocked row-wise engine handles 1D and 2D windows, the generic code is run with a trailing window dimension of size 1.
+// Connection count is chosen so that both full and partial blocks of output feature maps occur
+static void check_sparse_convolution(
+	kernel_checker& checker,
+	nnforge::random_generator& gen)
+{
+	const unsigned int input_feature_map_count = 6;
+	const unsigned int output_feature_map_count = 11;
+	const unsigned int feature_map_connection_count = 40;
+
+	// window width, window height, left padding, right padding, stride
+	const unsigned int shapes_2d[][5] = { { 3, 3, 1, 1, 1 }, { 3, 2, 0, 1, 2 }, { 1, 1, 0, 0, 1 } };
+	for(unsigned int i = 0; i < sizeof(shapes_2d) / sizeof(shapes_2d[0]); ++i)
+	{
+		const unsigned int * shape = shapes_2d[i];
+		check_against_3d(
+			checker,
+			(boost::format("sparse convolution %1%x%2% padding %3%/%4% stride %5%") % shape[0] % shape[1] % shape[2] % shape[3] % shape[4]).str(),
+			nnforge::layer::ptr(new nnforge::sparse_convolution_layer(
+				get_sizes(shape[0], shape[1], false),
+				input_feature_map_count,
+				output_feature_map_count,
+				feature_map_connection_count,
+				get_padding(shape[2], 2, 2),
+				get_padding(shape[3], 2, 2),
+				std::vector<unsigned int>(2, shape[4]))),
+			relu_none,
+			nnforge::layer::ptr(new nnforge::sparse_convolution_layer(
+				get_sizes(shape[0], shape[1], true),
+				input_feature_map_count,
+				output_feature_map_count,
+				feature_map_connection_count,
+				get_padding(shape[2], 2, 3),
+				get_padding(shape[3], 2, 3),
+				get_sizes(shape[4], shape[4], true))),
+			relu_none,
+			3,
+			input_feature_map_count,
+			13,
+			9,
+			true,
+			gen);
+	}
+
+	nnforge::layer_configuration_specific input_configuration_specific(3);
+	input_configuration_specific.dimension_sizes.push_back(17);
+	nnforge::layer_configuration_specific reference_input_configuration_specific(input_configuration_specific);
+	reference_input_configuration_specific.dimension_sizes.push_back(1);
+	check_against_reference(
+		checker,
+		"sparse convolution 1D 3 padding 1/1 stride 1",
+		nnforge::layer::ptr(new nnforge::sparse_convolution_layer(
+			std::vector<unsigned int>(1, 3),
+			input_feature_map_count,
+			output_feature_map_count,
+			feature_map_connection_count,
+			std::vector<unsigned int>(1, 1),
+			std::vector<unsigned int>(1, 1))),
+		relu_none,
+		input_configuration_specific,
+		nnforge::layer::ptr(new nnforge::sparse_convolution_layer(
+			get_sizes(3, 1, false),
+			input_feature_map_count,
+			output_feature_map_count,
+			feature_map_connection_count,
+			get_padding(1, 1, 2),
+			get_padding(1, 1, 2))),
+		relu_none,
+		reference_input_configuration_specific,
+		input_feature_map_count,
+		true,
+		gen);
+}
+
+// Softmax backward data is fused into the loss layer when the loss is the only consumer of softmax output.
+// The reference network adds another consumer contributing zero error, which makes softmax and loss run separately.
+// Both networks are checked with finite differences as well, as a loss layer emitting zero errors would make them agree trivially
+static void check_softmax_loss(
+	kernel_checker& checker,
+	nnforge::random_generator& gen)
+{
+	const unsigned int entry_count = 3;
+	const unsigned int feature_map_count = 7;
+	nnforge::layer_configuration_specific input_configuration_specific = get_configuration(3, 5, 4, false);
+
+	for(int loss_id = 0; loss_id < 2; ++loss_id)
+	{
+		std::string check_name = (loss_id == 0) ? "softmax negative log likelihood" : "softmax cross entropy";
+		nnforge::layer::ptr error_layer;
+		if (loss_id == 0)
+			error_layer = nnforge::layer::ptr(new nnforge::negative_log_likelihood_layer());
+		else
+			error_layer = nnforge::layer::ptr(new nnforge::cross_entropy_layer());
+
+		nnforge::layer_configuration_specific output_configuration_specific;
+		std::vector<nnforge::layer::const_ptr> layer_list = get_layer_list(
+			nnforge::layer::ptr(new nnforge::softmax_layer()),
+			input_configuration_specific,
+			feature_map_count,
+			relu_none,
+			error_layer,
+			output_configuration_specific);
+		nnforge::network_schema::ptr schema(new nnforge::network_schema(layer_list));
+		add_layer(layer_list, nnforge::layer::ptr(new nnforge::lerror_layer(2.0F, 0.0F)), "probe", "checked", "targets");
+		nnforge::network_schema::ptr reference_schema(new nnforge::network_schema(layer_list));
+
+		// Targets are probabilities
+		kernel_checker::input_map inputs;
+		inputs.insert(std::make_pair("images", std::make_pair(input_configuration_specific, kernel_checker::get_random_values(input_configuration_specific.get_neuron_count(), entry_count, -1.0F, 1.0F, gen))));
+		inputs.insert(std::make_pair("targets", std::make_pair(output_configuration_specific, kernel_checker::get_random_values(output_configuration_specific.get_neuron_count(), entry_count, 0.0F, 1.0F, gen))));
+
+		nnforge::network_data::ptr data = kernel_checker::get_random_data(*schema, gen);
+		nnforge::network_data::ptr reference_data = kernel_checker::get_data_copy(*reference_schema, *data);
+
+		std::vector<std::string> error_source_layer_names(1, "error");
+		std::vector<std::string> reference_error_source_layer_names(error_source_layer_names);
+		reference_error_source_layer_names.push_back("probe");
+
+		double error;
+		double reference_error;
+		kernel_checker::gradient_map gradients = checker.run_backward(*schema, *data, inputs, error_source_layer_names, error);
+		kernel_checker::gradient_map reference_gradients = checker.run_backward(*reference_schema, *reference_data, inputs, reference_error_source_layer_names, reference_error);
+		checker.check_values(check_name + " error", std::vector<float>(1, static_cast<float>(error)), std::vector<float>(1, static_cast<float>(reference_error)), 1.0e-5F);
+		checker.check_gradients(check_name + " fused vs separate", gradients, reference_gradients, 1.0e-4F);
+
+		checker.check_gradient(check_name + " fused", *schema, *data, inputs, error_source_layer_names, 1.0e-2F);
+		checker.check_gradient(check_name + " separate", *reference_schema, *reference_data, inputs, reference_error_source_layer_names, 1.0e-2F);
+	}
+}
+
+// Separable row/column kernel handles 2D layers only, feature maps not affected are copied
+static void check_local_contrast_subtractive(
+	kernel_checker& checker,
+	nnforge::random_generator& gen)
+{
+	const unsigned int feature_map_count = 5;
+	std::vector<unsigned int> feature_maps_affected;
+	feature_maps_affected.push_back(0);
+	feature_maps_affected.push_back(2);
+	feature_maps_affected.push_back(3);
+
+	const unsigned int window_sizes[][2] = { { 5, 3 }, { 2, 4 }, { 1, 1 } };
+	for(unsigned int i = 0; i < sizeof(window_sizes) / sizeof(window_sizes[0]); ++i)
+	{
+		const unsigned int * window_size = window_sizes[i];
+		check_against_3d(
+			checker,
+			(boost::format("local contrast subtractive %1%x%2%") % window_size[0] % window_size[1]).str(),
+			nnforge::layer::ptr(new nnforge::local_contrast_subtractive_layer(get_sizes(window_size[0], window_size[1], false), feature_maps_affected, feature_map_count)),
+			relu_none,
+			nnforge::layer::ptr(new nnforge::local_contrast_subtractive_layer(get_sizes(window_size[0], window_size[1], true), feature_maps_affected, feature_map_count)),
+			relu_none,
+			3,
+			feature_map_count,
+			11,
+			7,
+			true,
+			gen);
+		check_layer_gradient(
+			checker,
+			(boost::format("local contrast subtractive %1%x%2%") % window_size[0] % window_size[1]).str(),
+			nnforge::layer::ptr(new nnforge::local_contrast_subtractive_layer(get_sizes(window_size[0], window_size[1], false), feature_maps_affected, feature_map_count)),
+			get_configuration(3, 11, 7, false),
+			feature_map_count,
+			2,
+			gen);
+	}
+}
+
+// theta_input -> theta (1x1 convolution) -> affine grid -> linear sampler of images -> error against targets.
+// Linear sampler propagates errors to the grid only, so images are taken from the data layer directly
+static nnforge::network_schema::ptr get_linear_sampler_schema(
+	const std::vector<unsigned int>& output_sizes)
+{
+	std::vector<nnforge::layer::const_ptr> layer_list;
+	add_layer(layer_list, nnforge::layer::ptr(new nnforge::data_layer()), "images");
+	add_layer(layer_list, nnforge::layer::ptr(new nnforge::data_layer()), "theta_input");
+	add_layer(layer_list, nnforge::layer::ptr(new nnforge::convolution_layer(std::vector<unsigned int>(2, 1), 6, 6)), "theta", "theta_input");
+	add_layer(layer_list, nnforge::layer::ptr(new nnforge::affine_grid_generator_layer(output_sizes)), "grid", "theta");
+	add_layer(layer_list, nnforge::layer::ptr(new nnforge::linear_sampler_layer()), "checked", "grid", "images");
+	add_layer(layer_list, nnforge::layer::ptr(new nnforge::data_layer()), "targets");
+	add_layer(layer_list, nnforge::layer::ptr(new nnforge::lerror_layer()), "error", "checked", "targets");
+
+	return nnforge::network_schema::ptr(new nnforge::network_schema(layer_list));
+}
+
+// Forward output is checked against bilinear sampling computed here from the grid, with multiple feature maps and entries:
+// the generic code used to advance the output by a whole entry per feature map, writing out of bounds.
+// Theta is kept close to zero with its bias stretching the grid, so that samples at the borders fall partially out of the input
+static void check_linear_sampler(
+	kernel_checker& checker,
+	nnforge::random_generator& gen)
+{
+	const unsigned int entry_count = 3;
+	const unsigned int feature_map_count = 4;
+	const unsigned int input_width = 9;
+	const unsigned int input_height = 7;
+	nnforge::layer_configuration_specific input_configuration_specific = get_configuration(feature_map_count, input_width, input_height, false);
+	nnforge::layer_configuration_specific theta_configuration_specific = get_configuration(6, 1, 1, false);
+
+	const unsigned int output_sizes[][2] = { { 6, 5 }, { 13, 10 } };
+	for(unsigned int i = 0; i < sizeof(output_sizes) / sizeof(output_sizes[0]); ++i)
+	{
+		const unsigned int output_width = output_sizes[i][0];
+		const unsigned int output_height = output_sizes[i][1];
+		std::string check_name = (boost::format("linear sampler %1%x%2% from %3%x%4%") % output_width % output_height % input_width % input_height).str();
+		nnforge::layer_configuration_specific output_configuration_specific = get_configuration(feature_map_count, output_width, output_height, false);
+		nnforge::network_schema::ptr schema = get_linear_sampler_schema(get_sizes(output_width, output_height, false));
+
+		kernel_checker::input_map inputs;
+		inputs.insert(std::make_pair("images", std::make_pair(input_configuration_specific, kernel_checker::get_random_values(input_configuration_specific.get_neuron_count(), entry_count, -1.0F, 1.0F, gen))));
+		inputs.insert(std::make_pair("theta_input", std::make_pair(theta_configuration_specific, kernel_checker::get_random_values(theta_configuration_specific.get_neuron_count(), entry_count, -1.0F, 1.0F, gen))));
+		inputs.insert(std::make_pair("targets", std::make_pair(output_configuration_specific, kernel_checker::get_random_values(output_configuration_specific.get_neuron_count(), entry_count, -1.0F, 1.0F, gen))));
+
+		nnforge::network_data::ptr data = kernel_checker::get_random_data(*schema, gen);
+		nnforge::layer_data::ptr theta_data = data->data_list.get("theta");
+		for(nnforge::layer_data::iterator it = theta_data->begin(); it != theta_data->end(); ++it)
+			for(nnforge::layer_data_part::iterator it2 = it->begin(); it2 != it->end(); ++it2)
+				*it2 *= 0.02F;
+		nnforge::layer_data_part& theta_bias = theta_data->at(1);
+		const std::vector<float> original_theta_bias(theta_bias.begin(), theta_bias.end());
+		const float stretch_bias[] = { 0.2F, 0.0F, -0.1F, 0.0F, 0.2F, -0.1F };
+		for(unsigned int j = 0; j < static_cast<unsigned int>(theta_bias.size()); ++j)
+			theta_bias[j] = original_theta_bias[j] + stretch_bias[j];
+
+		std::vector<std::string> output_layer_names;
+		output_layer_names.push_back("grid");
+		output_layer_names.push_back("checked");
+		kernel_checker::output_map outputs = checker.run_forward(*schema, *data, inputs, output_layer_names);
+
+		const std::vector<float>& grid = outputs["grid"];
+		const unsigned int output_neuron_count_per_feature_map = output_width * output_height;
+		const unsigned int input_neuron_count_per_feature_map = input_width * input_height;
+		std::vector<float> expected_values(output_configuration_specific.get_neuron_count() * entry_count, 0.0F);
+		for(unsigned int entry_id = 0; entry_id < entry_count; ++entry_id)
+		{
+			const std::vector<float>& images = *inputs["images"].second->neuron_value_list[entry_id];
+			for(unsigned int output_id = 0; output_id < output_neuron_count_per_feature_map; ++output_id)
+			{
+				float absolute_x_pos = grid[entry_id * output_neuron_count_per_feature_map * 2 + output_id] * static_cast<float>(input_width - 1);
+				float absolute_y_pos = grid[(entry_id * 2 + 1) * output_neuron_count_per_feature_map + output_id] * static_cast<float>(input_height - 1);
+				int left_x = static_cast<int>(absolute_x_pos);
+				int top_y = static_cast<int>(absolute_y_pos);
+				float right_weight = absolute_x_pos - static_cast<float>(left_x);
+				float bottom_weight = absolute_y_pos - static_cast<float>(top_y);
+				for(unsigned int feature_map_id = 0; feature_map_id < feature_map_count; ++feature_map_id)
+				{
+					float sum = 0.0F;
+					for(int corner_y = 0; corner_y < 2; ++corner_y)
+					{
+						for(int corner_x = 0; corner_x < 2; ++corner_x)
+						{
+							int x = left_x + corner_x;
+							int y = top_y + corner_y;
+							if ((x < 0) || (x >= static_cast<int>(input_width)) || (y < 0) || (y >= static_cast<int>(input_height)))
+								continue;
+							float weight = (corner_x ? right_weight : 1.0F - right_weight) * (corner_y ? bottom_weight : 1.0F - bottom_weight);
+							sum += weight * images[feature_map_id * input_neuron_count_per_feature_map + y * input_width + x];
+						}
+					}
+					expected_values[(entry_id * feature_map_count + feature_map_id) * output_neuron_count_per_feature_map + output_id] = sum;
+				}
+			}
+		}
+		checker.check_values(check_name + " values", outputs["checked"], expected_values, 1.0e-5F);
+
+		// Bilinear sampling has kinks at the pixel borders, which spoil finite differences.
+		// Sampling of bilinear functions of position is smooth, and theta bias shrinks the grid so that it stays inside the input
+		std::uniform_real_distribution<float> coefficient_dist(-1.0F, 1.0F);
+		for(std::vector<std::shared_ptr<std::vector<float> > >::iterator it = inputs["images"].second->neuron_value_list.begin(); it != inputs["images"].second->neuron_value_list.end(); ++it)
+		{
+			for(unsigned int feature_map_id = 0; feature_map_id < feature_map_count; ++feature_map_id)
+			{
+				float coefficients[4];
+				for(int j = 0; j < 4; ++j)
+					coefficients[j] = coefficient_dist(gen);
+				for(unsigned int y = 0; y < input_height; ++y)
+				{
+					for(unsigned int x = 0; x < input_width; ++x)
+					{
+						float normalized_x = static_cast<float>(x) / static_cast<float>(input_width - 1);
+						float normalized_y = static_cast<float>(y) / static_cast<float>(input_height - 1);
+						(**it)[(feature_map_id * input_height + y) * input_width + x] = coefficients[0] + coefficients[1] * normalized_x + coefficients[2] * normalized_y + coefficients[3] * normalized_x * normalized_y;
+					}
+				}
+			}
+		}
+		const float shrink_bias[] = { -0.2F, 0.0F, 0.1F, 0.0F, -0.2F, 0.1F };
+		for(unsigned int j = 0; j < static_cast<unsigned int>(theta_bias.size()); ++j)
+			theta_bias[j] = original_theta_bias[j] + shrink_bias[j];
+
+		checker.check_gradient(check_name, *schema, *data, inputs, std::vector<std::string>(1, "error"), 1.0e-2F);
+	}
+}
+
+// The convolution feeding the checked layer is set to identity, so that the checked layer gets the images as they are
+static nnforge::network_data::ptr get_identity_convolution_data(
+	const nnforge::network_schema& schema,
+	unsigned int feature_map_count,
+	nnforge::random_generator& gen)
+{
+	nnforge::network_data::ptr res = kernel_checker::get_random_data(schema, gen);
+	nnforge::layer_data::ptr conv_data = res->data_list.get("conv");
+	std::fill(conv_data->at(0).begin(), conv_data->at(0).end(), 0.0F);
+	for(unsigned int feature_map_id = 0; feature_map_id < feature_map_count; ++feature_map_id)
+		conv_data->at(0)[feature_map_id * feature_map_count + feature_map_id] = 1.0F;
+	std::fill(conv_data->at(1).begin(), conv_data->at(1).end(), 0.0F);
+
+	return res;
+}
+
+// Forward output of the checked layer for images given, run through the identity convolution
+static std::vector<float> run_with_identity_convolution(
+	kernel_checker& checker,
+	const nnforge::network_schema& schema,
+	const nnforge::layer_configuration_specific& input_configuration_specific,
+	const nnforge::layer_configuration_specific& output_configuration_specific,
+	nnforge::neuron_value_set::ptr images,
+	nnforge::random_generator& gen)
+{
+	nnforge::network_data::ptr data = get_identity_convolution_data(schema, input_configuration_specific.feature_map_count, gen);
+	kernel_checker::input_map inputs;
+	inputs.insert(std::make_pair("images", std::make_pair(input_configuration_specific, images)));
+	inputs.insert(std::make_pair("targets", std::make_pair(output_configuration_specific, kernel_checker::get_random_values(output_configuration_specific.get_neuron_count(), static_cast<unsigned int>(images->neuron_value_list.size()), 0.0F, 1.0F, gen))));
+
+	return checker.run_forward(schema, *data, inputs, std::vector<std::string>(1, "checked"))["checked"];
+}
+
+static nnforge::layer::ptr get_cumulative_layer(
+	bool prefix_sum,
+	unsigned int feature_map_segment_length,
+	float clamp_min,
+	float clamp_max)
+{
+	if (prefix_sum)
+		return nnforge::layer::ptr(new nnforge::prefix_sum_layer(feature_map_segment_length, clamp_min, clamp_max));
+	else
+		return nnforge::layer::ptr(new nnforge::cdf_to_pdf_layer(feature_map_segment_length, clamp_min, clamp_max));
+}
+
+// Prefix sum and its inverse are checked against values computed here and with finite differences.
+// With a single entry there are fewer segments than threads, which makes prefix sum split each segment into chunks
+static void check_prefix_sum(
+	kernel_checker& checker,
+	nnforge::random_generator& gen)
+{
+	const unsigned int feature_map_count = 16;
+	const unsigned int feature_map_segment_length = 8;
+	nnforge::layer_configuration_specific input_configuration_specific = get_configuration(feature_map_count, 3, 2, false);
+	const unsigned int neuron_count_per_feature_map = input_configuration_specific.get_neuron_count_per_feature_map();
+
+	const unsigned int entry_counts[] = { 1, 3 };
+	for(unsigned int i = 0; i < sizeof(entry_counts) / sizeof(entry_counts[0]); ++i)
+	{
+		const unsigned int entry_count = entry_counts[i];
+		for(int clamp = 0; clamp < 2; ++clamp)
+		{
+			const float clamp_min = clamp ? -0.5F : -std::numeric_limits<float>::max();
+			const float clamp_max = clamp ? 1.0F : std::numeric_limits<float>::max();
+			for(int layer_id = 0; layer_id < 2; ++layer_id)
+			{
+				std::string check_name = (boost::format("%1% %2% entries%3%") % ((layer_id == 0) ? "prefix sum" : "cdf to pdf") % entry_count % (clamp ? " with clamp" : "")).str();
+				nnforge::layer_configuration_specific output_configuration_specific;
+				nnforge::network_schema::ptr schema = get_schema(get_cumulative_layer(layer_id == 0, feature_map_segment_length, clamp_min, clamp_max), input_configuration_specific, feature_map_count, relu_none, output_configuration_specific);
+				nnforge::neuron_value_set::ptr images = kernel_checker::get_random_values(input_configuration_specific.get_neuron_count(), entry_count, -0.5F, 0.5F, gen);
+				std::vector<float> values = run_with_identity_convolution(checker, *schema, input_configuration_specific, output_configuration_specific, images, gen);
+
+				std::vector<float> expected_values;
+				for(unsigned int entry_id = 0; entry_id < entry_count; ++entry_id)
+				{
+					const std::vector<float>& input_values = *images->neuron_value_list[entry_id];
+					std::vector<float> running_sums(neuron_count_per_feature_map, 0.0F);
+					for(unsigned int feature_map_id = 0; feature_map_id < feature_map_count; ++feature_map_id)
+					{
+						bool segment_start = ((feature_map_id % feature_map_segment_length) == 0);
+						for(unsigned int x = 0; x < neuron_count_per_feature_map; ++x)
+						{
+							float input_value = input_values[feature_map_id * neuron_count_per_feature_map + x];
+							float value;
+							if (layer_id == 0)
+							{
+								running_sums[x] = (segment_start ? 0.0F : running_sums[x]) + input_value;
+								value = running_sums[x];
+							}
+							else
+								value = segment_start ? input_value : input_value - input_values[(feature_map_id - 1) * neuron_count_per_feature_map + x];
+							expected_values.push_back(std::min(std::max(value, clamp_min), clamp_max));
+						}
+					}
+				}
+				checker.check_values(check_name + " values", values, expected_values, 1.0e-5F);
+
+				// Clamped outputs have zero gradient, which finite differences get wrong near the clamp borders
+				if (!clamp)
+					check_layer_gradient(checker, check_name, get_cumulative_layer(layer_id == 0, feature_map_segment_length, clamp_min, clamp_max), input_configuration_specific, feature_map_count, entry_count, gen);
+			}
+		}
+	}
+}
+
+// Reshape splitting each entry into entry subsampling size entries, the way cdf max gets its inputs
+static nnforge::layer::ptr get_entry_split_layer(unsigned int entry_subsampling_size)
+{
+	nnforge::reshape_layer * res = new nnforge::reshape_layer();
+	res->entry_factor = entry_subsampling_size;
+	res->dimension_factor_list.push_back(1);
+	res->dimension_factor_list.push_back(nnforge::tiling_factor(entry_subsampling_size, false));
+
+	return nnforge::layer::ptr(res);
+}
+
+// images -> split -> conv -> cdf max, targets -> split -> cdf max, error between them.
+// Splitting before cdf max keeps the tiling factor integer, which the plain backend requires
+static nnforge::network_schema::ptr get_cdf_max_schema(
+	const nnforge::layer_configuration_specific& input_configuration_specific,
+	unsigned int entry_subsampling_size,
+	bool is_min)
+{
+	std::vector<nnforge::layer::const_ptr> layer_list;
+	add_layer(layer_list, nnforge::layer::ptr(new nnforge::data_layer()), "images");
+	add_layer(layer_list, get_entry_split_layer(entry_subsampling_size), "split", "images");
+	add_layer(layer_list, nnforge::layer::ptr(new nnforge::convolution_layer(std::vector<unsigned int>(input_configuration_specific.dimension_sizes.size(), 1), input_configuration_specific.feature_map_count, input_configuration_specific.feature_map_count)), "conv", "split");
+	add_layer(layer_list, nnforge::layer::ptr(new nnforge::cdf_max_layer(entry_subsampling_size, is_min)), "checked", "conv");
+	add_layer(layer_list, nnforge::layer::ptr(new nnforge::data_layer()), "targets");
+	add_layer(layer_list, get_entry_split_layer(entry_subsampling_size), "targets_split", "targets");
+	add_layer(layer_list, nnforge::layer::ptr(new nnforge::cdf_max_layer(entry_subsampling_size, is_min)), "targets_max", "targets_split");
+	add_layer(layer_list, nnforge::layer::ptr(new nnforge::lerror_layer()), "error", "checked", "targets_max");
+
+	return nnforge::network_schema::ptr(new nnforge::network_schema(layer_list));
+}
+
+static void check_cdf_max(
+	kernel_checker& checker,
+	nnforge::random_generator& gen)
+{
+	const unsigned int entry_subsampling_size = 3;
+	const unsigned int entry_count = 2;
+	nnforge::layer_configuration_specific input_configuration_specific = get_configuration(5, 7, 6 * entry_subsampling_size, false);
+	const unsigned int output_neuron_count = input_configuration_specific.get_neuron_count() / entry_subsampling_size;
+
+	for(int is_min = 0; is_min < 2; ++is_min)
+	{
+		std::string check_name = is_min ? "cdf min" : "cdf max";
+		nnforge::network_schema::ptr schema = get_cdf_max_schema(input_configuration_specific, entry_subsampling_size, is_min != 0);
+
+		kernel_checker::input_map inputs;
+		nnforge::neuron_value_set::ptr images = kernel_checker::get_random_values(input_configuration_specific.get_neuron_count(), entry_count, 0.0F, 1.0F, gen);
+		inputs.insert(std::make_pair("images", std::make_pair(input_configuration_specific, images)));
+		inputs.insert(std::make_pair("targets", std::make_pair(input_configuration_specific, kernel_checker::get_random_values(input_configuration_specific.get_neuron_count(), entry_count, 0.0F, 1.0F, gen))));
+
+		nnforge::network_data::ptr data = get_identity_convolution_data(*schema, input_configuration_specific.feature_map_count, gen);
+		std::vector<float> values = checker.run_forward(*schema, *data, inputs, std::vector<std::string>(1, "checked"))["checked"];
+
+		// Split entries are consecutive parts of the source entry
+		std::vector<float> expected_values(output_neuron_count * entry_count);
+		for(unsigned int entry_id = 0; entry_id < entry_count; ++entry_id)
+		{
+			const std::vector<float>& input_values = *images->neuron_value_list[entry_id];
+			for(unsigned int neuron_id = 0; neuron_id < output_neuron_count; ++neuron_id)
+			{
+				float product = 1.0F;
+				for(unsigned int i = 0; i < entry_subsampling_size; ++i)
+				{
+					float input_value = input_values[i * output_neuron_count + neuron_id];
+					product *= is_min ? (1.0F - input_value) : input_value;
+				}
+				expected_values[entry_id * output_neuron_count + neuron_id] = is_min ? (1.0F - product) : product;
+			}
+		}
+		checker.check_values(check_name + " values", values, expected_values, 1.0e-5F);
+
+		checker.check_gradient(check_name, *schema, *kernel_checker::get_random_data(*schema, gen), inputs, std::vector<std::string>(1, "error"), 1.0e-2F);
+	}
+}
+
+// Grouped convolution is compared with the dense convolution run through the generic code,
+// the dense weights connect each output feature map to the input feature maps of its group only
+static void check_grouped_convolution(
+	kernel_checker& checker,
+	nnforge::random_generator& gen)
+{
+	const unsigned int entry_count = 3;
+	const unsigned int params[][9] = {
+		// input feature maps, output feature maps, groups, window width, window height, padding, stride x, stride y, width
+		{ 4, 6, 1, 3, 3, 1, 1, 1, 9 },
+		{ 4, 6, 2, 3, 3, 1, 1, 1, 9 },
+		{ 6, 6, 6, 3, 3, 1, 1, 1, 10 },
+		{ 4, 8, 4, 3, 3, 0, 2, 1, 11 },
+		{ 6, 6, 3, 3, 2, 1, 2, 2, 10 },
+		{ 6, 3, 3, 1, 1, 0, 1, 1, 7 },
+	};
+	for(unsigned int i = 0; i < sizeof(params) / sizeof(params[0]); ++i)
+	{
+		const unsigned int input_feature_map_count = params[i][0];
+		const unsigned int output_feature_map_count = params[i][1];
+		const unsigned int group_count = params[i][2];
+		const unsigned int input_feature_map_count_per_group = input_feature_map_count / group_count;
+		const unsigned int output_feature_map_count_per_group = output_feature_map_count / group_count;
+		const unsigned int window_elem_count = params[i][3] * params[i][4];
+		std::string check_name = (boost::format("grouped convolution %1%->%2% in %3% groups %4%x%5% pad %6% stride %7%x%8%")
+			% input_feature_map_count % output_feature_map_count % group_count % params[i][3] % params[i][4] % params[i][5] % params[i][6] % params[i][7]).str();
+
+		nnforge::layer_configuration_specific input_configuration_specific = get_configuration(3, params[i][8], 7, false);
+		nnforge::layer_configuration_specific reference_input_configuration_specific = get_configuration(3, params[i][8], 7, true);
+		nnforge::layer_configuration_specific output_configuration_specific;
+		nnforge::layer_configuration_specific reference_output_configuration_specific;
+		nnforge::network_schema::ptr schema = get_schema(
+			nnforge::layer::ptr(new nnforge::grouped_convolution_layer(
+				get_sizes(params[i][3], params[i][4], false),
+				input_feature_map_count,
+				output_feature_map_count,
+				group_count,
+				get_padding(params[i][5], 2, 2),
+				get_padding(params[i][5], 2, 2),
+				get_sizes(params[i][6], params[i][7], false))),
+			input_configuration_specific,
+			input_feature_map_count,
+			relu_none,
+			output_configuration_specific);
+		nnforge::network_schema::ptr reference_schema = get_schema(
+			nnforge::layer::ptr(new nnforge::convolution_layer(
+				get_sizes(params[i][3], params[i][4], true),
+				input_feature_map_count,
+				output_feature_map_count,
+				get_padding(params[i][5], 2, 3),
+				get_padding(params[i][5], 2, 3),
+				get_sizes(params[i][6], params[i][7], true))),
+			reference_input_configuration_specific,
+			input_feature_map_count,
+			relu_none,
+			reference_output_configuration_specific);
+
+		nnforge::neuron_value_set::ptr images = kernel_checker::get_random_values(input_configuration_specific.get_neuron_count(), entry_count, -1.0F, 1.0F, gen);
+		nnforge::neuron_value_set::ptr targets = kernel_checker::get_random_values(output_configuration_specific.get_neuron_count(), entry_count, -1.0F, 1.0F, gen);
+		kernel_checker::input_map inputs;
+		inputs.insert(std::make_pair("images", std::make_pair(input_configuration_specific, images)));
+		inputs.insert(std::make_pair("targets", std::make_pair(output_configuration_specific, targets)));
+		kernel_checker::input_map reference_inputs;
+		reference_inputs.insert(std::make_pair("images", std::make_pair(reference_input_configuration_specific, images)));
+		reference_inputs.insert(std::make_pair("targets", std::make_pair(reference_output_configuration_specific, targets)));
+
+		nnforge::network_data::ptr data = kernel_checker::get_random_data(*schema, gen);
+		nnforge::network_data::ptr reference_data = kernel_checker::get_random_data(*reference_schema, gen);
+		*reference_data->data_list.get("conv") = *data->data_list.get("conv");
+		nnforge::layer_data::ptr grouped_data = data->data_list.get("checked");
+		nnforge::layer_data::ptr dense_data = reference_data->data_list.get("checked");
+		std::fill(dense_data->at(0).begin(), dense_data->at(0).end(), 0.0F);
+		for(unsigned int output_feature_map_id = 0; output_feature_map_id < output_feature_map_count; ++output_feature_map_id)
+		{
+			unsigned int first_input_feature_map_id = (output_feature_map_id / output_feature_map_count_per_group) * input_feature_map_count_per_group;
+			std::copy(
+				grouped_data->at(0).begin() + output_feature_map_id * input_feature_map_count_per_group * window_elem_count,
+				grouped_data->at(0).begin() + (output_feature_map_id + 1) * input_feature_map_count_per_group * window_elem_count,
+				dense_data->at(0).begin() + (output_feature_map_id * input_feature_map_count + first_input_feature_map_id) * window_elem_count);
+		}
+		std::copy(grouped_data->at(1).begin(), grouped_data->at(1).end(), dense_data->at(1).begin());
+
+		std::vector<std::string> output_layer_names(1, "checked");
+		checker.check_values(
+			check_name + " values",
+			checker.run_forward(*schema, *data, inputs, output_layer_names)["checked"],
+			checker.run_forward(*reference_schema, *reference_data, reference_inputs, output_layer_names)["checked"],
+			1.0e-5F);
+
+		// Gradient of the dense weights is compared at the positions of the grouped ones only
+		double error;
+		double reference_error;
+		std::vector<std::string> error_source_layer_names(1, "error");
+		kernel_checker::gradient_map gradients = checker.run_backward(*schema, *data, inputs, error_source_layer_names, error);
+		kernel_checker::gradient_map reference_gradients = checker.run_backward(*reference_schema, *reference_data, reference_inputs, error_source_layer_names, reference_error);
+		std::vector<float>& dense_gradient = reference_gradients["checked"][0];
+		std::vector<float> grouped_gradient(gradients["checked"][0].size());
+		for(unsigned int output_feature_map_id = 0; output_feature_map_id < output_feature_map_count; ++output_feature_map_id)
+		{
+			unsigned int first_input_feature_map_id = (output_feature_map_id / output_feature_map_count_per_group) * input_feature_map_count_per_group;
+			std::copy(
+				dense_gradient.begin() + (output_feature_map_id * input_feature_map_count + first_input_feature_map_id) * window_elem_count,
+				dense_gradient.begin() + (output_feature_map_id * input_feature_map_count + first_input_feature_map_id + input_feature_map_count_per_group) * window_elem_count,
+				grouped_gradient.begin() + output_feature_map_id * input_feature_map_count_per_group * window_elem_count);
+		}
+		dense_gradient = grouped_gradient;
+		checker.check_gradients(check_name, gradients, reference_gradients, 1.0e-5F);
+	}
+}
+
+// Convolution with the window covering the whole input runs as matrix multiplication.
+// The reference gets a trailing window of size 2 with one of its elements over padding, which makes it run through the generic code.
+// Weights of the padded half of the window don't contribute to anything
+static void check_fully_connected(
+	kernel_checker& checker,
+	nnforge::random_generator& gen)
+{
+	// Sizes exceeding the blocks used by the kernel are included, to check the edges of the blocks
+	const unsigned int params[][5] = {
+		// input feature maps, width, height, output feature maps, entries
+		{ 30, 7, 5, 70, 37 },
+		{ 5, 1, 1, 9, 3 },
+		{ 4, 3, 2, 3, 1 },
+	};
+	for(unsigned int i = 0; i < sizeof(params) / sizeof(params[0]); ++i)
+	{
+		const unsigned int input_feature_map_count = params[i][0];
+		const unsigned int output_feature_map_count = params[i][3];
+		const unsigned int entry_count = params[i][4];
+		const unsigned int window_elem_count = params[i][1] * params[i][2];
+		std::string check_name = (boost::format("fully connected %1%x%2%x%3%->%4% %5% entries") % input_feature_map_count % params[i][1] % params[i][2] % output_feature_map_count % entry_count).str();
+
+		nnforge::layer_configuration_specific input_configuration_specific = get_configuration(3, params[i][1], params[i][2], false);
+		nnforge::layer_configuration_specific reference_input_configuration_specific = get_configuration(3, params[i][1], params[i][2], true);
+		std::vector<unsigned int> reference_window_sizes = get_sizes(params[i][1], params[i][2], true);
+		reference_window_sizes.back() = 2;
+		std::vector<unsigned int> reference_right_padding = get_padding(0, 0, 3);
+		reference_right_padding.back() = 1;
+		nnforge::layer_configuration_specific output_configuration_specific;
+		nnforge::layer_configuration_specific reference_output_configuration_specific;
+		nnforge::network_schema::ptr schema = get_schema(
+			nnforge::layer::ptr(new nnforge::convolution_layer(get_sizes(params[i][1], params[i][2], false), input_feature_map_count, output_feature_map_count)),
+			input_configuration_specific,
+			input_feature_map_count,
+			relu_none,
+			output_configuration_specific);
+		nnforge::network_schema::ptr reference_schema = get_schema(
+			nnforge::layer::ptr(new nnforge::convolution_layer(reference_window_sizes, input_feature_map_count, output_feature_map_count, get_padding(0, 0, 3), reference_right_padding)),
+			reference_input_configuration_specific,
+			input_feature_map_count,
+			relu_none,
+			reference_output_configuration_specific);
+
+		nnforge::neuron_value_set::ptr images = kernel_checker::get_random_values(input_configuration_specific.get_neuron_count(), entry_count, -1.0F, 1.0F, gen);
+		nnforge::neuron_value_set::ptr targets = kernel_checker::get_random_values(output_configuration_specific.get_neuron_count(), entry_count, -1.0F, 1.0F, gen);
+		kernel_checker::input_map inputs;
+		inputs.insert(std::make_pair("images", std::make_pair(input_configuration_specific, images)));
+		inputs.insert(std::make_pair("targets", std::make_pair(output_configuration_specific, targets)));
+		kernel_checker::input_map reference_inputs;
+		reference_inputs.insert(std::make_pair("images", std::make_pair(reference_input_configuration_specific, images)));
+		reference_inputs.insert(std::make_pair("targets", std::make_pair(reference_output_configuration_specific, targets)));
+
+		nnforge::network_data::ptr data = kernel_checker::get_random_data(*schema, gen);
+		nnforge::network_data::ptr reference_data = kernel_checker::get_random_data(*reference_schema, gen);
+		*reference_data->data_list.get("conv") = *data->data_list.get("conv");
+		nnforge::layer_data::ptr checked_data = data->data_list.get("checked");
+		nnforge::layer_data::ptr reference_checked_data = reference_data->data_list.get("checked");
+		for(unsigned int kernel_id = 0; kernel_id < output_feature_map_count * input_feature_map_count; ++kernel_id)
+			std::copy(
+				checked_data->at(0).begin() + kernel_id * window_elem_count,
+				checked_data->at(0).begin() + (kernel_id + 1) * window_elem_count,
+				reference_checked_data->at(0).begin() + kernel_id * 2 * window_elem_count);
+		std::copy(checked_data->at(1).begin(), checked_data->at(1).end(), reference_checked_data->at(1).begin());
+
+		std::vector<std::string> output_layer_names(1, "checked");
+		checker.check_values(
+			check_name + " values",
+			checker.run_forward(*schema, *data, inputs, output_layer_names)["checked"],
+			checker.run_forward(*reference_schema, *reference_data, reference_inputs, output_layer_names)["checked"],
+			1.0e-5F);
+
+		double error;
+		double reference_error;
+		std::vector<std::string> error_source_layer_names(1, "error");
+		kernel_checker::gradient_map gradients = checker.run_backward(*schema, *data, inputs, error_source_layer_names, error);
+		kernel_checker::gradient_map reference_gradients = checker.run_backward(*reference_schema, *reference_data, reference_inputs, error_source_layer_names, reference_error);
+		std::vector<float>& reference_weight_gradient = reference_gradients["checked"][0];
+		std::vector<float> weight_gradient(gradients["checked"][0].size());
+		for(unsigned int kernel_id = 0; kernel_id < output_feature_map_count * input_feature_map_count; ++kernel_id)
+			std::copy(
+				reference_weight_gradient.begin() + kernel_id * 2 * window_elem_count,
+				reference_weight_gradient.begin() + (kernel_id * 2 + 1) * window_elem_count,
+				weight_gradient.begin() + kernel_id * window_elem_count);
+		reference_weight_gradient = weight_gradient;
+		checker.check_gradients(check_name, gradients, reference_gradients, 1.0e-5F);
+	}
+}
+
+// images -> conv -> relu -> conv -> relu -> max subsampling -> fully connected -> error against targets
+static nnforge::network_schema::ptr get_conv_net_schema(
+	const nnforge::layer_configuration_specific& input_configuration_specific,
+	unsigned int feature_map_count,
+	unsigned int output_feature_map_count)
+{
+	std::vector<nnforge::layer::const_ptr> layer_list;
+	add_layer(layer_list, nnforge::layer::ptr(new nnforge::data_layer()), "images");
+	add_layer(layer_list, nnforge::layer::ptr(new nnforge::convolution_layer(get_sizes(3, 3, false), input_configuration_specific.feature_map_count, feature_map_count, get_padding(1, 2, 2), get_padding(1, 2, 2))), "conv", "images");
+	add_layer(layer_list, nnforge::layer::ptr(new nnforge::rectified_linear_layer()), "relu", "conv");
+	add_layer(layer_list, nnforge::layer::ptr(new nnforge::convolution_layer(get_sizes(3, 3, false), feature_map_count, feature_map_count, get_padding(1, 2, 2), get_padding(1, 2, 2))), "conv2", "relu");
+	add_layer(layer_list, nnforge::layer::ptr(new nnforge::rectified_linear_layer()), "relu2", "conv2");
+	add_layer(layer_list, nnforge::layer::ptr(new nnforge::max_subsampling_layer(get_sizes(2, 2, false))), "subsampling", "relu2");
+	add_layer(layer_list, nnforge::layer::ptr(new nnforge::convolution_layer(
+		get_sizes(input_configuration_specific.dimension_sizes[0] / 2, input_configuration_specific.dimension_sizes[1] / 2, false),
+		feature_map_count,
+		output_feature_map_count)), "checked", "subsampling");
+	add_layer(layer_list, nnforge::layer::ptr(new nnforge::data_layer()), "targets");
+	add_layer(layer_list, nnforge::layer::ptr(new nnforge::lerror_layer()), "error", "checked", "targets");
+
+	return nnforge::network_schema::ptr(new nnforge::network_schema(layer_list));
+}
+
+// Trainer keeping activations in bfloat16 between forward and backward prop is compared with the fp32 one.
+// Activations are rounded to 8 bits of mantissa, so the gradients match within a loose tolerance only, while the error is computed in fp32
+static void check_bf16_activations(
+	kernel_checker& checker,
+	const kernel_checker& bf16_checker,
+	nnforge::random_generator& gen)
+{
+	const unsigned int entry_count = 5;
+	const unsigned int output_feature_map_count = 4;
+	nnforge::layer_configuration_specific input_configuration_specific = get_configuration(3, 12, 10, false);
+	nnforge::layer_configuration_specific output_configuration_specific(output_feature_map_count);
+	output_configuration_specific.dimension_sizes.resize(2, 1);
+	nnforge::network_schema::ptr schema = get_conv_net_schema(input_configuration_specific, 8, output_feature_map_count);
+
+	kernel_checker::input_map inputs;
+	inputs.insert(std::make_pair("images", std::make_pair(input_configuration_specific, kernel_checker::get_random_values(input_configuration_specific.get_neuron_count(), entry_count, -1.0F, 1.0F, gen))));
+	inputs.insert(std::make_pair("targets", std::make_pair(output_configuration_specific, kernel_checker::get_random_values(output_configuration_specific.get_neuron_count(), entry_count, -1.0F, 1.0F, gen))));
+	nnforge::network_data::ptr data = kernel_checker::get_random_data(*schema, gen);
+
+	double error;
+	double bf16_error;
+	std::vector<std::string> error_source_layer_names(1, "error");
+	kernel_checker::gradient_map gradients = checker.run_backward(*schema, *data, inputs, error_source_layer_names, error);
+	kernel_checker::gradient_map bf16_gradients = bf16_checker.run_backward(*schema, *data, inputs, error_source_layer_names, bf16_error);
+
+	checker.check_values("bf16 activations error", std::vector<float>(1, static_cast<float>(bf16_error)), std::vector<float>(1, static_cast<float>(error)), 1.0e-5F);
+	checker.check_gradients("bf16 activations", bf16_gradients, gradients, 1.0e-2F);
+}
+
+// images -> conv -> two branches of convolution and ReLU -> concat and add of the branches -> 1x1 convolution of concat added to the sum
+static nnforge::network_schema::ptr get_branchy_schema(
+	const nnforge::layer_configuration_specific& input_configuration_specific,
+	unsigned int feature_map_count)
+{
+	std::vector<nnforge::layer::const_ptr> layer_list;
+	add_layer(layer_list, nnforge::layer::ptr(new nnforge::data_layer()), "images");
+	add_layer(layer_list, nnforge::layer::ptr(new nnforge::convolution_layer(get_sizes(1, 1, false), input_configuration_specific.feature_map_count, feature_map_count)), "conv", "images");
+	add_layer(layer_list, nnforge::layer::ptr(new nnforge::convolution_layer(get_sizes(3, 3, false), feature_map_count, feature_map_count, get_padding(1, 2, 2), get_padding(1, 2, 2))), "branch_a_conv", "conv");
+	add_layer(layer_list, nnforge::layer::ptr(new nnforge::rectified_linear_layer()), "branch_a", "branch_a_conv");
+	add_layer(layer_list, nnforge::layer::ptr(new nnforge::convolution_layer(get_sizes(5, 5, false), feature_map_count, feature_map_count, get_padding(2, 2, 2), get_padding(2, 2, 2))), "branch_b_conv", "conv");
+	add_layer(layer_list, nnforge::layer::ptr(new nnforge::rectified_linear_layer()), "branch_b", "branch_b_conv");
+	add_layer(layer_list, nnforge::layer::ptr(new nnforge::concat_layer()), "concat", "branch_a", "branch_b");
+	add_layer(layer_list, nnforge::layer::ptr(new nnforge::add_layer()), "sum", "branch_a", "branch_b");
+	add_layer(layer_list, nnforge::layer::ptr(new nnforge::convolution_layer(get_sizes(1, 1, false), feature_map_count * 2, feature_map_count)), "mix", "concat");
+	add_layer(layer_list, nnforge::layer::ptr(new nnforge::add_layer()), "checked", "mix", "sum");
+	add_layer(layer_list, nnforge::layer::ptr(new nnforge::data_layer()), "targets");
+	add_layer(layer_list, nnforge::layer::ptr(new nnforge::lerror_layer()), "error", "checked", "targets");
+
+	return nnforge::network_schema::ptr(new nnforge::network_schema(layer_list));
+}
+
+// Independent branches run concurrently in parallel branches mode, each of them with a part of the threads.
+// Kernels don't depend on thread count, so outputs should be exactly the same as in sequential mode
+static void check_parallel_branches(
+	kernel_checker& checker,
+	const kernel_checker& parallel_branches_checker,
+	nnforge::random_generator& gen)
+{
+	const unsigned int entry_count = 5;
+	const unsigned int feature_map_count = 8;
+	nnforge::layer_configuration_specific input_configuration_specific = get_configuration(3, 12, 10, false);
+	nnforge::layer_configuration_specific output_configuration_specific = get_configuration(feature_map_count, 12, 10, false);
+	nnforge::network_schema::ptr schema = get_branchy_schema(input_configuration_specific, feature_map_count);
+
+	kernel_checker::input_map inputs;
+	inputs.insert(std::make_pair("images", std::make_pair(input_configuration_specific, kernel_checker::get_random_values(input_configuration_specific.get_neuron_count(), entry_count, -1.0F, 1.0F, gen))));
+	inputs.insert(std::make_pair("targets", std::make_pair(output_configuration_specific, kernel_checker::get_random_values(output_configuration_specific.get_neuron_count(), entry_count, -1.0F, 1.0F, gen))));
+	nnforge::network_data::ptr data = kernel_checker::get_random_data(*schema, gen);
+
+	std::vector<std::string> output_layer_names;
+	output_layer_names.push_back("concat");
+	output_layer_names.push_back("sum");
+	output_layer_names.push_back("checked");
+	kernel_checker::output_map outputs = checker.run_forward(*schema, *data, inputs, output_layer_names);
+	kernel_checker::output_map parallel_branches_outputs = parallel_branches_checker.run_forward(*schema, *data, inputs, output_layer_names);
+	for(std::vector<std::string>::const_iterator it = output_layer_names.begin(); it != output_layer_names.end(); ++it)
+		checker.check_values("parallel branches " + *it, parallel_branches_outputs[*it], outputs[*it], 0.0F);
+}
+
+// The batch of recompute check fits into a single chunk within the memory limit only with conv and relu recomputed:
+// without recompute the limit allows 3 entries per chunk, with a bit more memory the planner doesn't recompute anything
+static const unsigned int recompute_check_entry_count = 4;
+static const float recompute_check_max_global_memory_usage = 0.001F;
+
+// Trainer dropping activations after forward prop and recomputing them during backward prop is compared with the one keeping them.
+// Recompute runs the same kernels on the same inputs, so gradients should be exactly the same.
+// Had the batch been split into chunks, gradients would be summed in different order and the check would fail
+static void check_recompute_activations(
+	kernel_checker& checker,
+	const kernel_checker& recompute_checker,
+	nnforge::random_generator& gen)
+{
+	const unsigned int entry_count = recompute_check_entry_count;
+	const unsigned int output_feature_map_count = 4;
+	nnforge::layer_configuration_specific input_configuration_specific = get_configuration(3, 32, 32, false);
+	nnforge::layer_configuration_specific output_configuration_specific(output_feature_map_count);
+	output_configuration_specific.dimension_sizes.resize(2, 1);
+	nnforge::network_schema::ptr schema = get_conv_net_schema(input_configuration_specific, 16, output_feature_map_count);
+
+	kernel_checker::input_map inputs;
+	inputs.insert(std::make_pair("images", std::make_pair(input_configuration_specific, kernel_checker::get_random_values(input_configuration_specific.get_neuron_count(), entry_count, -1.0F, 1.0F, gen))));
+	inputs.insert(std::make_pair("targets", std::make_pair(output_configuration_specific, kernel_checker::get_random_values(output_configuration_specific.get_neuron_count(), entry_count, -1.0F, 1.0F, gen))));
+	nnforge::network_data::ptr data = kernel_checker::get_random_data(*schema, gen);
+
+	double error;
+	double recompute_error;
+	std::vector<std::string> error_source_layer_names(1, "error");
+	kernel_checker::gradient_map gradients = checker.run_backward(*schema, *data, inputs, error_source_layer_names, error);
+	kernel_checker::gradient_map recompute_gradients = recompute_checker.run_backward(*schema, *data, inputs, error_source_layer_names, recompute_error);
+
+	checker.check_values("recompute activations error", std::vector<float>(1, static_cast<float>(recompute_error)), std::vector<float>(1, static_cast<float>(error)), 0.0F);
+	checker.check_gradients("recompute activations", recompute_gradients, gradients, 0.0F);
+}
+
+// Top-left corner of width x height of each feature map of each entry
+static std::vector<float> get_corner(
+	const std::vector<float>& values,
+	const nnforge::layer_configuration_specific& configuration_specific,
+	unsigned int width,
+	unsigned int height)
+{
+	std::vector<float> res;
+	const unsigned int neuron_count_per_feature_map = configuration_specific.get_neuron_count_per_feature_map();
+	const unsigned int feature_map_count = static_cast<unsigned int>(values.size()) / neuron_count_per_feature_map;
+	for(unsigned int feature_map_id = 0; feature_map_id < feature_map_count; ++feature_map_id)
+		for(unsigned int y = 0; y < height; ++y)
+		{
+			std::vector<float>::const_iterator row_it = values.begin() + feature_map_id * neuron_count_per_feature_map + y * configuration_specific.dimension_sizes[0];
+			res.insert(res.end(), row_it, row_it + width);
+		}
+
+	return res;
+}
+
+// Forward prop switching between input shapes restores plans from its cache, outputs are compared with fresh forward prop for each shape.
+// With shape bucketing the input of a new shape is padded to a larger cached one. Padded input gets into the output
+// of the layers having it in their window only: of the 3x3 convolution following the 1x1 one, which is not zero for zero input,
+// at the last column and row of the original shape
+static void check_plan_cache(
+	kernel_checker& checker,
+	nnforge::random_generator& gen)
+{
+	const unsigned int entry_count = 3;
+	const unsigned int feature_map_count = 6;
+	nnforge::layer_configuration_specific output_configuration_specific;
+	nnforge::network_schema::ptr schema = get_schema(
+		nnforge::layer::ptr(new nnforge::convolution_layer(get_sizes(3, 3, false), feature_map_count, feature_map_count, get_padding(1, 2, 2), get_padding(1, 2, 2))),
+		get_configuration(3, 12, 10, false),
+		feature_map_count,
+		relu_after_checked_layer,
+		output_configuration_specific);
+	nnforge::network_data::ptr data = kernel_checker::get_random_data(*schema, gen);
+	std::vector<std::string> output_layer_names(1, "checked");
+
+	for(int shape_bucketing = 0; shape_bucketing < 2; ++shape_bucketing)
+	{
+		const unsigned int sizes[][2] = { { 12, 10 }, { 7, 9 }, { 12, 10 }, { 9, 6 }, { 14, 5 }, { 7, 9 }, { 9, 6 } };
+		std::vector<nnforge::layer_configuration_specific> input_configuration_specific_list;
+		std::vector<kernel_checker::input_map> inputs_list;
+		for(unsigned int i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i)
+		{
+			nnforge::layer_configuration_specific input_configuration_specific = get_configuration(3, sizes[i][0], sizes[i][1], false);
+			input_configuration_specific_list.push_back(input_configuration_specific);
+			kernel_checker::input_map inputs;
+			inputs.insert(std::make_pair("images", std::make_pair(input_configuration_specific, kernel_checker::get_random_values(input_configuration_specific.get_neuron_count(), entry_count, -1.0F, 1.0F, gen))));
+			inputs_list.push_back(inputs);
+		}
+
+		std::vector<kernel_checker::output_map> outputs_list = checker.run_forward_sequence(*schema, *data, inputs_list, output_layer_names, shape_bucketing != 0);
+		std::vector<nnforge::layer_configuration_specific> planned_input_configuration_specific_list;
+		for(unsigned int i = 0; i < static_cast<unsigned int>(inputs_list.size()); ++i)
+		{
+			const nnforge::layer_configuration_specific& input_configuration_specific = input_configuration_specific_list[i];
+			std::string check_name = (boost::format("plan cache%1% step %2% %3%x%4%") % (shape_bucketing ? " with shape bucketing" : "") % i % sizes[i][0] % sizes[i][1]).str();
+			std::vector<float> reference_values = checker.run_forward(*schema, *data, inputs_list[i], output_layer_names)["checked"];
+			const std::vector<float>& values = outputs_list[i]["checked"];
+
+			// The smallest of the shapes planned before, which is at least as large in both dimensions, is used as the bucket
+			nnforge::layer_configuration_specific bucket_configuration_specific = input_configuration_specific;
+			if (shape_bucketing && (std::find(planned_input_configuration_specific_list.begin(), planned_input_configuration_specific_list.end(), input_configuration_specific) == planned_input_configuration_specific_list.end()))
+			{
+				for(std::vector<nnforge::layer_configuration_specific>::const_iterator it = planned_input_configuration_specific_list.begin(); it != planned_input_configuration_specific_list.end(); ++it)
+					if ((it->dimension_sizes[0] >= input_configuration_specific.dimension_sizes[0]) && (it->dimension_sizes[1] >= input_configuration_specific.dimension_sizes[1])
+						&& ((bucket_configuration_specific == input_configuration_specific) || (it->get_neuron_count() < bucket_configuration_specific.get_neuron_count())))
+						bucket_configuration_specific = *it;
+			}
+			if (bucket_configuration_specific == input_configuration_specific)
+			{
+				planned_input_configuration_specific_list.push_back(input_configuration_specific);
+				checker.check_values(check_name, values, reference_values, 0.0F);
+			}
+			else
+			{
+				nnforge::layer_configuration_specific bucket_output_configuration_specific = get_configuration(feature_map_count, bucket_configuration_specific.dimension_sizes[0], bucket_configuration_specific.dimension_sizes[1], false);
+				nnforge::layer_configuration_specific reference_output_configuration_specific = get_configuration(feature_map_count, input_configuration_specific.dimension_sizes[0], input_configuration_specific.dimension_sizes[1], false);
+				checker.check_values(
+					check_name + (boost::format(" in %1%x%2% bucket") % bucket_configuration_specific.dimension_sizes[0] % bucket_configuration_specific.dimension_sizes[1]).str(),
+					get_corner(values, bucket_output_configuration_specific, sizes[i][0] - 1, sizes[i][1] - 1),
+					get_corner(reference_values, reference_output_configuration_specific, sizes[i][0] - 1, sizes[i][1] - 1),
+					0.0F);
+			}
+		}
+	}
+}
+
+static float vector_exp(float x)
+{
+	return nnforge::plain::vector_math::exp(x);
+}
+
+static float vector_log(float x)
+{
+	return nnforge::plain::vector_math::log(x);
+}
+
+static float vector_sigmoid(float x)
+{
+	return nnforge::plain::vector_math::sigmoid(x);
+}
+
+static float vector_tanh(float x)
+{
+	return nnforge::plain::vector_math::tanh(x);
+}
+
+static float libm_sigmoid(float x)
+{
+	return 1.0F / (expf(-x) + 1.0F);
+}
+
+// Returns the best time of several runs
+template<float (*func)(float)>
+static float apply_function(
+	const std::vector<float>& arguments,
+	std::vector<float>& values)
+{
+	const int run_count = 5;
+	values.resize(arguments.size());
+	float best_seconds = std::numeric_limits<float>::max();
+	for(int run_id = 0; run_id < run_count; ++run_id)
+	{
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		const float * in = &arguments[0];
+		float * out = &values[0];
+		int elem_count = static_cast<int>(arguments.size());
+		for(int i = 0; i < elem_count; ++i)
+			out[i] = func(in[i]);
+		std::chrono::duration<float> sec = std::chrono::high_resolution_clock::now() - start;
+		best_seconds = std::min(best_seconds, sec.count());
+	}
+
+	return best_seconds;
+}
+
+// Error is relative to the libm value when absolute_error is false, absolute otherwise
+template<float (*func)(float), float (*reference_func)(float)>
+static void check_vector_function(
+	kernel_checker& checker,
+	const std::string& function_name,
+	const std::vector<float>& arguments,
+	bool absolute_error,
+	float tolerance)
+{
+	std::vector<float> values;
+	std::vector<float> reference_values;
+	float seconds = apply_function<func>(arguments, values);
+	float reference_seconds = apply_function<reference_func>(arguments, reference_values);
+
+	double max_error = 0.0;
+	float max_error_argument = 0.0F;
+	unsigned int nan_count = 0;
+	for(unsigned int i = 0; i < static_cast<unsigned int>(arguments.size()); ++i)
+	{
+		if (kernel_checker::is_nan(values[i]) || kernel_checker::is_nan(reference_values[i]))
+		{
+			++nan_count;
+			continue;
+		}
+		double error = fabs(static_cast<double>(values[i]) - static_cast<double>(reference_values[i]));
+		if (!absolute_error)
+			error /= fabs(static_cast<double>(reference_values[i]));
+		if (error > max_error)
+		{
+			max_error = error;
+			max_error_argument = arguments[i];
+		}
+	}
+
+	checker.report(
+		"vector_math " + function_name,
+		(nan_count == 0) && (max_error <= tolerance),
+		(boost::format("max %1% error %2% at %3% in %4% values [%5%, %6%], %7% NaN, %8%x throughput of libm")
+			% (absolute_error ? "abs" : "relative") % max_error % max_error_argument % arguments.size() % arguments.front() % arguments.back() % nan_count
+			% (reference_seconds / std::max(seconds, 1.0e-9F))).str());
+}
+
+static std::vector<float> get_uniform_arguments(
+	float min_value,
+	float max_value,
+	unsigned int count)
+{
+	std::vector<float> res(count);
+	for(unsigned int i = 0; i < count; ++i)
+		res[i] = static_cast<float>(min_value + (static_cast<double>(max_value) - static_cast<double>(min_value)) * i / (count - 1));
+	return res;
+}
+
+static unsigned int get_bits(float val)
+{
+	unsigned int res;
+	std::memcpy(&res, &val, sizeof(res));
+	return res;
+}
+
+static float get_float(unsigned int bits)
+{
+	float res;
+	std::memcpy(&res, &bits, sizeof(res));
+	return res;
+}
+
+// Polynomial approximations are compared with libm over the whole range where the input is not clamped,
+// for log every 127th bit pattern of positive normal floats is taken, which covers all the exponents and spreads over the mantissas.
+// Tolerances are the error bounds stated in vector_math.h.
+// Infinite input is clamped for exp and the functions using it, log passes +Inf through, NaN is passed through by all of them
+static void check_vector_math(kernel_checker& checker)
+{
+	const unsigned int argument_count = 1 << 22;
+	check_vector_function<vector_exp, expf>(checker, "exp", get_uniform_arguments(-87.3365F, 88.7228F, argument_count), false, 4.0e-6F);
+
+	std::vector<float> log_arguments;
+	for(unsigned int bits = get_bits(std::numeric_limits<float>::min()); bits <= get_bits(std::numeric_limits<float>::max()); bits += 127)
+		log_arguments.push_back(get_float(bits));
+	check_vector_function<vector_log, logf>(checker, "log", log_arguments, false, 1.0e-6F);
+
+	check_vector_function<vector_sigmoid, libm_sigmoid>(checker, "sigmoid", get_uniform_arguments(-87.3365F, 88.7228F, argument_count), false, 4.0e-6F);
+	check_vector_function<vector_tanh, tanhf>(checker, "tanh", get_uniform_arguments(-43.6682F, 44.3614F, argument_count), true, 1.0e-6F);
+
+	const float nan = std::numeric_limits<float>::quiet_NaN();
+	const float inf = std::numeric_limits<float>::infinity();
+	std::vector<float> special_arguments;
+	special_arguments.push_back(nan);
+	special_arguments.push_back(-nan);
+	special_arguments.push_back(inf);
+	special_arguments.push_back(-inf);
+	std::vector<float> special_values[4];
+	apply_function<vector_exp>(special_arguments, special_values[0]);
+	apply_function<vector_log>(special_arguments, special_values[1]);
+	apply_function<vector_sigmoid>(special_arguments, special_values[2]);
+	apply_function<vector_tanh>(special_arguments, special_values[3]);
+	const char * const function_names[4] = { "exp", "log", "sigmoid", "tanh" };
+	// log of negative numbers, -Inf included, is not defined and is not checked
+	const float expected_values[4][4] = {
+		{ nan, nan, expf(88.7228F), expf(-87.3365F) },
+		{ nan, nan, inf, 0.0F },
+		{ nan, nan, 1.0F, 0.0F },
+		{ nan, nan, 1.0F, -1.0F } };
+	for(unsigned int i = 0; i < 4; ++i)
+	{
+		for(unsigned int j = 0; j < static_cast<unsigned int>(special_arguments.size()); ++j)
+		{
+			if ((i == 1) && (j == 3))
+				continue;
+			float value = special_values[i][j];
+			float expected_value = expected_values[i][j];
+			bool success;
+			if (kernel_checker::is_nan(expected_value))
+				success = kernel_checker::is_nan(value);
+			else if ((get_bits(expected_value) & 0x7FFFFFFFU) == 0x7F800000U)
+				success = (get_bits(value) == get_bits(expected_value));
+			else
+				success = (fabs(static_cast<double>(value) - static_cast<double>(expected_value)) <= 4.0e-6 * std::max(fabs(static_cast<double>(expected_value)), 1.0));
+			checker.report(
+				(boost::format("vector_math %1%(%2%)") % function_names[i] % special_arguments[j]).str(),
+				success,
+				(boost::format("%1% while %2% expected") % value % expected_value).str());
+		}
+	}
+}
+
+// Entries [first_entry_id, first_entry_id + entry_count) of each input
+static kernel_checker::input_map get_entries(
+	const kernel_checker::input_map& inputs,
+	unsigned int first_entry_id,
+	unsigned int entry_count)
+{
+	kernel_checker::input_map res;
+	for(kernel_checker::input_map::const_iterator it = inputs.begin(); it != inputs.end(); ++it)
+	{
+		nnforge::neuron_value_set::ptr values(new nnforge::neuron_value_set(it->second.first.get_neuron_count()));
+		for(unsigned int entry_id = first_entry_id; entry_id < first_entry_id + entry_count; ++entry_id)
+			values->add_entry(&it->second.second->neuron_value_list[entry_id]->at(0));
+		res.insert(std::make_pair(it->first, std::make_pair(it->second.first, values)));
+	}
+
+	return res;
+}
+
+// All the weights of all the layers, in the order of layer names
+static std::vector<float> get_flat_weights(const nnforge::network_data& data)
+{
+	std::vector<float> res;
+	std::vector<std::string> data_layer_names = data.data_list.get_data_layer_name_list();
+	for(std::vector<std::string>::const_iterator it = data_layer_names.begin(); it != data_layer_names.end(); ++it)
+	{
+		nnforge::layer_data::const_ptr weights = data.data_list.get(*it);
+		for(nnforge::layer_data::const_iterator it2 = weights->begin(); it2 != weights->end(); ++it2)
+			res.insert(res.end(), it2->begin(), it2->end());
+	}
+
+	return res;
+}
+
+static std::vector<float> get_flat_gradients(const kernel_checker::gradient_map& gradients)
+{
+	std::vector<float> res;
+	for(kernel_checker::gradient_map::const_iterator it = gradients.begin(); it != gradients.end(); ++it)
+		for(std::vector<std::vector<float> >::const_iterator it2 = it->second.begin(); it2 != it->second.end(); ++it2)
+			res.insert(res.end(), it2->begin(), it2->end());
+
+	return res;
+}
+
+// Weights, gradients and momentum are kept in parameter arenas sharing the same layout, which the trainer updates segment by segment.
+// Weights after a step with each momentum type are compared with those computed here from the gradients of the plain step,
+// weight decay applies to the weight decay parts only, except for ADAM which applies it to all the parts
+static void check_parameter_arena(
+	kernel_checker& checker,
+	nnforge::random_generator& gen)
+{
+	const unsigned int entry_count = 4;
+	const unsigned int output_feature_map_count = 4;
+	const float learning_rate = 0.01F;
+	const float weight_decay = 0.05F;
+	nnforge::layer_configuration_specific input_configuration_specific = get_configuration(3, 8, 8, false);
+	nnforge::layer_configuration_specific output_configuration_specific(output_feature_map_count);
+	output_configuration_specific.dimension_sizes.resize(2, 1);
+	nnforge::network_schema::ptr schema = get_conv_net_schema(input_configuration_specific, 6, output_feature_map_count);
+	std::vector<std::string> error_source_layer_names(1, "error");
+
+	kernel_checker::input_map inputs;
+	inputs.insert(std::make_pair("images", std::make_pair(input_configuration_specific, kernel_checker::get_random_values(input_configuration_specific.get_neuron_count(), entry_count, -1.0F, 1.0F, gen))));
+	inputs.insert(std::make_pair("targets", std::make_pair(output_configuration_specific, kernel_checker::get_random_values(output_configuration_specific.get_neuron_count(), entry_count, -1.0F, 1.0F, gen))));
+	nnforge::network_data::ptr data = kernel_checker::get_random_data(*schema, gen);
+
+	{
+		nnforge::network_data::ptr arena_data = kernel_checker::get_data_copy(*schema, *data);
+		nnforge::parameter_arena::ptr arena = arena_data->move_to_arena();
+		bool is_aligned = ((reinterpret_cast<size_t>(arena->get_data()) % 64) == 0);
+		size_t part_elem_count = 0;
+		std::vector<std::string> data_layer_names = arena_data->data_list.get_data_layer_name_list();
+		for(std::vector<std::string>::const_iterator it = data_layer_names.begin(); it != data_layer_names.end(); ++it)
+		{
+			nnforge::layer_data::const_ptr weights = arena_data->data_list.get(*it);
+			for(unsigned int part_id = 0; part_id < static_cast<unsigned int>(weights->size()); ++part_id)
+			{
+				is_aligned = is_aligned && ((arena->get_offset(*it, part_id) % 16) == 0);
+				part_elem_count += weights->at(part_id).size();
+			}
+		}
+		float padding_sum = 0.0F;
+		for(size_t i = 0; i < arena->get_size(); ++i)
+			padding_sum += fabsf(arena->get_data()[i]);
+		for(std::vector<std::string>::const_iterator it = data_layer_names.begin(); it != data_layer_names.end(); ++it)
+		{
+			nnforge::layer_data::const_ptr weights = arena_data->data_list.get(*it);
+			for(nnforge::layer_data::const_iterator it2 = weights->begin(); it2 != weights->end(); ++it2)
+				for(nnforge::layer_data_part::const_iterator it3 = it2->begin(); it3 != it2->end(); ++it3)
+					padding_sum -= fabsf(*it3);
+		}
+		checker.report(
+			"parameter_arena layout",
+			arena->is_viewed_by(arena_data->data_list) && (arena_data->move_to_arena() == arena) && is_aligned && (arena->get_size() >= part_elem_count) && (fabsf(padding_sum) < 1.0e-3F),
+			(boost::format("%1% elements for %2% weights") % arena->get_size() % part_elem_count).str());
+		checker.check_values("parameter_arena values", get_flat_weights(*arena_data), get_flat_weights(*data), 0.0F);
+
+		// Copy gets its own storage
+		nnforge::network_data::ptr copy = kernel_checker::get_data_copy(*schema, *arena_data);
+		copy->data_list.get("conv")->at(0)[0] += 1.0F;
+		checker.check_values("parameter_arena copy", get_flat_weights(*arena_data), get_flat_weights(*data), 0.0F);
+
+		bool broken_before = arena_data->is_broken();
+		const float original_weight = arena_data->data_list.get("checked")->at(1)[0];
+		arena_data->data_list.get("checked")->at(1)[0] = std::numeric_limits<float>::quiet_NaN();
+		bool broken_nan = arena_data->is_broken();
+		arena_data->data_list.get("checked")->at(1)[0] = std::numeric_limits<float>::infinity();
+		bool broken_inf = arena_data->is_broken();
+		arena_data->data_list.get("checked")->at(1)[0] = original_weight;
+		checker.report("parameter_arena is_broken", !broken_before && broken_nan && broken_inf && !arena_data->is_broken(), "");
+	}
+
+	double error;
+	kernel_checker::gradient_map gradients = checker.run_backward(*schema, *data, inputs, error_source_layer_names, error);
+
+	std::vector<nnforge::training_momentum> momentum_list;
+	momentum_list.push_back(nnforge::training_momentum(nnforge::training_momentum::no_momentum));
+	momentum_list.push_back(nnforge::training_momentum(nnforge::training_momentum::vanilla_momentum, 0.9F));
+	momentum_list.push_back(nnforge::training_momentum(nnforge::training_momentum::nesterov_momentum, 0.9F));
+	momentum_list.push_back(nnforge::training_momentum(nnforge::training_momentum::adam_momentum, 0.9F, 0.999F));
+	const char * momentum_names[] = { "no_momentum", "vanilla", "nesterov", "adam" };
+	for(unsigned int momentum_id = 0; momentum_id < static_cast<unsigned int>(momentum_list.size()); ++momentum_id)
+	{
+		const nnforge::training_momentum& momentum = momentum_list[momentum_id];
+		nnforge::network_data::ptr momentum_data;
+		if (momentum.is_momentum_data())
+		{
+			momentum_data = nnforge::network_data::ptr(new nnforge::network_data(schema->get_layers()));
+			momentum_data->data_list.random_fill(-0.01F, 0.01F, gen);
+		}
+		nnforge::network_data::ptr momentum_data2;
+		if (momentum.is_momentum_data2())
+		{
+			momentum_data2 = nnforge::network_data::ptr(new nnforge::network_data(schema->get_layers()));
+			momentum_data2->data_list.random_fill(0.0F, 0.01F, gen);
+		}
+		std::vector<float> previous_upd = momentum_data ? get_flat_weights(*momentum_data) : std::vector<float>();
+		std::vector<float> previous_upd2 = momentum_data2 ? get_flat_weights(*momentum_data2) : std::vector<float>();
+
+		std::vector<float> expected_weights;
+		std::vector<float> expected_upd;
+		std::vector<float> expected_upd2;
+		unsigned int flat_id = 0;
+		for(kernel_checker::gradient_map::const_iterator it = gradients.begin(); it != gradients.end(); ++it)
+		{
+			std::set<unsigned int> weight_decay_part_id_set = schema->get_layer(it->first)->get_weight_decay_part_id_set();
+			nnforge::layer_data::const_ptr weights = data->data_list.get(it->first);
+			for(unsigned int part_id = 0; part_id < static_cast<unsigned int>(it->second.size()); ++part_id)
+			{
+				float actual_weight_decay = (weight_decay_part_id_set.find(part_id) == weight_decay_part_id_set.end()) ? 0.0F : weight_decay;
+				for(unsigned int weight_id = 0; weight_id < static_cast<unsigned int>(it->second[part_id].size()); ++weight_id, ++flat_id)
+				{
+					double w = weights->at(part_id)[weight_id];
+					double gr = -it->second[part_id][weight_id];
+					double upd;
+					switch (momentum.type)
+					{
+					case nnforge::training_momentum::no_momentum:
+						upd = learning_rate * (gr - w * actual_weight_decay);
+						break;
+					case nnforge::training_momentum::vanilla_momentum:
+						upd = previous_upd[flat_id] * momentum.momentum_val + learning_rate * (gr - w * actual_weight_decay);
+						expected_upd.push_back(static_cast<float>(upd));
+						break;
+					case nnforge::training_momentum::nesterov_momentum:
+						{
+							double new_upd = previous_upd[flat_id] * momentum.momentum_val + learning_rate * (gr - w * actual_weight_decay);
+							upd = (momentum.momentum_val + 1.0) * new_upd - momentum.momentum_val * previous_upd[flat_id];
+							expected_upd.push_back(static_cast<float>(new_upd));
+						}
+						break;
+					case nnforge::training_momentum::adam_momentum:
+						{
+							double total_gradient = gr - w * weight_decay;
+							double first_momentum = momentum.momentum_val * previous_upd[flat_id] + (1.0 - momentum.momentum_val) * total_gradient;
+							double second_momentum = momentum.momentum_val2 * previous_upd2[flat_id] + (1.0 - momentum.momentum_val2) * total_gradient * total_gradient;
+							// The first iteration
+							upd = learning_rate * (first_momentum / (1.0 - momentum.momentum_val)) / (sqrt(second_momentum / (1.0 - momentum.momentum_val2)) + 1.0e-8);
+							expected_upd.push_back(static_cast<float>(first_momentum));
+							expected_upd2.push_back(static_cast<float>(second_momentum));
+						}
+						break;
+					}
+					expected_weights.push_back(static_cast<float>(w + upd));
+				}
+			}
+		}
+
+		nnforge::network_data::ptr updated_data = checker.run_training_step(
+			*schema,
+			*data,
+			momentum_data,
+			momentum_data2,
+			inputs,
+			error_source_layer_names,
+			learning_rate,
+			weight_decay,
+			momentum,
+			nnforge::shared_memory_allreducer::ptr(),
+			error);
+		const std::string check_name = (boost::format("parameter_arena %1%") % momentum_names[momentum_id]).str();
+		checker.check_values(check_name + " weights", get_flat_weights(*updated_data), expected_weights, 1.0e-4F);
+		if (momentum_data)
+			checker.check_values(check_name + " momentum", get_flat_weights(*momentum_data), expected_upd, 1.0e-4F);
+		if (momentum_data2)
+			checker.check_values(check_name + " 2nd momentum", get_flat_weights(*momentum_data2), expected_upd2, 1.0e-4F);
+	}
+}
+
+// images -> conv -> two branches of convolution and ReLU -> concat -> 1x1 convolution -> concat with the images
+static nnforge::network_schema::ptr get_concat_schema(
+	const nnforge::layer_configuration_specific& input_configuration_specific,
+	unsigned int feature_map_count)
+{
+	std::vector<nnforge::layer::const_ptr> layer_list;
+	add_layer(layer_list, nnforge::layer::ptr(new nnforge::data_layer()), "images");
+	add_layer(layer_list, nnforge::layer::ptr(new nnforge::convolution_layer(get_sizes(1, 1, false), input_configuration_specific.feature_map_count, feature_map_count)), "conv", "images");
+	add_layer(layer_list, nnforge::layer::ptr(new nnforge::convolution_layer(get_sizes(3, 3, false), feature_map_count, feature_map_count, get_padding(1, 2, 2), get_padding(1, 2, 2))), "branch_a_conv", "conv");
+	add_layer(layer_list, nnforge::layer::ptr(new nnforge::rectified_linear_layer()), "branch_a", "branch_a_conv");
+	add_layer(layer_list, nnforge::layer::ptr(new nnforge::convolution_layer(get_sizes(5, 5, false), feature_map_count, feature_map_count, get_padding(2, 2, 2), get_padding(2, 2, 2))), "branch_b_conv", "conv");
+	add_layer(layer_list, nnforge::layer::ptr(new nnforge::rectified_linear_layer()), "branch_b", "branch_b_conv");
+	add_layer(layer_list, nnforge::layer::ptr(new nnforge::concat_layer()), "concat", "branch_a", "branch_b");
+	add_layer(layer_list, nnforge::layer::ptr(new nnforge::convolution_layer(get_sizes(1, 1, false), feature_map_count * 2, feature_map_count)), "mix", "concat");
+	add_layer(layer_list, nnforge::layer::ptr(new nnforge::concat_layer()), "checked", "mix", "images");
+
+	return nnforge::network_schema::ptr(new nnforge::network_schema(layer_list));
+}
+
+// Producers of the first concat write directly into their slices of its output when forward prop runs a single entry, the concat then copies nothing.
+// The second concat has the data layer among its inputs and copies them as usual. Output for each entry run alone is compared
+// with the one of the whole batch, for which inputs are copied into the concat output
+static void check_concat_aliasing(
+	kernel_checker& checker,
+	nnforge::random_generator& gen)
+{
+	const unsigned int entry_count = 4;
+	const unsigned int feature_map_count = 8;
+	nnforge::layer_configuration_specific input_configuration_specific = get_configuration(3, 12, 10, false);
+	nnforge::network_schema::ptr schema = get_concat_schema(input_configuration_specific, feature_map_count);
+
+	kernel_checker::input_map inputs;
+	inputs.insert(std::make_pair("images", std::make_pair(input_configuration_specific, kernel_checker::get_random_values(input_configuration_specific.get_neuron_count(), entry_count, -1.0F, 1.0F, gen))));
+	nnforge::network_data::ptr data = kernel_checker::get_random_data(*schema, gen);
+
+	std::vector<std::string> output_layer_names(1, "checked");
+	std::vector<float> values = checker.run_forward(*schema, *data, inputs, output_layer_names)["checked"];
+	const unsigned int output_neuron_count = static_cast<unsigned int>(values.size()) / entry_count;
+	for(unsigned int entry_id = 0; entry_id < entry_count; ++entry_id)
+	{
+		std::vector<float> entry_values = checker.run_forward(*schema, *data, get_entries(inputs, entry_id, 1), output_layer_names)["checked"];
+		checker.check_values(
+			(boost::format("concat aliasing entry %1%") % entry_id).str(),
+			entry_values,
+			std::vector<float>(values.begin() + entry_id * output_neuron_count, values.begin() + (entry_id + 1) * output_neuron_count),
+			0.0F);
+	}
+}
+
+#ifndef _WIN32
+static bool write_values(
+	int fd,
+	const std::vector<float>& values)
+{
+	const char * buf = reinterpret_cast<const char *>(&values[0]);
+	size_t remaining = values.size() * sizeof(float);
+	while (remaining > 0)
+	{
+		ssize_t written = write(fd, buf, remaining);
+		if (written <= 0)
+			return false;
+		buf += written;
+		remaining -= written;
+	}
+
+	return true;
+}
+
+// Reads until end of file
+static std::vector<float> read_values(int fd)
+{
+	std::vector<char> buf;
+	char chunk[4096];
+	ssize_t read_count;
+	while ((read_count = read(fd, chunk, sizeof(chunk))) > 0)
+		buf.insert(buf.end(), chunk, chunk + read_count);
+
+	std::vector<float> res(buf.size() / sizeof(float));
+	if (!res.empty())
+		memcpy(&res[0], &buf[0], res.size() * sizeof(float));
+	return res;
+}
+
+// Data-parallel training workers are forked processes, each one starts from its own random weights and trains a single step on its own entries.
+// Weights of worker 0 are broadcast and gradients are summed through the shared memory allreducer, so weights after the step,
+// and gradients derived from them, should be bitwise identical across the workers. Gradients should match those of a single process
+// training on the entries of all the workers, up to summation order. Small chunk makes collectives run in several chunks.
+// The check should be run before any OpenMP parallel region, OpenMP runtime is not usable in the forked process otherwise
+static void check_allreduce(
+	kernel_checker& checker,
+	nnforge::random_generator& gen)
+{
+	const unsigned int worker_count = 3;
+	const unsigned int entry_count = 2;
+	const unsigned int chunk_element_count = 1000;
+	const unsigned int output_feature_map_count = 4;
+	nnforge::layer_configuration_specific input_configuration_specific = get_configuration(3, 16, 16, false);
+	nnforge::layer_configuration_specific output_configuration_specific(output_feature_map_count);
+	output_configuration_specific.dimension_sizes.resize(2, 1);
+	nnforge::network_schema::ptr schema = get_conv_net_schema(input_configuration_specific, 8, output_feature_map_count);
+	std::vector<std::string> error_source_layer_names(1, "error");
+
+	kernel_checker::input_map inputs;
+	inputs.insert(std::make_pair("images", std::make_pair(input_configuration_specific, kernel_checker::get_random_values(input_configuration_specific.get_neuron_count(), entry_count * worker_count, -1.0F, 1.0F, gen))));
+	inputs.insert(std::make_pair("targets", std::make_pair(output_configuration_specific, kernel_checker::get_random_values(output_configuration_specific.get_neuron_count(), entry_count * worker_count, -1.0F, 1.0F, gen))));
+	std::vector<nnforge::network_data::ptr> worker_data;
+	for(unsigned int worker_rank = 0; worker_rank < worker_count; ++worker_rank)
+		worker_data.push_back(kernel_checker::get_random_data(*schema, gen));
+
+	// Each check gets its own segment
+	const std::string run_id = (boost::format("%1%") % getpid()).str();
+	std::vector<pid_t> worker_pids;
+	std::vector<int> worker_fds;
+	for(unsigned int worker_rank = 0; worker_rank < worker_count; ++worker_rank)
+	{
+		int fds[2];
+		if (pipe(fds) != 0)
+			throw std::runtime_error("Unable to create pipe for allreduce worker");
+		pid_t pid = fork();
+		if (pid < 0)
+			throw std::runtime_error("Unable to fork allreduce worker");
+		if (pid == 0)
+		{
+			close(fds[0]);
+			int exit_code = 0;
+			try
+			{
+				nnforge::shared_memory_allreducer::ptr allreducer(new nnforge::shared_memory_allreducer("nnforge_kernel_check", run_id, worker_count, worker_rank, 60.0F, chunk_element_count));
+				double error;
+				nnforge::network_data::ptr updated_data = checker.run_training_step(*schema, *worker_data[worker_rank], get_entries(inputs, worker_rank * entry_count, entry_count), error_source_layer_names, allreducer, error);
+				if (!write_values(fds[1], get_flat_weights(*updated_data)) || !write_values(fds[1], get_flat_gradients(kernel_checker::get_gradients(*worker_data[0], *updated_data))))
+					exit_code = 1;
+			}
+			catch (const std::exception& e)
+			{
+				std::cout << "Allreduce worker " << worker_rank << " exception caught: " << e.what() << std::endl;
+				exit_code = 1;
+			}
+			close(fds[1]);
+			_exit(exit_code);
+		}
+		close(fds[1]);
+		worker_pids.push_back(pid);
+		worker_fds.push_back(fds[0]);
+	}
+
+	std::vector<std::vector<float> > worker_results;
+	for(unsigned int worker_rank = 0; worker_rank < worker_count; ++worker_rank)
+	{
+		worker_results.push_back(read_values(worker_fds[worker_rank]));
+		close(worker_fds[worker_rank]);
+		int status;
+		waitpid(worker_pids[worker_rank], &status, 0);
+		checker.report((boost::format("allreduce worker %1% exit") % worker_rank).str(), WIFEXITED(status) && (WEXITSTATUS(status) == 0), (boost::format("status %1%") % status).str());
+	}
+
+	double error;
+	std::vector<float> reference_weights = get_flat_weights(*worker_data[0]);
+	std::vector<float> reference_gradients = get_flat_gradients(checker.run_backward(*schema, *worker_data[0], inputs, error_source_layer_names, error));
+	const unsigned int weight_count = static_cast<unsigned int>(reference_weights.size());
+	std::vector<float> gradients0;
+	for(unsigned int worker_rank = 0; worker_rank < worker_count; ++worker_rank)
+	{
+		const std::vector<float>& result = worker_results[worker_rank];
+		if (result.size() != weight_count * 2)
+		{
+			checker.report((boost::format("allreduce worker %1% results") % worker_rank).str(), false, (boost::format("%1% values while %2% expected") % result.size() % (weight_count * 2)).str());
+			continue;
+		}
+		std::vector<float> weights(result.begin(), result.begin() + weight_count);
+		std::vector<float> gradients(result.begin() + weight_count, result.end());
+		if (worker_rank == 0)
+		{
+			gradients0 = gradients;
+			checker.check_values("allreduce gradients against single process", gradients, reference_gradients, 1.0e-5F);
+		}
+		else
+		{
+			checker.check_values((boost::format("allreduce weights of worker %1% against worker 0") % worker_rank).str(), weights, std::vector<float>(worker_results[0].begin(), worker_results[0].begin() + weight_count), 0.0F);
+			checker.check_values((boost::format("allreduce gradients of worker %1% against worker 0") % worker_rank).str(), gradients, gradients0, 0.0F);
+		}
+	}
+
+	// Worker 0 is missing
+	try
+	{
+		nnforge::shared_memory_allreducer allreducer("nnforge_kernel_check", run_id + "_timeout", 2, 1, 0.5F, chunk_element_count);
+		checker.report("allreduce timeout", false, "no exception");
+	}
+	catch (const nnforge::neural_network_exception& e)
+	{
+		checker.report("allreduce timeout", true, e.what());
+	}
+}
+#endif
+
+static nnforge::factory_generator::ptr get_factory(
+	float max_global_memory_usage,
+	int openmp_thread_count,
+	bool parallel_branches,
+	bool recompute_activations,
+	bool bf16_activations)
+{
+	nnforge::plain::factory_generator_plain * factory = new nnforge::plain::factory_generator_plain(
+		max_global_memory_usage,
+		openmp_thread_count,
+		parallel_branches,
+		recompute_activations,
+		bf16_activations,
+		false,
+		false,
+		std::string(),
+		"none",
+		0.0F);
+	nnforge::factory_generator::ptr res(factory);
+	factory->initialize();
+
+	return res;
+}
+
+int main(int argc, char* argv[])
+{
+	try
+	{
+		nnforge::plain::plain::init();
+
+		int openmp_thread_count = (argc > 1) ? atoi(argv[1]) : 4;
+		kernel_checker checker(get_factory(0.5F, openmp_thread_count, false, false, false));
+		kernel_checker parallel_branches_checker(get_factory(0.5F, openmp_thread_count, true, false, false));
+		kernel_checker recompute_checker(get_factory(recompute_check_max_global_memory_usage, openmp_thread_count, false, true, false));
+		kernel_checker bf16_checker(get_factory(0.5F, openmp_thread_count, false, false, true));
+		nnforge::random_generator gen = nnforge::rnd::get_random_generator(48972);
+
+#ifndef _WIN32
+		check_allreduce(checker, gen);
+#endif
+		check_subsampling(checker, gen);
+		check_sparse_convolution(checker, gen);
+		check_softmax_loss(checker, gen);
+		check_local_contrast_subtractive(checker, gen);
+		check_linear_sampler(checker, gen);
+		check_prefix_sum(checker, gen);
+		check_cdf_max(checker, gen);
+		check_grouped_convolution(checker, gen);
+		check_fully_connected(checker, gen);
+		check_bf16_activations(checker, bf16_checker, gen);
+		check_parallel_branches(checker, parallel_branches_checker, gen);
+		check_recompute_activations(checker, recompute_checker, gen);
+		check_plan_cache(checker, gen);
+		check_parameter_arena(checker, gen);
+		check_concat_aliasing(checker, gen);
+		check_vector_math(checker);
+
+		std::cout << checker.get_failed_check_count() << " of " << checker.get_check_count() << " checks failed" << std::endl;
+		if (checker.get_failed_check_count() > 0)
+			return 1;
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << "Exception caught: " << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
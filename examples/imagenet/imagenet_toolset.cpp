@@ -390,7 +390,7 @@ nnforge::structured_data_reader::ptr imagenet_toolset::get_structured_reader(
 				training_target_image_height,
 				position_list));
 		}
-		return nnforge::structured_data_reader::ptr(new nnforge::structured_from_raw_data_reader(raw_reader, transformer));
+		return nnforge::structured_data_reader::ptr(new nnforge::structured_from_raw_data_reader(raw_reader, transformer, get_decoded_image_cache(dataset_name, layer_name)));
 	}
 	else
 		return toolset::get_structured_reader(dataset_name, layer_name, usage, in);
@@ -37,13 +37,11 @@ training_imagenet_raw_to_structured_data_transformer::~training_imagenet_raw_to_
 {
 }
 
-void training_imagenet_raw_to_structured_data_transformer::transform(
+void training_imagenet_raw_to_structured_data_transformer::transform_decoded(
 	unsigned int sample_id,
-	const std::vector<unsigned char>& raw_data,
+	const cv::Mat3b& original_image,
 	float * structured_data)
 {
-	cv::Mat3b original_image = cv::imdecode(raw_data, CV_LOAD_IMAGE_COLOR);
-
 	// Defaults to center crop
 	unsigned int source_crop_image_width = std::min(original_image.rows, original_image.cols);
 	unsigned int source_crop_image_height = source_crop_image_width;
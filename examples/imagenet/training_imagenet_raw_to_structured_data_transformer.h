@@ -16,12 +16,12 @@
 
 #pragma once
 
-#include <nnforge/raw_to_structured_data_transformer.h>
+#include <nnforge/image_raw_to_structured_data_transformer.h>
 #include <nnforge/rnd.h>
 
 #include <mutex>
 
-class training_imagenet_raw_to_structured_data_transformer : public nnforge::raw_to_structured_data_transformer
+class training_imagenet_raw_to_structured_data_transformer : public nnforge::image_raw_to_structured_data_transformer
 {
 public:
 	training_imagenet_raw_to_structured_data_transformer(
@@ -33,9 +33,9 @@ public:
 
 	virtual ~training_imagenet_raw_to_structured_data_transformer();
 
-	virtual void transform(
+	virtual void transform_decoded(
 		unsigned int sample_id,
-		const std::vector<unsigned char>& raw_data,
+		const cv::Mat3b& original_image,
 		float * structured_data);
 
 	virtual nnforge::layer_configuration_specific get_configuration() const;
@@ -35,13 +35,11 @@ validating_imagenet_raw_to_structured_data_transformer::~validating_imagenet_raw
 {
 }
 
-void validating_imagenet_raw_to_structured_data_transformer::transform(
+void validating_imagenet_raw_to_structured_data_transformer::transform_decoded(
 	unsigned int sample_id,
-	const std::vector<unsigned char>& raw_data,
+	const cv::Mat3b& original_image,
 	float * structured_data)
 {
-	cv::Mat3b original_image = cv::imdecode(raw_data, CV_LOAD_IMAGE_COLOR);
-
 	float scale = static_cast<float>(std::min(original_image.rows, original_image.cols)) / image_size;
 
 	unsigned int source_crop_image_width = std::min(static_cast<unsigned int>(static_cast<float>(target_image_width) * scale + 0.5F), static_cast<unsigned int>(original_image.cols));
@@ -77,3 +75,8 @@ unsigned int validating_imagenet_raw_to_structured_data_transformer::get_sample_
 {
 	return static_cast<unsigned int>(position_list.size());
 }
+
+bool validating_imagenet_raw_to_structured_data_transformer::is_deterministic() const
+{
+	return true;
+}
@@ -16,9 +16,9 @@
 
 #pragma once
 
-#include <nnforge/raw_to_structured_data_transformer.h>
+#include <nnforge/image_raw_to_structured_data_transformer.h>
 
-class validating_imagenet_raw_to_structured_data_transformer : public nnforge::raw_to_structured_data_transformer
+class validating_imagenet_raw_to_structured_data_transformer : public nnforge::image_raw_to_structured_data_transformer
 {
 public:
 	validating_imagenet_raw_to_structured_data_transformer(
@@ -29,15 +29,17 @@ public:
 
 	virtual ~validating_imagenet_raw_to_structured_data_transformer();
 
-	virtual void transform(
+	virtual void transform_decoded(
 		unsigned int sample_id,
-		const std::vector<unsigned char>& raw_data,
+		const cv::Mat3b& original_image,
 		float * structured_data);
 
 	virtual nnforge::layer_configuration_specific get_configuration() const;
 
 	virtual unsigned int get_sample_count() const;
 
+	virtual bool is_deterministic() const;
+
 protected:
 	unsigned int image_size;
 	unsigned int target_image_width;
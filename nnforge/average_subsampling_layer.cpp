@@ -301,4 +301,21 @@ namespace nnforge
 
 		return res;
 	}
+
+	bool average_subsampling_layer::get_window_geometry_list(std::vector<window_geometry>& window_geometry_list) const
+	{
+		window_geometry_list.clear();
+		if (entry_subsampling_size > 1)
+			return false;
+
+		for(unsigned int i = 0; i < subsampling_sizes.size(); ++i)
+		{
+			// Absolute subsampling size depends on the input size
+			if (!subsampling_sizes[i].is_relative())
+				return false;
+			window_geometry_list.push_back(window_geometry(subsampling_sizes[i].get_factor(), subsampling_sizes[i].get_factor()));
+		}
+
+		return true;
+	}
 }
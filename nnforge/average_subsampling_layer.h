@@ -83,6 +83,8 @@ namespace nnforge
 			const layer_configuration_specific& input_configuration_specific,
 			const layer_configuration_specific& output_configuration_specific) const;
 
+		virtual bool get_window_geometry_list(std::vector<window_geometry>& window_geometry_list) const;
+
 		static const std::string layer_type_name;
 
 		unsigned int get_subsampling_size(
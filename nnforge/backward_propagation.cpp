@@ -17,6 +17,7 @@
 #include "backward_propagation.h"
 
 #include "neural_network_exception.h"
+#include "shared_memory_allreducer.h"
 #include "profile_util.h"
 
 #include <boost/format.hpp>
@@ -234,6 +235,19 @@ namespace nnforge
 		throw neural_network_exception("get_max_flops not implemented");
 	}
 
+	bool backward_propagation::is_gradient_allreduce_supported() const
+	{
+		return false;
+	}
+
+	void backward_propagation::set_gradient_allreducer(std::shared_ptr<shared_memory_allreducer> gradient_allreducer)
+	{
+		if (gradient_allreducer && !is_gradient_allreduce_supported())
+			throw neural_network_exception("Gradient allreduce is not supported by this backward_propagation");
+
+		this->gradient_allreducer = gradient_allreducer;
+	}
+
 	std::ostream& operator<< (std::ostream& out, const backward_propagation::stat& val)
 	{
 		float gflops = val.flops_per_entry * static_cast<float>(val.entry_processed_count) / val.total_seconds * 1.0e-9F;
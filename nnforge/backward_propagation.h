@@ -36,6 +36,8 @@
 
 namespace nnforge
 {
+	class shared_memory_allreducer;
+
 	class backward_propagation
 	{
 	public:
@@ -68,6 +70,11 @@ namespace nnforge
 			training_momentum momentum,
 			unsigned int epoch_id);
 
+		// Data-parallel training: gradients are summed across workers before they are applied,
+		// and weights are taken from the worker with rank 0 at the start of each run.
+		// Each worker is supposed to read its own shard of the same size
+		void set_gradient_allreducer(std::shared_ptr<shared_memory_allreducer> gradient_allreducer);
+
 	protected:
 		backward_propagation(
 			const network_schema& schema,
@@ -100,6 +107,8 @@ namespace nnforge
 
 		virtual float get_max_flops() const;
 
+		virtual bool is_gradient_allreduce_supported() const;
+
 	protected:
 		network_schema::const_ptr schema;
 		network_action_schema::const_ptr action_schema;
@@ -116,6 +125,7 @@ namespace nnforge
 		std::map<layer_name_with_action, float> action_flops_per_entry;
 		float flops;
 		std::set<std::string> data_layer_names;
+		std::shared_ptr<shared_memory_allreducer> gradient_allreducer;
 
 	private:
 		void update_flops();
@@ -27,7 +27,8 @@ namespace nnforge
 		{
 			action_output_buffer = 0,
 			working_buffer = 1,
-			temporary_buffer = 2
+			temporary_buffer = 2,
+			packed_buffer = 3
 		};
 
 		buffer_lifetime() = default;
@@ -52,6 +53,8 @@ namespace nnforge
 				return "working";
 			case temporary_buffer:
 				return "temporary";
+			case packed_buffer:
+				return "packed";
 			default:
 				return "";
 			}
@@ -98,4 +98,9 @@ namespace nnforge
 
 		return res;
 	}
+
+	bool convert_to_polar_data_transformer::is_deterministic() const
+	{
+		return true;
+	}
 }
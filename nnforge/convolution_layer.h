@@ -69,6 +69,8 @@ namespace nnforge
 
 		virtual std::vector<std::string> get_parameter_strings() const;
 
+		virtual bool get_window_geometry_list(std::vector<window_geometry>& window_geometry_list) const;
+
 		static const std::string layer_type_name;
 
 	protected:
@@ -0,0 +1,299 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "convolution_pruner.h"
+
+#include "convolution_layer.h"
+#include "sparse_convolution_layer.h"
+#include "neural_network_exception.h"
+
+#include <algorithm>
+#include <cmath>
+#include <boost/format.hpp>
+
+namespace nnforge
+{
+	convolution_pruner::convolution_pruner(const std::map<std::string, unsigned int>& layer_name_to_connection_count_map)
+		: layer_name_to_connection_count_map(layer_name_to_connection_count_map)
+	{
+	}
+
+	std::vector<layer::const_ptr> convolution_pruner::get_pruned_layers(const network_schema& schema) const
+	{
+		std::vector<layer::const_ptr> res;
+
+		std::vector<layer::const_ptr> layers = schema.get_layers();
+		for(std::vector<layer::const_ptr>::const_iterator it = layers.begin(); it != layers.end(); ++it)
+		{
+			std::map<std::string, unsigned int>::const_iterator it2 = layer_name_to_connection_count_map.find((*it)->instance_name);
+			if (it2 != layer_name_to_connection_count_map.end())
+				res.push_back(create_sparse_layer(**it, it2->second));
+			else
+				res.push_back(*it);
+		}
+
+		return res;
+	}
+
+	network_data::ptr convolution_pruner::get_pruned_data(
+		const network_schema& schema,
+		const network_data& data) const
+	{
+		std::vector<layer::const_ptr> pruned_layers = get_pruned_layers(schema);
+		network_data::ptr res(new network_data(pruned_layers));
+
+		for(std::vector<layer::const_ptr>::const_iterator it = pruned_layers.begin(); it != pruned_layers.end(); ++it)
+		{
+			const std::string& layer_name = (*it)->instance_name;
+			layer_data::ptr dst_data = res->data_list.find(layer_name);
+			layer_data_custom::ptr dst_data_custom = res->data_custom_list.find(layer_name);
+
+			if (layer_name_to_connection_count_map.find(layer_name) == layer_name_to_connection_count_map.end())
+			{
+				if (dst_data)
+					*dst_data = *data.data_list.get(layer_name);
+				if (dst_data_custom)
+					*dst_data_custom = *data.data_custom_list.get(layer_name);
+				continue;
+			}
+
+			std::shared_ptr<const sparse_convolution_layer> layer_derived = std::dynamic_pointer_cast<const sparse_convolution_layer>(*it);
+			layer_data::const_ptr src_data = data.data_list.get(layer_name);
+
+			unsigned int input_feature_map_count = layer_derived->input_feature_map_count;
+			unsigned int output_feature_map_count = layer_derived->output_feature_map_count;
+			unsigned int window_elem_count = 1;
+			for(std::vector<unsigned int>::const_iterator it2 = layer_derived->window_sizes.begin(); it2 != layer_derived->window_sizes.end(); ++it2)
+				window_elem_count *= *it2;
+
+			// Dense weights are laid out as [output feature map][input feature map][window]
+			const layer_data_part& src_weights = src_data->at(0);
+			std::vector<std::pair<float, unsigned int> > norm_and_connection_list(output_feature_map_count * input_feature_map_count);
+			for(unsigned int connection_id = 0; connection_id < static_cast<unsigned int>(norm_and_connection_list.size()); ++connection_id)
+			{
+				float sum = 0.0F;
+				for(layer_data_part::const_iterator it2 = src_weights.begin() + connection_id * window_elem_count; it2 != src_weights.begin() + (connection_id + 1) * window_elem_count; ++it2)
+					sum += *it2 * *it2;
+				norm_and_connection_list[connection_id] = std::make_pair(sqrtf(sum), connection_id);
+			}
+
+			// Each output feature map keeps its strongest connection, the rest are the strongest ones overall
+			std::vector<bool> connection_matrix(output_feature_map_count * input_feature_map_count, false);
+			unsigned int connection_count = 0;
+			for(unsigned int output_feature_map_id = 0; output_feature_map_id < output_feature_map_count; ++output_feature_map_id)
+			{
+				std::vector<std::pair<float, unsigned int> >::const_iterator row_begin = norm_and_connection_list.begin() + output_feature_map_id * input_feature_map_count;
+				connection_matrix[std::max_element(row_begin, row_begin + input_feature_map_count)->second] = true;
+				++connection_count;
+			}
+			std::stable_sort(norm_and_connection_list.begin(), norm_and_connection_list.end(), std::greater<std::pair<float, unsigned int> >());
+			for(std::vector<std::pair<float, unsigned int> >::const_iterator it2 = norm_and_connection_list.begin(); (it2 != norm_and_connection_list.end()) && (connection_count < layer_derived->feature_map_connection_count); ++it2)
+			{
+				if (!connection_matrix[it2->second])
+				{
+					connection_matrix[it2->second] = true;
+					++connection_count;
+				}
+			}
+
+			sparse_convolution_layer::fill_data_custom(
+				*dst_data_custom,
+				connection_matrix,
+				output_feature_map_count,
+				input_feature_map_count);
+
+			// Sparse weights are laid out as [connection][window], connections being sorted by output and then input feature map
+			layer_data_part::iterator dst_weights_it = dst_data->at(0).begin();
+			for(unsigned int connection_id = 0; connection_id < static_cast<unsigned int>(connection_matrix.size()); ++connection_id)
+			{
+				if (connection_matrix[connection_id])
+					dst_weights_it = std::copy(src_weights.begin() + connection_id * window_elem_count, src_weights.begin() + (connection_id + 1) * window_elem_count, dst_weights_it);
+			}
+
+			if (layer_derived->bias)
+				std::copy(src_data->at(1).begin(), src_data->at(1).end(), dst_data->at(1).begin());
+		}
+
+		return res;
+	}
+
+	std::map<std::string, unsigned int> convolution_pruner::get_connection_counts_for_sparsity(
+		const network_schema& schema,
+		const std::vector<std::string>& layer_names,
+		float sparsity)
+	{
+		if ((sparsity < 0.0F) || (sparsity >= 1.0F))
+			throw neural_network_exception((boost::format("Invalid sparsity %1%, it should be in [0, 1) range") % sparsity).str());
+
+		return get_connection_counts(schema, layer_names, 1.0F - sparsity);
+	}
+
+	std::map<std::string, unsigned int> convolution_pruner::get_connection_counts_for_flops(
+		const network_schema& schema,
+		const std::vector<std::string>& layer_names,
+		float flops_ratio,
+		const std::map<std::string, layer_configuration_specific>& input_configuration_specific_map)
+	{
+		if ((flops_ratio <= 0.0F) || (flops_ratio > 1.0F))
+			throw neural_network_exception((boost::format("Invalid flops ratio %1%, it should be in (0, 1] range") % flops_ratio).str());
+
+		std::map<std::string, layer_configuration_specific> layer_config_map = get_layer_configuration_specific_map(schema, input_configuration_specific_map);
+		float dense_flops = get_forward_flops(schema.get_layers(), layer_config_map);
+		float target_flops = dense_flops * flops_ratio;
+
+		std::map<std::string, unsigned int> res = get_connection_counts(schema, layer_names, 0.0F);
+		float min_flops = get_forward_flops(convolution_pruner(res).get_pruned_layers(schema), layer_config_map);
+		if (min_flops > target_flops)
+			throw neural_network_exception((boost::format("Flops ratio %1% cannot be reached by pruning, the minimum is %2%") % flops_ratio % (min_flops / dense_flops)).str());
+
+		// Flops grow monotonically with the ratio of connections kept
+		float min_keep_ratio = 0.0F;
+		float max_keep_ratio = 1.0F;
+		for(int iteration = 0; iteration < 32; ++iteration)
+		{
+			float keep_ratio = (min_keep_ratio + max_keep_ratio) * 0.5F;
+			std::map<std::string, unsigned int> connection_counts = get_connection_counts(schema, layer_names, keep_ratio);
+			float flops = get_forward_flops(convolution_pruner(connection_counts).get_pruned_layers(schema), layer_config_map);
+			if (flops <= target_flops)
+			{
+				min_keep_ratio = keep_ratio;
+				res = connection_counts;
+			}
+			else
+			{
+				max_keep_ratio = keep_ratio;
+			}
+		}
+
+		return res;
+	}
+
+	std::vector<std::string> convolution_pruner::get_convolution_layer_names(
+		const network_schema& schema,
+		const std::vector<std::string>& layer_names)
+	{
+		std::vector<std::string> res;
+
+		if (layer_names.empty())
+		{
+			std::vector<layer::const_ptr> layers = schema.get_layers();
+			for(std::vector<layer::const_ptr>::const_iterator it = layers.begin(); it != layers.end(); ++it)
+				if ((*it)->get_type_name() == convolution_layer::layer_type_name)
+					res.push_back((*it)->instance_name);
+		}
+		else
+		{
+			for(std::vector<std::string>::const_iterator it = layer_names.begin(); it != layer_names.end(); ++it)
+			{
+				layer::const_ptr l = schema.get_layer(*it);
+				if (l->get_type_name() != convolution_layer::layer_type_name)
+					throw neural_network_exception((boost::format("Layer %1% of type %2% cannot be pruned, only %3% layers can") % *it % l->get_type_name() % convolution_layer::layer_type_name).str());
+				res.push_back(*it);
+			}
+		}
+
+		return res;
+	}
+
+	std::map<std::string, unsigned int> convolution_pruner::get_connection_counts(
+		const network_schema& schema,
+		const std::vector<std::string>& layer_names,
+		float keep_ratio)
+	{
+		std::map<std::string, unsigned int> res;
+		for(std::vector<std::string>::const_iterator it = layer_names.begin(); it != layer_names.end(); ++it)
+		{
+			std::shared_ptr<const convolution_layer> layer_derived = std::dynamic_pointer_cast<const convolution_layer>(schema.get_layer(*it));
+
+			// Sparse convolution layer requires connections to be at least as many as input and output feature maps
+			unsigned int dense_connection_count = layer_derived->input_feature_map_count * layer_derived->output_feature_map_count;
+			unsigned int min_connection_count = std::max(layer_derived->input_feature_map_count, layer_derived->output_feature_map_count);
+			unsigned int connection_count = static_cast<unsigned int>(static_cast<float>(dense_connection_count) * keep_ratio + 0.5F);
+
+			res.insert(std::make_pair(*it, std::min(std::max(connection_count, min_connection_count), dense_connection_count)));
+		}
+
+		return res;
+	}
+
+	layer::ptr convolution_pruner::create_sparse_layer(
+		const layer& l,
+		unsigned int connection_count)
+	{
+		const convolution_layer& layer_derived = dynamic_cast<const convolution_layer&>(l);
+
+		layer::ptr res(new sparse_convolution_layer(
+			layer_derived.window_sizes,
+			layer_derived.input_feature_map_count,
+			layer_derived.output_feature_map_count,
+			connection_count,
+			layer_derived.left_zero_padding,
+			layer_derived.right_zero_padding,
+			layer_derived.strides,
+			layer_derived.bias));
+		res->instance_name = layer_derived.instance_name;
+		res->input_layer_instance_names = layer_derived.input_layer_instance_names;
+
+		return res;
+	}
+
+	std::map<std::string, layer_configuration_specific> convolution_pruner::get_layer_configuration_specific_map(
+		const network_schema& schema,
+		const std::map<std::string, layer_configuration_specific>& input_configuration_specific_map)
+	{
+		std::map<std::string, layer_configuration_specific> res(input_configuration_specific_map);
+
+		// Layers depending on data layers missing in input_configuration_specific_map are skipped
+		std::vector<layer::const_ptr> layers_ordered = schema.get_layers_in_forward_propagation_order();
+		for(std::vector<layer::const_ptr>::const_iterator it = layers_ordered.begin(); it != layers_ordered.end(); ++it)
+		{
+			if ((*it)->input_layer_instance_names.empty() || (res.find((*it)->instance_name) != res.end()))
+				continue;
+
+			std::vector<layer_configuration_specific> input_configuration_specific_list;
+			for(std::vector<std::string>::const_iterator it2 = (*it)->input_layer_instance_names.begin(); it2 != (*it)->input_layer_instance_names.end(); ++it2)
+			{
+				std::map<std::string, layer_configuration_specific>::const_iterator it_inp = res.find(*it2);
+				if (it_inp == res.end())
+					break;
+				input_configuration_specific_list.push_back(it_inp->second);
+			}
+			if (input_configuration_specific_list.size() == (*it)->input_layer_instance_names.size())
+				res.insert(std::make_pair((*it)->instance_name, (*it)->get_output_layer_configuration_specific(input_configuration_specific_list)));
+		}
+
+		return res;
+	}
+
+	float convolution_pruner::get_forward_flops(
+		const std::vector<layer::const_ptr>& layers,
+		const std::map<std::string, layer_configuration_specific>& layer_config_map)
+	{
+		float res = 0.0F;
+		for(std::vector<layer::const_ptr>::const_iterator it = layers.begin(); it != layers.end(); ++it)
+		{
+			if ((*it)->input_layer_instance_names.empty() || (layer_config_map.find((*it)->instance_name) == layer_config_map.end()))
+				continue;
+
+			std::vector<layer_configuration_specific> input_configuration_specific_list;
+			for(std::vector<std::string>::const_iterator it2 = (*it)->input_layer_instance_names.begin(); it2 != (*it)->input_layer_instance_names.end(); ++it2)
+				input_configuration_specific_list.push_back(layer_config_map.find(*it2)->second);
+			res += (*it)->get_flops_per_entry(input_configuration_specific_list, layer_action(layer_action::forward));
+		}
+
+		return res;
+	}
+}
@@ -0,0 +1,88 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "network_schema.h"
+#include "network_data.h"
+#include "layer_configuration_specific.h"
+
+#include <vector>
+#include <string>
+#include <map>
+
+namespace nnforge
+{
+	// Converts dense convolution layers into sparse ones, keeping feature map connections with the largest weight norm
+	class convolution_pruner
+	{
+	public:
+		// Keys are instance names of convolution layers to prune,
+		// values are feature map connection counts to keep in them
+		convolution_pruner(const std::map<std::string, unsigned int>& layer_name_to_connection_count_map);
+
+		~convolution_pruner() = default;
+
+		// Returns layers of the schema with the pruned convolution layers replaced with sparse convolution ones
+		std::vector<layer::const_ptr> get_pruned_layers(const network_schema& schema) const;
+
+		// Converts data for the schema into data for the pruned layers, connections are chosen for this data individually
+		network_data::ptr get_pruned_data(
+			const network_schema& schema,
+			const network_data& data) const;
+
+		// Connection counts to keep in each of convolution layers to remove sparsity ratio of their connections
+		static std::map<std::string, unsigned int> get_connection_counts_for_sparsity(
+			const network_schema& schema,
+			const std::vector<std::string>& layer_names,
+			float sparsity);
+
+		// Connection counts to keep in each of convolution layers, pruned with the same ratio,
+		// for forward propagation of the schema to take flops_ratio of the dense one.
+		// Only layers computable from input_configuration_specific_map are counted
+		static std::map<std::string, unsigned int> get_connection_counts_for_flops(
+			const network_schema& schema,
+			const std::vector<std::string>& layer_names,
+			float flops_ratio,
+			const std::map<std::string, layer_configuration_specific>& input_configuration_specific_map);
+
+		// All convolution layers are pruned when layer_names is empty
+		static std::vector<std::string> get_convolution_layer_names(
+			const network_schema& schema,
+			const std::vector<std::string>& layer_names);
+
+	private:
+		static std::map<std::string, unsigned int> get_connection_counts(
+			const network_schema& schema,
+			const std::vector<std::string>& layer_names,
+			float keep_ratio);
+
+		static layer::ptr create_sparse_layer(
+			const layer& l,
+			unsigned int connection_count);
+
+		static std::map<std::string, layer_configuration_specific> get_layer_configuration_specific_map(
+			const network_schema& schema,
+			const std::map<std::string, layer_configuration_specific>& input_configuration_specific_map);
+
+		static float get_forward_flops(
+			const std::vector<layer::const_ptr>& layers,
+			const std::map<std::string, layer_configuration_specific>& layer_config_map);
+
+	private:
+		std::map<std::string, unsigned int> layer_name_to_connection_count_map;
+	};
+}
@@ -18,6 +18,11 @@
 
 #include "forward_propagation_cuda.h"
 
+#include "../grouped_convolution_layer.h"
+#include "../neural_network_exception.h"
+
+#include <boost/format.hpp>
+
 namespace nnforge
 {
 	namespace cuda
@@ -33,6 +38,12 @@ namespace nnforge
 			debug_state::ptr debug,
 			profile_state::ptr profile) const
 		{
+			// Grouped convolution is implemented in plain backend only
+			std::vector<layer::const_ptr> layers = schema.get_layers();
+			for(std::vector<layer::const_ptr>::const_iterator it = layers.begin(); it != layers.end(); ++it)
+				if ((*it)->get_type_name() == grouped_convolution_layer::layer_type_name)
+					throw neural_network_exception((boost::format("Layer %1% of type %2% is not supported by CUDA backend, run it with plain backend") % (*it)->instance_name % (*it)->get_type_name()).str());
+
 			return forward_propagation::ptr(new forward_propagation_cuda(schema, output_layer_names, debug, profile, cuda_config));
 		}
 	}
@@ -66,7 +66,7 @@ namespace nnforge
 		{
 			std::vector<cuda_linear_buffer_device::const_ptr> res;
 
-			for(std::vector<std::vector<float> >::const_iterator it = host_data->begin(); it != host_data->end(); ++it)
+			for(layer_data::const_iterator it = host_data->begin(); it != host_data->end(); ++it)
 			{
 				size_t buffer_size = it->size() * sizeof(float);
 				cuda_linear_buffer_device::ptr new_buf(new cuda_linear_buffer_device(buffer_size));
@@ -39,6 +39,10 @@ namespace nnforge
 
 		virtual unsigned int get_sample_count() const;
 
+		// The method should return true in case the output depends on input data and sample_id only,
+		// readers might then compute it once and re-use the result across epochs
+		virtual bool is_deterministic() const;
+
 	protected:
 		data_transformer() = default;
 
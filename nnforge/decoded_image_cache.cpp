@@ -0,0 +1,225 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "decoded_image_cache.h"
+
+#include "neural_network_exception.h"
+
+#include <opencv2/imgproc/imgproc.hpp>
+#include <boost/format.hpp>
+#include <algorithm>
+
+namespace nnforge
+{
+	const unsigned int decoded_image_cache::stripe_count = 16;
+
+	decoded_image_cache::stripe::stripe()
+		: clock_hand(0)
+		, used_bytes(0)
+	{
+	}
+
+	decoded_image_cache::decoded_image_cache(
+		size_t ram_budget_bytes,
+		size_t disk_budget_bytes,
+		const boost::filesystem::path& spill_file_path,
+		unsigned int max_side)
+		: ram_budget_bytes_per_stripe(ram_budget_bytes / stripe_count)
+		, disk_budget_bytes(disk_budget_bytes)
+		, spill_file_path(spill_file_path)
+		, max_side(max_side)
+		, disk_used_bytes(0)
+	{
+		for(unsigned int i = 0; i < stripe_count; ++i)
+			stripes.push_back(std::shared_ptr<stripe>(new stripe()));
+
+		if (disk_budget_bytes > 0)
+		{
+			spill_file.open(spill_file_path, std::ios_base::in | std::ios_base::out | std::ios_base::trunc | std::ios_base::binary);
+			if (!spill_file)
+				throw neural_network_exception((boost::format("Unable to create decoded image cache spill file %1%") % spill_file_path.string()).str());
+		}
+	}
+
+	decoded_image_cache::~decoded_image_cache()
+	{
+		if (spill_file.is_open())
+		{
+			spill_file.close();
+			boost::system::error_code ec;
+			boost::filesystem::remove(spill_file_path, ec);
+		}
+	}
+
+	size_t decoded_image_cache::get_size(const cv::Mat3b& image)
+	{
+		return static_cast<size_t>(image.rows) * image.cols * sizeof(cv::Vec3b);
+	}
+
+	bool decoded_image_cache::find(
+		unsigned int entry_id,
+		cv::Mat3b& image)
+	{
+		{
+			stripe& s = *stripes[entry_id % stripe_count];
+			std::lock_guard<std::mutex> lock(s.stripe_mutex);
+			std::map<unsigned int, size_t>::const_iterator it = s.entry_id_to_position_map.find(entry_id);
+			if (it != s.entry_id_to_position_map.end())
+			{
+				ram_entry& entry = s.clock[it->second];
+				entry.referenced = true;
+				// Reference counted, stays valid even if the entry is evicted later
+				image = entry.image;
+				return true;
+			}
+		}
+
+		if (disk_budget_bytes == 0)
+			return false;
+
+		{
+			std::lock_guard<std::mutex> lock(disk_mutex);
+			std::map<unsigned int, disk_entry>::const_iterator it = entry_id_to_disk_entry_map.find(entry_id);
+			if (it == entry_id_to_disk_entry_map.end())
+				return false;
+
+			image.create(it->second.rows, it->second.cols);
+			spill_file.seekg(it->second.offset);
+			spill_file.read(reinterpret_cast<char *>(image.data), get_size(image));
+			if (!spill_file)
+				throw neural_network_exception((boost::format("Error reading entry %1% from decoded image cache spill file %2%") % entry_id % spill_file_path.string()).str());
+		}
+
+		insert_to_ram(entry_id, image);
+
+		return true;
+	}
+
+	cv::Mat3b decoded_image_cache::insert(
+		unsigned int entry_id,
+		const cv::Mat3b& image)
+	{
+		cv::Mat3b image_to_store;
+		int larger_side = std::max(image.rows, image.cols);
+		if ((max_side > 0) && (larger_side > static_cast<int>(max_side)))
+		{
+			float scale = static_cast<float>(max_side) / static_cast<float>(larger_side);
+			cv::Size new_size(
+				std::max(static_cast<int>(static_cast<float>(image.cols) * scale + 0.5F), 1),
+				std::max(static_cast<int>(static_cast<float>(image.rows) * scale + 0.5F), 1));
+			cv::resize(image, image_to_store, new_size, 0.0, 0.0, cv::INTER_AREA);
+		}
+		else
+			image_to_store = image.isContinuous() ? image : image.clone();
+
+		insert_to_ram(entry_id, image_to_store);
+
+		return image_to_store;
+	}
+
+	void decoded_image_cache::insert_to_ram(
+		unsigned int entry_id,
+		const cv::Mat3b& image)
+	{
+		const size_t image_size = get_size(image);
+		std::vector<ram_entry> evicted_entries;
+
+		{
+			stripe& s = *stripes[entry_id % stripe_count];
+			std::lock_guard<std::mutex> lock(s.stripe_mutex);
+
+			// Another reader was faster
+			if (s.entry_id_to_position_map.find(entry_id) != s.entry_id_to_position_map.end())
+				return;
+
+			if (image_size <= ram_budget_bytes_per_stripe)
+			{
+				// CLOCK: entries referenced since the hand passed them get the second chance
+				while (s.used_bytes + image_size > ram_budget_bytes_per_stripe)
+				{
+					ram_entry& candidate = s.clock[s.clock_hand];
+					if (candidate.referenced)
+					{
+						candidate.referenced = false;
+						s.clock_hand = (s.clock_hand + 1) % s.clock.size();
+						continue;
+					}
+
+					evicted_entries.push_back(candidate);
+					s.used_bytes -= get_size(candidate.image);
+					s.entry_id_to_position_map.erase(candidate.entry_id);
+					if (s.clock_hand != s.clock.size() - 1)
+					{
+						candidate = s.clock.back();
+						s.entry_id_to_position_map[candidate.entry_id] = s.clock_hand;
+					}
+					s.clock.pop_back();
+					if (s.clock_hand >= s.clock.size())
+						s.clock_hand = 0;
+				}
+
+				ram_entry new_entry;
+				new_entry.entry_id = entry_id;
+				new_entry.image = image;
+				new_entry.referenced = true;
+				s.entry_id_to_position_map.insert(std::make_pair(entry_id, s.clock.size()));
+				s.clock.push_back(new_entry);
+				s.used_bytes += image_size;
+			}
+			else
+			{
+				// Doesn't fit RAM at all, goes directly to disk
+				ram_entry new_entry;
+				new_entry.entry_id = entry_id;
+				new_entry.image = image;
+				new_entry.referenced = false;
+				evicted_entries.push_back(new_entry);
+			}
+		}
+
+		for(std::vector<ram_entry>::const_iterator it = evicted_entries.begin(); it != evicted_entries.end(); ++it)
+			spill(*it);
+	}
+
+	void decoded_image_cache::spill(const ram_entry& entry)
+	{
+		if (disk_budget_bytes == 0)
+			return;
+
+		const size_t image_size = get_size(entry.image);
+
+		std::lock_guard<std::mutex> lock(disk_mutex);
+
+		if (entry_id_to_disk_entry_map.find(entry.entry_id) != entry_id_to_disk_entry_map.end())
+			return;
+
+		if (disk_used_bytes + image_size > disk_budget_bytes)
+			return;
+
+		disk_entry new_entry;
+		new_entry.offset = disk_used_bytes;
+		new_entry.rows = entry.image.rows;
+		new_entry.cols = entry.image.cols;
+
+		spill_file.seekp(new_entry.offset);
+		spill_file.write(reinterpret_cast<const char *>(entry.image.data), image_size);
+		if (!spill_file)
+			throw neural_network_exception((boost::format("Error writing entry %1% to decoded image cache spill file %2%") % entry.entry_id % spill_file_path.string()).str());
+
+		entry_id_to_disk_entry_map.insert(std::make_pair(entry.entry_id, new_entry));
+		disk_used_bytes += image_size;
+	}
+}
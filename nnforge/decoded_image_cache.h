@@ -0,0 +1,111 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <opencv2/core/core.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#include <vector>
+#include <map>
+#include <mutex>
+#include <memory>
+
+namespace nnforge
+{
+	// Keeps decoded images in RAM within the budget, images evicted from RAM are spilled to a local file within the disk budget.
+	// RAM part is split into stripes by entry ID, each with its own lock, budget and CLOCK eviction,
+	// so that concurrent readers rarely contend. The spill file is written once per image and is removed on destruction
+	class decoded_image_cache
+	{
+	public:
+		typedef std::shared_ptr<decoded_image_cache> ptr;
+
+		// disk_budget_bytes = 0 disables spilling, max_side = 0 disables downscaling
+		decoded_image_cache(
+			size_t ram_budget_bytes,
+			size_t disk_budget_bytes,
+			const boost::filesystem::path& spill_file_path,
+			unsigned int max_side);
+
+		~decoded_image_cache();
+
+		// The method returns false in case the image is neither in RAM nor on disk
+		bool find(
+			unsigned int entry_id,
+			cv::Mat3b& image);
+
+		// The image is downscaled first in case its larger side exceeds max_side. The image actually stored is returned
+		cv::Mat3b insert(
+			unsigned int entry_id,
+			const cv::Mat3b& image);
+
+	private:
+		struct ram_entry
+		{
+			unsigned int entry_id;
+			cv::Mat3b image;
+			bool referenced;
+		};
+
+		struct stripe
+		{
+			stripe();
+
+			std::mutex stripe_mutex;
+			std::vector<ram_entry> clock;
+			std::map<unsigned int, size_t> entry_id_to_position_map;
+			size_t clock_hand;
+			size_t used_bytes;
+		};
+
+		struct disk_entry
+		{
+			unsigned long long offset;
+			int rows;
+			int cols;
+		};
+
+		// Stores the image, which should be continuous, in RAM, evicting others if needed
+		void insert_to_ram(
+			unsigned int entry_id,
+			const cv::Mat3b& image);
+
+		void spill(const ram_entry& entry);
+
+		static size_t get_size(const cv::Mat3b& image);
+
+	private:
+		size_t ram_budget_bytes_per_stripe;
+		size_t disk_budget_bytes;
+		boost::filesystem::path spill_file_path;
+		unsigned int max_side;
+
+		std::vector<std::shared_ptr<stripe> > stripes;
+
+		std::mutex disk_mutex;
+		boost::filesystem::fstream spill_file;
+		std::map<unsigned int, disk_entry> entry_id_to_disk_entry_map;
+		unsigned long long disk_used_bytes;
+
+		static const unsigned int stripe_count;
+
+	private:
+		decoded_image_cache(const decoded_image_cache&) = delete;
+		decoded_image_cache& operator =(const decoded_image_cache&) = delete;
+	};
+}
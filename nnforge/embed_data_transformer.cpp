@@ -105,4 +105,9 @@ namespace nnforge
 
 		return res;
 	}
+
+	bool embed_data_transformer::is_deterministic() const
+	{
+		return true;
+	}
 }
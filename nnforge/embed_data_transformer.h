@@ -40,6 +40,8 @@ namespace nnforge
 
 		virtual layer_configuration_specific get_transformed_configuration(const layer_configuration_specific& original_config) const;
 
+		virtual bool is_deterministic() const;
+
 	protected:
 		std::vector<unsigned int> output_sizes;
 		std::vector<unsigned int> left_padding;
@@ -120,4 +120,9 @@ namespace nnforge
 
 		return res;
 	}
+
+	bool extract_data_transformer::is_deterministic() const
+	{
+		return true;
+	}
 }
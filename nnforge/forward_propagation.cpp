@@ -18,13 +18,17 @@
 
 #include "neural_network_exception.h"
 #include "profile_util.h"
+#include "structured_data_bunch_pad_reader.h"
 
 #include <boost/format.hpp>
 #include <chrono>
 #include <boost/filesystem/fstream.hpp>
+#include <boost/core/null_deleter.hpp>
 
 namespace nnforge
 {
+	const unsigned int forward_propagation::default_plan_cache_size = 8;
+
 	forward_propagation::forward_propagation(
 		const network_schema& schema,
 		const std::vector<std::string>& output_layer_names,
@@ -33,6 +37,8 @@ namespace nnforge
 		: output_layer_names(output_layer_names)
 		, debug(debug)
 		, profile(profile)
+		, plan_cache_size(default_plan_cache_size)
+		, shape_bucketing(false)
 	{
 		if (output_layer_names.empty())
 			throw neural_network_exception("No output layers specified for forward_propagation");
@@ -97,14 +103,9 @@ namespace nnforge
 	void forward_propagation::set_input_configuration_specific(const std::map<std::string, layer_configuration_specific>& input_configuration_specific_map)
 	{
 		bool same_input_config = true;
-		std::map<std::string, layer_configuration_specific> input_configuration_specific_map_filtered;
-		for(std::map<std::string, layer_configuration_specific>::const_iterator it = input_configuration_specific_map.begin(); it != input_configuration_specific_map.end(); ++it)
+		std::map<std::string, layer_configuration_specific> input_configuration_specific_map_filtered = filter_input_configuration_specific_map(input_configuration_specific_map);
+		for(std::map<std::string, layer_configuration_specific>::const_iterator it = input_configuration_specific_map_filtered.begin(); it != input_configuration_specific_map_filtered.end(); ++it)
 		{
-			if (data_layer_names.find(it->first) == data_layer_names.end())
-				continue;
-
-			input_configuration_specific_map_filtered.insert(*it);
-
 			std::map<std::string, layer_configuration_specific>::const_iterator it2 = layer_config_map.find(it->first);
 			if ((it2 == layer_config_map.end()) || (it->second != it2->second))
 			{
@@ -114,6 +115,23 @@ namespace nnforge
 		if (same_input_config)
 			return;
 
+		save_current_plan();
+		current_input_configuration_specific_map = input_configuration_specific_map_filtered;
+
+		for(std::list<cached_plan>::iterator it = plan_cache.begin(); it != plan_cache.end(); ++it)
+		{
+			if (it->input_configuration_specific_map == input_configuration_specific_map_filtered)
+			{
+				plan_cache.splice(plan_cache.begin(), plan_cache, it);
+				const cached_plan& current_plan = plan_cache.front();
+				layer_config_map = current_plan.layer_config_map;
+				action_flops_per_entry = current_plan.action_flops_per_entry;
+				flops = current_plan.flops;
+				restore_plan(current_plan.backend_plan);
+				return;
+			}
+		}
+
 		layer_config_map = schema->get_layer_configuration_specific_map(input_configuration_specific_map_filtered);
 
 		if (debug->is_debug())
@@ -125,6 +143,101 @@ namespace nnforge
 		update_flops();
 
 		layer_config_map_modified();
+
+		if (plan_cache_size > 0)
+		{
+			plan::ptr backend_plan = save_plan();
+			if (backend_plan)
+			{
+				cached_plan new_plan;
+				new_plan.input_configuration_specific_map = input_configuration_specific_map_filtered;
+				new_plan.layer_config_map = layer_config_map;
+				new_plan.action_flops_per_entry = action_flops_per_entry;
+				new_plan.flops = flops;
+				new_plan.backend_plan = backend_plan;
+				plan_cache.push_front(new_plan);
+				while (plan_cache.size() > plan_cache_size)
+					plan_cache.pop_back();
+			}
+		}
+	}
+
+	std::map<std::string, layer_configuration_specific> forward_propagation::filter_input_configuration_specific_map(const std::map<std::string, layer_configuration_specific>& input_configuration_specific_map) const
+	{
+		std::map<std::string, layer_configuration_specific> res;
+		for(std::map<std::string, layer_configuration_specific>::const_iterator it = input_configuration_specific_map.begin(); it != input_configuration_specific_map.end(); ++it)
+		{
+			if (data_layer_names.find(it->first) != data_layer_names.end())
+				res.insert(*it);
+		}
+		return res;
+	}
+
+	void forward_propagation::save_current_plan()
+	{
+		if (plan_cache.empty() || (plan_cache.front().input_configuration_specific_map != current_input_configuration_specific_map))
+			return;
+
+		plan_cache.front().backend_plan = save_plan();
+	}
+
+	std::map<std::string, layer_configuration_specific> forward_propagation::get_bucket_configuration_specific_map(const std::map<std::string, layer_configuration_specific>& input_configuration_specific_map) const
+	{
+		std::map<std::string, layer_configuration_specific> res;
+		size_t best_neuron_count = 0;
+		for(std::list<cached_plan>::const_iterator it = plan_cache.begin(); it != plan_cache.end(); ++it)
+		{
+			if (it->input_configuration_specific_map.size() != input_configuration_specific_map.size())
+				continue;
+
+			bool fits = true;
+			size_t neuron_count = 0;
+			for(std::map<std::string, layer_configuration_specific>::const_iterator it2 = input_configuration_specific_map.begin(); (it2 != input_configuration_specific_map.end()) && fits; ++it2)
+			{
+				std::map<std::string, layer_configuration_specific>::const_iterator it3 = it->input_configuration_specific_map.find(it2->first);
+				if ((it3 == it->input_configuration_specific_map.end())
+					|| (it3->second.feature_map_count != it2->second.feature_map_count)
+					|| (it3->second.dimension_sizes.size() != it2->second.dimension_sizes.size()))
+				{
+					fits = false;
+					break;
+				}
+				for(unsigned int i = 0; i < static_cast<unsigned int>(it2->second.dimension_sizes.size()); ++i)
+					if (it3->second.dimension_sizes[i] < it2->second.dimension_sizes[i])
+						fits = false;
+				neuron_count += it3->second.get_neuron_count();
+			}
+
+			if (fits && (res.empty() || (neuron_count < best_neuron_count)))
+			{
+				res = it->input_configuration_specific_map;
+				best_neuron_count = neuron_count;
+			}
+		}
+
+		return res;
+	}
+
+	void forward_propagation::set_plan_cache_size(unsigned int plan_cache_size)
+	{
+		this->plan_cache_size = plan_cache_size;
+		while (plan_cache.size() > plan_cache_size)
+			plan_cache.pop_back();
+	}
+
+	void forward_propagation::set_shape_bucketing(bool shape_bucketing)
+	{
+		this->shape_bucketing = shape_bucketing;
+	}
+
+	forward_propagation::plan::ptr forward_propagation::save_plan() const
+	{
+		return plan::ptr();
+	}
+
+	void forward_propagation::restore_plan(plan::ptr backend_plan)
+	{
+		throw neural_network_exception("restore_plan not implemented");
 	}
 
 	void forward_propagation::update_flops()
@@ -141,8 +254,29 @@ namespace nnforge
 		forward_propagation::stat res;
 
 		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
-		set_input_configuration_specific(reader.get_config_map());
-		structured_data_bunch_reader::ptr narrow_reader = reader.get_narrow_reader(data_layer_names);
+		structured_data_bunch_reader::ptr pad_reader;
+		std::map<std::string, layer_configuration_specific> input_configuration_specific_map = reader.get_config_map();
+		if (shape_bucketing)
+		{
+			std::map<std::string, layer_configuration_specific> input_configuration_specific_map_filtered = filter_input_configuration_specific_map(input_configuration_specific_map);
+			bool cached = false;
+			for(std::list<cached_plan>::const_iterator it = plan_cache.begin(); (it != plan_cache.end()) && !cached; ++it)
+				cached = (it->input_configuration_specific_map == input_configuration_specific_map_filtered);
+			if (!cached)
+			{
+				std::map<std::string, layer_configuration_specific> bucket_configuration_specific_map = get_bucket_configuration_specific_map(input_configuration_specific_map_filtered);
+				if (!bucket_configuration_specific_map.empty())
+				{
+					pad_reader = structured_data_bunch_reader::ptr(new structured_data_bunch_pad_reader(
+						structured_data_bunch_reader::ptr(&reader, boost::null_deleter()),
+						bucket_configuration_specific_map));
+					input_configuration_specific_map = pad_reader->get_config_map();
+				}
+			}
+		}
+		structured_data_bunch_reader& current_reader = pad_reader ? *pad_reader : reader;
+		set_input_configuration_specific(input_configuration_specific_map);
+		structured_data_bunch_reader::ptr narrow_reader = current_reader.get_narrow_reader(data_layer_names);
 		res.flops_per_entry = flops;
 		std::vector<std::string> data_layer_name_list(data_layer_names.begin(), data_layer_names.end());
 		std::map<std::string, layer_configuration_specific> output_config_map;
@@ -150,7 +284,7 @@ namespace nnforge
 			output_config_map[*it] = layer_config_map[*it];
 		writer.set_config_map(output_config_map);
 		std::map<layer_name_with_action, float> action_seconds;
-		actual_run(narrow_reader ? *narrow_reader : reader, writer, res.entry_processed_count, action_seconds);
+		actual_run(narrow_reader ? *narrow_reader : current_reader, writer, res.entry_processed_count, action_seconds);
 		std::chrono::duration<float> sec = std::chrono::high_resolution_clock::now() - start;
 		res.total_seconds = sec.count();
 
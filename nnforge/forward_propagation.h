@@ -31,6 +31,7 @@
 #include <string>
 #include <set>
 #include <map>
+#include <list>
 #include <memory>
 #include <ostream>
 
@@ -65,6 +66,25 @@ namespace nnforge
 
 		bool is_schema_with_weights() const;
 
+		// Plans for up to plan_cache_size most recently used input configurations are kept,
+		// so switching back to one of them doesn't require re-planning. 0 disables the cache
+		void set_plan_cache_size(unsigned int plan_cache_size);
+
+		// When enabled, input of the shape not in the plan cache is zero-padded (at the end of each dimension)
+		// to the smallest cached shape which is at least as large in every dimension, if any.
+		// Output is then that of the padded input
+		void set_shape_bucketing(bool shape_bucketing);
+
+	protected:
+		// Backend state derived from layer_config_map
+		class plan
+		{
+		public:
+			typedef std::shared_ptr<plan> ptr;
+
+			virtual ~plan() = default;
+		};
+
 	protected:
 		forward_propagation(
 			const network_schema& schema,
@@ -91,6 +111,13 @@ namespace nnforge
 
 		virtual float get_max_flops() const;
 
+		// The method returns the snapshot of the backend state derived from layer_config_map,
+		// empty pointer (default) means the backend doesn't support plan caching
+		virtual plan::ptr save_plan() const;
+
+		// The method is called instead of layer_config_map_modified when the configuration is restored from the plan cache
+		virtual void restore_plan(plan::ptr backend_plan);
+
 	protected:
 		network_schema::const_ptr schema;
 		network_action_schema::ptr action_schema;
@@ -105,8 +132,35 @@ namespace nnforge
 		std::set<std::string> data_layer_names;
 
 	private:
+		struct cached_plan
+		{
+			std::map<std::string, layer_configuration_specific> input_configuration_specific_map;
+			std::map<std::string, layer_configuration_specific> layer_config_map;
+			std::map<layer_name_with_action, float> action_flops_per_entry;
+			float flops;
+			plan::ptr backend_plan;
+		};
+
 		void update_flops();
 
+		// Updates the cache entry of the current configuration, the backend might have modified its state since it was planned
+		void save_current_plan();
+
+		// Returns empty map if there is no suitable cached shape
+		std::map<std::string, layer_configuration_specific> get_bucket_configuration_specific_map(const std::map<std::string, layer_configuration_specific>& input_configuration_specific_map) const;
+
+		std::map<std::string, layer_configuration_specific> filter_input_configuration_specific_map(const std::map<std::string, layer_configuration_specific>& input_configuration_specific_map) const;
+
+	private:
+		unsigned int plan_cache_size;
+		bool shape_bucketing;
+		std::map<std::string, layer_configuration_specific> current_input_configuration_specific_map;
+		// Most recently used first
+		std::list<cached_plan> plan_cache;
+
+		static const unsigned int default_plan_cache_size;
+
+	private:
 		forward_propagation() = delete;
 		forward_propagation(const forward_propagation&) = delete;
 		forward_propagation& operator =(const forward_propagation&) = delete;
@@ -0,0 +1,35 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "image_raw_to_structured_data_transformer.h"
+
+#include <opencv2/highgui/highgui.hpp>
+
+namespace nnforge
+{
+	void image_raw_to_structured_data_transformer::transform(
+		unsigned int sample_id,
+		const std::vector<unsigned char>& raw_data,
+		float * structured_data)
+	{
+		transform_decoded(sample_id, decode(raw_data), structured_data);
+	}
+
+	cv::Mat3b image_raw_to_structured_data_transformer::decode(const std::vector<unsigned char>& raw_data)
+	{
+		return cv::imdecode(raw_data, CV_LOAD_IMAGE_COLOR);
+	}
+}
@@ -0,0 +1,49 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "raw_to_structured_data_transformer.h"
+
+#include <opencv2/core/core.hpp>
+
+namespace nnforge
+{
+	// Transformer for raw data which is an encoded (JPEG, PNG, ...) color image.
+	// Decoding is separated from the rest of transformation so that readers can cache decoded images across epochs
+	class image_raw_to_structured_data_transformer : public raw_to_structured_data_transformer
+	{
+	public:
+		typedef std::shared_ptr<image_raw_to_structured_data_transformer> ptr;
+
+		virtual ~image_raw_to_structured_data_transformer() = default;
+
+		virtual void transform(
+			unsigned int sample_id,
+			const std::vector<unsigned char>& raw_data,
+			float * structured_data);
+
+		virtual void transform_decoded(
+			unsigned int sample_id,
+			const cv::Mat3b& image,
+			float * structured_data) = 0;
+
+		static cv::Mat3b decode(const std::vector<unsigned char>& raw_data);
+
+	protected:
+		image_raw_to_structured_data_transformer() = default;
+	};
+}
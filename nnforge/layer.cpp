@@ -35,12 +35,7 @@ namespace nnforge
 
 	layer_data::ptr layer::create_layer_data() const
 	{
-		layer_data::ptr res(new layer_data());
-
-		data_config dc = get_data_config();
-		res->resize(dc.size());
-		for(unsigned int i = 0; i < dc.size(); ++i)
-			(*res)[i].resize(dc[i]);
+		layer_data::ptr res(new layer_data(get_data_config()));
 
 		return res;
 	}
@@ -152,6 +147,12 @@ namespace nnforge
 		return 1;
 	}
 
+	bool layer::get_window_geometry_list(std::vector<window_geometry>& window_geometry_list) const
+	{
+		window_geometry_list.clear();
+		return true;
+	}
+
 	std::string layer::get_string_for_average_data(
 		const layer_configuration_specific& config,
 		const std::vector<double>& data) const
@@ -22,6 +22,7 @@
 #include "rnd.h"
 #include "layer_data_configuration.h"
 #include "tiling_factor.h"
+#include "window_geometry.h"
 #include "layer_action.h"
 
 #include <ostream>
@@ -97,6 +98,11 @@ namespace nnforge
 
 		virtual tiling_factor get_tiling_factor() const;
 
+		// The method fills window_geometry_list with one entry per spatial dimension,
+		// empty list (default) means each output position depends on the same input position only.
+		// The method returns false in case output might depend on input positions arbitrarily far away
+		virtual bool get_window_geometry_list(std::vector<window_geometry>& window_geometry_list) const;
+
 		virtual std::string get_string_for_average_data(
 			const layer_configuration_specific& config,
 			const std::vector<double>& data) const;
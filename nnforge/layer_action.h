@@ -30,7 +30,8 @@ namespace nnforge
 			backward_data = 1,
 			backward_weights = 2,
 			backward_data_and_weights = 3,
-			update_weights = 4
+			update_weights = 4,
+			recompute_forward = 5
 		};
 
 		layer_action() = default;
@@ -71,6 +72,10 @@ namespace nnforge
 			{
 				return "update_weights";
 			}
+			else if (at == recompute_forward)
+			{
+				return "recompute_forward";
+			}
 			else
 			{
 				return (boost::format("backward_data_%1%") % backprop_index).str();
@@ -16,10 +16,84 @@
 
 #include "layer_data.h"
 
+#include "neural_network_exception.h"
+
 #include <algorithm>
+#include <boost/format.hpp>
 
 namespace nnforge
 {
+	layer_data::layer_data(const std::vector<unsigned int>& weight_counts)
+	{
+		allocate(weight_counts);
+	}
+
+	layer_data::layer_data(const layer_data& other)
+		: std::vector<layer_data_part>()
+	{
+		allocate(other.get_weight_counts());
+		for(unsigned int i = 0; i < static_cast<unsigned int>(size()); ++i)
+			std::copy(other[i].begin(), other[i].end(), at(i).begin());
+	}
+
+	layer_data& layer_data::operator =(const layer_data& other)
+	{
+		if (this == &other)
+			return *this;
+
+		if (get_weight_counts() != other.get_weight_counts())
+			allocate(other.get_weight_counts());
+		for(unsigned int i = 0; i < static_cast<unsigned int>(size()); ++i)
+			std::copy(other[i].begin(), other[i].end(), at(i).begin());
+
+		return *this;
+	}
+
+	std::vector<unsigned int> layer_data::get_weight_counts() const
+	{
+		std::vector<unsigned int> res;
+		for(const_iterator it = begin(); it != end(); ++it)
+			res.push_back(static_cast<unsigned int>(it->size()));
+
+		return res;
+	}
+
+	void layer_data::allocate(const std::vector<unsigned int>& weight_counts)
+	{
+		size_t total_weight_count = 0;
+		for(std::vector<unsigned int>::const_iterator it = weight_counts.begin(); it != weight_counts.end(); ++it)
+			total_weight_count += *it;
+
+		std::vector<float>(total_weight_count, 0.0F).swap(own_storage);
+		storage_owner.reset();
+
+		clear();
+		size_t offset = 0;
+		for(std::vector<unsigned int>::const_iterator it = weight_counts.begin(); it != weight_counts.end(); ++it)
+		{
+			push_back(layer_data_part(own_storage.empty() ? 0 : &own_storage[0] + offset, *it));
+			offset += *it;
+		}
+	}
+
+	void layer_data::move_to(
+		const std::vector<float *>& part_storage_list,
+		std::shared_ptr<void> storage_owner)
+	{
+		if (part_storage_list.size() != size())
+			throw neural_network_exception((boost::format("Storage is provided for %1% parts of layer data while it has %2%") % part_storage_list.size() % size()).str());
+
+		for(unsigned int i = 0; i < static_cast<unsigned int>(size()); ++i)
+		{
+			if (part_storage_list[i] != at(i).begin())
+				std::copy(at(i).begin(), at(i).end(), part_storage_list[i]);
+			at(i).ptr = part_storage_list[i];
+		}
+
+		std::vector<float>().swap(own_storage);
+		this->storage_owner = storage_owner;
+	}
+
 	void layer_data::write(std::ostream& binary_stream_to_write_to) const
 	{
 		unsigned int weight_vector_count = static_cast<unsigned int>(size());
@@ -30,7 +104,7 @@ namespace nnforge
 			unsigned int weight_count = static_cast<unsigned int>(at(i).size());
 			binary_stream_to_write_to.write(reinterpret_cast<const char*>(&weight_count), sizeof(weight_count));
 
-			binary_stream_to_write_to.write(reinterpret_cast<const char*>(&(*at(i).begin())), sizeof(float) * weight_count);
+			binary_stream_to_write_to.write(reinterpret_cast<const char*>(at(i).begin()), sizeof(float) * weight_count);
 		}
 	}
 
@@ -39,21 +113,27 @@ namespace nnforge
 		unsigned int weight_vector_count;
 		binary_stream_to_read_from.read(reinterpret_cast<char*>(&weight_vector_count), sizeof(weight_vector_count));
 
-		resize(weight_vector_count);
+		// Weight counts precede the values of each part, so the values are read into temporary buffers first
+		std::vector<std::vector<float> > part_values(weight_vector_count);
+		std::vector<unsigned int> weight_counts(weight_vector_count);
 		for(unsigned int i = 0; i < weight_vector_count; ++i)
 		{
 			unsigned int weight_count;
 			binary_stream_to_read_from.read(reinterpret_cast<char*>(&weight_count), sizeof(weight_count));
+			weight_counts[i] = weight_count;
 
-			at(i).resize(weight_count);
-
-			binary_stream_to_read_from.read(reinterpret_cast<char*>(&(*at(i).begin())), sizeof(float) * weight_count);
+			part_values[i].resize(weight_count);
+			binary_stream_to_read_from.read(reinterpret_cast<char*>(part_values[i].empty() ? 0 : &part_values[i][0]), sizeof(float) * weight_count);
 		}
+
+		allocate(weight_counts);
+		for(unsigned int i = 0; i < weight_vector_count; ++i)
+			std::copy(part_values[i].begin(), part_values[i].end(), at(i).begin());
 	}
 
 	void layer_data::fill(float val)
 	{
-		for(std::vector<std::vector<float> >::iterator it = begin(); it != end(); ++it)
+		for(iterator it = begin(); it != end(); ++it)
 			std::fill(it->begin(), it->end(), val);
 	}
 
@@ -62,11 +142,11 @@ namespace nnforge
 		float max,
 		random_generator& gen)
 	{
-		for(std::vector<std::vector<float> >::iterator it = begin(); it != end(); ++it)
+		for(iterator it = begin(); it != end(); ++it)
 		{
 			std::uniform_real_distribution<float> nd(min, max);
 
-			for(std::vector<float>::iterator it2 = it->begin(); it2 != it->end(); ++it2)
+			for(layer_data_part::iterator it2 = it->begin(); it2 != it->end(); ++it2)
 				*it2 = nd(gen);
 		}
 	}
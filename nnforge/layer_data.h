@@ -17,6 +17,7 @@
 #pragma once
 
 #include "rnd.h"
+#include "layer_data_part.h"
 
 #include <vector>
 #include <ostream>
@@ -25,14 +26,44 @@
 
 namespace nnforge
 {
-	class layer_data : public std::vector<std::vector<float> >
+	// Weights of the layer, split into weight vectors (parts). Values of all the parts are stored contiguously,
+	// either in layer_data itself or in the storage they are moved to by move_to (parameter_arena)
+	class layer_data : private std::vector<layer_data_part>
 	{
 	public:
 		typedef std::shared_ptr<layer_data> ptr;
 		typedef std::shared_ptr<const layer_data> const_ptr;
 
+		using std::vector<layer_data_part>::iterator;
+		using std::vector<layer_data_part>::const_iterator;
+		using std::vector<layer_data_part>::begin;
+		using std::vector<layer_data_part>::end;
+		using std::vector<layer_data_part>::size;
+		using std::vector<layer_data_part>::empty;
+		using std::vector<layer_data_part>::operator [];
+		using std::vector<layer_data_part>::at;
+		using std::vector<layer_data_part>::front;
+		using std::vector<layer_data_part>::back;
+
 		layer_data() = default;
 
+		// Weights are zero
+		layer_data(const std::vector<unsigned int>& weight_counts);
+
+		// Values are copied into own storage
+		layer_data(const layer_data& other);
+
+		// Values are copied into the current storage if the weight counts match, into new own storage otherwise
+		layer_data& operator =(const layer_data& other);
+
+		std::vector<unsigned int> get_weight_counts() const;
+
+		// Values of part i are moved to part_storage_list[i], the part views it afterwards.
+		// storage_owner is kept alive while the parts view the storage
+		void move_to(
+			const std::vector<float *>& part_storage_list,
+			std::shared_ptr<void> storage_owner);
+
 		// The stream should be created with std::ios_base::binary flag
 		void write(std::ostream& binary_stream_to_write_to) const;
 
@@ -45,5 +76,13 @@ namespace nnforge
 			float min,
 			float max,
 			random_generator& gen);
+
+	private:
+		// Parts are set to view own storage, values are zero
+		void allocate(const std::vector<unsigned int>& weight_counts);
+
+	private:
+		std::vector<float> own_storage;
+		std::shared_ptr<void> storage_owner;
 	};
 }
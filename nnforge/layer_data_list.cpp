@@ -95,10 +95,10 @@ namespace nnforge
 
 			for(layer_data::const_iterator it2 = it->second->begin(); it2 != it->second->end(); it2++)
 			{
-				const std::vector<float>& data = *it2;
+				const layer_data_part& data = *it2;
 
 				double sum = 0.0;
-				for(std::vector<float>::const_iterator it3 = data.begin(); it3 != data.end(); ++it3)
+				for(layer_data_part::const_iterator it3 = data.begin(); it3 != data.end(); ++it3)
 					sum += static_cast<float>(fabsf(*it3));
 				float avg = static_cast<float>(sum) / static_cast<float>(data.size());
 
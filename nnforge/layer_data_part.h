@@ -0,0 +1,91 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace nnforge
+{
+	// Weights of a single weight vector of layer_data, a view into the storage of the layer_data
+	// or into parameter_arena the storage is moved to. The part stays the same object when the storage is moved,
+	// so references to it remain valid, pointers to the values don't.
+	// Copies view the same storage, copy values with std::copy
+	class layer_data_part
+	{
+	public:
+		typedef float value_type;
+		typedef float * iterator;
+		typedef const float * const_iterator;
+
+		layer_data_part(
+			float * ptr,
+			size_t elem_count)
+			: ptr(ptr)
+			, elem_count(elem_count)
+		{
+		}
+
+		iterator begin()
+		{
+			return ptr;
+		}
+
+		const_iterator begin() const
+		{
+			return ptr;
+		}
+
+		iterator end()
+		{
+			return ptr + elem_count;
+		}
+
+		const_iterator end() const
+		{
+			return ptr + elem_count;
+		}
+
+		size_t size() const
+		{
+			return elem_count;
+		}
+
+		bool empty() const
+		{
+			return (elem_count == 0);
+		}
+
+		float& operator [](size_t i)
+		{
+			return ptr[i];
+		}
+
+		const float& operator [](size_t i) const
+		{
+			return ptr[i];
+		}
+
+	private:
+		float * ptr;
+		size_t elem_count;
+
+		friend class layer_data;
+
+	private:
+		layer_data_part& operator =(const layer_data_part&) = delete;
+	};
+}
@@ -94,4 +94,10 @@ namespace nnforge
 			return 0.0F;
 		}
 	}
+
+	bool linear_sampler_layer::get_window_geometry_list(std::vector<window_geometry>& window_geometry_list) const
+	{
+		window_geometry_list.clear();
+		return false;
+	}
 }
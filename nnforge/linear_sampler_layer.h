@@ -41,6 +41,8 @@ namespace nnforge
 
 		virtual std::string get_type_name() const;
 
+		virtual bool get_window_geometry_list(std::vector<window_geometry>& window_geometry_list) const;
+
 		static const std::string layer_type_name;
 	};
 }
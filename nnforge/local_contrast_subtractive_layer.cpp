@@ -144,7 +144,8 @@ namespace nnforge
 	{
 		unsigned int window_dimension_size = window_sizes[dimension_id];
 
-		if (window_dimension_size <= 1)
+		// Window of size 2 has the same single weight as window of size 1, zero deviation would make it NaN
+		if (window_dimension_size <= 2)
 			return -1.0F;
 
 		unsigned int m = (window_dimension_size - 1) >> 1;
@@ -218,4 +219,17 @@ namespace nnforge
 			return 0.0F;
 		}
 	}
+
+	bool local_contrast_subtractive_layer::get_window_geometry_list(std::vector<window_geometry>& window_geometry_list) const
+	{
+		window_geometry_list.clear();
+		for(unsigned int i = 0; i < window_weights_list.size(); ++i)
+		{
+			// Window is mirrored at the borders, which stays within the window
+			unsigned int half_window = static_cast<unsigned int>(window_weights_list[i].size());
+			window_geometry_list.push_back(window_geometry(half_window * 2 - 1, 1, half_window - 1));
+		}
+
+		return true;
+	}
 }
@@ -45,6 +45,8 @@ namespace nnforge
 
 		virtual void read_proto(const void * layer_proto);
 
+		virtual bool get_window_geometry_list(std::vector<window_geometry>& window_geometry_list) const;
+
 		static const std::string layer_type_name;
 
 	private:
@@ -0,0 +1,135 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "materialized_structured_data_reader.h"
+
+#include "neural_network_exception.h"
+
+#include <boost/format.hpp>
+#include <cstring>
+
+namespace nnforge
+{
+	materialized_structured_data_reader::materialized_structured_data_reader(
+		structured_data_reader::ptr original_reader,
+		size_t ram_limit_bytes,
+		const boost::filesystem::path& spill_file_path)
+		: original_reader(original_reader)
+		, config(original_reader->get_configuration())
+		, neuron_count(config.get_neuron_count())
+		, spill_file_path(spill_file_path)
+	{
+		if (!original_reader->is_deterministic())
+			throw neural_network_exception("Cannot materialize non-deterministic reader");
+
+		int original_entry_count = original_reader->get_entry_count();
+		if (original_entry_count < 0)
+			throw neural_network_exception("Cannot materialize reader with unknown entry count");
+		entry_count = static_cast<unsigned int>(original_entry_count);
+
+		materialized_list.resize(entry_count, false);
+
+		size_t total_bytes = static_cast<size_t>(entry_count) * neuron_count * sizeof(float);
+		if (total_bytes <= ram_limit_bytes)
+		{
+			data_in_ram.resize(static_cast<size_t>(entry_count) * neuron_count);
+		}
+		else
+		{
+			spill_file.open(spill_file_path, std::ios_base::in | std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+			if (!spill_file.is_open())
+				throw neural_network_exception((boost::format("Cannot open materialized data file %1%") % spill_file_path.string()).str());
+			spill_file.exceptions(std::ostream::eofbit | std::ostream::failbit | std::ostream::badbit);
+		}
+	}
+
+	materialized_structured_data_reader::~materialized_structured_data_reader()
+	{
+		if (spill_file.is_open())
+		{
+			spill_file.close();
+			boost::system::error_code ec;
+			boost::filesystem::remove(spill_file_path, ec);
+		}
+	}
+
+	bool materialized_structured_data_reader::read(
+		unsigned int entry_id,
+		float * data)
+	{
+		if (entry_id >= entry_count)
+			return false;
+
+		{
+			std::lock_guard<std::mutex> lock(materialized_mutex);
+			if (materialized_list[entry_id])
+			{
+				if (spill_file.is_open())
+				{
+					spill_file.seekg(static_cast<std::istream::off_type>(entry_id) * static_cast<std::istream::off_type>(sizeof(float) * neuron_count), std::ios::beg);
+					spill_file.read(reinterpret_cast<char*>(data), sizeof(float) * neuron_count);
+				}
+				else
+				{
+					memcpy(data, &data_in_ram[static_cast<size_t>(entry_id) * neuron_count], sizeof(float) * neuron_count);
+				}
+				return true;
+			}
+		}
+
+		if (!original_reader->read(entry_id, data))
+			return false;
+
+		{
+			std::lock_guard<std::mutex> lock(materialized_mutex);
+			if (!materialized_list[entry_id])
+			{
+				if (spill_file.is_open())
+				{
+					spill_file.seekp(static_cast<std::ostream::off_type>(entry_id) * static_cast<std::ostream::off_type>(sizeof(float) * neuron_count), std::ios::beg);
+					spill_file.write(reinterpret_cast<const char*>(data), sizeof(float) * neuron_count);
+				}
+				else
+				{
+					memcpy(&data_in_ram[static_cast<size_t>(entry_id) * neuron_count], data, sizeof(float) * neuron_count);
+				}
+				materialized_list[entry_id] = true;
+			}
+		}
+
+		return true;
+	}
+
+	layer_configuration_specific materialized_structured_data_reader::get_configuration() const
+	{
+		return config;
+	}
+
+	int materialized_structured_data_reader::get_entry_count() const
+	{
+		return static_cast<int>(entry_count);
+	}
+
+	raw_data_writer::ptr materialized_structured_data_reader::get_writer(std::shared_ptr<std::ostream> out) const
+	{
+		throw std::runtime_error("get_writer not implemented for materialized_structured_data_reader");
+	}
+
+	bool materialized_structured_data_reader::is_deterministic() const
+	{
+		return true;
+	}
+}
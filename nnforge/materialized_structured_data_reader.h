@@ -0,0 +1,72 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "structured_data_reader.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#include <vector>
+#include <mutex>
+#include <memory>
+
+namespace nnforge
+{
+	// The reader computes each entry of the deterministic original reader once and serves it from memory afterwards.
+	// In case the whole data doesn't fit into RAM limit it is kept in a local file, which is removed on destruction
+	class materialized_structured_data_reader : public structured_data_reader
+	{
+	public:
+		typedef std::shared_ptr<materialized_structured_data_reader> ptr;
+
+		materialized_structured_data_reader(
+			structured_data_reader::ptr original_reader,
+			size_t ram_limit_bytes,
+			const boost::filesystem::path& spill_file_path);
+
+		virtual ~materialized_structured_data_reader();
+
+		virtual bool read(
+			unsigned int entry_id,
+			float * data);
+
+		virtual layer_configuration_specific get_configuration() const;
+
+		virtual int get_entry_count() const;
+
+		virtual raw_data_writer::ptr get_writer(std::shared_ptr<std::ostream> out) const;
+
+		virtual bool is_deterministic() const;
+
+	protected:
+		structured_data_reader::ptr original_reader;
+		layer_configuration_specific config;
+		unsigned int neuron_count;
+		unsigned int entry_count;
+
+		std::mutex materialized_mutex;
+		std::vector<bool> materialized_list;
+		std::vector<float> data_in_ram;
+		boost::filesystem::path spill_file_path;
+		boost::filesystem::fstream spill_file;
+
+	private:
+		materialized_structured_data_reader(const materialized_structured_data_reader&) = delete;
+		materialized_structured_data_reader& operator =(const materialized_structured_data_reader&) = delete;
+	};
+}
@@ -335,4 +335,16 @@ namespace nnforge
 
 		return res;
 	}
+
+	bool max_subsampling_layer::get_window_geometry_list(std::vector<window_geometry>& window_geometry_list) const
+	{
+		window_geometry_list.clear();
+		if (tiling || (entry_subsampling_size > 1))
+			return false;
+
+		for(unsigned int i = 0; i < subsampling_sizes.size(); ++i)
+			window_geometry_list.push_back(window_geometry(subsampling_sizes[i], strides[i]));
+
+		return true;
+	}
 }
@@ -21,6 +21,7 @@
 #include <boost/uuid/uuid_io.hpp>
 #include <boost/format.hpp>
 #include <numeric> 
+#include <cstring>
 
 namespace nnforge
 {
@@ -85,4 +86,36 @@ namespace nnforge
 				gen);
 		}
 	}
+
+	parameter_arena::ptr network_data::move_to_arena()
+	{
+		if (!arena || !arena->is_viewed_by(data_list))
+			arena = parameter_arena::create(data_list);
+
+		return arena;
+	}
+
+	bool network_data::is_broken() const
+	{
+		if (arena && arena->is_viewed_by(data_list))
+			return arena->is_broken();
+
+		std::vector<std::string> layer_names = data_list.get_data_layer_name_list();
+		for(std::vector<std::string>::const_iterator it = layer_names.begin(); it != layer_names.end(); ++it)
+		{
+			layer_data::ptr dt = data_list.get(*it);
+			for(layer_data::const_iterator it2 = dt->begin(); it2 != dt->end(); ++it2)
+			{
+				for(layer_data_part::const_iterator it3 = it2->begin(); it3 != it2->end(); ++it3)
+				{
+					unsigned int bits;
+					memcpy(&bits, &(*it3), sizeof(bits));
+					if ((bits & 0x7FFFFFFFU) >= 0x7F800000U)
+						return true;
+				}
+			}
+		}
+
+		return false;
+	}
 }
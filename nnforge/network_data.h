@@ -22,6 +22,7 @@
 #include "rnd.h"
 #include "layer_data_list.h"
 #include "layer_data_custom_list.h"
+#include "parameter_arena.h"
 
 #include <vector>
 #include <string>
@@ -61,10 +62,20 @@ namespace nnforge
 			const std::vector<layer::const_ptr>& layer_list,
 			random_generator& gen);
 
+		// Moves weights to the single arena, layer data parts view it afterwards.
+		// The arena is reused if the parts still view it, otherwise it is recreated
+		parameter_arena::ptr move_to_arena();
+
+		// Returns true if any weight is NaN or infinite
+		bool is_broken() const;
+
 	public:
 		layer_data_list data_list;
 		layer_data_custom_list data_custom_list;
 
+	private:
+		parameter_arena::ptr arena;
+
 	private:
 		static const boost::uuids::uuid data_guid;
 	};
@@ -61,9 +61,9 @@ namespace nnforge
 					if ((previous_layer->get_type_name() == convolution_layer::layer_type_name) || (previous_layer->get_type_name() == sparse_convolution_layer::layer_type_name))
 					{
 						layer_data::ptr data = data_list.find(previous_layer->instance_name);
-						std::vector<float>::iterator it_start = data->at(0).begin();
-						std::vector<float>::iterator it_end = data->at(0).end();
-						for(std::vector<float>::iterator it = it_start; it != it_end; ++it)
+						layer_data_part::iterator it_start = data->at(0).begin();
+						layer_data_part::iterator it_end = data->at(0).end();
+						for(layer_data_part::iterator it = it_start; it != it_end; ++it)
 							*it *= weight_multiplier;
 					}
 				}
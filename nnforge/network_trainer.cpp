@@ -151,7 +151,7 @@ namespace nnforge
 					return true;
 			}
 		}
-		return false;
+		return state.data->is_broken();
 	}
 
 	float network_trainer::get_global_learning_rate(unsigned int epoch) const
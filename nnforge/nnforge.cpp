@@ -58,5 +58,6 @@ namespace nnforge
 		layer_factory::get_singleton().register_layer(layer::ptr(new batch_norm_layer(1)));
 		layer_factory::get_singleton().register_layer(layer::ptr(new affine_grid_generator_layer(std::vector<unsigned int>(2, 1))));
 		layer_factory::get_singleton().register_layer(layer::ptr(new linear_sampler_layer()));
+		layer_factory::get_singleton().register_layer(layer::ptr(new grouped_convolution_layer(std::vector<unsigned int>(1, 1), 1, 1, 1)));
 	}
 }
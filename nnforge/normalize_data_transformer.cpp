@@ -104,4 +104,9 @@ namespace nnforge
 			mul_add_list.push_back(std::make_pair(normalizer.feature_map_param(i).mul(), normalizer.feature_map_param(i).add()));
 		}
 	}
+
+	bool normalize_data_transformer::is_deterministic() const
+	{
+		return true;
+	}
 }
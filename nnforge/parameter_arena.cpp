@@ -0,0 +1,150 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "parameter_arena.h"
+
+#include "neural_network_exception.h"
+
+#include <boost/format.hpp>
+#include <cstring>
+
+namespace nnforge
+{
+	const size_t parameter_arena::part_alignment_elem_count = 64 / sizeof(float);
+
+	parameter_arena::parameter_arena(const layer_data_list& data)
+	{
+		size_t total_size = 0;
+		std::vector<std::string> layer_names = data.get_data_layer_name_list();
+		for(std::vector<std::string>::const_iterator it = layer_names.begin(); it != layer_names.end(); ++it)
+		{
+			layer_data::ptr dt = data.get(*it);
+			std::vector<part_info>& part_info_list = instance_name_to_part_info_list_map.insert(std::make_pair(*it, std::vector<part_info>())).first->second;
+			for(layer_data::const_iterator it2 = dt->begin(); it2 != dt->end(); ++it2)
+			{
+				part_info info;
+				info.offset = total_size;
+				info.size = it2->size();
+				part_info_list.push_back(info);
+				total_size += (info.size + part_alignment_elem_count - 1) / part_alignment_elem_count * part_alignment_elem_count;
+			}
+		}
+
+		buffer.resize(total_size, 0.0F);
+	}
+
+	parameter_arena::ptr parameter_arena::create(layer_data_list& data)
+	{
+		parameter_arena::ptr res(new parameter_arena(data));
+
+		for(std::map<std::string, std::vector<part_info> >::const_iterator it = res->instance_name_to_part_info_list_map.begin(); it != res->instance_name_to_part_info_list_map.end(); ++it)
+		{
+			std::vector<float *> part_storage_list;
+			for(std::vector<part_info>::const_iterator it2 = it->second.begin(); it2 != it->second.end(); ++it2)
+				part_storage_list.push_back(res->get_data() + it2->offset);
+			data.get(it->first)->move_to(part_storage_list, res);
+		}
+
+		return res;
+	}
+
+	bool parameter_arena::is_viewed_by(const layer_data_list& data) const
+	{
+		std::vector<std::string> layer_names = data.get_data_layer_name_list();
+		if (layer_names.size() != instance_name_to_part_info_list_map.size())
+			return false;
+
+		for(std::vector<std::string>::const_iterator it = layer_names.begin(); it != layer_names.end(); ++it)
+		{
+			std::map<std::string, std::vector<part_info> >::const_iterator part_info_list_it = instance_name_to_part_info_list_map.find(*it);
+			if (part_info_list_it == instance_name_to_part_info_list_map.end())
+				return false;
+			const std::vector<part_info>& part_info_list = part_info_list_it->second;
+			layer_data::ptr dt = data.get(*it);
+			if (dt->size() != part_info_list.size())
+				return false;
+			for(unsigned int part_id = 0; part_id < static_cast<unsigned int>(part_info_list.size()); ++part_id)
+			{
+				const layer_data_part& part = dt->at(part_id);
+				if ((part.begin() != get_data() + part_info_list[part_id].offset) || (part.size() != part_info_list[part_id].size))
+					return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool parameter_arena::is_same_layout(const parameter_arena& other) const
+	{
+		if (instance_name_to_part_info_list_map.size() != other.instance_name_to_part_info_list_map.size())
+			return false;
+
+		for(std::map<std::string, std::vector<part_info> >::const_iterator it = instance_name_to_part_info_list_map.begin(), it_other = other.instance_name_to_part_info_list_map.begin(); it != instance_name_to_part_info_list_map.end(); ++it, ++it_other)
+		{
+			if ((it->first != it_other->first) || (it->second.size() != it_other->second.size()))
+				return false;
+			for(unsigned int part_id = 0; part_id < static_cast<unsigned int>(it->second.size()); ++part_id)
+				if ((it->second[part_id].offset != it_other->second[part_id].offset) || (it->second[part_id].size != it_other->second[part_id].size))
+					return false;
+		}
+
+		return true;
+	}
+
+	size_t parameter_arena::get_offset(
+		const std::string& instance_name,
+		unsigned int part_id) const
+	{
+		std::map<std::string, std::vector<part_info> >::const_iterator it = instance_name_to_part_info_list_map.find(instance_name);
+		if (it == instance_name_to_part_info_list_map.end())
+			throw neural_network_exception((boost::format("Layer %1% is not in parameter_arena") % instance_name).str());
+		if (part_id >= it->second.size())
+			throw neural_network_exception((boost::format("Part %1% is out of range for layer %2% in parameter_arena") % part_id % instance_name).str());
+
+		return it->second[part_id].offset;
+	}
+
+	bool parameter_arena::is_broken() const
+	{
+		// Integer compare, -ffast-math folds away floating point checks for NaN and infinity
+		const float * data = get_data();
+		const size_t elem_count = get_size();
+		unsigned int non_finite_count = 0;
+		for(size_t i = 0; i < elem_count; ++i)
+		{
+			unsigned int bits;
+			memcpy(&bits, data + i, sizeof(bits));
+			non_finite_count += ((bits & 0x7FFFFFFFU) >= 0x7F800000U) ? 1 : 0;
+		}
+
+		return (non_finite_count > 0);
+	}
+
+	float * parameter_arena::get_data()
+	{
+		return buffer.empty() ? 0 : &buffer[0];
+	}
+
+	const float * parameter_arena::get_data() const
+	{
+		return buffer.empty() ? 0 : &buffer[0];
+	}
+
+	size_t parameter_arena::get_size() const
+	{
+		return buffer.size();
+	}
+}
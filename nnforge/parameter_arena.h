@@ -0,0 +1,81 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "layer_data_list.h"
+
+#include <vector>
+#include <map>
+#include <string>
+#include <memory>
+#include <boost/align/aligned_allocator.hpp>
+
+namespace nnforge
+{
+	// Single aligned storage for all the weights of layer_data_list, layer data parts view it.
+	// Layers follow in the order of get_data_layer_name_list, parts of each layer are consecutive and start at cache line boundary,
+	// padding between them is zero. Lists with the same layers and part sizes, weights, gradients and momentum, get the same layout,
+	// so whole-model operations - collectives, weight updates, checks - run as single contiguous passes over the arenas
+	class parameter_arena
+	{
+	public:
+		typedef std::shared_ptr<parameter_arena> ptr;
+
+		// Values of data are moved to the new arena, layer data parts view it afterwards and keep it alive
+		static ptr create(layer_data_list& data);
+
+		// Returns true if all the parts of data view this arena at the offsets of its layout
+		bool is_viewed_by(const layer_data_list& data) const;
+
+		bool is_same_layout(const parameter_arena& other) const;
+
+		// Offset of the part in elements. The method throws exception in case there is no such part
+		size_t get_offset(
+			const std::string& instance_name,
+			unsigned int part_id) const;
+
+		// Returns true if any value is NaN or infinite
+		bool is_broken() const;
+
+		float * get_data();
+
+		const float * get_data() const;
+
+		// The number of elements, including padding between parts
+		size_t get_size() const;
+
+	private:
+		parameter_arena(const layer_data_list& data);
+
+	private:
+		struct part_info
+		{
+			size_t offset;
+			size_t size;
+		};
+
+	private:
+		std::map<std::string, std::vector<part_info> > instance_name_to_part_info_list_map;
+		std::vector<float, boost::alignment::aligned_allocator<float, 64> > buffer;
+
+		static const size_t part_alignment_elem_count;
+
+	private:
+		parameter_arena(const parameter_arena&) = delete;
+		parameter_arena& operator =(const parameter_arena&) = delete;
+	};
+}
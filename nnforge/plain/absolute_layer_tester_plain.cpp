@@ -44,7 +44,7 @@ namespace nnforge
 			float * const out_it = *output_buffer;
 			const float * const in_it = *input_buffers[0];
 
-			#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
+			#pragma omp parallel for default(none) schedule(runtime) num_threads(plain_config->openmp_thread_count)
 			for(int i = 0; i < elem_count; ++i)
 				*(out_it + i) = fabs(*(in_it + i));
 		}
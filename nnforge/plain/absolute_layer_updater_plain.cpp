@@ -46,7 +46,7 @@ namespace nnforge
 			float * const out_it = *output_buffer;
 			const float * const in_it = *input_buffers[0];
 
-			#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
+			#pragma omp parallel for default(none) schedule(runtime) num_threads(plain_config->openmp_thread_count)
 			for(int i = 0; i < elem_count; ++i)
 				*(out_it + i) = fabs(*(in_it + i));
 		}
@@ -77,7 +77,7 @@ namespace nnforge
 
 			if (add_update_to_destination)
 			{
-				#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
+				#pragma omp parallel for default(none) schedule(runtime) num_threads(plain_config->openmp_thread_count)
 				for(int i = 0; i < elem_count; ++i)
 				{
 					float input_val = *(in_it + i);
@@ -87,7 +87,7 @@ namespace nnforge
 			}
 			else
 			{
-				#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
+				#pragma omp parallel for default(none) schedule(runtime) num_threads(plain_config->openmp_thread_count)
 				for(int i = 0; i < elem_count; ++i)
 				{
 					float input_val = *(in_it + i);
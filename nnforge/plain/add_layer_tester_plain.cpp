@@ -51,7 +51,7 @@ namespace nnforge
 			const float alpha = layer_derived->alpha;
 			const int src_ptr_count = static_cast<int>(in_list.size());
 			const int elem_count = static_cast<int>(entry_count * output_configuration_specific.get_neuron_count());
-			#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
+			#pragma omp parallel for default(none) schedule(runtime) num_threads(plain_config->openmp_thread_count)
 			for(int i = 0; i < elem_count; ++i)
 			{
 				float sum = 0.0F;
@@ -53,7 +53,7 @@ namespace nnforge
 			const float alpha = layer_derived->alpha;
 			const int src_ptr_count = static_cast<int>(in_list.size());
 			const int elem_count = static_cast<int>(entry_count * output_configuration_specific.get_neuron_count());
-			#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
+			#pragma omp parallel for default(none) schedule(runtime) num_threads(plain_config->openmp_thread_count)
 			for(int i = 0; i < elem_count; ++i)
 			{
 				float sum = 0.0F;
@@ -89,7 +89,7 @@ namespace nnforge
 			const int elem_count = static_cast<int>(entry_count * output_configuration_specific.get_neuron_count());
 			if (add_update_to_destination)
 			{
-				#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
+				#pragma omp parallel for default(none) schedule(runtime) num_threads(plain_config->openmp_thread_count)
 				for(int i = 0; i < elem_count; ++i)
 				{
 					in_errors[i] += out_errors[i] * alpha;
@@ -99,7 +99,7 @@ namespace nnforge
 			{
 				if ((in_errors != out_errors) || (alpha != 1.0F))
 				{
-					#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
+					#pragma omp parallel for default(none) schedule(runtime) num_threads(plain_config->openmp_thread_count)
 					for(int i = 0; i < elem_count; ++i)
 					{
 						in_errors[i] = out_errors[i] * alpha;
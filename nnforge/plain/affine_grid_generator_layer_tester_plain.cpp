@@ -58,7 +58,7 @@ namespace nnforge
 
 			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count)
 			{
-				#pragma omp for schedule(guided)
+				#pragma omp for schedule(runtime)
 				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
 				{
 					int entry_id = workload_id / output_height;
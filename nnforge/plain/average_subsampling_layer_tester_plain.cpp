@@ -16,6 +16,7 @@
 
 #include "average_subsampling_layer_tester_plain.h"
 
+#include "subsampling_2d_kernel.h"
 #include "../average_subsampling_layer.h"
 
 #include <array>
@@ -31,6 +32,15 @@ namespace nnforge
 			return average_subsampling_layer::layer_type_name;
 		}
 
+		average_subsampling_layer_tester_plain::kernel_2d_func average_subsampling_layer_tester_plain::get_kernel_2d(unsigned int subsampling_size)
+		{
+			if (subsampling_size == 2)
+				return subsampling_2d_kernel<2, 2>::run_average;
+			if (subsampling_size == 3)
+				return subsampling_2d_kernel<3, 3>::run_average;
+			return 0;
+		}
+
 		void average_subsampling_layer_tester_plain::run_forward_propagation(
 			plain_buffer::ptr output_buffer,
 			const std::vector<plain_buffer::const_ptr>& input_buffers,
@@ -79,9 +89,37 @@ namespace nnforge
 			for(unsigned int i = 0; i < subsampling_dimension_count; ++i)
 				subsampling_elem_count *= subsampling_sizes[i];
 			const unsigned int const_subsampling_elem_count = subsampling_elem_count;
-			const float mult = layer_derived->get_effective_alpha(input_configuration_specific_list[0].feature_map_count, output_configuration_specific.feature_map_count);
+			const float mult = layer_derived->get_effective_alpha(input_configuration_specific_list[0], output_configuration_specific);
 			const unsigned int output_feature_map_count = output_configuration_specific.feature_map_count;
 
+			// Common 2D shapes are run with the specialized kernels
+			if ((output_configuration_specific.dimension_sizes.size() == 2)
+				&& (feature_map_subsampling_size == 1)
+				&& (entry_subsampling_size == 1)
+				&& (subsampling_sizes[0] == subsampling_sizes[1]))
+			{
+				const kernel_2d_func kernel = get_kernel_2d(subsampling_sizes[0]);
+				if (kernel)
+				{
+					const unsigned int input_width = input_dimension_sizes[0];
+					const unsigned int output_width = output_dimension_sizes[0];
+					const unsigned int output_height = output_dimension_sizes[1];
+					const int total_workload = entry_count * output_feature_map_count;
+
+					#pragma omp parallel for default(none) schedule(runtime) num_threads(plain_config->openmp_thread_count)
+					for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+						kernel(
+							in_it_global + workload_id * input_neuron_count_per_feature_map,
+							out_it_global + workload_id * output_neuron_count_per_feature_map,
+							input_width,
+							output_width,
+							output_height,
+							mult);
+
+					return;
+				}
+			}
+
 			std::vector<unsigned int> current_local_input_position(subsampling_dimension_count, 0);
 			std::vector<unsigned int> offset_list(subsampling_elem_count);
 			for(unsigned int i = 1; i < subsampling_elem_count; ++i)
@@ -110,7 +148,7 @@ namespace nnforge
 			{
 				std::array<unsigned int, max_dimension_count> current_output_position;
 
-				#pragma omp for schedule(guided)
+				#pragma omp for schedule(runtime)
 				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
 				{
 					int output_entry_id = workload_id / output_feature_map_count;
@@ -44,6 +44,12 @@ namespace nnforge
 				const layer_configuration_specific& output_configuration_specific,
 				unsigned int entry_count) const;
 
+		private:
+			typedef void (*kernel_2d_func)(const float *, float *, unsigned int, unsigned int, unsigned int, float);
+
+			// Returns 0 when there is no specialized kernel for the shape
+			static kernel_2d_func get_kernel_2d(unsigned int subsampling_size);
+
 		private:
 			static const int max_dimension_count;
 		};
@@ -81,7 +81,7 @@ namespace nnforge
 			for(unsigned int i = 0; i < subsampling_dimension_count; ++i)
 				subsampling_elem_count *= subsampling_sizes[i];
 			const unsigned int const_subsampling_elem_count = subsampling_elem_count;
-			const float mult = layer_derived->get_effective_alpha(input_configuration_specific_list[0].feature_map_count, output_configuration_specific.feature_map_count);
+			const float mult = layer_derived->get_effective_alpha(input_configuration_specific_list[0], output_configuration_specific);
 			const unsigned int output_feature_map_count = output_configuration_specific.feature_map_count;
 
 			std::vector<unsigned int> current_local_input_position(subsampling_dimension_count, 0);
@@ -112,7 +112,7 @@ namespace nnforge
 			{
 				std::array<unsigned int, max_dimension_count> current_output_position;
 
-				#pragma omp for schedule(guided)
+				#pragma omp for schedule(runtime)
 				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
 				{
 					int output_entry_id = workload_id / output_feature_map_count;
@@ -202,7 +202,7 @@ namespace nnforge
 			for(unsigned int i = 0; i < subsampling_dimension_count; ++i)
 				subsampling_elem_count *= subsampling_sizes[i];
 			const unsigned int const_subsampling_elem_count = subsampling_elem_count;
-			const float mult = layer_derived->get_effective_alpha(input_configuration_specific_list[0].feature_map_count, output_configuration_specific.feature_map_count);
+			const float mult = layer_derived->get_effective_alpha(input_configuration_specific_list[0], output_configuration_specific);
 			const unsigned int output_feature_map_count = output_configuration_specific.feature_map_count;
 
 			std::vector<unsigned int> current_local_input_position(subsampling_dimension_count, 0);
@@ -237,7 +237,7 @@ namespace nnforge
 				if (!exact_subsampling)
 				{
 					const int total_clean_workload = entry_count * entry_subsampling_size * input_neuron_count;
-					#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
+					#pragma omp parallel for default(none) schedule(runtime) num_threads(plain_config->openmp_thread_count)
 					for(int workload_id = 0; workload_id < total_clean_workload; ++workload_id)
 					{
 						*(in_err_it_global + workload_id) = 0.0F;
@@ -255,7 +255,7 @@ namespace nnforge
 			{
 				std::array<unsigned int, max_dimension_count> current_output_position;
 
-				#pragma omp for schedule(guided)
+				#pragma omp for schedule(runtime)
 				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
 				{
 					int output_entry_id = workload_id / output_feature_map_count;
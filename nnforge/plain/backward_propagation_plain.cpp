@@ -17,12 +17,21 @@
 #include "backward_propagation_plain.h"
 
 #include "layer_updater_plain_factory.h"
+#include "plain_buffer_pool.h"
+#include "bfloat16_kernel.h"
+#include "negative_log_likelihood_layer_updater_plain.h"
+#include "cross_entropy_layer_updater_plain.h"
 
 #include <boost/filesystem.hpp>
 #include <boost/format.hpp>
 #include <boost/filesystem/fstream.hpp>
+#include <algorithm>
 
 #include "../neural_network_exception.h"
+#include "../shared_memory_allreducer.h"
+#include "../softmax_layer.h"
+#include "../negative_log_likelihood_layer.h"
+#include "../cross_entropy_layer.h"
 
 namespace nnforge
 {
@@ -38,10 +47,50 @@ namespace nnforge
 			plain_running_configuration::const_ptr plain_config)
 			: backward_propagation(schema, output_layer_names, error_source_layer_names, exclude_data_update_layer_names, debug, profile)
 			, plain_config(plain_config)
+			, recompute_plan_batch_size(0)
+			, recompute_plan_constant_buffer_size(0)
+			, per_entry_buffer_size_without_recompute(0)
 			, temporary_working_fixed_size(0)
 		{
 			actions_in_execution_order = action_schema->get_actions_in_execution_order();
 
+			// Topological order might put all the backward weights actions at the very end, keeping all the activations alive till then,
+			// recompute and packing are pointless in this case so we run each backward weights action as soon as its dependencies are ready
+			if (plain_config->recompute_activations || plain_config->bf16_activations)
+			{
+				std::vector<layer_name_with_action> reordered_actions;
+				std::set<layer_name_with_action> actions_done;
+				std::vector<layer_name_with_action> pending_backward_weights_actions;
+				for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
+					if (it->get_action().get_action_type() == layer_action::backward_weights)
+						pending_backward_weights_actions.push_back(*it);
+				for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
+				{
+					if (it->get_action().get_action_type() == layer_action::backward_weights)
+						continue;
+
+					reordered_actions.push_back(*it);
+					actions_done.insert(*it);
+
+					for(std::vector<layer_name_with_action>::iterator it2 = pending_backward_weights_actions.begin(); it2 != pending_backward_weights_actions.end();)
+					{
+						std::vector<layer_name_with_action> dependencies = action_schema->get_dependencies(*it2);
+						bool dependencies_done = true;
+						for(std::vector<layer_name_with_action>::const_iterator it3 = dependencies.begin(); it3 != dependencies.end(); ++it3)
+							dependencies_done = dependencies_done && (actions_done.find(*it3) != actions_done.end());
+						if (dependencies_done)
+						{
+							reordered_actions.push_back(*it2);
+							actions_done.insert(*it2);
+							it2 = pending_backward_weights_actions.erase(it2);
+						}
+						else
+							++it2;
+					}
+				}
+				actions_in_execution_order = reordered_actions;
+			}
+
 			for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
 			{
 				if (it->get_action().get_action_type() != layer_action::backward_data)
@@ -51,27 +100,7 @@ namespace nnforge
 				input_to_all_output_map.insert(std::make_pair(previous_layer_name, std::vector<layer_name_with_action>())).first->second.push_back(*it);
 			}
 
-			// CPU is an easy to saturate device, we run everything in a single stream/thread, this will save some (maybe significant amount of) RAM
-			network_action_schema::ptr sequential_action_schema(new network_action_schema());
-			{
-				std::vector<layer_name_with_action> dependencies;
-				for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
-				{
-					sequential_action_schema->add_action(
-						this->schema->get_layer(it->get_name()),
-						it->get_action(),
-						dependencies);
-					dependencies.clear();
-					dependencies.push_back(*it);
-				}
-			}
-			action_schema = sequential_action_schema;
-
-			if (debug->is_debug())
-			{
-				boost::filesystem::ofstream out(debug->get_path_to_unique_file("backward_prop_plain_action_schema_sequential", "gv"), std::ios_base::out | std::ios_base::trunc);
-				action_schema->write_gv(out);
-			}
+			setup_sequential_action_schema();
 
 			std::set<std::string> action_layer_names;
 			for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
@@ -84,6 +113,8 @@ namespace nnforge
 					std::make_pair(
 						*it,
 						layer_updater_plain_factory::get_singleton().get_updater_plain_layer(this->schema->get_layer(*it)->get_type_name())));
+
+			setup_fused_softmax();
 		}
 
 		void backward_propagation_plain::actual_run(
@@ -110,12 +141,66 @@ namespace nnforge
 				updates_accumulated.insert(std::make_pair(layer_name, std::vector<double>(d->size(), 0.0)));
 			}
 
+			// Weights, gradients and momentum share the same layout, so weights are updated in contiguous passes over the arenas
+			parameter_arena::ptr data_arena = data.move_to_arena();
+			parameter_arena::ptr momentum_arena;
+			if (momentum.is_momentum_data())
+			{
+				momentum_arena = momentum_data->move_to_arena();
+				if (!momentum_arena->is_same_layout(*data_arena))
+					throw neural_network_exception("Momentum data doesn't match weights");
+			}
+			parameter_arena::ptr momentum2_arena;
+			if (momentum.is_momentum_data2())
+			{
+				momentum2_arena = momentum_data2->move_to_arena();
+				if (!momentum2_arena->is_same_layout(*data_arena))
+					throw neural_network_exception("2nd momentum data doesn't match weights");
+			}
+
 			std::vector<layer::const_ptr> layer_list;
 			for(std::vector<std::string>::const_iterator it = data_layer_list.begin(); it != data_layer_list.end(); ++it)
 				layer_list.push_back(schema->get_layer(*it));
 			layer_data_list::ptr gradient(new layer_data_list(layer_list, 0.0F));
+			parameter_arena::ptr gradient_arena = parameter_arena::create(*gradient);
+			if (!gradient_arena->is_same_layout(*data_arena))
+				throw neural_network_exception("Gradient doesn't match weights");
+
+			if (gradient_allreducer)
+			{
+				// All the workers start from the same weights and momentum
+				gradient_allreducer->broadcast(data_arena->get_data(), data_arena->get_size());
+				if (momentum_arena)
+					gradient_allreducer->broadcast(momentum_arena->get_data(), momentum_arena->get_size());
+				if (momentum2_arena)
+					gradient_allreducer->broadcast(momentum2_arena->get_data(), momentum2_arena->get_size());
+			}
 
-			buffer_plain_size_configuration buffer_configuration = buffer_config_without_data_and_momentum;
+			// Layers follow in the arena order
+			std::map<std::string, std::vector<update_segment> > layer_name_to_update_segment_list_map;
+			std::vector<update_segment> all_update_segment_list;
+			for(std::vector<std::string>::const_iterator it = data_layer_list.begin(); it != data_layer_list.end(); ++it)
+			{
+				const std::string& layer_name = *it;
+				std::vector<update_segment>& update_segment_list = layer_name_to_update_segment_list_map.insert(std::make_pair(layer_name, std::vector<update_segment>())).first->second;
+				layer_data::ptr d = data.data_list.get(layer_name);
+				const std::vector<float>& layer_learning_rates = learning_rates.find(layer_name)->second;
+				std::set<unsigned int> weight_decay_part_id_set = schema->get_layer(layer_name)->get_weight_decay_part_id_set();
+				std::vector<double>& layer_updates_accumulated = updates_accumulated[layer_name];
+				for(unsigned int part_id = 0; part_id < static_cast<unsigned int>(d->size()); ++part_id)
+				{
+					update_segment segment;
+					segment.offset = data_arena->get_offset(layer_name, part_id);
+					segment.size = d->at(part_id).size();
+					segment.learning_rate = layer_learning_rates[part_id];
+					segment.is_weight_decay = (weight_decay_part_id_set.find(part_id) != weight_decay_part_id_set.end());
+					segment.updates_accumulated = &layer_updates_accumulated[part_id];
+					update_segment_list.push_back(segment);
+					all_update_segment_list.push_back(segment);
+				}
+			}
+
+			buffer_plain_size_configuration buffer_configuration;
 			{
 				for(std::vector<std::string>::const_iterator it = data_layer_list.begin(); it != data_layer_list.end(); ++it)
 				{
@@ -142,6 +227,10 @@ namespace nnforge
 				for(std::map<std::string, std::vector<double> >::const_iterator it = updates_accumulated.begin(); it != updates_accumulated.end(); ++it)
 					buffer_configuration.add_constant_buffer(it->second.size() * sizeof(double));
 			}
+			if (plain_config->recompute_activations)
+				update_recompute_plan(buffer_configuration.constant_buffer_size + buffer_config_without_data_and_momentum.constant_buffer_size, batch_size);
+			buffer_configuration.add_constant_buffer(buffer_config_without_data_and_momentum.constant_buffer_size);
+			buffer_configuration.add_per_entry_buffer(buffer_config_without_data_and_momentum.per_entry_buffer_size);
 
 			unsigned int max_entry_count = plain_config->get_max_entry_count(buffer_configuration);
 
@@ -182,6 +271,8 @@ namespace nnforge
 			}
 			unsigned int max_chunk_size = *std::max_element(entry_read_count_list.begin(), entry_read_count_list.end());
 
+			plain_running_configuration::openmp_state openmp_state = plain_config->setup_openmp();
+
 			std::map<std::string, plain_buffer::ptr> dedicated_buffers;
 			for(std::map<std::string, size_t>::const_iterator it = dedicated_per_entry_data_name_to_size_map.begin(); it != dedicated_per_entry_data_name_to_size_map.end(); ++it)
 				dedicated_buffers.insert(std::make_pair(it->first, plain_buffer::ptr(new plain_buffer(it->second * max_chunk_size))));
@@ -194,6 +285,21 @@ namespace nnforge
 			for(std::vector<size_t>::const_iterator it = layer_buffer_set_per_entry_size_list.begin(); it != layer_buffer_set_per_entry_size_list.end(); ++it)
 				layer_buffers.push_back(plain_buffer::ptr(new plain_buffer(*it * max_chunk_size)));
 
+			if (plain_config->numa_aware)
+			{
+				for(std::map<std::string, plain_buffer::ptr>::iterator it = dedicated_buffers.begin(); it != dedicated_buffers.end(); ++it)
+					plain_config->first_touch(*it->second, it->second->get_size());
+				for(std::vector<plain_buffer::ptr>::iterator it = layer_buffers.begin(); it != layer_buffers.end(); ++it)
+					plain_config->first_touch(**it, (*it)->get_size());
+			}
+
+			if (debug->is_debug())
+			{
+				std::stringstream debug_str;
+				debug_str << "backward prop plain buffer pool: " << plain_buffer_pool::get_singleton().get_usage_stats();
+				debug->output_message(debug_str.str().c_str());
+			}
+
 			unsigned int base_iteration_count = 0;
 			if (momentum.type == training_momentum::adam_momentum)
 			{
@@ -240,9 +346,16 @@ namespace nnforge
 					gradient_applied_count++;
 				}
 
-				for(std::vector<layer_name_with_action>::const_iterator action_it = actions_in_execution_order.begin(); action_it  != actions_in_execution_order.end(); ++action_it)
+				// With gradient allreduce weights are updated after all the actions, once gradients for the whole model are summed
+				std::vector<std::string> deferred_update_layer_names;
+				for(std::vector<layer_name_with_action>::const_iterator action_it = actions_to_run_in_execution_order.begin(); action_it  != actions_to_run_in_execution_order.end(); ++action_it)
 				{
 					const layer_name_with_action& current_layer_name_with_action = *action_it;
+
+					// The action is done by its consumer
+					if (fused_softmax_actions.find(current_layer_name_with_action) != fused_softmax_actions.end())
+						continue;
+
 					std::string layer_name = current_layer_name_with_action.get_name();;
 					layer_configuration_specific output_layer_configuration_specific = layer_config_map[layer_name];
 					layer::const_ptr l = schema->get_layer(layer_name);
@@ -264,6 +377,7 @@ namespace nnforge
 					switch (action.get_action_type())
 					{
 					case layer_action::forward:
+					case layer_action::recompute_forward:
 						{
 							plain_buffer::ptr output_buffer;
 							{
@@ -274,10 +388,21 @@ namespace nnforge
 									output_buffer = dedicated_buffers.find(layer_name)->second;
 							}
 
+							// Packed layers are restored from their bfloat16 copies rather than recomputed
+							if ((action.get_action_type() == layer_action::recompute_forward) && is_layer_packed(layer_name, layers_to_recompute))
+							{
+								bfloat16_kernel::unpack(
+									*output_buffer,
+									*layer_buffers[packed_per_entry_data_action_to_set_map[layer_name_with_action(layer_name, layer_action(layer_action::forward))]],
+									output_layer_configuration_specific.get_neuron_count() * entry_read_count * tiling_factor,
+									plain_config);
+								break;
+							}
+
 							std::vector<plain_buffer::const_ptr> input_buffers;
 							for(std::vector<std::string>::const_iterator input_layer_name_it = current_layer->input_layer_instance_names.begin(); input_layer_name_it != current_layer->input_layer_instance_names.end(); ++input_layer_name_it)
 							{
-								std::map<layer_name_with_action, unsigned int>::const_iterator it = layer_buffer_action_to_set_map.find(layer_name_with_action(*input_layer_name_it, layer_action::forward));
+								std::map<layer_name_with_action, unsigned int>::const_iterator it = layer_buffer_action_to_set_map.find(get_forward_output_action(*input_layer_name_it, action, layers_to_recompute));
 								if (it != layer_buffer_action_to_set_map.end())
 									input_buffers.push_back(layer_buffers[it->second]);
 								else
@@ -305,6 +430,13 @@ namespace nnforge
 								output_layer_configuration_specific,
 								actions,
 								entry_read_count * tiling_factor);
+
+							if ((action.get_action_type() == layer_action::forward) && is_layer_packed(layer_name, layers_to_recompute))
+								bfloat16_kernel::pack(
+									*layer_buffers[packed_per_entry_data_action_to_set_map[current_layer_name_with_action]],
+									*output_buffer,
+									output_layer_configuration_specific.get_neuron_count() * entry_read_count * tiling_factor,
+									plain_config);
 						}
 						break;
 					case layer_action::backward_data:
@@ -317,7 +449,7 @@ namespace nnforge
 							{
 								if (updaters[layer_name]->is_backward_data_dependent_on_input_buffer(action.get_backprop_index(), data_input_index, actions, plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
 								{
-									std::map<layer_name_with_action, unsigned int>::const_iterator it = layer_buffer_action_to_set_map.find(layer_name_with_action(*input_layer_name_it, layer_action::forward));
+									std::map<layer_name_with_action, unsigned int>::const_iterator it = layer_buffer_action_to_set_map.find(get_forward_output_action(*input_layer_name_it, action, layers_to_recompute));
 									if (it != layer_buffer_action_to_set_map.end())
 										input_neurons_buffers.push_back(layer_buffers[it->second]);
 									else
@@ -331,7 +463,7 @@ namespace nnforge
 							{
 								if (updaters[layer_name]->is_backward_data_dependent_on_temporary_per_entry_buffer(action.get_backprop_index(), actions, plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
 								{
-									std::map<layer_name_with_action, unsigned int>::const_iterator it = temporary_per_entry_data_action_to_set_map.find(layer_name_with_action(layer_name, layer_action::forward));
+									std::map<layer_name_with_action, unsigned int>::const_iterator it = temporary_per_entry_data_action_to_set_map.find(get_temporary_buffer_action(layer_name, action, layers_to_recompute));
 									if (it != temporary_per_entry_data_action_to_set_map.end())
 										temporary_per_entry_buffer = layer_buffers[it->second];
 								}
@@ -341,7 +473,7 @@ namespace nnforge
 							{
 								if (updaters[layer_name]->is_backward_data_dependent_on_output_buffer(action.get_backprop_index(), actions, plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
 								{
-									std::map<layer_name_with_action, unsigned int>::const_iterator it = layer_buffer_action_to_set_map.find(layer_name_with_action(layer_name, layer_action::forward));
+									std::map<layer_name_with_action, unsigned int>::const_iterator it = layer_buffer_action_to_set_map.find(get_forward_output_action(layer_name, action, layers_to_recompute));
 									if (it != layer_buffer_action_to_set_map.end())
 										output_neurons_buffer = layer_buffers[it->second];
 									else
@@ -349,6 +481,27 @@ namespace nnforge
 								}
 							}
 
+							if (layers_with_fused_softmax.find(layer_name) != layers_with_fused_softmax.end())
+							{
+								if (current_layer->get_type_name() == negative_log_likelihood_layer::layer_type_name)
+									std::static_pointer_cast<const negative_log_likelihood_layer_updater_plain>(updaters.find(layer_name)->second)->run_backward_data_propagation_through_softmax(
+										output_buffer,
+										input_neurons_buffers,
+										plain_config,
+										current_layer,
+										input_layer_configuration_specific_list,
+										entry_read_count * tiling_factor);
+								else
+									std::static_pointer_cast<const cross_entropy_layer_updater_plain>(updaters.find(layer_name)->second)->run_backward_data_propagation_through_softmax(
+										output_buffer,
+										input_neurons_buffers,
+										plain_config,
+										current_layer,
+										input_layer_configuration_specific_list,
+										entry_read_count * tiling_factor);
+								break;
+							}
+
 							plain_buffer::const_ptr output_errors_buffer;
 							{
 								std::map<std::string, std::vector<layer_name_with_action> >::const_iterator it = input_to_all_output_map.find(layer_name);
@@ -384,7 +537,7 @@ namespace nnforge
 							{
 								if (updaters[layer_name]->is_backward_weights_dependent_on_input_buffer(data_input_index, actions, plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
 								{
-									std::map<layer_name_with_action, unsigned int>::const_iterator it = layer_buffer_action_to_set_map.find(layer_name_with_action(*input_layer_name_it, layer_action::forward));
+									std::map<layer_name_with_action, unsigned int>::const_iterator it = layer_buffer_action_to_set_map.find(get_forward_output_action(*input_layer_name_it, action, layers_to_recompute));
 									if (it != layer_buffer_action_to_set_map.end())
 										input_neurons_buffers.push_back(layer_buffers[it->second]);
 									else
@@ -398,7 +551,7 @@ namespace nnforge
 							{
 								if (updaters[layer_name]->is_backward_weights_dependent_on_temporary_per_entry_buffer(actions, plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
 								{
-									std::map<layer_name_with_action, unsigned int>::const_iterator it = temporary_per_entry_data_action_to_set_map.find(layer_name_with_action(layer_name, layer_action::forward));
+									std::map<layer_name_with_action, unsigned int>::const_iterator it = temporary_per_entry_data_action_to_set_map.find(get_temporary_buffer_action(layer_name, action, layers_to_recompute));
 									if (it != temporary_per_entry_data_action_to_set_map.end())
 										temporary_per_entry_buffer = layer_buffers[it->second];
 								}
@@ -429,32 +582,45 @@ namespace nnforge
 						break;
 					case layer_action::update_weights:
 						{
-							if (is_apply_gradient)
-							{
-								layer_data::ptr previous_upd;
-								if (momentum.is_momentum_data())
-									previous_upd = momentum_data->data_list.find(layer_name);
-								layer_data::ptr previous_upd2;
-								if (momentum.is_momentum_data2())
-									previous_upd2 = momentum_data2->data_list.find(layer_name);
+							if (is_apply_gradient && gradient_allreducer)
+								deferred_update_layer_names.push_back(layer_name);
+							else if (is_apply_gradient)
 								apply_gradient(
-									layer_name,
-									data.data_list.find(layer_name),
-									gradient->find(layer_name),
-									previous_upd,
-									previous_upd2,
-									updates_accumulated[layer_name],
-									learning_rates.find(layer_name)->second,
+									layer_name_to_update_segment_list_map[layer_name],
+									*data_arena,
+									*gradient_arena,
+									momentum_arena,
+									momentum2_arena,
 									gradient_normalizer,
 									weight_decay,
 									momentum,
 									base_iteration_count + gradient_applied_count);
-							}
 						}
 						break;
 					}
 				}
 
+				if (is_apply_gradient && gradient_allreducer)
+				{
+					gradient_allreducer->allreduce(gradient_arena->get_data(), gradient_arena->get_size());
+					std::vector<update_segment> deferred_update_segment_list;
+					for(std::vector<std::string>::const_iterator it = deferred_update_layer_names.begin(); it != deferred_update_layer_names.end(); ++it)
+					{
+						const std::vector<update_segment>& update_segment_list = layer_name_to_update_segment_list_map[*it];
+						deferred_update_segment_list.insert(deferred_update_segment_list.end(), update_segment_list.begin(), update_segment_list.end());
+					}
+					apply_gradient(
+						deferred_update_segment_list,
+						*data_arena,
+						*gradient_arena,
+						momentum_arena,
+						momentum2_arena,
+						gradient_normalizer,
+						weight_decay,
+						momentum,
+						base_iteration_count + gradient_applied_count);
+				}
+
 				for(int entry_id = 0; entry_id < entry_read_count * static_cast<int>(output_layers_tiling_factor); ++entry_id)
 				{
 					std::map<std::string, const float *> data_map;
@@ -474,28 +640,18 @@ namespace nnforge
 			{
 				float gradient_normalizer = 1.0F / static_cast<float>(batch_size);
 				gradient_applied_count++;
-				for(std::map<std::string, std::vector<double> >::const_iterator it = updates_accumulated.begin(); it != updates_accumulated.end(); ++it)
-				{
-					const std::string& layer_name = it->first;
-					layer_data::ptr previous_upd;
-					if (momentum.is_momentum_data())
-						previous_upd = momentum_data->data_list.find(layer_name);
-					layer_data::ptr previous_upd2;
-					if (momentum.is_momentum_data2())
-						previous_upd2 = momentum_data2->data_list.find(layer_name);
-					apply_gradient(
-						layer_name,
-						data.data_list.find(layer_name),
-						gradient->find(layer_name),
-						previous_upd,
-						previous_upd2,
-						updates_accumulated[layer_name],
-						learning_rates.find(layer_name)->second,
-						gradient_normalizer,
-						weight_decay,
-						momentum,
-						base_iteration_count + gradient_applied_count);
-				}
+				if (gradient_allreducer)
+					gradient_allreducer->allreduce(gradient_arena->get_data(), gradient_arena->get_size());
+				apply_gradient(
+					all_update_segment_list,
+					*data_arena,
+					*gradient_arena,
+					momentum_arena,
+					momentum2_arena,
+					gradient_normalizer,
+					weight_decay,
+					momentum,
+					base_iteration_count + gradient_applied_count);
 			}
 
 			average_absolute_updates.clear();
@@ -509,12 +665,26 @@ namespace nnforge
 						f.push_back(static_cast<float>(*it2) * mult / static_cast<float>(it_data->size()));
 				}
 			}
+
+			plain_config->restore_openmp(openmp_state);
+
 			entries_processed = entry_processed_count;
 			action_seconds.clear();
 		}
 
 		void backward_propagation_plain::layer_config_map_modified()
 		{
+			bool action_schema_modified = !layers_to_recompute.empty();
+			layers_to_recompute.clear();
+			if (plain_config->bf16_activations)
+			{
+				setup_packed_layers();
+				action_schema_modified = true;
+			}
+			if (action_schema_modified)
+				setup_sequential_action_schema();
+			recompute_plan_batch_size = 0;
+
 			setup_dedicated_buffer_sizes();
 
 			setup_layer_buffer_sizes();
@@ -522,6 +692,453 @@ namespace nnforge
 			setup_temporary_working_fixed_buffer_sizes();
 
 			update_buffer_config();
+
+			per_entry_buffer_size_without_recompute = buffer_config_without_data_and_momentum.per_entry_buffer_size;
+		}
+
+		void backward_propagation_plain::setup_sequential_action_schema()
+		{
+			actions_to_run_in_execution_order = get_actions_with_recompute(layers_to_recompute);
+
+			// CPU is an easy to saturate device, we run everything in a single stream/thread, this will save some (maybe significant amount of) RAM
+			network_action_schema::ptr sequential_action_schema(new network_action_schema());
+			{
+				std::vector<layer_name_with_action> dependencies;
+				for(std::vector<layer_name_with_action>::const_iterator it = actions_to_run_in_execution_order.begin(); it != actions_to_run_in_execution_order.end(); ++it)
+				{
+					sequential_action_schema->add_action(
+						this->schema->get_layer(it->get_name()),
+						it->get_action(),
+						dependencies);
+					dependencies.clear();
+					dependencies.push_back(*it);
+				}
+			}
+			action_schema = sequential_action_schema;
+
+			if (debug->is_debug())
+			{
+				boost::filesystem::ofstream out(debug->get_path_to_unique_file("backward_prop_plain_action_schema_sequential", "gv"), std::ios_base::out | std::ios_base::trunc);
+				action_schema->write_gv(out);
+			}
+		}
+
+		void backward_propagation_plain::setup_packed_layers()
+		{
+			layers_to_pack.clear();
+
+			// Loss layers get their inputs in full precision, errors are computed from them directly
+			std::set<std::string> error_source_layer_name_set(error_source_layer_names.begin(), error_source_layer_names.end());
+			std::set<std::string> layers_used_by_error_sources;
+			std::set<std::string> layers_used_by_backward;
+			for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
+			{
+				std::vector<std::string> layers_used = get_forward_output_layers_used(*it, false);
+				if (error_source_layer_name_set.find(it->get_name()) != error_source_layer_name_set.end())
+					layers_used_by_error_sources.insert(layers_used.begin(), layers_used.end());
+				else
+					layers_used_by_backward.insert(layers_used.begin(), layers_used.end());
+			}
+
+			std::set<std::string> output_layer_name_set(output_layer_names.begin(), output_layer_names.end());
+			for(std::set<std::string>::const_iterator it = layers_used_by_backward.begin(); it != layers_used_by_backward.end(); ++it)
+			{
+				// Outputs have dedicated buffers which are alive during the whole pass anyway
+				if (output_layer_name_set.find(*it) != output_layer_name_set.end())
+					continue;
+				if (layers_used_by_error_sources.find(*it) != layers_used_by_error_sources.end())
+					continue;
+				layers_to_pack.insert(*it);
+			}
+
+			if (debug->is_debug())
+			{
+				std::stringstream debug_str;
+				debug_str << "backward prop plain bfloat16 activations: " << layers_to_pack.size() << " layers";
+				for(std::set<std::string>::const_iterator it = layers_to_pack.begin(); it != layers_to_pack.end(); ++it)
+					debug_str << ((it == layers_to_pack.begin()) ? " - " : ", ") << *it;
+				debug->output_message(debug_str.str().c_str());
+			}
+		}
+
+		void backward_propagation_plain::setup_fused_softmax()
+		{
+			fused_softmax_actions.clear();
+			layers_with_fused_softmax.clear();
+
+			for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
+			{
+				if (it->get_action().get_action_type() != layer_action::backward_data)
+					continue;
+				const std::string& layer_name = it->get_name();
+				layer::const_ptr l = schema->get_layer(layer_name);
+				if (l->get_type_name() != softmax_layer::layer_type_name)
+					continue;
+				if (add_output_actions.find(*it) != add_output_actions.end())
+					continue;
+
+				std::map<std::string, std::vector<layer_name_with_action> >::const_iterator consumer_actions_it = input_to_all_output_map.find(layer_name);
+				if ((consumer_actions_it == input_to_all_output_map.end()) || (consumer_actions_it->second.size() != 1))
+					continue;
+				const layer_name_with_action& consumer_action = consumer_actions_it->second.front();
+				if (consumer_action.get_action().get_backprop_index() != 0)
+					continue;
+				layer::const_ptr consumer_layer = schema->get_layer(consumer_action.get_name());
+				if ((consumer_layer->get_type_name() != negative_log_likelihood_layer::layer_type_name) && (consumer_layer->get_type_name() != cross_entropy_layer::layer_type_name))
+					continue;
+
+				fused_softmax_actions.insert(*it);
+				layers_with_fused_softmax.insert(consumer_action.get_name());
+			}
+
+			if (debug->is_debug())
+			{
+				std::stringstream debug_str;
+				debug_str << "backward prop plain softmax layers fused into loss layers: " << fused_softmax_actions.size();
+				for(std::set<layer_name_with_action>::const_iterator it = fused_softmax_actions.begin(); it != fused_softmax_actions.end(); ++it)
+					debug_str << (it == fused_softmax_actions.begin() ? " (" : ", ") << it->get_name();
+				if (!fused_softmax_actions.empty())
+					debug_str << ")";
+				debug->output_message(debug_str.str().c_str());
+			}
+		}
+
+		void backward_propagation_plain::update_recompute_plan(
+			size_t constant_buffer_size,
+			unsigned int batch_size)
+		{
+			if ((recompute_plan_batch_size == batch_size) && (recompute_plan_constant_buffer_size == constant_buffer_size))
+				return;
+			recompute_plan_batch_size = batch_size;
+			recompute_plan_constant_buffer_size = constant_buffer_size;
+
+			long long memory_left = static_cast<long long>(plain_config->max_memory_usage_gigabytes * static_cast<float>(1 << 30)) - static_cast<long long>(constant_buffer_size);
+			size_t per_entry_budget = (memory_left > 0) ? static_cast<size_t>(memory_left) / batch_size : 0;
+
+			std::set<std::string> new_layers_to_recompute;
+			if (per_entry_buffer_size_without_recompute > per_entry_budget)
+			{
+				size_t dedicated_size = 0;
+				for(std::map<std::string, size_t>::const_iterator it = dedicated_per_entry_data_name_to_size_map.begin(); it != dedicated_per_entry_data_name_to_size_map.end(); ++it)
+					dedicated_size += it->second;
+
+				// Peak size of alive buffers is cheap to estimate but it underestimates the size of buffer sets, scale the budget accordingly
+				size_t peak_size_without_recompute = get_per_entry_buffer_peak_size(std::set<std::string>()) + dedicated_size;
+				size_t peak_budget = static_cast<size_t>(static_cast<double>(per_entry_budget) * static_cast<double>(peak_size_without_recompute) / static_cast<double>(per_entry_buffer_size_without_recompute));
+
+				std::set<std::string> layers_used_by_backward;
+				for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
+				{
+					std::vector<std::string> layers_used = get_forward_output_layers_used(*it);
+					layers_used_by_backward.insert(layers_used.begin(), layers_used.end());
+				}
+
+				std::set<std::string> recomputable_layers;
+				for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
+				{
+					if (it->get_action().get_action_type() != layer_action::forward)
+						continue;
+					const std::string& layer_name = it->get_name();
+					if (dedicated_per_entry_data_name_to_size_map.find(layer_name) != dedicated_per_entry_data_name_to_size_map.end())
+						continue;
+					layer::const_ptr l = schema->get_layer(layer_name);
+					std::vector<layer_configuration_specific> input_layer_configuration_specific_list;
+					for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2)
+						input_layer_configuration_specific_list.push_back(layer_config_map[*it2]);
+					if (updaters[layer_name]->is_forward_propagation_repeatable(layer_name_to_action_set_map[layer_name], plain_config, l, input_layer_configuration_specific_list, layer_config_map[layer_name]))
+						recomputable_layers.insert(layer_name);
+				}
+
+				// Each candidate is a layer used by backward prop together with the layers it is computed from and which are not needed by backward prop otherwise,
+				// this way recompute starts from activations which are kept anyway. Candidates saving more memory per flop go first
+				std::vector<std::pair<float, std::set<std::string> > > candidates;
+				for(std::set<std::string>::const_iterator it = layers_used_by_backward.begin(); it != layers_used_by_backward.end(); ++it)
+				{
+					if (recomputable_layers.find(*it) == recomputable_layers.end())
+						continue;
+
+					std::set<std::string> candidate_layers;
+					std::vector<std::string> layers_to_visit(1, *it);
+					while (!layers_to_visit.empty())
+					{
+						std::string layer_name = layers_to_visit.back();
+						layers_to_visit.pop_back();
+						if (!candidate_layers.insert(layer_name).second)
+							continue;
+						layer::const_ptr l = schema->get_layer(layer_name);
+						for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2)
+							if ((recomputable_layers.find(*it2) != recomputable_layers.end()) && (layers_used_by_backward.find(*it2) == layers_used_by_backward.end()))
+								layers_to_visit.push_back(*it2);
+					}
+
+					double saved_size = 0.0;
+					double recompute_flops = 0.0;
+					for(std::set<std::string>::const_iterator it2 = candidate_layers.begin(); it2 != candidate_layers.end(); ++it2)
+					{
+						layer::const_ptr l = schema->get_layer(*it2);
+						std::vector<layer_configuration_specific> input_layer_configuration_specific_list;
+						for(std::vector<std::string>::const_iterator it3 = l->input_layer_instance_names.begin(); it3 != l->input_layer_instance_names.end(); ++it3)
+							input_layer_configuration_specific_list.push_back(layer_config_map[*it3]);
+						saved_size += static_cast<double>(layer_config_map[*it2].get_neuron_count() * cumulative_tiling_factor_map[*it2] * sizeof(float));
+						saved_size += static_cast<double>(updaters[*it2]->get_temporary_per_entry_buffer_size(layer_name_to_action_set_map[*it2], plain_config, l, input_layer_configuration_specific_list, layer_config_map[*it2]) * cumulative_tiling_factor_map[*it2]);
+						recompute_flops += static_cast<double>(l->get_flops_per_entry(input_layer_configuration_specific_list, layer_action(layer_action::forward)) * cumulative_tiling_factor_map[*it2]);
+					}
+
+					candidates.push_back(std::make_pair(-static_cast<float>(saved_size / (recompute_flops + 1.0)), candidate_layers));
+				}
+				std::stable_sort(candidates.begin(), candidates.end());
+
+				std::vector<bool> candidate_selected(candidates.size(), false);
+				size_t current_peak_size = peak_size_without_recompute;
+				for(unsigned int i = 0; (i < candidates.size()) && (current_peak_size > peak_budget); ++i)
+				{
+					std::set<std::string> trial_layers_to_recompute = new_layers_to_recompute;
+					trial_layers_to_recompute.insert(candidates[i].second.begin(), candidates[i].second.end());
+					size_t new_peak_size = get_per_entry_buffer_peak_size(trial_layers_to_recompute) + dedicated_size;
+					if (new_peak_size < current_peak_size)
+					{
+						new_layers_to_recompute = trial_layers_to_recompute;
+						candidate_selected[i] = true;
+						current_peak_size = new_peak_size;
+					}
+				}
+
+				// Keep the activations which are the most expensive to recompute, if the budget allows
+				if (current_peak_size <= peak_budget)
+				{
+					for(int i = static_cast<int>(candidates.size()) - 1; i >= 0; --i)
+					{
+						if (!candidate_selected[i])
+							continue;
+						std::set<std::string> trial_layers_to_recompute;
+						for(unsigned int j = 0; j < candidates.size(); ++j)
+							if (candidate_selected[j] && (j != static_cast<unsigned int>(i)))
+								trial_layers_to_recompute.insert(candidates[j].second.begin(), candidates[j].second.end());
+						size_t new_peak_size = get_per_entry_buffer_peak_size(trial_layers_to_recompute) + dedicated_size;
+						if (new_peak_size <= peak_budget)
+						{
+							new_layers_to_recompute = trial_layers_to_recompute;
+							candidate_selected[i] = false;
+						}
+					}
+				}
+			}
+
+			if (new_layers_to_recompute != layers_to_recompute)
+			{
+				layers_to_recompute = new_layers_to_recompute;
+
+				setup_sequential_action_schema();
+
+				setup_layer_buffer_sizes();
+
+				update_buffer_config();
+
+				// The estimate might be wrong, never do recompute if it doesn't actually save memory
+				if ((!layers_to_recompute.empty()) && (buffer_config_without_data_and_momentum.per_entry_buffer_size >= per_entry_buffer_size_without_recompute))
+				{
+					layers_to_recompute.clear();
+
+					setup_sequential_action_schema();
+
+					setup_layer_buffer_sizes();
+
+					update_buffer_config();
+				}
+			}
+
+			if (debug->is_debug())
+			{
+				std::stringstream debug_str;
+				debug_str << "backward prop plain recompute for batch " << batch_size << ": " << layers_to_recompute.size() << " layers";
+				for(std::set<std::string>::const_iterator it = layers_to_recompute.begin(); it != layers_to_recompute.end(); ++it)
+					debug_str << ((it == layers_to_recompute.begin()) ? " - " : ", ") << *it;
+				debug->output_message(debug_str.str().c_str());
+			}
+		}
+
+		std::vector<layer_name_with_action> backward_propagation_plain::get_actions_with_recompute(const std::set<std::string>& layers_to_recompute)
+		{
+			if (layers_to_recompute.empty() && layers_to_pack.empty())
+				return actions_in_execution_order;
+
+			// Recompute (or restore of the packed output) is done just before the first backward action using the output, all the forward actions are done by then
+			std::vector<layer_name_with_action> res;
+			std::set<std::string> recomputed_layer_names;
+			for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
+			{
+				std::vector<std::string> layers_used = get_forward_output_layers_used(*it);
+				std::vector<std::string> output_layers_used = get_forward_output_layers_used(*it, false);
+				for(std::vector<std::string>::const_iterator it2 = layers_used.begin(); it2 != layers_used.end(); ++it2)
+				{
+					if (is_layer_packed(*it2, layers_to_recompute) && (std::find(output_layers_used.begin(), output_layers_used.end(), *it2) == output_layers_used.end()))
+						continue;
+					add_recompute_action(*it2, layers_to_recompute, recomputed_layer_names, res);
+				}
+				res.push_back(*it);
+			}
+
+			return res;
+		}
+
+		void backward_propagation_plain::add_recompute_action(
+			const std::string& layer_name,
+			const std::set<std::string>& layers_to_recompute,
+			std::set<std::string>& recomputed_layer_names,
+			std::vector<layer_name_with_action>& actions) const
+		{
+			bool is_packed = is_layer_packed(layer_name, layers_to_recompute);
+			if ((!is_packed) && (layers_to_recompute.find(layer_name) == layers_to_recompute.end()))
+				return;
+			if (!recomputed_layer_names.insert(layer_name).second)
+				return;
+
+			// Packed output is restored without its inputs
+			if (!is_packed)
+			{
+				layer::const_ptr l = schema->get_layer(layer_name);
+				for(std::vector<std::string>::const_iterator it = l->input_layer_instance_names.begin(); it != l->input_layer_instance_names.end(); ++it)
+					add_recompute_action(*it, layers_to_recompute, recomputed_layer_names, actions);
+			}
+
+			actions.push_back(layer_name_with_action(layer_name, layer_action(layer_action::recompute_forward)));
+		}
+
+		std::vector<std::string> backward_propagation_plain::get_forward_output_layers_used(
+			const layer_name_with_action& action,
+			bool include_temporary_buffers)
+		{
+			std::vector<std::string> res;
+
+			std::string layer_name = action.get_name();
+			layer::const_ptr l = schema->get_layer(layer_name);
+			layer_updater_plain::const_ptr updater = updaters[layer_name];
+			layer_configuration_specific output_layer_configuration_specific = layer_config_map[layer_name];
+			std::vector<layer_configuration_specific> input_layer_configuration_specific_list;
+			for(std::vector<std::string>::const_iterator it = l->input_layer_instance_names.begin(); it != l->input_layer_instance_names.end(); ++it)
+				input_layer_configuration_specific_list.push_back(layer_config_map[*it]);
+			const std::set<layer_action>& actions = layer_name_to_action_set_map[layer_name];
+
+			switch (action.get_action().get_action_type())
+			{
+			case layer_action::backward_data:
+				{
+					unsigned int action_input_index = action.get_action().get_backprop_index();
+					unsigned int data_input_index = 0;
+					for(std::vector<std::string>::const_iterator it = l->input_layer_instance_names.begin(); it != l->input_layer_instance_names.end(); ++it, ++data_input_index)
+						if ((data_layer_names.find(*it) == data_layer_names.end()) && updater->is_backward_data_dependent_on_input_buffer(action_input_index, data_input_index, actions, plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
+							res.push_back(*it);
+					if (updater->is_backward_data_dependent_on_output_buffer(action_input_index, actions, plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific)
+						|| (include_temporary_buffers && updater->is_backward_data_dependent_on_temporary_per_entry_buffer(action_input_index, actions, plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific)))
+						res.push_back(layer_name);
+				}
+				break;
+			case layer_action::backward_weights:
+				{
+					unsigned int data_input_index = 0;
+					for(std::vector<std::string>::const_iterator it = l->input_layer_instance_names.begin(); it != l->input_layer_instance_names.end(); ++it, ++data_input_index)
+						if ((data_layer_names.find(*it) == data_layer_names.end()) && updater->is_backward_weights_dependent_on_input_buffer(data_input_index, actions, plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
+							res.push_back(*it);
+					if (include_temporary_buffers && updater->is_backward_weights_dependent_on_temporary_per_entry_buffer(actions, plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
+						res.push_back(layer_name);
+				}
+				break;
+			default:
+				// Forward and recompute actions don't depend on forward outputs kept for backward prop
+				break;
+			}
+
+			return res;
+		}
+
+		layer_name_with_action backward_propagation_plain::get_forward_output_action(
+			const std::string& layer_name,
+			const layer_action& consumer_action,
+			const std::set<std::string>& layers_to_recompute) const
+		{
+			// Forward actions always use original outputs, all the others use recomputed or restored ones
+			if ((consumer_action.get_action_type() != layer_action::forward)
+				&& ((layers_to_recompute.find(layer_name) != layers_to_recompute.end()) || is_layer_packed(layer_name, layers_to_recompute)))
+				return layer_name_with_action(layer_name, layer_action(layer_action::recompute_forward));
+			else
+				return layer_name_with_action(layer_name, layer_action(layer_action::forward));
+		}
+
+		layer_name_with_action backward_propagation_plain::get_temporary_buffer_action(
+			const std::string& layer_name,
+			const layer_action& consumer_action,
+			const std::set<std::string>& layers_to_recompute) const
+		{
+			if (is_layer_packed(layer_name, layers_to_recompute))
+				return layer_name_with_action(layer_name, layer_action(layer_action::forward));
+			else
+				return get_forward_output_action(layer_name, consumer_action, layers_to_recompute);
+		}
+
+		bool backward_propagation_plain::is_layer_packed(
+			const std::string& layer_name,
+			const std::set<std::string>& layers_to_recompute) const
+		{
+			return (layers_to_pack.find(layer_name) != layers_to_pack.end()) && (layers_to_recompute.find(layer_name) == layers_to_recompute.end());
+		}
+
+		size_t backward_propagation_plain::get_per_entry_buffer_peak_size(const std::set<std::string>& layers_to_recompute)
+		{
+			std::vector<layer_name_with_action> actions = get_actions_with_recompute(layers_to_recompute);
+			std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, float> > > buffers;
+			std::map<layer_name_with_action, std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, bool> > > > dependencies;
+			fill_buffers_and_dependencies(actions, layers_to_recompute, buffers, dependencies);
+			return get_per_entry_buffer_peak_size(actions, buffers, dependencies);
+		}
+
+		size_t backward_propagation_plain::get_per_entry_buffer_peak_size(
+			const std::vector<layer_name_with_action>& actions,
+			const std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, float> > >& buffers,
+			const std::map<layer_name_with_action, std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, bool> > > >& dependencies) const
+		{
+			std::map<layer_name_with_action, unsigned int> action_to_position_map;
+			for(unsigned int i = 0; i < actions.size(); ++i)
+				action_to_position_map.insert(std::make_pair(actions[i], i));
+
+			std::map<std::pair<layer_name_with_action, buffer_lifetime>, unsigned int> last_use_position_map;
+			for(std::map<layer_name_with_action, std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, bool> > > >::const_iterator it = dependencies.begin(); it != dependencies.end(); ++it)
+			{
+				unsigned int position = action_to_position_map[it->first];
+				for(std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, bool> > >::const_iterator it2 = it->second.begin(); it2 != it->second.end(); ++it2)
+				{
+					for(std::vector<std::pair<buffer_lifetime, bool> >::const_iterator it3 = it2->second.begin(); it3 != it2->second.end(); ++it3)
+					{
+						unsigned int& last_use_position = last_use_position_map.insert(std::make_pair(std::make_pair(it2->first, it3->first), position)).first->second;
+						last_use_position = std::max(last_use_position, position);
+					}
+				}
+			}
+
+			// Each buffer is alive from the action producing it till the last action using it
+			std::vector<double> size_delta_list(actions.size() + 1, 0.0);
+			for(std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, float> > >::const_iterator it = buffers.begin(); it != buffers.end(); ++it)
+			{
+				unsigned int start_position = action_to_position_map[it->first];
+				for(std::vector<std::pair<buffer_lifetime, float> >::const_iterator it2 = it->second.begin(); it2 != it->second.end(); ++it2)
+				{
+					unsigned int end_position = start_position;
+					std::map<std::pair<layer_name_with_action, buffer_lifetime>, unsigned int>::const_iterator last_use_it = last_use_position_map.find(std::make_pair(it->first, it2->first));
+					if (last_use_it != last_use_position_map.end())
+						end_position = std::max(end_position, last_use_it->second);
+					size_delta_list[start_position] += static_cast<double>(it2->second);
+					size_delta_list[end_position + 1] -= static_cast<double>(it2->second);
+				}
+			}
+
+			double current_size = 0.0;
+			double peak_size = 0.0;
+			for(std::vector<double>::const_iterator it = size_delta_list.begin(); it != size_delta_list.end(); ++it)
+			{
+				current_size += *it;
+				peak_size = std::max(peak_size, current_size);
+			}
+
+			return static_cast<size_t>(peak_size);
 		}
 
 		void backward_propagation_plain::setup_dedicated_buffer_sizes()
@@ -569,163 +1186,48 @@ namespace nnforge
 			{
 				std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, float> > > buffers;
 				std::map<layer_name_with_action, std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, bool> > > > dependencies;
-				std::set<std::string> dedicated_output_buffers(output_layer_names.begin(), output_layer_names.end());
-				for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
-				{
-					std::string layer_name = it->get_name();
-					layer::const_ptr l = schema->get_layer(layer_name);
-					layer_updater_plain::const_ptr updater = updaters[layer_name];
-					layer_configuration_specific output_layer_configuration_specific = layer_config_map[layer_name];
-					std::vector<layer_configuration_specific> input_layer_configuration_specific_list;
-					for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2)
-						input_layer_configuration_specific_list.push_back(layer_config_map[*it2]);
-
-					std::vector<std::pair<buffer_lifetime, float> > current_buffers;
-					{
-						switch (it->get_action().get_action_type())
-						{
-						case layer_action::forward:
-							{
-								size_t buffer_size_per_entry = layer_config_map.find(layer_name)->second.get_neuron_count() * cumulative_tiling_factor_map[layer_name] * sizeof(float);
-								if (dedicated_output_buffers.find(it->get_name()) == dedicated_output_buffers.end())
-										current_buffers.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), static_cast<float>(buffer_size_per_entry)));
-							}
-							{
-								size_t temporary_per_entry_buffer_size = updater->get_temporary_per_entry_buffer_size(
-									layer_name_to_action_set_map[layer_name],
-									plain_config,
-									l,
-									input_layer_configuration_specific_list,
-									output_layer_configuration_specific) * cumulative_tiling_factor_map[layer_name];
-								if (temporary_per_entry_buffer_size > 0)
-									current_buffers.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::temporary_buffer), static_cast<float>(temporary_per_entry_buffer_size)));
-							}
-							break;
-						case layer_action::backward_data:
-							{
-								const std::string& previous_layer_name = schema->get_layer(layer_name)->input_layer_instance_names[it->get_action().get_backprop_index()];
-								size_t buffer_size_per_entry = layer_config_map.find(previous_layer_name)->second.get_neuron_count() * cumulative_tiling_factor_map[previous_layer_name] * sizeof(float);
-								current_buffers.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), static_cast<float>(buffer_size_per_entry)));
-							}
-							break;
-						}
-
-						{
-							size_t temporary_working_per_entry_buffer_size = updater->get_temporary_working_per_entry_buffer_size(
-								it->get_action(),
-								layer_name_to_action_set_map[layer_name],
-								plain_config,
-								l,
-								input_layer_configuration_specific_list,
-								output_layer_configuration_specific) * cumulative_tiling_factor_map[layer_name];
-							if (temporary_working_per_entry_buffer_size > 0)
-								current_buffers.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::working_buffer), static_cast<float>(temporary_working_per_entry_buffer_size)));
-						}
-					}
-
-					if (!current_buffers.empty())
-						buffers.insert(std::make_pair(*it, current_buffers));
-
-					int input_index_layer_can_write;
-					{
-						layer_configuration_specific output_layer_configuration_specific = layer_config_map[layer_name];
-						layer::const_ptr l = schema->get_layer(layer_name);
-						std::vector<layer_configuration_specific> input_layer_configuration_specific_list;
-						for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2)
-							input_layer_configuration_specific_list.push_back(layer_config_map[*it2]);
-						input_index_layer_can_write = updaters[layer_name]->get_input_index_layer_can_write(
-							it->get_action(),
-							layer_name_to_action_set_map[layer_name],
-							plain_config,
-							l,
-							input_layer_configuration_specific_list,
-							output_layer_configuration_specific);
-					}
-
-					std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, bool> > > current_dependencies;
-					{
-						layer::const_ptr l = schema->get_layer(it->get_name());
-						switch (it->get_action().get_action_type())
-						{
-						case layer_action::forward:
-							{
-								int input_index = 0;
-								for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2, ++input_index)
-								{
-									const std::string& previous_layer_name = *it2;
-									if (data_layer_names.find(previous_layer_name) == data_layer_names.end())
-										current_dependencies.insert(std::make_pair(layer_name_with_action(previous_layer_name, layer_action(layer_action::forward)), std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(
-											std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), (input_index_layer_can_write == input_index)));
-								}
-							}
-							break;
-						case layer_action::backward_weights:
-							{
-								unsigned int data_input_index = 0;
-								for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2, ++data_input_index)
-								{
-									const std::string& previous_layer_name = *it2;
-									if ((data_layer_names.find(previous_layer_name) == data_layer_names.end()) &&
-										updater->is_backward_weights_dependent_on_input_buffer(data_input_index, layer_name_to_action_set_map[layer_name], plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
-									{
-										current_dependencies.insert(std::make_pair(layer_name_with_action(previous_layer_name, layer_action(layer_action::forward)), std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), false));
-									}
-								}
-								std::map<std::string, std::vector<layer_name_with_action> >::const_iterator input_to_all_output_it = input_to_all_output_map.find(l->instance_name);
-								if (input_to_all_output_it != input_to_all_output_map.end())
-									for(std::vector<layer_name_with_action>::const_iterator src_it = input_to_all_output_it->second.begin(); src_it != input_to_all_output_it->second.end(); ++src_it)
-										current_dependencies.insert(std::make_pair(*src_it, std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), false));
-								if (updater->is_backward_weights_dependent_on_temporary_per_entry_buffer(layer_name_to_action_set_map[layer_name], plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
-									current_dependencies.insert(std::make_pair(layer_name_with_action(it->get_name(), layer_action(layer_action::forward)), std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::temporary_buffer), false));
-							}
-							break;
-						case layer_action::backward_data:
-							{
-								unsigned int action_input_index = it->get_action().get_backprop_index();
-								unsigned int data_input_index = 0;
-								for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2, ++data_input_index)
-								{
-									const std::string& previous_layer_name = *it2;
-									if ((data_layer_names.find(previous_layer_name) == data_layer_names.end()) && updater->is_backward_data_dependent_on_input_buffer(action_input_index, data_input_index, layer_name_to_action_set_map[layer_name], plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
-										current_dependencies.insert(std::make_pair(layer_name_with_action(previous_layer_name, layer_action(layer_action::forward)), std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), false));
-								}
-								if (updater->is_backward_data_dependent_on_output_buffer(action_input_index, layer_name_to_action_set_map[layer_name], plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
-									current_dependencies.insert(std::make_pair(layer_name_with_action(it->get_name(), layer_action(layer_action::forward)), std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), false));
-								std::map<std::string, std::vector<layer_name_with_action> >::const_iterator input_to_all_output_it = input_to_all_output_map.find(l->instance_name);
-								if (input_to_all_output_it != input_to_all_output_map.end())
-									for(std::vector<layer_name_with_action>::const_iterator src_it = input_to_all_output_it->second.begin(); src_it != input_to_all_output_it->second.end(); ++src_it)
-										current_dependencies.insert(std::make_pair(*src_it, std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), (input_index_layer_can_write == 0)));
-								if (updater->is_backward_data_dependent_on_temporary_per_entry_buffer(action_input_index, layer_name_to_action_set_map[layer_name], plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
-									current_dependencies.insert(std::make_pair(layer_name_with_action(it->get_name(), layer_action(layer_action::forward)), std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::temporary_buffer), false));
-							}
-							break;
-						}
-					}
-
-					if (!current_dependencies.empty())
-						dependencies.insert(std::make_pair(*it, current_dependencies));
-				}
+				fill_buffers_and_dependencies(actions_to_run_in_execution_order, layers_to_recompute, buffers, dependencies);
 
 				std::vector<std::vector<std::pair<layer_name_with_action, buffer_lifetime> > > should_be_placed_into_the_same_buffers;
+				std::map<layer_name_with_action, unsigned int> action_to_same_buffers_index_map;
 				for(std::vector<std::vector<layer_name_with_action> >::const_iterator it = same_output_action_sets.begin(); it != same_output_action_sets.end(); ++it)
 				{
 					const std::vector<layer_name_with_action>& src_tt = *it;
 					should_be_placed_into_the_same_buffers.push_back(std::vector<std::pair<layer_name_with_action, buffer_lifetime> >());
 					std::vector<std::pair<layer_name_with_action, buffer_lifetime> >& tt = should_be_placed_into_the_same_buffers.back();
 					for(std::vector<layer_name_with_action>::const_iterator it2 = src_tt.begin(); it2 != src_tt.end(); ++it2)
+					{
 						tt.push_back(std::make_pair(*it2, buffer_lifetime(buffer_lifetime::action_output_buffer)));
+						action_to_same_buffers_index_map.insert(std::make_pair(*it2, static_cast<unsigned int>(should_be_placed_into_the_same_buffers.size() - 1)));
+					}
+				}
+
+				// Errors written by the loss layer for the fused softmax are softmax backward data output,
+				// the softmax action might already share its output with other actions writing errors for the same layer
+				for(std::set<layer_name_with_action>::const_iterator it = fused_softmax_actions.begin(); it != fused_softmax_actions.end(); ++it)
+				{
+					std::map<layer_name_with_action, unsigned int>::const_iterator same_buffers_index_it = action_to_same_buffers_index_map.find(*it);
+					if (same_buffers_index_it == action_to_same_buffers_index_map.end())
+					{
+						should_be_placed_into_the_same_buffers.push_back(std::vector<std::pair<layer_name_with_action, buffer_lifetime> >());
+						should_be_placed_into_the_same_buffers.back().push_back(std::make_pair(*it, buffer_lifetime(buffer_lifetime::action_output_buffer)));
+					}
+					std::vector<std::pair<layer_name_with_action, buffer_lifetime> >& tt = (same_buffers_index_it == action_to_same_buffers_index_map.end()) ? should_be_placed_into_the_same_buffers.back() : should_be_placed_into_the_same_buffers[same_buffers_index_it->second];
+					const std::vector<layer_name_with_action>& consumer_actions = input_to_all_output_map.find(it->get_name())->second;
+					tt.push_back(std::make_pair(consumer_actions.front(), buffer_lifetime(buffer_lifetime::action_output_buffer)));
 				}
 
 				layer_buffer_set_list = action_schema->get_buffer_set(
 					buffers,
 					dependencies,
-					std::vector<std::vector<std::pair<layer_name_with_action, buffer_lifetime> > >());
+					should_be_placed_into_the_same_buffers);
 			}
 
 			layer_buffer_set_per_entry_size_list.clear();
 			layer_buffer_action_to_set_map.clear();
 			temporary_working_per_entry_data_action_to_set_map.clear();
 			temporary_per_entry_data_action_to_set_map.clear();
+			packed_per_entry_data_action_to_set_map.clear();
 			for(unsigned int set_id = 0; set_id < layer_buffer_set_list.size(); ++set_id)
 			{
 				const std::vector<std::pair<layer_name_with_action, buffer_lifetime> >& action_list = layer_buffer_set_list[set_id];
@@ -748,6 +1250,7 @@ namespace nnforge
 						switch (it->first.get_action().get_action_type())
 						{
 						case layer_action::forward:
+						case layer_action::recompute_forward:
 							buffer_size_per_entry = layer_config_map.find(layer_name)->second.get_neuron_count() * cumulative_tiling_factor_map[layer_name] * sizeof(float);
 							break;
 						case layer_action::backward_data:
@@ -762,12 +1265,16 @@ namespace nnforge
 						break;
 					case buffer_lifetime::working_buffer:
 						temporary_working_per_entry_data_action_to_set_map.insert(std::make_pair(it->first, set_id));
-						buffer_size_per_entry = updaters[layer_name]->get_temporary_working_per_entry_buffer_size(it->first.get_action(), layer_name_to_action_set_map[layer_name], plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific) * cumulative_tiling_factor_map[layer_name];
+						buffer_size_per_entry = updaters[layer_name]->get_temporary_working_per_entry_buffer_size((it->first.get_action().get_action_type() == layer_action::recompute_forward) ? layer_action(layer_action::forward) : it->first.get_action(), layer_name_to_action_set_map[layer_name], plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific) * cumulative_tiling_factor_map[layer_name];
 						break;
 					case buffer_lifetime::temporary_buffer:
 						temporary_per_entry_data_action_to_set_map.insert(std::make_pair(it->first, set_id));
 						buffer_size_per_entry = updaters[layer_name]->get_temporary_per_entry_buffer_size(layer_name_to_action_set_map[layer_name], plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific) * cumulative_tiling_factor_map[layer_name];
 						break;
+					case buffer_lifetime::packed_buffer:
+						packed_per_entry_data_action_to_set_map.insert(std::make_pair(it->first, set_id));
+						buffer_size_per_entry = layer_config_map.find(layer_name)->second.get_neuron_count() * cumulative_tiling_factor_map[layer_name] * sizeof(unsigned short);
+						break;
 					default:
 						throw neural_network_exception((boost::format("Unexpected buffer lifetime %1% encountered for layer %2% action %3%") % it->second.str() % it->first.get_name() % it->first.get_action().str()).str());
 					}
@@ -804,6 +1311,171 @@ namespace nnforge
 			}
 		}
 
+		void backward_propagation_plain::fill_buffers_and_dependencies(
+			const std::vector<layer_name_with_action>& actions,
+			const std::set<std::string>& layers_to_recompute,
+			std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, float> > >& buffers,
+			std::map<layer_name_with_action, std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, bool> > > >& dependencies)
+		{
+			std::set<std::string> dedicated_output_buffers(output_layer_names.begin(), output_layer_names.end());
+			for(std::vector<layer_name_with_action>::const_iterator it = actions.begin(); it != actions.end(); ++it)
+			{
+				std::string layer_name = it->get_name();
+				layer::const_ptr l = schema->get_layer(layer_name);
+				layer_updater_plain::const_ptr updater = updaters[layer_name];
+				layer_configuration_specific output_layer_configuration_specific = layer_config_map[layer_name];
+				std::vector<layer_configuration_specific> input_layer_configuration_specific_list;
+				for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2)
+					input_layer_configuration_specific_list.push_back(layer_config_map[*it2]);
+				// Updaters are not aware of recompute, it is just another forward prop for them
+				layer_action updater_action = (it->get_action().get_action_type() == layer_action::recompute_forward) ? layer_action(layer_action::forward) : it->get_action();
+				bool is_packed = is_layer_packed(layer_name, layers_to_recompute);
+				// Restore of the packed output just unpacks it, updater is not involved
+				bool is_restore = is_packed && (it->get_action().get_action_type() == layer_action::recompute_forward);
+
+				std::vector<std::pair<buffer_lifetime, float> > current_buffers;
+				{
+					switch (it->get_action().get_action_type())
+					{
+					case layer_action::forward:
+					case layer_action::recompute_forward:
+						{
+							size_t buffer_size_per_entry = layer_config_map.find(layer_name)->second.get_neuron_count() * cumulative_tiling_factor_map[layer_name] * sizeof(float);
+							if (dedicated_output_buffers.find(it->get_name()) == dedicated_output_buffers.end())
+									current_buffers.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), static_cast<float>(buffer_size_per_entry)));
+						}
+						if (is_restore)
+							break;
+						if (is_packed)
+						{
+							size_t packed_buffer_size_per_entry = layer_config_map.find(layer_name)->second.get_neuron_count() * cumulative_tiling_factor_map[layer_name] * sizeof(unsigned short);
+							current_buffers.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::packed_buffer), static_cast<float>(packed_buffer_size_per_entry)));
+						}
+						{
+							size_t temporary_per_entry_buffer_size = updater->get_temporary_per_entry_buffer_size(
+								layer_name_to_action_set_map[layer_name],
+								plain_config,
+								l,
+								input_layer_configuration_specific_list,
+								output_layer_configuration_specific) * cumulative_tiling_factor_map[layer_name];
+							if (temporary_per_entry_buffer_size > 0)
+								current_buffers.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::temporary_buffer), static_cast<float>(temporary_per_entry_buffer_size)));
+						}
+						break;
+					case layer_action::backward_data:
+						{
+							const std::string& previous_layer_name = schema->get_layer(layer_name)->input_layer_instance_names[it->get_action().get_backprop_index()];
+							size_t buffer_size_per_entry = layer_config_map.find(previous_layer_name)->second.get_neuron_count() * cumulative_tiling_factor_map[previous_layer_name] * sizeof(float);
+							current_buffers.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), static_cast<float>(buffer_size_per_entry)));
+						}
+						break;
+					}
+
+					if (!is_restore)
+					{
+						size_t temporary_working_per_entry_buffer_size = updater->get_temporary_working_per_entry_buffer_size(
+							updater_action,
+							layer_name_to_action_set_map[layer_name],
+							plain_config,
+							l,
+							input_layer_configuration_specific_list,
+							output_layer_configuration_specific) * cumulative_tiling_factor_map[layer_name];
+						if (temporary_working_per_entry_buffer_size > 0)
+							current_buffers.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::working_buffer), static_cast<float>(temporary_working_per_entry_buffer_size)));
+					}
+				}
+
+				if (!current_buffers.empty())
+					buffers.insert(std::make_pair(*it, current_buffers));
+
+				int input_index_layer_can_write;
+				{
+					layer_configuration_specific output_layer_configuration_specific = layer_config_map[layer_name];
+					layer::const_ptr l = schema->get_layer(layer_name);
+					std::vector<layer_configuration_specific> input_layer_configuration_specific_list;
+					for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2)
+						input_layer_configuration_specific_list.push_back(layer_config_map[*it2]);
+					input_index_layer_can_write = updaters[layer_name]->get_input_index_layer_can_write(
+						updater_action,
+						layer_name_to_action_set_map[layer_name],
+						plain_config,
+						l,
+						input_layer_configuration_specific_list,
+						output_layer_configuration_specific);
+				}
+
+				std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, bool> > > current_dependencies;
+				{
+					layer::const_ptr l = schema->get_layer(it->get_name());
+					switch (it->get_action().get_action_type())
+					{
+					case layer_action::forward:
+					case layer_action::recompute_forward:
+						if (is_restore)
+						{
+							current_dependencies.insert(std::make_pair(layer_name_with_action(layer_name, layer_action(layer_action::forward)), std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(
+								std::make_pair(buffer_lifetime(buffer_lifetime::packed_buffer), false));
+						}
+						else
+						{
+							int input_index = 0;
+							for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2, ++input_index)
+							{
+								const std::string& previous_layer_name = *it2;
+								if (data_layer_names.find(previous_layer_name) == data_layer_names.end())
+									current_dependencies.insert(std::make_pair(get_forward_output_action(previous_layer_name, it->get_action(), layers_to_recompute), std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(
+										std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), (input_index_layer_can_write == input_index)));
+							}
+						}
+						break;
+					case layer_action::backward_weights:
+						{
+							unsigned int data_input_index = 0;
+							for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2, ++data_input_index)
+							{
+								const std::string& previous_layer_name = *it2;
+								if ((data_layer_names.find(previous_layer_name) == data_layer_names.end()) &&
+									updater->is_backward_weights_dependent_on_input_buffer(data_input_index, layer_name_to_action_set_map[layer_name], plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
+								{
+									current_dependencies.insert(std::make_pair(get_forward_output_action(previous_layer_name, it->get_action(), layers_to_recompute), std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), false));
+								}
+							}
+							std::map<std::string, std::vector<layer_name_with_action> >::const_iterator input_to_all_output_it = input_to_all_output_map.find(l->instance_name);
+							if (input_to_all_output_it != input_to_all_output_map.end())
+								for(std::vector<layer_name_with_action>::const_iterator src_it = input_to_all_output_it->second.begin(); src_it != input_to_all_output_it->second.end(); ++src_it)
+									current_dependencies.insert(std::make_pair(*src_it, std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), false));
+							if (updater->is_backward_weights_dependent_on_temporary_per_entry_buffer(layer_name_to_action_set_map[layer_name], plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
+								current_dependencies.insert(std::make_pair(get_temporary_buffer_action(it->get_name(), it->get_action(), layers_to_recompute), std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::temporary_buffer), false));
+						}
+						break;
+					case layer_action::backward_data:
+						{
+							unsigned int action_input_index = it->get_action().get_backprop_index();
+							unsigned int data_input_index = 0;
+							for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2, ++data_input_index)
+							{
+								const std::string& previous_layer_name = *it2;
+								if ((data_layer_names.find(previous_layer_name) == data_layer_names.end()) && updater->is_backward_data_dependent_on_input_buffer(action_input_index, data_input_index, layer_name_to_action_set_map[layer_name], plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
+									current_dependencies.insert(std::make_pair(get_forward_output_action(previous_layer_name, it->get_action(), layers_to_recompute), std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), false));
+							}
+							if (updater->is_backward_data_dependent_on_output_buffer(action_input_index, layer_name_to_action_set_map[layer_name], plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
+								current_dependencies.insert(std::make_pair(get_forward_output_action(it->get_name(), it->get_action(), layers_to_recompute), std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), false));
+							std::map<std::string, std::vector<layer_name_with_action> >::const_iterator input_to_all_output_it = input_to_all_output_map.find(l->instance_name);
+							if (input_to_all_output_it != input_to_all_output_map.end())
+								for(std::vector<layer_name_with_action>::const_iterator src_it = input_to_all_output_it->second.begin(); src_it != input_to_all_output_it->second.end(); ++src_it)
+									current_dependencies.insert(std::make_pair(*src_it, std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), (input_index_layer_can_write == 0)));
+							if (updater->is_backward_data_dependent_on_temporary_per_entry_buffer(action_input_index, layer_name_to_action_set_map[layer_name], plain_config, l, input_layer_configuration_specific_list, output_layer_configuration_specific))
+								current_dependencies.insert(std::make_pair(get_temporary_buffer_action(it->get_name(), it->get_action(), layers_to_recompute), std::vector<std::pair<buffer_lifetime, bool> >())).first->second.push_back(std::make_pair(buffer_lifetime(buffer_lifetime::temporary_buffer), false));
+						}
+						break;
+					}
+				}
+
+				if (!current_dependencies.empty())
+					dependencies.insert(std::make_pair(*it, current_dependencies));
+			}
+		}
+
 		void backward_propagation_plain::update_buffer_config()
 		{
 			buffer_plain_size_configuration buffer_configuration;
@@ -819,138 +1491,123 @@ namespace nnforge
 			buffer_config_without_data_and_momentum = buffer_configuration;
 		}
 
+		bool backward_propagation_plain::is_gradient_allreduce_supported() const
+		{
+			return true;
+		}
+
 		void backward_propagation_plain::apply_gradient(
-			const std::string& layer_name,
-			layer_data::ptr data,
-			layer_data::ptr gradient,
-			layer_data::ptr previous_upd,
-			layer_data::ptr previous_upd2,
-			std::vector<double>& updates_accumulated,
-			const std::vector<float>& learning_rates,
+			const std::vector<update_segment>& update_segment_list,
+			parameter_arena& data_arena,
+			parameter_arena& gradient_arena,
+			parameter_arena::ptr previous_upd_arena,
+			parameter_arena::ptr previous_upd2_arena,
 			float normalizer,
 			float weight_decay,
 			training_momentum momentum,
 			unsigned int iteration_id) const
 		{
+			// Gradient is summed across workers already
+			if (gradient_allreducer)
+				normalizer /= static_cast<float>(gradient_allreducer->get_worker_count());
+
+			float * const data = data_arena.get_data();
+			float * const gradient = gradient_arena.get_data();
+
 			switch (momentum.type)
 			{
 			case training_momentum::no_momentum:
 				{
-					layer_data::iterator gradient_it = gradient->begin();
-					std::vector<double>::iterator updates_accumulated_it = updates_accumulated.begin();
-					std::vector<float>::const_iterator learning_rate_it = learning_rates.begin();
-					std::set<unsigned int> weight_decay_part_id_set = schema->get_layer(layer_name)->get_weight_decay_part_id_set();
-					unsigned int part_id = 0;
-					double accum = 0.0;
-					for(layer_data::iterator data_it = data->begin(); data_it != data->end(); ++data_it, ++gradient_it, ++learning_rate_it, ++part_id, ++updates_accumulated_it)
+					for(std::vector<update_segment>::const_iterator it = update_segment_list.begin(); it != update_segment_list.end(); ++it)
 					{
-						float actual_weight_decay = (weight_decay_part_id_set.find(part_id) == weight_decay_part_id_set.end()) ? 0.0F : weight_decay;
-						std::vector<float>::iterator gradient_it2 = gradient_it->begin();
-						float learning_rate = *learning_rate_it;
-						for(std::vector<float>::iterator data_it2 = data_it->begin(); data_it2 != data_it->end(); ++data_it2, ++gradient_it2)
+						const float learning_rate = it->learning_rate;
+						const float actual_weight_decay = it->is_weight_decay ? weight_decay : 0.0F;
+						const size_t end = it->offset + it->size;
+						double accum = 0.0;
+						for(size_t i = it->offset; i < end; ++i)
 						{
-							float current_weight = *data_it2;
-							float gr = *gradient_it2;
+							float current_weight = data[i];
+							float gr = gradient[i];
 							float upd = learning_rate * (gr * normalizer - current_weight * actual_weight_decay);
 							accum += static_cast<double>(fabsf(upd));
 							float new_weight = current_weight + upd;
-							*data_it2 = new_weight;
-							*gradient_it2 = 0.0F;
+							data[i] = new_weight;
+							gradient[i] = 0.0F;
 						}
-						*updates_accumulated_it += accum;
+						*it->updates_accumulated += accum;
 					}
 				}
 				break;
 			case training_momentum::vanilla_momentum:
 				{
-					layer_data::iterator gradient_it = gradient->begin();
-					layer_data::iterator previous_upd_it = previous_upd->begin();
-					std::vector<double>::iterator updates_accumulated_it = updates_accumulated.begin();
-					std::vector<float>::const_iterator learning_rate_it = learning_rates.begin();
-					std::set<unsigned int> weight_decay_part_id_set = schema->get_layer(layer_name)->get_weight_decay_part_id_set();
-					unsigned int part_id = 0;
-					for(layer_data::iterator data_it = data->begin(); data_it != data->end(); ++data_it, ++gradient_it, ++previous_upd_it, ++learning_rate_it, ++part_id, ++updates_accumulated_it)
+					float * const previous_upd = previous_upd_arena->get_data();
+					for(std::vector<update_segment>::const_iterator it = update_segment_list.begin(); it != update_segment_list.end(); ++it)
 					{
-						float actual_weight_decay = (weight_decay_part_id_set.find(part_id) == weight_decay_part_id_set.end()) ? 0.0F : weight_decay;
-						std::vector<float>::iterator gradient_it2 = gradient_it->begin();
-						std::vector<float>::iterator previous_upd_it2 = previous_upd_it->begin();
-						float learning_rate = *learning_rate_it;
+						const float learning_rate = it->learning_rate;
+						const float actual_weight_decay = it->is_weight_decay ? weight_decay : 0.0F;
+						const size_t end = it->offset + it->size;
 						double accum = 0.0;
-						for(std::vector<float>::iterator data_it2 = data_it->begin(); data_it2 != data_it->end(); ++data_it2, ++gradient_it2, ++previous_upd_it2)
+						for(size_t i = it->offset; i < end; ++i)
 						{
-							float current_weight = *data_it2;
-							float gr = *gradient_it2;
-							float prev_upd = *previous_upd_it2;
+							float current_weight = data[i];
+							float gr = gradient[i];
+							float prev_upd = previous_upd[i];
 							float upd = prev_upd * momentum.momentum_val + learning_rate * (gr * normalizer - current_weight * actual_weight_decay);
 							accum += static_cast<double>(fabsf(upd));
 							float new_weight = current_weight + upd;
-							*data_it2 = new_weight;
-							*gradient_it2 = 0.0F;
-							*previous_upd_it2 = upd;
+							data[i] = new_weight;
+							gradient[i] = 0.0F;
+							previous_upd[i] = upd;
 						}
-						*updates_accumulated_it += accum;
+						*it->updates_accumulated += accum;
 					}
 				}
 				break;
 			case training_momentum::nesterov_momentum:
 				{
-					layer_data::iterator gradient_it = gradient->begin();
-					layer_data::iterator previous_upd_it = previous_upd->begin();
-					std::vector<double>::iterator updates_accumulated_it = updates_accumulated.begin();
-					std::vector<float>::const_iterator learning_rate_it = learning_rates.begin();
-					std::set<unsigned int> weight_decay_part_id_set = schema->get_layer(layer_name)->get_weight_decay_part_id_set();
-					unsigned int part_id = 0;
-					for(layer_data::iterator data_it = data->begin(); data_it != data->end(); ++data_it, ++gradient_it, ++previous_upd_it, ++learning_rate_it, ++part_id, ++updates_accumulated_it)
+					float * const previous_upd = previous_upd_arena->get_data();
+					const float mp1 = momentum.momentum_val + 1.0F;
+					for(std::vector<update_segment>::const_iterator it = update_segment_list.begin(); it != update_segment_list.end(); ++it)
 					{
-						float actual_weight_decay = (weight_decay_part_id_set.find(part_id) == weight_decay_part_id_set.end()) ? 0.0F : weight_decay;
-						std::vector<float>::iterator gradient_it2 = gradient_it->begin();
-						std::vector<float>::iterator previous_upd_it2 = previous_upd_it->begin();
-						float learning_rate = *learning_rate_it;
+						const float learning_rate = it->learning_rate;
+						const float actual_weight_decay = it->is_weight_decay ? weight_decay : 0.0F;
+						const size_t end = it->offset + it->size;
 						double accum = 0.0;
-						float mp1 = momentum.momentum_val + 1.0F;
-						for(std::vector<float>::iterator data_it2 = data_it->begin(); data_it2 != data_it->end(); ++data_it2, ++gradient_it2, ++previous_upd_it2)
+						for(size_t i = it->offset; i < end; ++i)
 						{
-							float current_weight = *data_it2;
-							float gr = *gradient_it2;
-							float prev_upd = *previous_upd_it2;
+							float current_weight = data[i];
+							float gr = gradient[i];
+							float prev_upd = previous_upd[i];
 							float new_upd = prev_upd * momentum.momentum_val + learning_rate * (gr * normalizer - current_weight * actual_weight_decay);
 							float upd = mp1 * new_upd - momentum.momentum_val * prev_upd;
 							accum += static_cast<double>(fabsf(upd));
 							float new_weight = current_weight + upd;
-							*data_it2 = new_weight;
-							*gradient_it2 = 0.0F;
-							*previous_upd_it2 = new_upd;
+							data[i] = new_weight;
+							gradient[i] = 0.0F;
+							previous_upd[i] = new_upd;
 						}
-						*updates_accumulated_it += accum;
+						*it->updates_accumulated += accum;
 					}
 				}
 				break;
 			case training_momentum::adam_momentum:
 				{
-					layer_data::iterator gradient_it = gradient->begin();
-					layer_data::iterator previous_upd_it = previous_upd->begin();
-					layer_data::iterator previous_upd2_it = previous_upd2->begin();
-					std::vector<double>::iterator updates_accumulated_it = updates_accumulated.begin();
-					std::vector<float>::const_iterator learning_rate_it = learning_rates.begin();
-					std::set<unsigned int> weight_decay_part_id_set = schema->get_layer(layer_name)->get_weight_decay_part_id_set();
-					unsigned int part_id = 0;
-					float one_minus_beta1t_inverted = 1.0F / (1.0F - powf(momentum.momentum_val, static_cast<float>(iteration_id)));
-					float one_minus_beta2t_inverted = 1.0F / (1.0F - powf(momentum.momentum_val2, static_cast<float>(iteration_id)));
-					float epsilon = 1.0e-8F;
-					for(layer_data::iterator data_it = data->begin(); data_it != data->end(); ++data_it, ++gradient_it, ++previous_upd_it, ++previous_upd2_it, ++learning_rate_it, ++part_id, ++updates_accumulated_it)
+					float * const previous_upd = previous_upd_arena->get_data();
+					float * const previous_upd2 = previous_upd2_arena->get_data();
+					const float one_minus_beta1t_inverted = 1.0F / (1.0F - powf(momentum.momentum_val, static_cast<float>(iteration_id)));
+					const float one_minus_beta2t_inverted = 1.0F / (1.0F - powf(momentum.momentum_val2, static_cast<float>(iteration_id)));
+					const float epsilon = 1.0e-8F;
+					for(std::vector<update_segment>::const_iterator it = update_segment_list.begin(); it != update_segment_list.end(); ++it)
 					{
-						float actual_weight_decay = (weight_decay_part_id_set.find(part_id) == weight_decay_part_id_set.end()) ? 0.0F : weight_decay;
-						std::vector<float>::iterator gradient_it2 = gradient_it->begin();
-						std::vector<float>::iterator previous_upd_it2 = previous_upd_it->begin();
-						std::vector<float>::iterator previous_upd2_it2 = previous_upd2_it->begin();
-						float learning_rate = *learning_rate_it;
+						const float learning_rate = it->learning_rate;
+						const size_t end = it->offset + it->size;
 						double accum = 0.0;
-						for(std::vector<float>::iterator data_it2 = data_it->begin(); data_it2 != data_it->end(); ++data_it2, ++gradient_it2, ++previous_upd_it2, ++previous_upd2_it2)
+						for(size_t i = it->offset; i < end; ++i)
 						{
-							float current_weight = *data_it2;
-							float gr = *gradient_it2;
-							float previous_biased_first_momentum = *previous_upd_it2;
-							float previous_biased_second_momentum = *previous_upd2_it2;
+							float current_weight = data[i];
+							float gr = gradient[i];
+							float previous_biased_first_momentum = previous_upd[i];
+							float previous_biased_second_momentum = previous_upd2[i];
 							float total_gradient = gr * normalizer - current_weight * weight_decay;
 							float new_biased_first_momentum = momentum.momentum_val * previous_biased_first_momentum + (1.0F - momentum.momentum_val) * total_gradient;
 							float new_biased_second_momentum = momentum.momentum_val2 * previous_biased_second_momentum + (1.0F - momentum.momentum_val2) * total_gradient * total_gradient;
@@ -959,12 +1616,12 @@ namespace nnforge
 							float upd = (learning_rate * unbiased_first_momentum) / (sqrtf(unbiased_second_momentum) + epsilon);
 							float new_weight = current_weight + upd;
 							accum += static_cast<double>(fabsf(upd));
-							*data_it2 = new_weight;
-							*gradient_it2 = 0.0F;
-							*previous_upd_it2 = new_biased_first_momentum;
-							*previous_upd2_it2 = new_biased_second_momentum;
+							data[i] = new_weight;
+							gradient[i] = 0.0F;
+							previous_upd[i] = new_biased_first_momentum;
+							previous_upd2[i] = new_biased_second_momentum;
 						}
-						*updates_accumulated_it += accum;
+						*it->updates_accumulated += accum;
 					}
 				}
 				break;
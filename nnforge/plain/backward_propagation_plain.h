@@ -17,6 +17,7 @@
 #pragma once
 
 #include "../backward_propagation.h"
+#include "../parameter_arena.h"
 
 #include "plain_running_configuration.h"
 #include "layer_updater_plain.h"
@@ -63,7 +64,28 @@ namespace nnforge
 			// The layer_config_map is guaranteed to be compatible with schema
 			virtual void layer_config_map_modified();
 
+			virtual bool is_gradient_allreduce_supported() const;
+
+		private:
+			// Contiguous range of the parameter arenas holding weights of a single layer part
+			struct update_segment
+			{
+				size_t offset;
+				size_t size;
+				float learning_rate;
+				bool is_weight_decay;
+				double * updates_accumulated;
+			};
+
 		private:
+			void setup_sequential_action_schema();
+
+			// Softmax backward data is done by NLL or cross-entropy layer consuming it, which writes errors with respect to softmax input right away
+			void setup_fused_softmax();
+
+			// Chooses layers, outputs of which are kept in bfloat16 between forward prop and the first backward action using them
+			void setup_packed_layers();
+
 			void setup_dedicated_buffer_sizes();
 
 			void setup_layer_buffer_sizes();
@@ -72,14 +94,62 @@ namespace nnforge
 
 			void update_buffer_config();
 
-			void apply_gradient(
+			// Chooses layers to recompute during backward prop so that the whole batch fits into the memory available
+			void update_recompute_plan(
+				size_t constant_buffer_size,
+				unsigned int batch_size);
+
+			void fill_buffers_and_dependencies(
+				const std::vector<layer_name_with_action>& actions,
+				const std::set<std::string>& layers_to_recompute,
+				std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, float> > >& buffers,
+				std::map<layer_name_with_action, std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, bool> > > >& dependencies);
+
+			// Returns peak size of buffers alive simultaneously, it is a lower bound for the size of buffer sets
+			size_t get_per_entry_buffer_peak_size(
+				const std::vector<layer_name_with_action>& actions,
+				const std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, float> > >& buffers,
+				const std::map<layer_name_with_action, std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, bool> > > >& dependencies) const;
+
+			size_t get_per_entry_buffer_peak_size(const std::set<std::string>& layers_to_recompute);
+
+			std::vector<layer_name_with_action> get_actions_with_recompute(const std::set<std::string>& layers_to_recompute);
+
+			void add_recompute_action(
+				const std::string& layer_name,
+				const std::set<std::string>& layers_to_recompute,
+				std::set<std::string>& recomputed_layer_names,
+				std::vector<layer_name_with_action>& actions) const;
+
+			// Returns names of the layers, forward output or temporary buffers of which are used by the backward action
+			std::vector<std::string> get_forward_output_layers_used(
+				const layer_name_with_action& action,
+				bool include_temporary_buffers = true);
+
+			layer_name_with_action get_forward_output_action(
+				const std::string& layer_name,
+				const layer_action& consumer_action,
+				const std::set<std::string>& layers_to_recompute) const;
+
+			// Temporary buffers of packed layers are kept as is, they are not restored with outputs
+			layer_name_with_action get_temporary_buffer_action(
 				const std::string& layer_name,
-				layer_data::ptr data,
-				layer_data::ptr gradient,
-				layer_data::ptr previous_upd,
-				layer_data::ptr previous_upd2,
-				std::vector<double>& updates_accumulated,
-				const std::vector<float>& learning_rates,
+				const layer_action& consumer_action,
+				const std::set<std::string>& layers_to_recompute) const;
+
+			// Recompute takes precedence over packing, the output is dropped altogether then
+			bool is_layer_packed(
+				const std::string& layer_name,
+				const std::set<std::string>& layers_to_recompute) const;
+
+			// Updates weights and momentum, and zeroes gradient, for segments of the arenas sharing the same layout.
+			// Segments are traversed in the order they are listed, a whole model update is a single pass over the arenas
+			void apply_gradient(
+				const std::vector<update_segment>& update_segment_list,
+				parameter_arena& data_arena,
+				parameter_arena& gradient_arena,
+				parameter_arena::ptr previous_upd_arena,
+				parameter_arena::ptr previous_upd2_arena,
 				float normalizer,
 				float weight_decay,
 				training_momentum momentum,
@@ -89,17 +159,27 @@ namespace nnforge
 			plain_running_configuration::const_ptr plain_config;
 
 			std::vector<layer_name_with_action> actions_in_execution_order;
+			std::vector<layer_name_with_action> actions_to_run_in_execution_order;
+			std::set<std::string> layers_to_recompute;
+			std::set<std::string> layers_to_pack;
+			unsigned int recompute_plan_batch_size;
+			size_t recompute_plan_constant_buffer_size;
+			size_t per_entry_buffer_size_without_recompute;
 			std::map<std::string, std::vector<layer_name_with_action> > input_to_all_output_map;
 			std::map<std::string, std::set<layer_action> > layer_name_to_action_set_map;
 
 			std::map<std::string, layer_updater_plain::const_ptr> updaters;
 
+			std::set<layer_name_with_action> fused_softmax_actions;
+			std::set<std::string> layers_with_fused_softmax;
+
 			size_t temporary_working_fixed_size;
 
 			std::vector<size_t> layer_buffer_set_per_entry_size_list;
 			std::map<layer_name_with_action, unsigned int> temporary_working_per_entry_data_action_to_set_map;
 			std::map<layer_name_with_action, unsigned int> layer_buffer_action_to_set_map;
 			std::map<layer_name_with_action, unsigned int> temporary_per_entry_data_action_to_set_map;
+			std::map<layer_name_with_action, unsigned int> packed_per_entry_data_action_to_set_map;
 
 			std::map<std::string, size_t> dedicated_per_entry_data_name_to_size_map;
 
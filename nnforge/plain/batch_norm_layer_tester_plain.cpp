@@ -46,12 +46,12 @@ namespace nnforge
 			const unsigned int neuron_count = output_configuration_specific.get_neuron_count();
 			const unsigned int neuron_count_per_feature_map = output_configuration_specific.get_neuron_count_per_feature_map();
 			const unsigned int feature_map_count = output_configuration_specific.feature_map_count;
-			const std::vector<float>::const_iterator gamma = (*data)[0].begin();
-			const std::vector<float>::const_iterator beta = (*data)[1].begin();
-			const std::vector<float>::const_iterator mean = (*data)[2].begin();
-			const std::vector<float>::const_iterator inverse_sigma = (*data)[3].begin();
+			const layer_data_part::const_iterator gamma = (*data)[0].begin();
+			const layer_data_part::const_iterator beta = (*data)[1].begin();
+			const layer_data_part::const_iterator mean = (*data)[2].begin();
+			const layer_data_part::const_iterator inverse_sigma = (*data)[3].begin();
 
-			#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
+			#pragma omp parallel for default(none) schedule(runtime) num_threads(plain_config->openmp_thread_count)
 			for(int workload_id = 0; workload_id < total_workload; ++workload_id)
 			{
 				int entry_id = workload_id / feature_map_count;
@@ -0,0 +1,49 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "bfloat16_kernel.h"
+
+namespace nnforge
+{
+	namespace plain
+	{
+		void bfloat16_kernel::pack(
+			unsigned short * output,
+			const float * input,
+			size_t elem_count,
+			plain_running_configuration::const_ptr plain_config)
+		{
+			const long long total_elem_count = static_cast<long long>(elem_count);
+
+			#pragma omp parallel for default(none) num_threads(plain_config->openmp_thread_count) schedule(runtime) shared(output,input)
+			for(long long i = 0; i < total_elem_count; ++i)
+				output[i] = from_float(input[i]);
+		}
+
+		void bfloat16_kernel::unpack(
+			float * output,
+			const unsigned short * input,
+			size_t elem_count,
+			plain_running_configuration::const_ptr plain_config)
+		{
+			const long long total_elem_count = static_cast<long long>(elem_count);
+
+			#pragma omp parallel for default(none) num_threads(plain_config->openmp_thread_count) schedule(runtime) shared(output,input)
+			for(long long i = 0; i < total_elem_count; ++i)
+				output[i] = to_float(input[i]);
+		}
+	}
+}
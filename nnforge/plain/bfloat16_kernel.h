@@ -0,0 +1,67 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "plain_running_configuration.h"
+
+#include <cstring>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Conversion between fp32 and bfloat16, the upper 16 bits of fp32.
+		// Rounding is to nearest even, NaNs are converted to quiet NaNs as rounding could carry their payload into Inf.
+		// The loops are branch-free integer ones and get vectorized by the compiler
+		class bfloat16_kernel
+		{
+		public:
+			static void pack(
+				unsigned short * output,
+				const float * input,
+				size_t elem_count,
+				plain_running_configuration::const_ptr plain_config);
+
+			static void unpack(
+				float * output,
+				const unsigned short * input,
+				size_t elem_count,
+				plain_running_configuration::const_ptr plain_config);
+
+			static inline unsigned short from_float(float x)
+			{
+				unsigned int bits;
+				std::memcpy(&bits, &x, sizeof(bits));
+				unsigned int rounded_bits = bits + 0x7FFFU + ((bits >> 16) & 1U);
+				// Integer check as -ffast-math lets the compiler assume there are no NaNs
+				unsigned int res_bits = ((bits & 0x7FFFFFFFU) > 0x7F800000U) ? (bits | 0x00400000U) : rounded_bits;
+				return static_cast<unsigned short>(res_bits >> 16);
+			}
+
+			static inline float to_float(unsigned short x)
+			{
+				unsigned int bits = static_cast<unsigned int>(x) << 16;
+				float res;
+				std::memcpy(&res, &bits, sizeof(res));
+				return res;
+			}
+
+		private:
+			bfloat16_kernel() = delete;
+		};
+	}
+}
@@ -0,0 +1,229 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "bilinear_sampler_2d_kernel.h"
+
+#include <algorithm>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		bilinear_sampler_2d_kernel::row_table::row_table(int width)
+			: offsets(width * corner_count)
+			, masks(width * corner_count)
+			, weights(width * corner_count)
+			, right_weights(width)
+			, bottom_weights(width)
+		{
+		}
+
+		void bilinear_sampler_2d_kernel::fill_row_table(
+			row_table& table,
+			const float * grid_x_row,
+			const float * grid_y_row,
+			int output_width,
+			int input_width,
+			int input_height)
+		{
+			const float denormalize_scale_x = static_cast<float>(input_width - 1);
+			const float denormalize_scale_y = static_cast<float>(input_height - 1);
+			const int corner_x_offsets[corner_count] = {0, 1, 0, 1};
+			const int corner_y_offsets[corner_count] = {0, 0, 1, 1};
+
+			for(int x = 0; x < output_width; ++x)
+			{
+				float absolute_x_pos = grid_x_row[x] * denormalize_scale_x;
+				float absolute_y_pos = grid_y_row[x] * denormalize_scale_y;
+				int left_x = static_cast<int>(absolute_x_pos);
+				int top_y = static_cast<int>(absolute_y_pos);
+				float right_weight = absolute_x_pos - (float)left_x;
+				float left_weight = 1.0F - right_weight;
+				float bottom_weight = absolute_y_pos - (float)top_y;
+				float top_weight = 1.0F - bottom_weight;
+				const float corner_weights[corner_count] = {top_weight * left_weight, top_weight * right_weight, bottom_weight * left_weight, bottom_weight * right_weight};
+
+				for(int corner_id = 0; corner_id < corner_count; ++corner_id)
+				{
+					int corner_x = left_x + corner_x_offsets[corner_id];
+					int corner_y = top_y + corner_y_offsets[corner_id];
+					bool in_bounds = ((unsigned int)corner_x < (unsigned int)input_width) && ((unsigned int)corner_y < (unsigned int)input_height);
+					int elem_id = corner_id * output_width + x;
+					table.offsets[elem_id] = in_bounds ? (corner_y * input_width + corner_x) : 0;
+					table.masks[elem_id] = in_bounds ? 1.0F : 0.0F;
+					table.weights[elem_id] = in_bounds ? corner_weights[corner_id] : 0.0F;
+				}
+				table.right_weights[x] = right_weight;
+				table.bottom_weights[x] = bottom_weight;
+			}
+		}
+
+		void bilinear_sampler_2d_kernel::run_forward_propagation(
+			float * output,
+			const float * grid,
+			const float * input,
+			const layer_configuration_specific& input_configuration_specific,
+			const layer_configuration_specific& output_configuration_specific,
+			unsigned int entry_count,
+			plain_running_configuration::const_ptr plain_config)
+		{
+			const int output_width = output_configuration_specific.dimension_sizes[0];
+			const int output_height = output_configuration_specific.dimension_sizes[1];
+			const int input_width = input_configuration_specific.dimension_sizes[0];
+			const int input_height = input_configuration_specific.dimension_sizes[1];
+			const int feature_map_count = input_configuration_specific.feature_map_count;
+			const int output_elem_count_per_feature_map = output_configuration_specific.get_neuron_count_per_feature_map();
+			const int input_elem_count_per_feature_map = input_configuration_specific.get_neuron_count_per_feature_map();
+			const int output_elem_count_per_entry = output_configuration_specific.get_neuron_count();
+			const int input_elem_count_per_entry = input_configuration_specific.get_neuron_count();
+			const int total_workload = entry_count * output_height;
+
+			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count) shared(output,grid,input)
+			{
+				row_table table(output_width);
+				const int * const top_left_offsets = &table.offsets[0];
+				const int * const top_right_offsets = top_left_offsets + output_width;
+				const int * const bottom_left_offsets = top_right_offsets + output_width;
+				const int * const bottom_right_offsets = bottom_left_offsets + output_width;
+				const float * const top_left_weights = &table.weights[0];
+				const float * const top_right_weights = top_left_weights + output_width;
+				const float * const bottom_left_weights = top_right_weights + output_width;
+				const float * const bottom_right_weights = bottom_left_weights + output_width;
+
+				#pragma omp for schedule(runtime)
+				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				{
+					int entry_id = workload_id / output_height;
+					int y = workload_id - (entry_id * output_height);
+
+					const float * grid_x_row = grid + entry_id * output_elem_count_per_feature_map * 2 + y * output_width;
+					fill_row_table(table, grid_x_row, grid_x_row + output_elem_count_per_feature_map, output_width, input_width, input_height);
+
+					const float * current_input = input + entry_id * input_elem_count_per_entry;
+					float * current_output = output + entry_id * output_elem_count_per_entry + y * output_width;
+					for(int feature_map_id = 0; feature_map_id < feature_map_count; ++feature_map_id)
+					{
+						for(int x = 0; x < output_width; ++x)
+							current_output[x] = top_left_weights[x] * current_input[top_left_offsets[x]] + top_right_weights[x] * current_input[top_right_offsets[x]]
+								+ bottom_left_weights[x] * current_input[bottom_left_offsets[x]] + bottom_right_weights[x] * current_input[bottom_right_offsets[x]];
+
+						current_input += input_elem_count_per_feature_map;
+						current_output += output_elem_count_per_feature_map;
+					}
+				}
+			}
+		}
+
+		void bilinear_sampler_2d_kernel::run_backward_grid_propagation(
+			float * grid_errors,
+			const float * grid,
+			const float * input,
+			const float * output_errors,
+			const layer_configuration_specific& input_configuration_specific,
+			const layer_configuration_specific& output_configuration_specific,
+			bool add_update_to_destination,
+			unsigned int entry_count,
+			plain_running_configuration::const_ptr plain_config)
+		{
+			const int output_width = output_configuration_specific.dimension_sizes[0];
+			const int output_height = output_configuration_specific.dimension_sizes[1];
+			const int input_width = input_configuration_specific.dimension_sizes[0];
+			const int input_height = input_configuration_specific.dimension_sizes[1];
+			const float denormalize_scale_x = static_cast<float>(input_width - 1);
+			const float denormalize_scale_y = static_cast<float>(input_height - 1);
+			const int feature_map_count = input_configuration_specific.feature_map_count;
+			const int output_elem_count_per_feature_map = output_configuration_specific.get_neuron_count_per_feature_map();
+			const int input_elem_count_per_feature_map = input_configuration_specific.get_neuron_count_per_feature_map();
+			const int output_elem_count_per_entry = output_configuration_specific.get_neuron_count();
+			const int input_elem_count_per_entry = input_configuration_specific.get_neuron_count();
+			const int total_workload = entry_count * output_height;
+
+			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count) shared(grid_errors,grid,input,output_errors,add_update_to_destination)
+			{
+				row_table table(output_width);
+				const int * const top_left_offsets = &table.offsets[0];
+				const int * const top_right_offsets = top_left_offsets + output_width;
+				const int * const bottom_left_offsets = top_right_offsets + output_width;
+				const int * const bottom_right_offsets = bottom_left_offsets + output_width;
+				const float * const top_left_masks = &table.masks[0];
+				const float * const top_right_masks = top_left_masks + output_width;
+				const float * const bottom_left_masks = top_right_masks + output_width;
+				const float * const bottom_right_masks = bottom_left_masks + output_width;
+				const float * const right_weights = &table.right_weights[0];
+				const float * const bottom_weights = &table.bottom_weights[0];
+
+				// Sums of output error times corner value over feature maps
+				std::vector<float> corner_sums(output_width * corner_count);
+				float * const top_left_sums = &corner_sums[0];
+				float * const top_right_sums = top_left_sums + output_width;
+				float * const bottom_left_sums = top_right_sums + output_width;
+				float * const bottom_right_sums = bottom_left_sums + output_width;
+
+				#pragma omp for schedule(runtime)
+				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				{
+					int entry_id = workload_id / output_height;
+					int y = workload_id - (entry_id * output_height);
+
+					float * grid_errors_x_row = grid_errors + entry_id * output_elem_count_per_feature_map * 2 + y * output_width;
+					float * grid_errors_y_row = grid_errors_x_row + output_elem_count_per_feature_map;
+					const float * grid_x_row = grid + entry_id * output_elem_count_per_feature_map * 2 + y * output_width;
+					fill_row_table(table, grid_x_row, grid_x_row + output_elem_count_per_feature_map, output_width, input_width, input_height);
+
+					std::fill(corner_sums.begin(), corner_sums.end(), 0.0F);
+					const float * current_input = input + entry_id * input_elem_count_per_entry;
+					const float * current_output_errors = output_errors + entry_id * output_elem_count_per_entry + y * output_width;
+					for(int feature_map_id = 0; feature_map_id < feature_map_count; ++feature_map_id)
+					{
+						for(int x = 0; x < output_width; ++x)
+						{
+							float output_error = current_output_errors[x];
+							top_left_sums[x] += top_left_masks[x] * current_input[top_left_offsets[x]] * output_error;
+							top_right_sums[x] += top_right_masks[x] * current_input[top_right_offsets[x]] * output_error;
+							bottom_left_sums[x] += bottom_left_masks[x] * current_input[bottom_left_offsets[x]] * output_error;
+							bottom_right_sums[x] += bottom_right_masks[x] * current_input[bottom_right_offsets[x]] * output_error;
+						}
+
+						current_input += input_elem_count_per_feature_map;
+						current_output_errors += output_elem_count_per_feature_map;
+					}
+
+					for(int x = 0; x < output_width; ++x)
+					{
+						float right_weight = right_weights[x];
+						float left_weight = 1.0F - right_weight;
+						float bottom_weight = bottom_weights[x];
+						float top_weight = 1.0F - bottom_weight;
+
+						float input_err_x = (top_weight * (top_right_sums[x] - top_left_sums[x]) + bottom_weight * (bottom_right_sums[x] - bottom_left_sums[x])) * denormalize_scale_x;
+						float input_err_y = (left_weight * (bottom_left_sums[x] - top_left_sums[x]) + right_weight * (bottom_right_sums[x] - top_right_sums[x])) * denormalize_scale_y;
+
+						if (add_update_to_destination)
+						{
+							grid_errors_x_row[x] += input_err_x;
+							grid_errors_y_row[x] += input_err_y;
+						}
+						else
+						{
+							grid_errors_x_row[x] = input_err_x;
+							grid_errors_y_row[x] = input_err_y;
+						}
+					}
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,83 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "plain_running_configuration.h"
+#include "../layer_configuration_specific.h"
+
+#include <vector>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Bilinear sampling of 2D feature maps at positions given by a normalized grid (x and y feature maps, [0, 1] spans the whole input).
+		// Work is split by output rows: corner offsets and weights are computed once per output position of the row
+		// and then applied to all feature maps, so the per feature map loops are plain gathers over the row, vectorized by the compiler.
+		// Corners which are out of bounds get zero weight and a valid offset instead of a branch
+		class bilinear_sampler_2d_kernel
+		{
+		public:
+			static void run_forward_propagation(
+				float * output,
+				const float * grid,
+				const float * input,
+				const layer_configuration_specific& input_configuration_specific,
+				const layer_configuration_specific& output_configuration_specific,
+				unsigned int entry_count,
+				plain_running_configuration::const_ptr plain_config);
+
+			// Gradient with respect to the grid only
+			static void run_backward_grid_propagation(
+				float * grid_errors,
+				const float * grid,
+				const float * input,
+				const float * output_errors,
+				const layer_configuration_specific& input_configuration_specific,
+				const layer_configuration_specific& output_configuration_specific,
+				bool add_update_to_destination,
+				unsigned int entry_count,
+				plain_running_configuration::const_ptr plain_config);
+
+		private:
+			static const int corner_count = 4;
+
+			// Per thread tables for a single output row, each corner's entries are contiguous
+			struct row_table
+			{
+				row_table(int width);
+
+				std::vector<int> offsets;
+				std::vector<float> masks;
+				std::vector<float> weights;
+				std::vector<float> right_weights;
+				std::vector<float> bottom_weights;
+			};
+
+			static void fill_row_table(
+				row_table& table,
+				const float * grid_x_row,
+				const float * grid_y_row,
+				int output_width,
+				int input_width,
+				int input_height);
+
+		private:
+			bilinear_sampler_2d_kernel() = delete;
+		};
+	}
+}
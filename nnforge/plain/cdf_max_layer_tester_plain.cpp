@@ -19,6 +19,7 @@
 #include "../cdf_max_layer.h"
 
 #include <array>
+#include <algorithm>
 
 namespace nnforge
 {
@@ -44,40 +45,47 @@ namespace nnforge
 		{
 			const float * const in_it_global = *input_buffers[0];
 			float * const out_it_global = *output_buffer;
-			const unsigned int neuron_count = output_configuration_specific.get_neuron_count();
+			const int neuron_count = output_configuration_specific.get_neuron_count();
 			std::shared_ptr<const cdf_max_layer> layer_derived = std::dynamic_pointer_cast<const cdf_max_layer>(layer_schema);
-			const unsigned int entry_subsampling_size = layer_derived->entry_subsampling_size;
+			const int entry_subsampling_size = layer_derived->entry_subsampling_size;
 			const bool is_min = layer_derived->is_min;
-			const int total_workload = entry_count;
+			// Entries are split into blocks of neurons so that there is enough parallelism for small batches
+			const int neuron_block_count = (neuron_count + neuron_block_size - 1) / neuron_block_size;
+			const int total_workload = entry_count * neuron_block_count;
 
-			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count)
+			#pragma omp parallel for default(none) schedule(runtime) num_threads(plain_config->openmp_thread_count)
+			for(int workload_id = 0; workload_id < total_workload; ++workload_id)
 			{
-				#pragma omp for schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
-				{
-					int entry_id = workload_id;
+				int entry_id = workload_id / neuron_block_count;
+				int neuron_block_id = workload_id - entry_id * neuron_block_count;
+				int neuron_offset = neuron_block_id * neuron_block_size;
+				int current_neuron_count = std::min(neuron_count - neuron_offset, static_cast<int>(neuron_block_size));
 
-					const float * in_it_base = in_it_global + entry_id * neuron_count * entry_subsampling_size;
-					float * out_it_base = out_it_global + entry_id * neuron_count;
+				const float * in_it = in_it_global + entry_id * neuron_count * entry_subsampling_size + neuron_offset;
+				float * out_it = out_it_global + entry_id * neuron_count + neuron_offset;
 
-					for(float * out_it = out_it_base; out_it != out_it_base + neuron_count; ++out_it, ++in_it_base)
+				if (is_min)
+				{
+					for(int x = 0; x < current_neuron_count; ++x)
+						out_it[x] = 1.0F - in_it[x];
+					for(int i = 1; i < entry_subsampling_size; ++i)
 					{
-						if (is_min)
-						{
-							float product = 1.0F - *in_it_base;
-							for(unsigned int i = 1; i < entry_subsampling_size; ++i)
-								product *= (1.0F - *(in_it_base + neuron_count * i));
-
-							*out_it = 1.0F - product;
-						}
-						else
-						{
-							float product = *in_it_base;
-							for(unsigned int i = 1; i < entry_subsampling_size; ++i)
-								product *= *(in_it_base + neuron_count * i);
-
-							*out_it = product;
-						}
+						const float * current_in_it = in_it + neuron_count * i;
+						for(int x = 0; x < current_neuron_count; ++x)
+							out_it[x] *= (1.0F - current_in_it[x]);
+					}
+					for(int x = 0; x < current_neuron_count; ++x)
+						out_it[x] = 1.0F - out_it[x];
+				}
+				else
+				{
+					for(int x = 0; x < current_neuron_count; ++x)
+						out_it[x] = in_it[x];
+					for(int i = 1; i < entry_subsampling_size; ++i)
+					{
+						const float * current_in_it = in_it + neuron_count * i;
+						for(int x = 0; x < current_neuron_count; ++x)
+							out_it[x] *= current_in_it[x];
 					}
 				}
 			}
@@ -43,6 +43,9 @@ namespace nnforge
 				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
 				const layer_configuration_specific& output_configuration_specific,
 				unsigned int entry_count) const;
+
+		private:
+			static const int neuron_block_size = 64;
 		};
 	}
 }
@@ -81,6 +81,9 @@ namespace nnforge
 				layer::const_ptr layer_schema,
 				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
 				const layer_configuration_specific& output_configuration_specific) const;
+
+		private:
+			static const int neuron_block_size = 64;
 		};
 	}
 }
@@ -44,45 +44,34 @@ namespace nnforge
 		{
 			const float * const in_it_global = *input_buffers[0];
 			float * const out_it_global = *output_buffer;
-			const unsigned int neuron_count = output_configuration_specific.get_neuron_count();
 			std::shared_ptr<const cdf_to_pdf_layer> layer_derived = std::dynamic_pointer_cast<const cdf_to_pdf_layer>(layer_schema);
-			const unsigned int feature_map_segment_length = layer_derived->feature_map_segment_length;
-			const unsigned int feature_map_segment_count = output_configuration_specific.feature_map_count / feature_map_segment_length;
-			const unsigned int neuron_count_per_feature_map = output_configuration_specific.get_neuron_count_per_feature_map();
+			const int feature_map_segment_length = layer_derived->feature_map_segment_length;
+			const int feature_map_count = output_configuration_specific.feature_map_count;
+			const int neuron_count_per_feature_map = output_configuration_specific.get_neuron_count_per_feature_map();
 			const float clamp_min = layer_derived->clamp_min;
 			const float clamp_max = layer_derived->clamp_max;
-			const int total_workload = entry_count * feature_map_segment_count * neuron_count_per_feature_map;
+			const int total_workload = entry_count * feature_map_count;
 
-			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count)
+			// Each feature map depends on the input only, so they are all processed independently
+			#pragma omp parallel for default(none) schedule(runtime) num_threads(plain_config->openmp_thread_count)
+			for(int workload_id = 0; workload_id < total_workload; ++workload_id)
 			{
-				#pragma omp for schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
-				{
-					int entry_id = workload_id / (feature_map_segment_count * neuron_count_per_feature_map);
-					int tt = workload_id - entry_id * feature_map_segment_count * neuron_count_per_feature_map;
-					int feature_map_segment_id = tt / neuron_count_per_feature_map;
-					int neuron_id = tt - feature_map_segment_id * neuron_count_per_feature_map;
-
-					int offset = entry_id * neuron_count + feature_map_segment_id * feature_map_segment_length * neuron_count_per_feature_map + neuron_id;
+				int feature_map_id = workload_id % feature_map_count;
+				const float * in_it = in_it_global + workload_id * neuron_count_per_feature_map;
+				float * out_it = out_it_global + workload_id * neuron_count_per_feature_map;
 
-					float previous_val = 0.0F;
-					for(unsigned int i = 0; i < feature_map_segment_length; ++i, offset += neuron_count_per_feature_map)
-					{
-						float current_val = in_it_global[offset];
-						out_it_global[offset] = std::min(std::max(current_val - previous_val, clamp_min), clamp_max);
-						previous_val = previous_val;
-					}
+				if ((feature_map_id % feature_map_segment_length) != 0)
+				{
+					const float * previous_in_it = in_it - neuron_count_per_feature_map;
+					for(int x = 0; x < neuron_count_per_feature_map; ++x)
+						out_it[x] = std::min(std::max(in_it[x] - previous_in_it[x], clamp_min), clamp_max);
+				}
+				else
+				{
+					for(int x = 0; x < neuron_count_per_feature_map; ++x)
+						out_it[x] = std::min(std::max(in_it[x], clamp_min), clamp_max);
 				}
 			}
 		}
-
-		int cdf_to_pdf_layer_tester_plain::get_input_index_layer_can_write(
-			plain_running_configuration::const_ptr plain_config,
-			layer::const_ptr layer_schema,
-			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
-			const layer_configuration_specific& output_configuration_specific) const
-		{
-			return 0;
-		}
 	}
 }
@@ -43,12 +43,6 @@ namespace nnforge
 				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
 				const layer_configuration_specific& output_configuration_specific,
 				unsigned int entry_count) const;
-
-			virtual int get_input_index_layer_can_write(
-				plain_running_configuration::const_ptr plain_config,
-				layer::const_ptr layer_schema,
-				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
-				const layer_configuration_specific& output_configuration_specific) const;
 		};
 	}
 }
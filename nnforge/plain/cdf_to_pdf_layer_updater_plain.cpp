@@ -46,34 +46,32 @@ namespace nnforge
 		{
 			const float * const in_it_global = *input_buffers[0];
 			float * const out_it_global = *output_buffer;
-			const unsigned int neuron_count = output_configuration_specific.get_neuron_count();
 			std::shared_ptr<const cdf_to_pdf_layer> layer_derived = std::dynamic_pointer_cast<const cdf_to_pdf_layer>(layer_schema);
-			const unsigned int feature_map_segment_length = layer_derived->feature_map_segment_length;
-			const unsigned int feature_map_segment_count = output_configuration_specific.feature_map_count / feature_map_segment_length;
-			const unsigned int neuron_count_per_feature_map = output_configuration_specific.get_neuron_count_per_feature_map();
+			const int feature_map_segment_length = layer_derived->feature_map_segment_length;
+			const int feature_map_count = output_configuration_specific.feature_map_count;
+			const int neuron_count_per_feature_map = output_configuration_specific.get_neuron_count_per_feature_map();
 			const float clamp_min = layer_derived->clamp_min;
 			const float clamp_max = layer_derived->clamp_max;
-			const int total_workload = entry_count * feature_map_segment_count * neuron_count_per_feature_map;
+			const int total_workload = entry_count * feature_map_count;
 
-			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count)
+			// Each feature map depends on the input only, so they are all processed independently
+			#pragma omp parallel for default(none) schedule(runtime) num_threads(plain_config->openmp_thread_count)
+			for(int workload_id = 0; workload_id < total_workload; ++workload_id)
 			{
-				#pragma omp for schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
-				{
-					int entry_id = workload_id / (feature_map_segment_count * neuron_count_per_feature_map);
-					int tt = workload_id - entry_id * feature_map_segment_count * neuron_count_per_feature_map;
-					int feature_map_segment_id = tt / neuron_count_per_feature_map;
-					int neuron_id = tt - feature_map_segment_id * neuron_count_per_feature_map;
-
-					int offset = entry_id * neuron_count + feature_map_segment_id * feature_map_segment_length * neuron_count_per_feature_map + neuron_id;
+				int feature_map_id = workload_id % feature_map_count;
+				const float * in_it = in_it_global + workload_id * neuron_count_per_feature_map;
+				float * out_it = out_it_global + workload_id * neuron_count_per_feature_map;
 
-					float previous_val = 0.0F;
-					for(unsigned int i = 0; i < feature_map_segment_length; ++i, offset += neuron_count_per_feature_map)
-					{
-						float current_val = in_it_global[offset];
-						out_it_global[offset] = std::min(std::max(current_val - previous_val, clamp_min), clamp_max);
-						previous_val = previous_val;
-					}
+				if ((feature_map_id % feature_map_segment_length) != 0)
+				{
+					const float * previous_in_it = in_it - neuron_count_per_feature_map;
+					for(int x = 0; x < neuron_count_per_feature_map; ++x)
+						out_it[x] = std::min(std::max(in_it[x] - previous_in_it[x], clamp_min), clamp_max);
+				}
+				else
+				{
+					for(int x = 0; x < neuron_count_per_feature_map; ++x)
+						out_it[x] = std::min(std::max(in_it[x], clamp_min), clamp_max);
 				}
 			}
 		}
@@ -99,49 +97,50 @@ namespace nnforge
 		{
 			float * const in_err_it_global = *input_errors_buffer;
 			const float * const out_err_it_global = *output_errors_buffer;
-			const unsigned int neuron_count = output_configuration_specific.get_neuron_count();
 			std::shared_ptr<const cdf_to_pdf_layer> layer_derived = std::dynamic_pointer_cast<const cdf_to_pdf_layer>(layer_schema);
-			const unsigned int feature_map_segment_length = layer_derived->feature_map_segment_length;
-			const unsigned int feature_map_segment_count = output_configuration_specific.feature_map_count / feature_map_segment_length;
-			const unsigned int neuron_count_per_feature_map = output_configuration_specific.get_neuron_count_per_feature_map();
-			const float clamp_min = layer_derived->clamp_min;
-			const float clamp_max = layer_derived->clamp_max;
-			const int total_workload = entry_count * feature_map_segment_count * neuron_count_per_feature_map;
+			const int feature_map_segment_length = layer_derived->feature_map_segment_length;
+			const int feature_map_count = output_configuration_specific.feature_map_count;
+			const int neuron_count_per_feature_map = output_configuration_specific.get_neuron_count_per_feature_map();
+			const int total_workload = entry_count * feature_map_count;
 
-			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count)
+			#pragma omp parallel for default(none) schedule(runtime) num_threads(plain_config->openmp_thread_count) shared(add_update_to_destination)
+			for(int workload_id = 0; workload_id < total_workload; ++workload_id)
 			{
-				#pragma omp for schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
-				{
-					int entry_id = workload_id / (feature_map_segment_count * neuron_count_per_feature_map);
-					int tt = workload_id - entry_id * feature_map_segment_count * neuron_count_per_feature_map;
-					int feature_map_segment_id = tt / neuron_count_per_feature_map;
-					int neuron_id = tt - feature_map_segment_id * neuron_count_per_feature_map;
-
-					int offset = entry_id * neuron_count + (feature_map_segment_id * feature_map_segment_length + feature_map_segment_length - 1) * neuron_count_per_feature_map + neuron_id;
+				int feature_map_id = workload_id % feature_map_count;
+				float * in_err_it = in_err_it_global + workload_id * neuron_count_per_feature_map;
+				const float * out_err_it = out_err_it_global + workload_id * neuron_count_per_feature_map;
+				bool is_last_in_segment = ((feature_map_id % feature_map_segment_length) == (feature_map_segment_length - 1));
+				const float * next_out_err_it = out_err_it + neuron_count_per_feature_map;
 
-					float previous_val = 0.0F;
-					for(unsigned int i = 0; i < feature_map_segment_length; ++i, offset -= neuron_count_per_feature_map)
+				if (add_update_to_destination)
+				{
+					if (is_last_in_segment)
+					{
+						for(int x = 0; x < neuron_count_per_feature_map; ++x)
+							in_err_it[x] += out_err_it[x];
+					}
+					else
 					{
-						float current_val = out_err_it_global[offset];
-						in_err_it_global[offset] = current_val - previous_val;
-						previous_val = current_val;
+						for(int x = 0; x < neuron_count_per_feature_map; ++x)
+							in_err_it[x] += out_err_it[x] - next_out_err_it[x];
+					}
+				}
+				else
+				{
+					if (is_last_in_segment)
+					{
+						for(int x = 0; x < neuron_count_per_feature_map; ++x)
+							in_err_it[x] = out_err_it[x];
+					}
+					else
+					{
+						for(int x = 0; x < neuron_count_per_feature_map; ++x)
+							in_err_it[x] = out_err_it[x] - next_out_err_it[x];
 					}
 				}
 			}
 		}
 
-		int cdf_to_pdf_layer_updater_plain::get_input_index_layer_can_write(
-			const layer_action& action,
-			const std::set<layer_action>& actions,
-			plain_running_configuration::const_ptr plain_config,
-			layer::const_ptr layer_schema,
-			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
-			const layer_configuration_specific& output_configuration_specific) const
-		{
-			return 0;
-		}
-
 		bool cdf_to_pdf_layer_updater_plain::is_backward_data_dependent_on_input_buffer(
 			unsigned int action_input_index,
 			unsigned int data_input_index,
@@ -42,18 +42,38 @@ namespace nnforge
 			const layer_configuration_specific& output_configuration_specific,
 			unsigned int entry_count) const
 		{
-			for(unsigned int entry_id = 0; entry_id < entry_count; ++entry_id)
+			float * const out_it_global = *output_buffer;
+			const unsigned int output_neuron_count = output_configuration_specific.get_neuron_count();
+			const int input_count = static_cast<int>(input_configuration_specific_list.size());
+			std::vector<const float *> input_ptrs(input_count);
+			std::vector<unsigned int> input_neuron_counts(input_count);
+			std::vector<unsigned int> output_offsets(input_count);
+			unsigned int offset = 0;
+			for(int i = 0; i < input_count; ++i)
 			{
-				float *dst = (float *)*output_buffer + entry_id * output_configuration_specific.get_neuron_count();
-				for(unsigned int i = 0; i < static_cast<unsigned int>(input_configuration_specific_list.size()); ++i)
-				{
-					unsigned int input_neuron_count = input_configuration_specific_list[i].get_neuron_count();
-					memcpy(
-						dst,
-						(const float *)(*input_buffers[i]) + entry_id * input_neuron_count,
-						input_neuron_count * sizeof(float));
-					dst += input_neuron_count;
-				}
+				input_ptrs[i] = *input_buffers[i];
+				input_neuron_counts[i] = input_configuration_specific_list[i].get_neuron_count();
+				output_offsets[i] = offset;
+				offset += input_neuron_counts[i];
+			}
+			const std::vector<const float *>::const_iterator input_ptrs_it = input_ptrs.begin();
+			const std::vector<unsigned int>::const_iterator input_neuron_counts_it = input_neuron_counts.begin();
+			const std::vector<unsigned int>::const_iterator output_offsets_it = output_offsets.begin();
+			const int total_workload = entry_count * input_count;
+
+			// Forward prop doesn't run the layer for a single entry when the inputs are aliased into the output.
+			// For more entries an input's slice of the output has the output's per-entry stride, so it is copied
+
+			#pragma omp parallel for default(none) schedule(runtime) num_threads(plain_config->openmp_thread_count)
+			for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+			{
+				int entry_id = workload_id / input_count;
+				int input_id = workload_id - entry_id * input_count;
+				unsigned int input_neuron_count = *(input_neuron_counts_it + input_id);
+				memcpy(
+					out_it_global + entry_id * output_neuron_count + *(output_offsets_it + input_id),
+					*(input_ptrs_it + input_id) + entry_id * input_neuron_count,
+					input_neuron_count * sizeof(float));
 			}
 		}
 	}
@@ -16,6 +16,7 @@
 
 #include "convolution_layer_tester_plain.h"
 
+#include "fully_connected_kernel.h"
 #include "../convolution_layer.h"
 
 #include <array>
@@ -52,6 +53,12 @@ namespace nnforge
 			const unsigned int output_neuron_count_per_feature_map = output_configuration_specific.get_neuron_count_per_feature_map();
 			std::shared_ptr<const convolution_layer> layer_derived = std::dynamic_pointer_cast<const convolution_layer>(layer_schema);
 
+			if (fully_connected_kernel::is_supported(*layer_derived, input_configuration_specific_list[0]))
+			{
+				fully_connected_kernel::run_forward_propagation(out_it_global, in_it_global, &(*data)[0][0], layer_derived->bias ? &(*data)[1][0] : 0, input_neuron_count, output_neuron_count, entry_count, plain_config);
+				return;
+			}
+
 			const bool bias = layer_derived->bias;
 
 			std::vector<unsigned int> window_sizes_extended = layer_derived->window_sizes;
@@ -83,7 +90,7 @@ namespace nnforge
 			for(unsigned int i = 0; i < dimension_count; ++i)
 				window_elem_count *= window_sizes[i];
 			const unsigned int const_window_elem_count = window_elem_count;
-			const std::vector<float>::const_iterator weights = (*data)[0].begin();
+			const layer_data_part::const_iterator weights = (*data)[0].begin();
 			const float * const biases = bias ? &(*data)[1][0] : 0;
 
 			std::vector<unsigned int> current_local_input_position(dimension_count, 0);
@@ -117,7 +124,7 @@ namespace nnforge
 				std::array<unsigned int, max_dimension_count> current_output_position;
 				std::array<int, max_dimension_count> current_input_position;
 
-				#pragma omp for schedule(guided)
+				#pragma omp for schedule(runtime)
 				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
 				{
 					int entry_id = workload_id / output_feature_map_count;
@@ -131,7 +138,7 @@ namespace nnforge
 					for(float * out_it = out_it_base; out_it != out_it_base + output_neuron_count_per_feature_map; ++out_it)
 					{
 						float sum = bias ? *(biases + output_feature_map_id) : 0.0F;
-						std::vector<float>::const_iterator weights_it = weights + (output_feature_map_id * (const_window_elem_count * input_feature_map_count));
+						layer_data_part::const_iterator weights_it = weights + (output_feature_map_id * (const_window_elem_count * input_feature_map_count));
 
 						int in_it_offset2 = 0;
 
@@ -16,6 +16,7 @@
 
 #include "convolution_layer_updater_plain.h"
 
+#include "fully_connected_kernel.h"
 #include "../convolution_layer.h"
 
 #include <array>
@@ -54,6 +55,12 @@ namespace nnforge
 			float * const out_it_global = *output_buffer;
 			std::shared_ptr<const convolution_layer> layer_derived = std::dynamic_pointer_cast<const convolution_layer>(layer_schema);
 
+			if (fully_connected_kernel::is_supported(*layer_derived, input_configuration_specific_list[0]))
+			{
+				fully_connected_kernel::run_forward_propagation(out_it_global, in_it_global, &(*data)[0][0], layer_derived->bias ? &(*data)[1][0] : 0, input_neuron_count, output_neuron_count, entry_count, plain_config);
+				return;
+			}
+
 			const bool bias = layer_derived->bias;
 
 			std::vector<unsigned int> window_sizes_extended = layer_derived->window_sizes;
@@ -86,7 +93,7 @@ namespace nnforge
 				window_elem_count *= window_sizes[i];
 			const unsigned int const_window_elem_count = window_elem_count;
 
-			const std::vector<float>::const_iterator weights = (*data)[0].begin();
+			const layer_data_part::const_iterator weights = (*data)[0].begin();
 			const float * const biases = bias ? &(*data)[1][0] : 0;
 
 			std::vector<unsigned int> current_local_input_position(dimension_count, 0);
@@ -120,7 +127,7 @@ namespace nnforge
 				std::array<unsigned int, max_dimension_count> current_output_position;
 				std::array<int, max_dimension_count> current_input_position;
 
-				#pragma omp for schedule(guided)
+				#pragma omp for schedule(runtime)
 				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
 				{
 					int entry_id = workload_id / output_feature_map_count;
@@ -134,7 +141,7 @@ namespace nnforge
 					for(float * out_it = out_it_base; out_it != out_it_base + output_neuron_count_per_feature_map; ++out_it)
 					{
 						float sum = bias ? *(biases + output_feature_map_id) : 0.0F;
-						std::vector<float>::const_iterator weights_it = weights + (output_feature_map_id * (const_window_elem_count * input_feature_map_count));
+						layer_data_part::const_iterator weights_it = weights + (output_feature_map_id * (const_window_elem_count * input_feature_map_count));
 						int in_it_offset2 = 0;
 
 						for(unsigned int i = 0; i < dimension_count; ++i)
@@ -211,6 +218,12 @@ namespace nnforge
 			const unsigned int output_neuron_count_per_feature_map = output_configuration_specific.get_neuron_count_per_feature_map();
 			std::shared_ptr<const convolution_layer> layer_derived = std::dynamic_pointer_cast<const convolution_layer>(layer_schema);
 
+			if (fully_connected_kernel::is_supported(*layer_derived, input_configuration_specific_list[0]))
+			{
+				fully_connected_kernel::run_backward_data_propagation(in_err_it_global, out_err_it_global, &(*data)[0][0], input_neuron_count, output_neuron_count, add_update_to_destination, entry_count, plain_config);
+				return;
+			}
+
 			std::vector<unsigned int> window_sizes_extended = layer_derived->window_sizes;
 			window_sizes_extended.resize(max_dimension_count, 1);
 			const std::vector<unsigned int>& window_sizes = window_sizes_extended;
@@ -241,7 +254,7 @@ namespace nnforge
 				window_elem_count *= window_sizes[i];
 			const unsigned int const_window_elem_count = window_elem_count;
 
-			const std::vector<float>::const_iterator weights = (*data)[0].begin();
+			const layer_data_part::const_iterator weights = (*data)[0].begin();
 
 			std::vector<unsigned int> current_local_input_position(dimension_count, 0);
 			std::vector<unsigned int> offset_list(window_elem_count);
@@ -274,7 +287,7 @@ namespace nnforge
 				std::array<unsigned int, max_dimension_count> current_output_position;
 				std::array<int, max_dimension_count> current_input_position;
 
-				#pragma omp for schedule(guided)
+				#pragma omp for schedule(runtime)
 				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
 				{
 					int entry_id = workload_id / input_feature_map_count;
@@ -282,7 +295,7 @@ namespace nnforge
 
 					const float * out_err_it_base = out_err_it_global + (entry_id * output_neuron_count);
 					float * in_err_it_base = in_err_it_global + (entry_id * input_neuron_count) + (input_feature_map_id * input_neuron_count_per_feature_map);
-					std::vector<float>::const_iterator weights_it_base = weights + (const_window_elem_count * input_feature_map_id);
+					layer_data_part::const_iterator weights_it_base = weights + (const_window_elem_count * input_feature_map_id);
 
 					if (!add_update_to_destination)
 						std::fill_n(in_err_it_base, input_neuron_count_per_feature_map, 0.0F);
@@ -302,8 +315,8 @@ namespace nnforge
 						for(unsigned int output_feature_map_id = 0; output_feature_map_id < output_feature_map_count; ++output_feature_map_id)
 						{
 							const float * out_err_it = out_err_it_base2 + (output_feature_map_id * output_neuron_count_per_feature_map);
-							std::vector<float>::const_iterator weights_it_base2 = weights_it_base + (output_feature_map_id * (const_window_elem_count * input_feature_map_count));
-							std::vector<float>::const_iterator weights_it = weights_it_base2;
+							layer_data_part::const_iterator weights_it_base2 = weights_it_base + (output_feature_map_id * (const_window_elem_count * input_feature_map_count));
+							layer_data_part::const_iterator weights_it = weights_it_base2;
 							float current_err = *out_err_it;
 
 							int ind = 0;
@@ -367,6 +380,12 @@ namespace nnforge
 			const float * const out_err_it_global = *output_errors_buffer;
 			std::shared_ptr<const convolution_layer> layer_derived = std::dynamic_pointer_cast<const convolution_layer>(layer_schema);
 
+			if (fully_connected_kernel::is_supported(*layer_derived, input_configuration_specific_list[0]))
+			{
+				fully_connected_kernel::run_backward_weights_propagation(&(*gradient)[0][0], layer_derived->bias ? &(*gradient)[1][0] : 0, in_it_global, out_err_it_global, input_neuron_count, output_neuron_count, entry_count, plain_config);
+				return;
+			}
+
 			const bool bias = layer_derived->bias;
 
 			std::vector<unsigned int> window_sizes_extended = layer_derived->window_sizes;
@@ -399,7 +418,7 @@ namespace nnforge
 				window_elem_count *= window_sizes[i];
 			const unsigned int const_window_elem_count = window_elem_count;
 
-			const std::vector<float>::iterator gradient_weights = (*gradient)[0].begin();
+			const layer_data_part::iterator gradient_weights = (*gradient)[0].begin();
 
 			std::vector<unsigned int> current_local_input_position(dimension_count, 0);
 			std::vector<unsigned int> offset_list(window_elem_count);
@@ -435,14 +454,14 @@ namespace nnforge
 				std::array<int, max_dimension_count> current_input_position;
 				std::vector<float> weights_local(const_window_elem_count, 0.0F);
 
-				#pragma omp for schedule(guided)
+				#pragma omp for schedule(runtime)
 				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
 				{
 					int feature_map_pair_id = workload_id;
 					int output_feature_map_id = feature_map_pair_id / input_feature_map_count;
 					int input_feature_map_id = feature_map_pair_id - (output_feature_map_id * input_feature_map_count);
 
-					std::vector<float>::iterator gradient_weights_it_base = gradient_weights + (output_feature_map_id * (const_window_elem_count * input_feature_map_count)) + (const_window_elem_count * input_feature_map_id);
+					layer_data_part::iterator gradient_weights_it_base = gradient_weights + (output_feature_map_id * (const_window_elem_count * input_feature_map_count)) + (const_window_elem_count * input_feature_map_id);
 					std::fill_n(weights_local.begin(), const_window_elem_count, 0.0F);
 
 					for(int entry_id = 0; entry_id < const_updater_count; ++entry_id)
@@ -499,16 +518,16 @@ namespace nnforge
 					}
 
 					std::vector<float>::iterator weights_local_it = weights_local.begin();
-					for(std::vector<float>::iterator it = gradient_weights_it_base; it != gradient_weights_it_base + const_window_elem_count; ++it, ++weights_local_it)
+					for(layer_data_part::iterator it = gradient_weights_it_base; it != gradient_weights_it_base + const_window_elem_count; ++it, ++weights_local_it)
 						*it += *weights_local_it;
 				}
 			}
 
 			if (bias)
 			{
-				const std::vector<float>::iterator gradient_biases = (*gradient)[1].begin();
+				const layer_data_part::iterator gradient_biases = (*gradient)[1].begin();
 				const int total_workload_bias = output_feature_map_count;
-				#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
+				#pragma omp parallel for default(none) schedule(runtime) num_threads(plain_config->openmp_thread_count)
 				for(int workload_id = 0; workload_id < total_workload_bias; ++workload_id)
 				{
 					int output_feature_map_id = workload_id;
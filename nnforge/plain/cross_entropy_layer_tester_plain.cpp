@@ -16,6 +16,7 @@
 
 #include "cross_entropy_layer_tester_plain.h"
 
+#include "vector_math.h"
 #include "../cross_entropy_layer.h"
 
 #include <array>
@@ -59,7 +60,7 @@ namespace nnforge
 
 			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count)
 			{
-				#pragma omp for schedule(guided)
+				#pragma omp for schedule(runtime)
 				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
 				{
 					int entry_id = workload_id / output_neuron_count;
@@ -83,11 +84,11 @@ namespace nnforge
 
 							if (actual_val > 0.0F)
 							{
-								err -= actual_val * logf(std::max(predicted_val, 1.0e-20F));
+								err -= actual_val * vector_math::log(std::max(predicted_val, 1.0e-20F));
 							}
 							if (actual_val < 1.0F)
 							{
-								err -= (1.0F - actual_val) * logf(std::max(1.0F - predicted_val, 1.0e-20F));
+								err -= (1.0F - actual_val) * vector_math::log(std::max(1.0F - predicted_val, 1.0e-20F));
 							}
 						}
 						err *= total_scale;
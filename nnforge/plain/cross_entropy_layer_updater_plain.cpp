@@ -16,6 +16,7 @@
 
 #include "cross_entropy_layer_updater_plain.h"
 
+#include "vector_math.h"
 #include "../cross_entropy_layer.h"
 #include "../neural_network_exception.h"
 
@@ -60,7 +61,7 @@ namespace nnforge
 
 			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count)
 			{
-				#pragma omp for schedule(guided)
+				#pragma omp for schedule(runtime)
 				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
 				{
 					int entry_id = workload_id / output_neuron_count;
@@ -84,11 +85,11 @@ namespace nnforge
 
 							if (actual_val > 0.0F)
 							{
-								err -= actual_val * logf(std::max(predicted_val, 1.0e-20F));
+								err -= actual_val * vector_math::log(std::max(predicted_val, 1.0e-20F));
 							}
 							if (actual_val < 1.0F)
 							{
-								err -= (1.0F - actual_val) * logf(std::max(1.0F - predicted_val, 1.0e-20F));
+								err -= (1.0F - actual_val) * vector_math::log(std::max(1.0F - predicted_val, 1.0e-20F));
 							}
 						}
 						err *= total_scale;
@@ -137,7 +138,7 @@ namespace nnforge
 			const int input_feature_map_count = input_configuration_specific_list[0].feature_map_count;
 
 			const int total_workload = entry_count * neuron_count_per_feature_map;
-			#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
+			#pragma omp parallel for default(none) schedule(runtime) num_threads(plain_config->openmp_thread_count)
 			for(int workload_id = 0; workload_id < total_workload; ++workload_id)
 			{
 				int entry_id = workload_id / neuron_count_per_feature_map;
@@ -155,7 +156,6 @@ namespace nnforge
 					{
 						float actual_val = *(target_input_neurons_it + input_offset);
 						float predicted_val = *(deriv_input_neurons_it + input_offset);
-						float gradient = 0.0F;
 						if (actual_val > 0.0F)
 						{
 							gradient = actual_val / std::max(predicted_val, 1.0e-20F);
@@ -175,6 +175,63 @@ namespace nnforge
 			}
 		}
 
+		void cross_entropy_layer_updater_plain::run_backward_data_propagation_through_softmax(
+			plain_buffer::ptr input_errors_buffer,
+			const std::vector<plain_buffer::const_ptr>& input_neurons_buffers,
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			unsigned int entry_count) const
+		{
+			float * const in_err_it = *input_errors_buffer;
+			const float * const softmax_output_neurons_it = *input_neurons_buffers[0];
+			const float * const target_input_neurons_it = *input_neurons_buffers[1];
+			const float * scale_mask_it = 0;
+			if (input_neurons_buffers.size() > 2)
+				scale_mask_it = *input_neurons_buffers[2];
+			const float * const const_scale_mask_it = scale_mask_it;
+
+			std::shared_ptr<const cross_entropy_layer> layer_derived = std::dynamic_pointer_cast<const cross_entropy_layer>(layer_schema);
+			const float scale = layer_derived->scale;
+			const int neuron_count_per_feature_map = input_configuration_specific_list[0].get_neuron_count_per_feature_map();
+			const int input_feature_map_count = input_configuration_specific_list[0].feature_map_count;
+
+			// Cross-entropy gradient is recomputed in the 2nd pass instead of being stored
+			const int total_workload = entry_count * neuron_count_per_feature_map;
+			#pragma omp parallel for default(none) schedule(runtime) num_threads(plain_config->openmp_thread_count)
+			for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+			{
+				int entry_id = workload_id / neuron_count_per_feature_map;
+				int neuron_id = workload_id - (entry_id * neuron_count_per_feature_map);
+				int output_offset = entry_id * neuron_count_per_feature_map + neuron_id;
+				float total_scale = scale;
+				if (const_scale_mask_it)
+					total_scale *= *(const_scale_mask_it + output_offset);
+				const int input_offset_base = entry_id * input_feature_map_count * neuron_count_per_feature_map + neuron_id;
+
+				float sum = 0.0F;
+				for(int feature_map_id = 0; feature_map_id < input_feature_map_count; ++feature_map_id)
+				{
+					int input_offset = input_offset_base + feature_map_id * neuron_count_per_feature_map;
+					float actual_val = *(target_input_neurons_it + input_offset);
+					float predicted_val = *(softmax_output_neurons_it + input_offset);
+					float gradient = ((actual_val > 0.0F) ? actual_val / std::max(predicted_val, 1.0e-20F) : 0.0F)
+						- ((actual_val < 1.0F) ? (1.0F - actual_val) / std::max(1.0F - predicted_val, 1.0e-20F) : 0.0F);
+					sum += gradient * predicted_val;
+				}
+
+				for(int feature_map_id = 0; feature_map_id < input_feature_map_count; ++feature_map_id)
+				{
+					int input_offset = input_offset_base + feature_map_id * neuron_count_per_feature_map;
+					float actual_val = *(target_input_neurons_it + input_offset);
+					float predicted_val = *(softmax_output_neurons_it + input_offset);
+					float gradient = ((actual_val > 0.0F) ? actual_val / std::max(predicted_val, 1.0e-20F) : 0.0F)
+						- ((actual_val < 1.0F) ? (1.0F - actual_val) / std::max(1.0F - predicted_val, 1.0e-20F) : 0.0F);
+					*(in_err_it + input_offset) = total_scale * predicted_val * (gradient - sum);
+				}
+			}
+		}
+
 		bool cross_entropy_layer_updater_plain::is_backward_data_dependent_on_input_buffer(
 			unsigned int action_input_index,
 			unsigned int data_input_index,
@@ -67,7 +67,7 @@ namespace nnforge
 
 			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count) shared(keep_elem_ptr)
 			{
-				#pragma omp for schedule(guided)
+				#pragma omp for schedule(runtime)
 				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
 				{
 					int elem_id = workload_id;
@@ -110,7 +110,7 @@ namespace nnforge
 			{
 				#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count) shared(keep_elem_ptr)
 				{
-					#pragma omp for schedule(guided)
+					#pragma omp for schedule(runtime)
 					for(int workload_id = 0; workload_id < total_workload; ++workload_id)
 					{
 						int elem_id = workload_id;
@@ -122,7 +122,7 @@ namespace nnforge
 			{
 				#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count) shared(keep_elem_ptr)
 				{
-					#pragma omp for schedule(guided)
+					#pragma omp for schedule(runtime)
 					for(int workload_id = 0; workload_id < total_workload; ++workload_id)
 					{
 						int elem_id = workload_id;
@@ -175,5 +175,15 @@ namespace nnforge
 		{
 			return output_configuration_specific.get_neuron_count() * sizeof(unsigned char);
 		}
+
+		bool dropout_layer_updater_plain::is_forward_propagation_repeatable(
+			const std::set<layer_action>& actions,
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific) const
+		{
+			return false;
+		}
 	}
 }
@@ -18,6 +18,8 @@
 
 #include "forward_propagation_plain_factory.h"
 #include "backward_propagation_plain_factory.h"
+#include "plain_buffer_pool.h"
+#include "plain_kernel_tuner.h"
 
 #include <iostream>
 
@@ -31,17 +33,49 @@ namespace nnforge
 	{
 		factory_generator_plain::factory_generator_plain(
 			float plain_max_global_memory_usage,
-			int plain_openmp_thread_count)
+			int plain_openmp_thread_count,
+			bool plain_parallel_branches,
+			bool plain_recompute_activations,
+			bool plain_bf16_activations,
+			bool plain_numa,
+			bool plain_autotune,
+			const std::string& plain_kernel_tuning_cache,
+			const std::string& plain_huge_pages,
+			float plain_buffer_pool_max_cached_memory)
 			: plain_max_global_memory_usage(plain_max_global_memory_usage)
 			, plain_openmp_thread_count(plain_openmp_thread_count)
+			, plain_parallel_branches(plain_parallel_branches)
+			, plain_recompute_activations(plain_recompute_activations)
+			, plain_bf16_activations(plain_bf16_activations)
+			, plain_numa(plain_numa)
+			, plain_autotune(plain_autotune)
+			, plain_kernel_tuning_cache(plain_kernel_tuning_cache)
+			, plain_huge_pages(plain_huge_pages)
+			, plain_buffer_pool_max_cached_memory(plain_buffer_pool_max_cached_memory)
 		{
 		}
 
 		void factory_generator_plain::initialize()
 		{
+			plain_running_configuration::mode_settings modes;
+			modes.parallel_branches = plain_parallel_branches;
+			modes.recompute_activations = plain_recompute_activations;
+			modes.bf16_activations = plain_bf16_activations;
+			modes.numa_aware = plain_numa;
 			plain_config = plain_running_configuration::const_ptr(new plain_running_configuration(
 				plain_openmp_thread_count,
-				plain_max_global_memory_usage));
+				plain_max_global_memory_usage,
+				modes));
+
+			// Blocks cached by the pool are counted against the global memory budget together with the ones in use
+			plain_buffer_pool::get_singleton().configure(
+				plain_buffer_pool::get_huge_page_mode(plain_huge_pages),
+				static_cast<size_t>(plain_buffer_pool_max_cached_memory * static_cast<float>(1 << 30)),
+				static_cast<size_t>(plain_max_global_memory_usage * static_cast<float>(1 << 30)));
+
+			plain_kernel_tuner::get_singleton().configure(
+				plain_autotune,
+				plain_kernel_tuning_cache);
 		}
 
 		forward_propagation_factory::ptr factory_generator_plain::create_forward_propagation_factory() const
@@ -54,11 +88,35 @@ namespace nnforge
 			return backward_propagation_factory::ptr(new backward_propagation_plain_factory(plain_config));
 		}
 
+		std::vector<string_option> factory_generator_plain::get_string_options()
+		{
+			std::vector<string_option> res;
+
+			res.push_back(string_option("plain_huge_pages", &plain_huge_pages, "transparent", "Back large plain buffers with 2 MB huge pages (none, transparent, explicit)"));
+			res.push_back(string_option("plain_kernel_tuning_cache", &plain_kernel_tuning_cache, "plain_kernel_tuning.txt", "File keeping kernel settings found by autotuning, empty means not to persist them"));
+
+			return res;
+		}
+
+		std::vector<bool_option> factory_generator_plain::get_bool_options()
+		{
+			std::vector<bool_option> res;
+
+			res.push_back(bool_option("plain_parallel_branches", &plain_parallel_branches, false, "Run independent branches of the schema concurrently, splitting OpenMP threads between them"));
+			res.push_back(bool_option("plain_recompute_activations", &plain_recompute_activations, false, "Drop some of the activations after forward prop and recompute them during backward prop when the batch doesn't fit into memory otherwise"));
+			res.push_back(bool_option("plain_bf16_activations", &plain_bf16_activations, false, "Keep activations needed by backward prop in bfloat16 between forward and backward prop, computations stay in fp32"));
+			res.push_back(bool_option("plain_numa", &plain_numa, false, "Pin OpenMP threads to NUMA nodes, schedule kernel loops statically and place buffers on the nodes of the threads processing them"));
+			res.push_back(bool_option("plain_autotune", &plain_autotune, false, "Time OpenMP schedule and thread count candidates for each layer on the first use and run it with the fastest ones (sequential forward prop only)"));
+
+			return res;
+		}
+
 		std::vector<float_option> factory_generator_plain::get_float_options()
 		{
 			std::vector<float_option> res;
 
 			res.push_back(float_option("plain_max_global_memory_usage,M", &plain_max_global_memory_usage, 0.5F, "memory to be used by single plain configuration, in GB."));
+			res.push_back(float_option("plain_buffer_pool_max_cached_memory", &plain_buffer_pool_max_cached_memory, 0.5F, "memory kept by plain buffer pool for reuse across runs, in GB, limited to what plain_max_global_memory_usage leaves free."));
 
 			return res;
 		}
@@ -77,6 +135,11 @@ namespace nnforge
 		void factory_generator_plain::info() const
 		{
 			std::cout << *plain_config;
+			std::cout << "Huge pages = " << plain_huge_pages << std::endl;
+			std::cout << "Buffer pool max cached memory = " << plain_buffer_pool_max_cached_memory << " GB" << std::endl;
+			std::cout << "Autotune = " << plain_autotune << std::endl;
+			if (plain_autotune)
+				std::cout << "Kernel tuning cache = " << plain_kernel_tuning_cache << std::endl;
 		}
 	}
 }
@@ -28,7 +28,15 @@ namespace nnforge
 		public:
 			factory_generator_plain(
 				float plain_max_global_memory_usage,
-				int plain_openmp_thread_count);
+				int plain_openmp_thread_count,
+				bool plain_parallel_branches,
+				bool plain_recompute_activations,
+				bool plain_bf16_activations,
+				bool plain_numa,
+				bool plain_autotune,
+				const std::string& plain_kernel_tuning_cache,
+				const std::string& plain_huge_pages,
+				float plain_buffer_pool_max_cached_memory);
 
 			factory_generator_plain() = default;
 
@@ -42,6 +50,10 @@ namespace nnforge
 
 			virtual void info() const;
 
+			virtual std::vector<string_option> get_string_options();
+
+			virtual std::vector<bool_option> get_bool_options();
+
 			virtual std::vector<float_option> get_float_options();
 
 			virtual std::vector<int_option> get_int_options();
@@ -49,6 +61,14 @@ namespace nnforge
 		protected:
 			float plain_max_global_memory_usage;
 			int plain_openmp_thread_count;
+			bool plain_parallel_branches;
+			bool plain_recompute_activations;
+			bool plain_bf16_activations;
+			bool plain_numa;
+			bool plain_autotune;
+			std::string plain_kernel_tuning_cache;
+			std::string plain_huge_pages;
+			float plain_buffer_pool_max_cached_memory;
 
 			plain_running_configuration::const_ptr plain_config;
 		};
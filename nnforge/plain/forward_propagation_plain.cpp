@@ -17,12 +17,25 @@
 #include "forward_propagation_plain.h"
 
 #include "layer_tester_plain_factory.h"
+#include "max_subsampling_layer_tester_plain.h"
+#include "plain_buffer_pool.h"
 
 #include <boost/filesystem.hpp>
 #include <boost/format.hpp>
 #include <boost/filesystem/fstream.hpp>
 
 #include "../neural_network_exception.h"
+#include "../rectified_linear_layer.h"
+#include "../reshape_layer.h"
+#include "../concat_layer.h"
+#include "../max_subsampling_layer.h"
+
+#include <algorithm>
+#include <chrono>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 namespace nnforge
 {
@@ -40,29 +53,34 @@ namespace nnforge
 			, plain_config(plain_config)
 			, max_entry_count(0)
 			, temporary_working_fixed_size(0)
+			, concurrent_action_count(1)
 		{
 			actions_in_execution_order = action_schema->get_actions_in_execution_order();
 
 			// CPU is an easy to saturate device, we run everything in a single stream/thread, this will save some (maybe significant amount of) RAM
-			network_action_schema::ptr sequential_action_schema(new network_action_schema());
+			// In parallel branches mode we keep the original graph, buffer sets will then account for actions running concurrently
+			if (!plain_config->parallel_branches)
 			{
-				std::vector<layer_name_with_action> dependencies;
-				for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
+				network_action_schema::ptr sequential_action_schema(new network_action_schema());
 				{
-					sequential_action_schema->add_action(
-						this->schema->get_layer(it->get_name()),
-						it->get_action(),
-						dependencies);
-					dependencies.clear();
-					dependencies.push_back(*it);
+					std::vector<layer_name_with_action> dependencies;
+					for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
+					{
+						sequential_action_schema->add_action(
+							this->schema->get_layer(it->get_name()),
+							it->get_action(),
+							dependencies);
+						dependencies.clear();
+						dependencies.push_back(*it);
+					}
 				}
-			}
-			action_schema = sequential_action_schema;
+				action_schema = sequential_action_schema;
 
-			if (debug->is_debug())
-			{
-				boost::filesystem::ofstream out(debug->get_path_to_unique_file("forward_prop_plain_action_schema_sequential", "gv"), std::ios_base::out | std::ios_base::trunc);
-				action_schema->write_gv(out);
+				if (debug->is_debug())
+				{
+					boost::filesystem::ofstream out(debug->get_path_to_unique_file("forward_prop_plain_action_schema_sequential", "gv"), std::ios_base::out | std::ios_base::trunc);
+					action_schema->write_gv(out);
+				}
 			}
 
 			for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
@@ -95,18 +113,37 @@ namespace nnforge
 			current_max_entry_count = std::min(current_max_entry_count, max_max_entry_count);
 			const int current_max_entry_count_const = static_cast<int>(current_max_entry_count);
 
+			plain_running_configuration::openmp_state openmp_state = plain_config->setup_openmp();
+
 			std::map<std::string, plain_buffer::ptr> dedicated_buffers;
 			for(std::map<std::string, size_t>::const_iterator it = dedicated_per_entry_data_name_to_size_map.begin(); it != dedicated_per_entry_data_name_to_size_map.end(); ++it)
 				dedicated_buffers.insert(std::make_pair(it->first, plain_buffer::ptr(new plain_buffer(it->second * current_max_entry_count))));
 
-			plain_buffer::ptr temporary_working_fixed_buffer;
+			// Each of the actions running concurrently gets its own fixed working buffer
+			std::vector<plain_buffer::ptr> temporary_working_fixed_buffers(concurrent_action_count);
 			if (temporary_working_fixed_size > 0)
-				temporary_working_fixed_buffer = plain_buffer::ptr(new plain_buffer(temporary_working_fixed_size));
+				for(std::vector<plain_buffer::ptr>::iterator it = temporary_working_fixed_buffers.begin(); it != temporary_working_fixed_buffers.end(); ++it)
+					*it = plain_buffer::ptr(new plain_buffer(temporary_working_fixed_size));
 
 			std::vector<plain_buffer::ptr> layer_buffers;
 			for(std::vector<size_t>::const_iterator it = layer_buffer_set_per_entry_size_list.begin(); it != layer_buffer_set_per_entry_size_list.end(); ++it)
 				layer_buffers.push_back(plain_buffer::ptr(new plain_buffer(*it * current_max_entry_count)));
 
+			if (plain_config->numa_aware)
+			{
+				for(std::map<std::string, plain_buffer::ptr>::iterator it = dedicated_buffers.begin(); it != dedicated_buffers.end(); ++it)
+					plain_config->first_touch(*it->second, it->second->get_size());
+				for(std::vector<plain_buffer::ptr>::iterator it = layer_buffers.begin(); it != layer_buffers.end(); ++it)
+					plain_config->first_touch(**it, (*it)->get_size());
+			}
+
+			if (debug->is_debug())
+			{
+				std::stringstream debug_str;
+				debug_str << "forward prop plain buffer pool: " << plain_buffer_pool::get_singleton().get_usage_stats();
+				debug->output_message(debug_str.str().c_str());
+			}
+
 			unsigned int entry_processed_count = 0;
 
 			while(true)
@@ -127,55 +164,91 @@ namespace nnforge
 				if (entry_read_count == 0)
 					break;
 
-				for(std::vector<layer_name_with_action>::const_iterator action_it = actions_in_execution_order.begin(); action_it  != actions_in_execution_order.end(); ++action_it)
+				if (action_waves.empty())
 				{
-					const layer_name_with_action& current_layer_name_with_action = *action_it;
-					std::string layer_name = current_layer_name_with_action.get_name();;
-					layer_action action = current_layer_name_with_action.get_action();
-					layer::const_ptr current_layer = schema->find_layer(layer_name);
-
-					plain_buffer::ptr output_buffer;
+					for(std::vector<layer_name_with_action>::const_iterator action_it = actions_in_execution_order.begin(); action_it  != actions_in_execution_order.end(); ++action_it)
 					{
-						std::map<layer_name_with_action, unsigned int>::const_iterator it = layer_buffer_action_to_set_map.find(current_layer_name_with_action);
-						if (it != layer_buffer_action_to_set_map.end())
-							output_buffer = layer_buffers[it->second];
+						if (plain_kernel_tuner::get_singleton().is_enabled() && is_action_tunable(*action_it))
+						{
+							plain_kernel_tuner::kernel_choice choice = get_kernel_choice(
+								*action_it,
+								temporary_working_fixed_buffers.front(),
+								layer_buffers,
+								dedicated_buffers,
+								entry_read_count,
+								openmp_state);
+							plain_kernel_tuner::apply_schedule(choice.schedule);
+							run_action(
+								*action_it,
+								get_plain_config(choice.thread_count),
+								temporary_working_fixed_buffers.front(),
+								layer_buffers,
+								dedicated_buffers,
+								entry_read_count);
+							plain_config->reset_openmp_schedule(openmp_state);
+						}
 						else
-							output_buffer = dedicated_buffers.find(layer_name)->second;
+						{
+							run_action(
+								*action_it,
+								plain_config,
+								temporary_working_fixed_buffers.front(),
+								layer_buffers,
+								dedicated_buffers,
+								entry_read_count);
+						}
 					}
+				}
+				else
+				{
+					// Actions within the wave run their own parallel regions, the setting is restored afterwards
+					#ifdef _OPENMP
+					int previous_max_active_levels = omp_get_max_active_levels();
+					omp_set_max_active_levels(std::max(previous_max_active_levels, 2));
+					#endif
 
-					std::vector<plain_buffer::const_ptr> input_buffers;
-					for(std::vector<std::string>::const_iterator input_layer_name_it = current_layer->input_layer_instance_names.begin(); input_layer_name_it != current_layer->input_layer_instance_names.end(); ++input_layer_name_it)
+					for(unsigned int wave_id = 0; wave_id < static_cast<unsigned int>(action_waves.size()); ++wave_id)
 					{
-						std::map<layer_name_with_action, unsigned int>::const_iterator it = layer_buffer_action_to_set_map.find(layer_name_with_action(*input_layer_name_it, layer_action::forward));
-						if (it != layer_buffer_action_to_set_map.end())
-							input_buffers.push_back(layer_buffers[it->second]);
-						else
-							input_buffers.push_back(dedicated_buffers.find(*input_layer_name_it)->second);
-					}
+						const std::vector<layer_name_with_action>& wave = action_waves[wave_id];
+						const std::vector<int>& thread_counts = action_wave_thread_counts[wave_id];
+						if (wave.size() == 1)
+						{
+							run_action(
+								wave.front(),
+								plain_config,
+								temporary_working_fixed_buffers.front(),
+								layer_buffers,
+								dedicated_buffers,
+								entry_read_count);
+							continue;
+						}
 
-					plain_buffer::ptr temporary_working_per_entry_buffer;
-					{
-						std::map<layer_name_with_action, unsigned int>::const_iterator it = temporary_working_per_entry_data_action_to_set_map.find(current_layer_name_with_action);
-						if (it != temporary_working_per_entry_data_action_to_set_map.end())
-							temporary_working_per_entry_buffer = layer_buffers[it->second];
-					}
+						// Configs are created here as the map is not to be modified by concurrent actions
+						std::vector<plain_running_configuration::const_ptr> action_plain_configs;
+						for(std::vector<int>::const_iterator it = thread_counts.begin(); it != thread_counts.end(); ++it)
+							action_plain_configs.push_back(get_plain_config(*it));
 
-					std::vector<layer_configuration_specific> input_layer_configuration_specific_list;
-					for(std::vector<std::string>::const_iterator it2 = current_layer->input_layer_instance_names.begin(); it2 != current_layer->input_layer_instance_names.end(); ++it2)
-						input_layer_configuration_specific_list.push_back(layer_config_map[*it2]);
+						const int action_count = static_cast<int>(wave.size());
+						#pragma omp parallel for default(shared) schedule(dynamic, 1) num_threads(std::min(action_count, plain_config->openmp_thread_count))
+						for(int action_id = 0; action_id < action_count; ++action_id)
+						{
+							int thread_id = 0;
+							#ifdef _OPENMP
+							thread_id = omp_get_thread_num();
+							#endif
+							run_action(
+								wave[action_id],
+								action_plain_configs[action_id],
+								temporary_working_fixed_buffers[thread_id],
+								layer_buffers,
+								dedicated_buffers,
+								entry_read_count);
+						}
+					}
 
-					testers.find(layer_name)->second->run_forward_propagation(
-						output_buffer,
-						input_buffers,
-						temporary_working_fixed_buffer,
-						temporary_working_per_entry_buffer,
-						plain_config,
-						current_layer,
-						net_data->data_list.find(layer_name),
-						net_data->data_custom_list.find(layer_name),
-						input_layer_configuration_specific_list,
-						layer_config_map[layer_name],
-						entry_read_count * cumulative_tiling_factor_map[layer_name]);
+					#ifdef _OPENMP
+					omp_set_max_active_levels(previous_max_active_levels);
+					#endif
 				}
 
 				for(int entry_id = 0; entry_id < entry_read_count * static_cast<int>(output_layers_tiling_factor); ++entry_id)
@@ -192,27 +265,444 @@ namespace nnforge
 					break;
 			}
 
+			plain_config->restore_openmp(openmp_state);
+
 			entries_processed = entry_processed_count;
 			action_seconds.clear();
 		}
 
+		void forward_propagation_plain::run_action(
+			const layer_name_with_action& current_layer_name_with_action,
+			plain_running_configuration::const_ptr action_plain_config,
+			plain_buffer::ptr temporary_working_fixed_buffer,
+			const std::vector<plain_buffer::ptr>& layer_buffers,
+			const std::map<std::string, plain_buffer::ptr>& dedicated_buffers,
+			unsigned int entry_count) const
+		{
+			// The layer is run by its consumer
+			if (fused_relu_actions.find(current_layer_name_with_action) != fused_relu_actions.end())
+				return;
+
+			std::string layer_name = current_layer_name_with_action.get_name();
+
+			// The inputs have already written their data into the concat output
+			if ((entry_count == 1) && (aliased_concat_layer_names.find(layer_name) != aliased_concat_layer_names.end()))
+				return;
+
+			layer::const_ptr current_layer = schema->find_layer(layer_name);
+
+			plain_buffer::ptr output_buffer;
+			{
+				std::map<std::string, std::pair<std::string, size_t> >::const_iterator slice_it = concat_input_layer_name_to_slice_map.find(layer_name);
+				std::map<layer_name_with_action, unsigned int>::const_iterator it = layer_buffer_action_to_set_map.find(current_layer_name_with_action);
+				if ((entry_count == 1) && (slice_it != concat_input_layer_name_to_slice_map.end()))
+				{
+					// A single entry slice of the concat output is dense, so the producer writes there as it would into its own buffer
+					output_buffer = plain_buffer::ptr(new plain_buffer(
+						dedicated_buffers.find(slice_it->second.first)->second,
+						slice_it->second.second,
+						layer_config_map.find(layer_name)->second.get_neuron_count() * sizeof(float)));
+				}
+				else if (it != layer_buffer_action_to_set_map.end())
+					output_buffer = layer_buffers[it->second];
+				else
+					output_buffer = dedicated_buffers.find(layer_name)->second;
+			}
+
+			std::vector<plain_buffer::const_ptr> input_buffers;
+			for(std::vector<std::string>::const_iterator input_layer_name_it = current_layer->input_layer_instance_names.begin(); input_layer_name_it != current_layer->input_layer_instance_names.end(); ++input_layer_name_it)
+			{
+				std::map<layer_name_with_action, unsigned int>::const_iterator it = layer_buffer_action_to_set_map.find(layer_name_with_action(*input_layer_name_it, layer_action::forward));
+				if (it != layer_buffer_action_to_set_map.end())
+					input_buffers.push_back(layer_buffers[it->second]);
+				else
+					input_buffers.push_back(dedicated_buffers.find(*input_layer_name_it)->second);
+			}
+
+			plain_buffer::ptr temporary_working_per_entry_buffer;
+			{
+				std::map<layer_name_with_action, unsigned int>::const_iterator it = temporary_working_per_entry_data_action_to_set_map.find(current_layer_name_with_action);
+				if (it != temporary_working_per_entry_data_action_to_set_map.end())
+					temporary_working_per_entry_buffer = layer_buffers[it->second];
+			}
+
+			std::vector<layer_configuration_specific> input_layer_configuration_specific_list;
+			for(std::vector<std::string>::const_iterator it2 = current_layer->input_layer_instance_names.begin(); it2 != current_layer->input_layer_instance_names.end(); ++it2)
+				input_layer_configuration_specific_list.push_back(layer_config_map.find(*it2)->second);
+
+			if (layers_with_fused_relu.find(layer_name) != layers_with_fused_relu.end())
+			{
+				std::static_pointer_cast<const max_subsampling_layer_tester_plain>(testers.find(layer_name)->second)->run_forward_propagation_with_relu(
+					output_buffer,
+					input_buffers[0],
+					action_plain_config,
+					current_layer,
+					input_layer_configuration_specific_list[0],
+					layer_config_map.find(layer_name)->second,
+					entry_count * cumulative_tiling_factor_map.find(layer_name)->second);
+				return;
+			}
+
+			testers.find(layer_name)->second->run_forward_propagation(
+				output_buffer,
+				input_buffers,
+				temporary_working_fixed_buffer,
+				temporary_working_per_entry_buffer,
+				action_plain_config,
+				current_layer,
+				net_data->data_list.find(layer_name),
+				net_data->data_custom_list.find(layer_name),
+				input_layer_configuration_specific_list,
+				layer_config_map.find(layer_name)->second,
+				entry_count * cumulative_tiling_factor_map.find(layer_name)->second);
+		}
+
+		plain_kernel_tuner::kernel_choice forward_propagation_plain::get_kernel_choice(
+			const layer_name_with_action& current_layer_name_with_action,
+			plain_buffer::ptr temporary_working_fixed_buffer,
+			const std::vector<plain_buffer::ptr>& layer_buffers,
+			const std::map<std::string, plain_buffer::ptr>& dedicated_buffers,
+			unsigned int entry_count,
+			const plain_running_configuration::openmp_state& openmp_state)
+		{
+			std::map<std::pair<layer_name_with_action, unsigned int>, plain_kernel_tuner::kernel_choice>::const_iterator known_it = action_and_entry_count_to_kernel_choice_map.find(std::make_pair(current_layer_name_with_action, entry_count));
+			if (known_it != action_and_entry_count_to_kernel_choice_map.end())
+				return known_it->second;
+
+			plain_kernel_tuner& tuner = plain_kernel_tuner::get_singleton();
+			std::string layer_name = current_layer_name_with_action.get_name();
+			layer::const_ptr current_layer = schema->find_layer(layer_name);
+			std::vector<layer_configuration_specific> input_layer_configuration_specific_list;
+			for(std::vector<std::string>::const_iterator it = current_layer->input_layer_instance_names.begin(); it != current_layer->input_layer_instance_names.end(); ++it)
+				input_layer_configuration_specific_list.push_back(layer_config_map.find(*it)->second);
+			std::string layer_signature = tuner.get_layer_signature(
+				current_layer,
+				current_layer_name_with_action.get_action(),
+				input_layer_configuration_specific_list,
+				layer_config_map.find(layer_name)->second,
+				entry_count * cumulative_tiling_factor_map.find(layer_name)->second,
+				plain_config->openmp_thread_count);
+
+			plain_kernel_tuner::kernel_choice choice(plain_config->numa_aware ? plain_kernel_tuner::schedule_static : plain_kernel_tuner::schedule_guided, plain_config->openmp_thread_count);
+			if (!tuner.find_choice(layer_signature, choice))
+			{
+				float best_seconds = -1.0F;
+				std::vector<plain_kernel_tuner::kernel_choice> candidates = plain_kernel_tuner::get_candidates(plain_config->openmp_thread_count);
+				for(std::vector<plain_kernel_tuner::kernel_choice>::const_iterator it = candidates.begin(); it != candidates.end(); ++it)
+				{
+					plain_kernel_tuner::apply_schedule(it->schedule);
+					plain_running_configuration::const_ptr candidate_plain_config = get_plain_config(it->thread_count);
+					// The first run warms up caches, the best of the others is taken
+					float candidate_seconds = -1.0F;
+					for(int run_id = 0; run_id < 3; ++run_id)
+					{
+						std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+						run_action(
+							current_layer_name_with_action,
+							candidate_plain_config,
+							temporary_working_fixed_buffer,
+							layer_buffers,
+							dedicated_buffers,
+							entry_count);
+						std::chrono::duration<float> sec = std::chrono::high_resolution_clock::now() - start;
+						if ((run_id > 0) && ((candidate_seconds < 0.0F) || (sec.count() < candidate_seconds)))
+							candidate_seconds = sec.count();
+					}
+					if ((best_seconds < 0.0F) || (candidate_seconds < best_seconds))
+					{
+						best_seconds = candidate_seconds;
+						choice = *it;
+					}
+				}
+				plain_config->reset_openmp_schedule(openmp_state);
+
+				tuner.set_choice(layer_signature, choice);
+
+				if (debug->is_debug())
+				{
+					std::stringstream debug_str;
+					debug_str << "forward prop plain tuned " << current_layer_name_with_action.get_name() << " " << current_layer_name_with_action.get_action().str()
+						<< " for " << entry_count << " entries: " << plain_kernel_tuner::get_schedule_str(choice.schedule) << " schedule, " << choice.thread_count << " threads";
+					debug->output_message(debug_str.str().c_str());
+				}
+			}
+
+			action_and_entry_count_to_kernel_choice_map.insert(std::make_pair(std::make_pair(current_layer_name_with_action, entry_count), choice));
+
+			return choice;
+		}
+
+		bool forward_propagation_plain::is_action_tunable(const layer_name_with_action& current_layer_name_with_action) const
+		{
+			// The layer is run by its consumer, there is nothing to time
+			if (fused_relu_actions.find(current_layer_name_with_action) != fused_relu_actions.end())
+				return false;
+
+			// Running the action again would corrupt the input if the output is written in-place,
+			// reshape views are no-ops in addition
+			std::map<layer_name_with_action, unsigned int>::const_iterator output_it = layer_buffer_action_to_set_map.find(current_layer_name_with_action);
+			if (output_it != layer_buffer_action_to_set_map.end())
+			{
+				layer::const_ptr current_layer = schema->find_layer(current_layer_name_with_action.get_name());
+				for(std::vector<std::string>::const_iterator it = current_layer->input_layer_instance_names.begin(); it != current_layer->input_layer_instance_names.end(); ++it)
+				{
+					std::map<layer_name_with_action, unsigned int>::const_iterator input_it = layer_buffer_action_to_set_map.find(layer_name_with_action(*it, layer_action::forward));
+					if ((input_it != layer_buffer_action_to_set_map.end()) && (input_it->second == output_it->second))
+						return false;
+				}
+			}
+
+			return true;
+		}
+
+		plain_running_configuration::const_ptr forward_propagation_plain::get_plain_config(int thread_count)
+		{
+			if (thread_count == plain_config->openmp_thread_count)
+				return plain_config;
+
+			std::map<int, plain_running_configuration::const_ptr>::const_iterator it = thread_count_to_plain_config_map.find(thread_count);
+			if (it != thread_count_to_plain_config_map.end())
+				return it->second;
+
+			// Configs run a single action each, the modes affecting the whole propagation are off
+			plain_running_configuration::mode_settings modes;
+			modes.numa_aware = plain_config->numa_aware;
+			plain_running_configuration::const_ptr res(new plain_running_configuration(thread_count, plain_config->max_memory_usage_gigabytes, modes));
+			thread_count_to_plain_config_map.insert(std::make_pair(thread_count, res));
+			return res;
+		}
+
 		void forward_propagation_plain::layer_config_map_modified()
 		{
+			action_and_entry_count_to_kernel_choice_map.clear();
+
+			setup_action_waves();
+
+			setup_concat_aliasing();
+
 			setup_dedicated_buffer_sizes();
 
 			setup_layer_buffer_sizes();
 
+			setup_fused_relu();
+
 			setup_temporary_working_fixed_buffer_sizes();
 
 			update_max_entry_count();
 		}
 
+		forward_propagation::plan::ptr forward_propagation_plain::save_plan() const
+		{
+			std::shared_ptr<plain_plan> res(new plain_plan());
+			res->temporary_working_fixed_size = temporary_working_fixed_size;
+			res->layer_buffer_set_per_entry_size_list = layer_buffer_set_per_entry_size_list;
+			res->temporary_working_per_entry_data_action_to_set_map = temporary_working_per_entry_data_action_to_set_map;
+			res->layer_buffer_action_to_set_map = layer_buffer_action_to_set_map;
+			res->dedicated_per_entry_data_name_to_size_map = dedicated_per_entry_data_name_to_size_map;
+			res->fused_relu_actions = fused_relu_actions;
+			res->layers_with_fused_relu = layers_with_fused_relu;
+			res->concat_input_layer_name_to_slice_map = concat_input_layer_name_to_slice_map;
+			res->aliased_concat_layer_names = aliased_concat_layer_names;
+			res->action_waves = action_waves;
+			res->action_wave_thread_counts = action_wave_thread_counts;
+			res->concurrent_action_count = concurrent_action_count;
+			res->thread_count_to_plain_config_map = thread_count_to_plain_config_map;
+			res->action_and_entry_count_to_kernel_choice_map = action_and_entry_count_to_kernel_choice_map;
+			res->max_entry_count = max_entry_count;
+			return res;
+		}
+
+		void forward_propagation_plain::restore_plan(plan::ptr backend_plan)
+		{
+			const plain_plan& p = *std::dynamic_pointer_cast<plain_plan>(backend_plan);
+			temporary_working_fixed_size = p.temporary_working_fixed_size;
+			layer_buffer_set_per_entry_size_list = p.layer_buffer_set_per_entry_size_list;
+			temporary_working_per_entry_data_action_to_set_map = p.temporary_working_per_entry_data_action_to_set_map;
+			layer_buffer_action_to_set_map = p.layer_buffer_action_to_set_map;
+			dedicated_per_entry_data_name_to_size_map = p.dedicated_per_entry_data_name_to_size_map;
+			fused_relu_actions = p.fused_relu_actions;
+			layers_with_fused_relu = p.layers_with_fused_relu;
+			concat_input_layer_name_to_slice_map = p.concat_input_layer_name_to_slice_map;
+			aliased_concat_layer_names = p.aliased_concat_layer_names;
+			action_waves = p.action_waves;
+			action_wave_thread_counts = p.action_wave_thread_counts;
+			concurrent_action_count = p.concurrent_action_count;
+			thread_count_to_plain_config_map = p.thread_count_to_plain_config_map;
+			action_and_entry_count_to_kernel_choice_map = p.action_and_entry_count_to_kernel_choice_map;
+			max_entry_count = p.max_entry_count;
+		}
+
+		void forward_propagation_plain::setup_action_waves()
+		{
+			action_waves.clear();
+			action_wave_thread_counts.clear();
+			thread_count_to_plain_config_map.clear();
+			concurrent_action_count = 1;
+
+			if (!plain_config->parallel_branches)
+				return;
+
+			std::map<layer_name_with_action, float> flops_per_action = action_schema->get_flops_per_action(layer_config_map, cumulative_tiling_factor_map);
+
+			// Each action is put into the earliest wave following the waves of all the actions it depends on
+			std::map<layer_name_with_action, unsigned int> action_to_wave_map;
+			for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
+			{
+				unsigned int wave_id = 0;
+				std::vector<layer_name_with_action> dependencies = action_schema->get_dependencies(*it);
+				for(std::vector<layer_name_with_action>::const_iterator it2 = dependencies.begin(); it2 != dependencies.end(); ++it2)
+				{
+					std::map<layer_name_with_action, unsigned int>::const_iterator it3 = action_to_wave_map.find(*it2);
+					if (it3 != action_to_wave_map.end())
+						wave_id = std::max(wave_id, it3->second + 1);
+				}
+				action_to_wave_map.insert(std::make_pair(*it, wave_id));
+				if (wave_id >= action_waves.size())
+					action_waves.resize(wave_id + 1);
+				action_waves[wave_id].push_back(*it);
+			}
+
+			const int thread_count = plain_config->openmp_thread_count;
+			for(std::vector<std::vector<layer_name_with_action> >::iterator it = action_waves.begin(); it != action_waves.end(); ++it)
+			{
+				std::vector<layer_name_with_action>& wave = *it;
+				const int action_count = static_cast<int>(wave.size());
+
+				// Heavier actions go first, they get the remaining threads and are picked up first by the dynamic schedule
+				std::vector<std::pair<float, layer_name_with_action> > flops_and_actions;
+				float total_flops = 0.0F;
+				for(std::vector<layer_name_with_action>::const_iterator it2 = wave.begin(); it2 != wave.end(); ++it2)
+				{
+					float current_flops = flops_per_action[*it2];
+					flops_and_actions.push_back(std::make_pair(-current_flops, *it2));
+					total_flops += current_flops;
+				}
+				std::stable_sort(flops_and_actions.begin(), flops_and_actions.end());
+
+				std::vector<int> thread_counts(action_count, 1);
+				if (action_count == 1)
+					thread_counts.front() = thread_count;
+				else if (action_count < thread_count)
+				{
+					// Split threads between the actions proportionally to the amount of work
+					int spare_thread_count = thread_count - action_count;
+					int distributed_thread_count = 0;
+					for(int i = 0; i < action_count; ++i)
+					{
+						int additional_thread_count = (total_flops > 0.0F) ? static_cast<int>(static_cast<float>(spare_thread_count) * -flops_and_actions[i].first / total_flops) : spare_thread_count / action_count;
+						additional_thread_count = std::min(additional_thread_count, spare_thread_count - distributed_thread_count);
+						thread_counts[i] += additional_thread_count;
+						distributed_thread_count += additional_thread_count;
+					}
+					for(int i = 0; distributed_thread_count < spare_thread_count; i = (i + 1) % action_count, ++distributed_thread_count)
+						++thread_counts[i];
+				}
+
+				for(int i = 0; i < action_count; ++i)
+				{
+					wave[i] = flops_and_actions[i].second;
+					// Configs are created upfront, actions of the wave look them up concurrently
+					get_plain_config(thread_counts[i]);
+				}
+				action_wave_thread_counts.push_back(thread_counts);
+
+				concurrent_action_count = std::max(concurrent_action_count, static_cast<unsigned int>(std::min(action_count, thread_count)));
+			}
+
+			if (debug->is_debug())
+			{
+				std::stringstream debug_str;
+				debug_str << "forward prop plain parallel branches: " << action_waves.size() << " waves, up to " << concurrent_action_count << " concurrent actions";
+				debug->output_message(debug_str.str().c_str());
+				for(unsigned int wave_id = 0; wave_id < static_cast<unsigned int>(action_waves.size()); ++wave_id)
+				{
+					if (action_waves[wave_id].size() <= 1)
+						continue;
+					std::stringstream debug_str;
+					debug_str << " - wave " << wave_id << ": ";
+					for(unsigned int i = 0; i < static_cast<unsigned int>(action_waves[wave_id].size()); ++i)
+					{
+						if (i != 0)
+							debug_str << ", ";
+						debug_str << action_waves[wave_id][i].get_name() << " (" << action_wave_thread_counts[wave_id][i] << " threads)";
+					}
+					debug->output_message(debug_str.str().c_str());
+				}
+				boost::filesystem::ofstream out(debug->get_path_to_unique_file("forward_prop_plain_action_waves", "gv"), std::ios_base::out | std::ios_base::trunc);
+				action_schema->write_gv(out, action_to_wave_map);
+			}
+		}
+
+		void forward_propagation_plain::setup_concat_aliasing()
+		{
+			concat_input_layer_name_to_slice_map.clear();
+			aliased_concat_layer_names.clear();
+
+			std::map<std::string, unsigned int> layer_name_to_consumer_count_map;
+			for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
+			{
+				layer::const_ptr l = schema->get_layer(it->get_name());
+				for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2)
+					++layer_name_to_consumer_count_map[*it2];
+			}
+
+			std::set<std::string> output_layer_name_set(output_layer_names.begin(), output_layer_names.end());
+			for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
+			{
+				const std::string& layer_name = it->get_name();
+				layer::const_ptr l = schema->get_layer(layer_name);
+				if (l->get_type_name() != concat_layer::layer_type_name)
+					continue;
+				// Per entry slices are dense for a single entry only, tiling makes more than one out of it
+				if (cumulative_tiling_factor_map[layer_name] != 1)
+					continue;
+
+				// Each input should have its own buffer otherwise: data and output layers are read elsewhere,
+				// layers with other consumers are read after the concat is done, concat inputs are skipped themselves
+				bool aliasable = true;
+				for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2)
+				{
+					if ((data_layer_names.find(*it2) != data_layer_names.end())
+						|| (output_layer_name_set.find(*it2) != output_layer_name_set.end())
+						|| (layer_name_to_consumer_count_map[*it2] != 1)
+						|| (aliased_concat_layer_names.find(*it2) != aliased_concat_layer_names.end()))
+					{
+						aliasable = false;
+						break;
+					}
+				}
+				if (!aliasable)
+					continue;
+
+				size_t offset = 0;
+				for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2)
+				{
+					concat_input_layer_name_to_slice_map.insert(std::make_pair(*it2, std::make_pair(layer_name, offset)));
+					offset += layer_config_map.find(*it2)->second.get_neuron_count() * sizeof(float);
+				}
+				aliased_concat_layer_names.insert(layer_name);
+			}
+
+			if (debug->is_debug())
+			{
+				std::stringstream debug_str;
+				debug_str << "forward prop plain concat layers with inputs aliased into the output: " << aliased_concat_layer_names.size();
+				for(std::set<std::string>::const_iterator it = aliased_concat_layer_names.begin(); it != aliased_concat_layer_names.end(); ++it)
+					debug_str << (it == aliased_concat_layer_names.begin() ? " (" : ", ") << *it;
+				if (!aliased_concat_layer_names.empty())
+					debug_str << ")";
+				debug->output_message(debug_str.str().c_str());
+			}
+		}
+
 		void forward_propagation_plain::setup_dedicated_buffer_sizes()
 		{
 			dedicated_per_entry_data_name_to_size_map.clear();
 
+			// The output of the aliased concat is written by its inputs, so it doesn't share the buffer with other layers
 			std::set<std::string> separate_buffers_layer_names(output_layer_names.begin(), output_layer_names.end());
 			separate_buffers_layer_names.insert(data_layer_names.begin(), data_layer_names.end());
+			separate_buffers_layer_names.insert(aliased_concat_layer_names.begin(), aliased_concat_layer_names.end());
 			for(std::set<std::string>::const_iterator it = separate_buffers_layer_names.begin(); it != separate_buffers_layer_names.end(); ++it)
 				dedicated_per_entry_data_name_to_size_map.insert(std::make_pair(*it, layer_config_map.find(*it)->second.get_neuron_count() * cumulative_tiling_factor_map[*it] * sizeof(float)));
 		}
@@ -264,9 +754,43 @@ namespace nnforge
 						input_index_layer_can_write_output_map.insert(std::make_pair(layer_name_with_action(it->first, layer_action::forward), static_cast<unsigned int>(input_index_layer_can_write)));
 				}
 
+				std::set<std::string> dedicated_output_buffers(output_layer_names.begin(), output_layer_names.end());
+				dedicated_output_buffers.insert(aliased_concat_layer_names.begin(), aliased_concat_layer_names.end());
+
+				// Reshape doesn't move data, so its output is a view of the input buffer.
+				// Unlike the in-place write this also holds when other layers still read the input.
+				// Layers sharing the buffer are grouped by the layer which actually produces the data.
+				// Concat inputs are aliased into the output in setup_concat_aliasing
+				std::map<std::string, std::string> view_layer_name_to_source_layer_name_map;
+				std::map<std::string, std::vector<std::string> > source_layer_name_to_view_layer_names_map;
+				for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
+				{
+					const std::string& layer_name = it->get_name();
+					layer::const_ptr l = schema->get_layer(layer_name);
+					if (l->get_type_name() != reshape_layer::layer_type_name)
+						continue;
+					const std::string& input_layer_name = l->input_layer_instance_names.front();
+					if ((dedicated_output_buffers.find(layer_name) != dedicated_output_buffers.end())
+						|| (dedicated_output_buffers.find(input_layer_name) != dedicated_output_buffers.end())
+						|| (data_layer_names.find(input_layer_name) != data_layer_names.end()))
+						continue;
+
+					std::map<std::string, std::string>::const_iterator source_it = view_layer_name_to_source_layer_name_map.find(input_layer_name);
+					const std::string& source_layer_name = (source_it != view_layer_name_to_source_layer_name_map.end()) ? source_it->second : input_layer_name;
+					view_layer_name_to_source_layer_name_map.insert(std::make_pair(layer_name, source_layer_name));
+					source_layer_name_to_view_layer_names_map[source_layer_name].push_back(layer_name);
+				}
+
+				std::vector<std::vector<std::pair<layer_name_with_action, buffer_lifetime> > > should_be_placed_into_the_same_buffers;
+				for(std::map<std::string, std::vector<std::string> >::const_iterator it = source_layer_name_to_view_layer_names_map.begin(); it != source_layer_name_to_view_layer_names_map.end(); ++it)
+				{
+					should_be_placed_into_the_same_buffers.push_back(std::vector<std::pair<layer_name_with_action, buffer_lifetime> >(1, std::make_pair(layer_name_with_action(it->first, layer_action::forward), buffer_lifetime(buffer_lifetime::action_output_buffer))));
+					for(std::vector<std::string>::const_iterator it2 = it->second.begin(); it2 != it->second.end(); ++it2)
+						should_be_placed_into_the_same_buffers.back().push_back(std::make_pair(layer_name_with_action(*it2, layer_action::forward), buffer_lifetime(buffer_lifetime::action_output_buffer)));
+				}
+
 				std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, float> > > buffers;
 				std::map<layer_name_with_action, std::map<layer_name_with_action, std::vector<std::pair<buffer_lifetime, bool> > > > dependencies;
-				std::set<std::string> dedicated_output_buffers(output_layer_names.begin(), output_layer_names.end());
 				for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
 				{
 					std::string layer_name = it->get_name();
@@ -294,9 +818,15 @@ namespace nnforge
 					for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2, ++input_index)
 					{
 						const std::string& previous_layer_name = *it2;
+						// The buffer shared with views stays alive for them, only the views themselves are allowed to write into it
+						bool can_write = (input_index_layer_can_write == input_index);
+						if ((view_layer_name_to_source_layer_name_map.find(layer_name) == view_layer_name_to_source_layer_name_map.end())
+							&& ((view_layer_name_to_source_layer_name_map.find(previous_layer_name) != view_layer_name_to_source_layer_name_map.end())
+								|| (source_layer_name_to_view_layer_names_map.find(previous_layer_name) != source_layer_name_to_view_layer_names_map.end())))
+							can_write = false;
 						if (data_layer_names.find(previous_layer_name) == data_layer_names.end())
 							current_dependencies.insert(std::make_pair(layer_name_with_action(previous_layer_name, layer_action(layer_action::forward)), std::vector<std::pair<buffer_lifetime, bool> >(1,
-								std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), (input_index_layer_can_write == input_index)))));
+								std::make_pair(buffer_lifetime(buffer_lifetime::action_output_buffer), can_write))));
 					}
 					if (!current_dependencies.empty())
 						dependencies.insert(std::make_pair(*it, current_dependencies));
@@ -321,7 +851,14 @@ namespace nnforge
 				layer_buffer_set_list = action_schema->get_buffer_set(
 					buffers,
 					dependencies,
-					std::vector<std::vector<std::pair<layer_name_with_action, buffer_lifetime> > >());
+					should_be_placed_into_the_same_buffers);
+
+				if (debug->is_debug())
+				{
+					std::stringstream debug_str;
+					debug_str << "forward prop plain reshape layers turned into views: " << view_layer_name_to_source_layer_name_map.size();
+					debug->output_message(debug_str.str().c_str());
+				}
 			}
 
 			layer_buffer_set_per_entry_size_list.clear();
@@ -392,6 +929,61 @@ namespace nnforge
 			}
 		}
 
+		void forward_propagation_plain::setup_fused_relu()
+		{
+			fused_relu_actions.clear();
+			layers_with_fused_relu.clear();
+
+			std::map<std::string, std::vector<std::string> > layer_name_to_consumer_layer_names_map;
+			for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
+			{
+				layer::const_ptr l = schema->get_layer(it->get_name());
+				for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2)
+					layer_name_to_consumer_layer_names_map[*it2].push_back(it->get_name());
+			}
+
+			std::set<std::string> output_layer_name_set(output_layer_names.begin(), output_layer_names.end());
+			for(std::vector<layer_name_with_action>::const_iterator it = actions_in_execution_order.begin(); it != actions_in_execution_order.end(); ++it)
+			{
+				const std::string& layer_name = it->get_name();
+				layer::const_ptr l = schema->get_layer(layer_name);
+				if (l->get_type_name() != rectified_linear_layer::layer_type_name)
+					continue;
+				if (output_layer_name_set.find(layer_name) != output_layer_name_set.end())
+					continue;
+
+				const std::vector<std::string>& consumer_layer_names = layer_name_to_consumer_layer_names_map[layer_name];
+				if (consumer_layer_names.size() != 1)
+					continue;
+				const std::string& consumer_layer_name = consumer_layer_names.front();
+				layer::const_ptr consumer_layer = schema->get_layer(consumer_layer_name);
+				if (consumer_layer->get_type_name() != max_subsampling_layer::layer_type_name)
+					continue;
+				if (!std::static_pointer_cast<const max_subsampling_layer_tester_plain>(testers[consumer_layer_name])->is_relu_fusable(consumer_layer))
+					continue;
+
+				// Skipping ReLU is only valid when it runs in place, its output buffer then holds its input
+				std::map<layer_name_with_action, unsigned int>::const_iterator output_set_it = layer_buffer_action_to_set_map.find(*it);
+				std::map<layer_name_with_action, unsigned int>::const_iterator input_set_it = layer_buffer_action_to_set_map.find(layer_name_with_action(l->input_layer_instance_names.front(), layer_action::forward));
+				if ((output_set_it == layer_buffer_action_to_set_map.end()) || (input_set_it == layer_buffer_action_to_set_map.end()) || (output_set_it->second != input_set_it->second))
+					continue;
+
+				fused_relu_actions.insert(*it);
+				layers_with_fused_relu.insert(consumer_layer_name);
+			}
+
+			if (debug->is_debug())
+			{
+				std::stringstream debug_str;
+				debug_str << "forward prop plain ReLU layers fused into max subsampling: " << fused_relu_actions.size();
+				for(std::set<layer_name_with_action>::const_iterator it = fused_relu_actions.begin(); it != fused_relu_actions.end(); ++it)
+					debug_str << (it == fused_relu_actions.begin() ? " (" : ", ") << it->get_name();
+				if (!fused_relu_actions.empty())
+					debug_str << ")";
+				debug->output_message(debug_str.str().c_str());
+			}
+		}
+
 		void forward_propagation_plain::update_max_entry_count()
 		{
 			buffer_plain_size_configuration buffer_configuration;
@@ -418,7 +1010,7 @@ namespace nnforge
 			for(std::map<std::string, size_t>::const_iterator it = dedicated_per_entry_data_name_to_size_map.begin(); it != dedicated_per_entry_data_name_to_size_map.end(); ++it)
 				buffer_configuration.add_per_entry_buffer(it->second);
 
-			buffer_configuration.add_constant_buffer(temporary_working_fixed_size);
+			buffer_configuration.add_constant_buffer(temporary_working_fixed_size * concurrent_action_count);
 
 			max_entry_count = plain_config->get_max_entry_count(buffer_configuration);
 
@@ -19,8 +19,10 @@
 #include "../forward_propagation.h"
 #include "plain_running_configuration.h"
 #include "layer_tester_plain.h"
+#include "plain_kernel_tuner.h"
 
 #include <map>
+#include <set>
 
 namespace nnforge
 {
@@ -55,11 +57,68 @@ namespace nnforge
 			// The layer_config_map is guaranteed to be compatible with schema
 			virtual void layer_config_map_modified();
 
+			virtual plan::ptr save_plan() const;
+
+			virtual void restore_plan(plan::ptr backend_plan);
+
 		private:
+			// Everything layer_config_map_modified sets up, kernel choices made so far included
+			class plain_plan : public plan
+			{
+			public:
+				size_t temporary_working_fixed_size;
+				std::vector<size_t> layer_buffer_set_per_entry_size_list;
+				std::map<layer_name_with_action, unsigned int> temporary_working_per_entry_data_action_to_set_map;
+				std::map<layer_name_with_action, unsigned int> layer_buffer_action_to_set_map;
+				std::map<std::string, size_t> dedicated_per_entry_data_name_to_size_map;
+				std::set<layer_name_with_action> fused_relu_actions;
+				std::set<std::string> layers_with_fused_relu;
+				std::map<std::string, std::pair<std::string, size_t> > concat_input_layer_name_to_slice_map;
+				std::set<std::string> aliased_concat_layer_names;
+				std::vector<std::vector<layer_name_with_action> > action_waves;
+				std::vector<std::vector<int> > action_wave_thread_counts;
+				unsigned int concurrent_action_count;
+				std::map<int, plain_running_configuration::const_ptr> thread_count_to_plain_config_map;
+				std::map<std::pair<layer_name_with_action, unsigned int>, plain_kernel_tuner::kernel_choice> action_and_entry_count_to_kernel_choice_map;
+				unsigned int max_entry_count;
+			};
+
+		private:
+			void run_action(
+				const layer_name_with_action& current_layer_name_with_action,
+				plain_running_configuration::const_ptr action_plain_config,
+				plain_buffer::ptr temporary_working_fixed_buffer,
+				const std::vector<plain_buffer::ptr>& layer_buffers,
+				const std::map<std::string, plain_buffer::ptr>& dedicated_buffers,
+				unsigned int entry_count) const;
+
+			// Times the candidate kernel settings on the first use of the action with this chunk size, if the tuner doesn't know the winner yet
+			plain_kernel_tuner::kernel_choice get_kernel_choice(
+				const layer_name_with_action& current_layer_name_with_action,
+				plain_buffer::ptr temporary_working_fixed_buffer,
+				const std::vector<plain_buffer::ptr>& layer_buffers,
+				const std::map<std::string, plain_buffer::ptr>& dedicated_buffers,
+				unsigned int entry_count,
+				const plain_running_configuration::openmp_state& openmp_state);
+
+			// Fused actions and actions writing in-place (reshape views, for example) are not tuned
+			bool is_action_tunable(const layer_name_with_action& current_layer_name_with_action) const;
+
+			plain_running_configuration::const_ptr get_plain_config(int thread_count);
+
+			void setup_action_waves();
+
+			// Finds concat layers whose inputs are all produced for the concat only, the producers then write
+			// directly into their slices of the concat output when a single entry is processed
+			void setup_concat_aliasing();
+
 			void setup_dedicated_buffer_sizes();
 
 			void setup_layer_buffer_sizes();
 
+			// Finds in-place ReLU layers which are consumed by max subsampling only, they are then run as part of the subsampling
+			void setup_fused_relu();
+
 			void setup_temporary_working_fixed_buffer_sizes();
 
 			void update_max_entry_count();
@@ -80,6 +139,22 @@ namespace nnforge
 
 			std::map<std::string, size_t> dedicated_per_entry_data_name_to_size_map;
 
+			std::set<layer_name_with_action> fused_relu_actions;
+			std::set<std::string> layers_with_fused_relu;
+
+			// Producer layer name to the concat layer name and the byte offset of the producer's slice in the concat output
+			std::map<std::string, std::pair<std::string, size_t> > concat_input_layer_name_to_slice_map;
+			// Concat layers with dedicated output buffers, they don't copy anything when a single entry is processed
+			std::set<std::string> aliased_concat_layer_names;
+
+			// Filled in parallel branches mode only: actions in the same wave are independent and run concurrently
+			std::vector<std::vector<layer_name_with_action> > action_waves;
+			std::vector<std::vector<int> > action_wave_thread_counts;
+			unsigned int concurrent_action_count;
+
+			std::map<int, plain_running_configuration::const_ptr> thread_count_to_plain_config_map;
+			std::map<std::pair<layer_name_with_action, unsigned int>, plain_kernel_tuner::kernel_choice> action_and_entry_count_to_kernel_choice_map;
+
 			unsigned int max_entry_count;
 
 		private:
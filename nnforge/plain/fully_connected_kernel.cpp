@@ -0,0 +1,309 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "fully_connected_kernel.h"
+
+#include <algorithm>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// out0[i] += sum of in0[k] * w_i[k], out1[i] += sum of in1[k] * w_i[k] for 4 consecutive weight rows w_i
+		static inline void dot_2x4(
+			float * out0,
+			float * out1,
+			const float * in0,
+			const float * in1,
+			const float * w0,
+			int weight_row_stride,
+			int k_begin,
+			int k_end)
+		{
+			const float * w1 = w0 + weight_row_stride;
+			const float * w2 = w1 + weight_row_stride;
+			const float * w3 = w2 + weight_row_stride;
+			float s00 = 0.0F, s01 = 0.0F, s02 = 0.0F, s03 = 0.0F;
+			float s10 = 0.0F, s11 = 0.0F, s12 = 0.0F, s13 = 0.0F;
+			for(int k = k_begin; k < k_end; ++k)
+			{
+				float x0 = in0[k];
+				float x1 = in1[k];
+				s00 += x0 * w0[k];
+				s01 += x0 * w1[k];
+				s02 += x0 * w2[k];
+				s03 += x0 * w3[k];
+				s10 += x1 * w0[k];
+				s11 += x1 * w1[k];
+				s12 += x1 * w2[k];
+				s13 += x1 * w3[k];
+			}
+			out0[0] += s00;
+			out0[1] += s01;
+			out0[2] += s02;
+			out0[3] += s03;
+			out1[0] += s10;
+			out1[1] += s11;
+			out1[2] += s12;
+			out1[3] += s13;
+		}
+
+		// sum of in[k] * w[k]
+		static inline float dot_1x1(
+			const float * in,
+			const float * w,
+			int k_begin,
+			int k_end)
+		{
+			float sum = 0.0F;
+			for(int k = k_begin; k < k_end; ++k)
+				sum += in[k] * w[k];
+			return sum;
+		}
+
+		// dst[k] += a0 * src0[k] + a1 * src1[k] + a2 * src2[k] + a3 * src3[k] for 4 consecutive source rows
+		static inline void axpy_4(
+			float * dst,
+			const float * src0,
+			int src_row_stride,
+			float a0,
+			float a1,
+			float a2,
+			float a3,
+			int k_begin,
+			int k_end)
+		{
+			const float * src1 = src0 + src_row_stride;
+			const float * src2 = src1 + src_row_stride;
+			const float * src3 = src2 + src_row_stride;
+			for(int k = k_begin; k < k_end; ++k)
+				dst[k] += a0 * src0[k] + a1 * src1[k] + a2 * src2[k] + a3 * src3[k];
+		}
+
+		// dst[k] += a * src[k]
+		static inline void axpy_1(
+			float * dst,
+			const float * src,
+			float a,
+			int k_begin,
+			int k_end)
+		{
+			for(int k = k_begin; k < k_end; ++k)
+				dst[k] += a * src[k];
+		}
+
+		bool fully_connected_kernel::is_supported(
+			const convolution_layer& layer_schema,
+			const layer_configuration_specific& input_configuration_specific)
+		{
+			if (layer_schema.window_sizes.size() != input_configuration_specific.dimension_sizes.size())
+				return false;
+
+			for(unsigned int i = 0; i < layer_schema.window_sizes.size(); ++i)
+			{
+				if (layer_schema.window_sizes[i] != input_configuration_specific.dimension_sizes[i])
+					return false;
+				if ((i < layer_schema.left_zero_padding.size()) && (layer_schema.left_zero_padding[i] != 0))
+					return false;
+				if ((i < layer_schema.right_zero_padding.size()) && (layer_schema.right_zero_padding[i] != 0))
+					return false;
+			}
+
+			return true;
+		}
+
+		void fully_connected_kernel::run_forward_propagation(
+			float * output,
+			const float * input,
+			const float * weights,
+			const float * biases,
+			unsigned int input_neuron_count,
+			unsigned int output_neuron_count,
+			unsigned int entry_count,
+			plain_running_configuration::const_ptr plain_config)
+		{
+			const int in_count = input_neuron_count;
+			const int out_count = output_neuron_count;
+			const int output_block_count = (out_count + output_block_size - 1) / output_block_size;
+			const int entry_block_count = (entry_count + entry_block_size - 1) / entry_block_size;
+			const int total_workload = output_block_count * entry_block_count;
+			const int entry_count_int = entry_count;
+
+			#pragma omp parallel for default(none) schedule(runtime) num_threads(plain_config->openmp_thread_count) shared(output,input,weights,biases)
+			for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+			{
+				const int output_block_id = workload_id % output_block_count;
+				const int entry_block_id = workload_id / output_block_count;
+				const int n_begin = output_block_id * output_block_size;
+				const int n_end = std::min(n_begin + output_block_size, out_count);
+				const int e_begin = entry_block_id * entry_block_size;
+				const int e_end = std::min(e_begin + entry_block_size, entry_count_int);
+
+				for(int e = e_begin; e < e_end; ++e)
+				{
+					float * out = output + e * out_count;
+					if (biases)
+						std::copy(biases + n_begin, biases + n_end, out + n_begin);
+					else
+						std::fill(out + n_begin, out + n_end, 0.0F);
+				}
+
+				for(int k_begin = 0; k_begin < in_count; k_begin += input_block_size)
+				{
+					const int k_end = std::min(k_begin + input_block_size, in_count);
+
+					int e = e_begin;
+					for(; e + 2 <= e_end; e += 2)
+					{
+						const float * in0 = input + e * in_count;
+						const float * in1 = in0 + in_count;
+						float * out0 = output + e * out_count;
+						float * out1 = out0 + out_count;
+						int n = n_begin;
+						for(; n + 4 <= n_end; n += 4)
+							dot_2x4(out0 + n, out1 + n, in0, in1, weights + n * in_count, in_count, k_begin, k_end);
+						for(; n < n_end; ++n)
+						{
+							const float * w = weights + n * in_count;
+							out0[n] += dot_1x1(in0, w, k_begin, k_end);
+							out1[n] += dot_1x1(in1, w, k_begin, k_end);
+						}
+					}
+					for(; e < e_end; ++e)
+					{
+						const float * in = input + e * in_count;
+						float * out = output + e * out_count;
+						for(int n = n_begin; n < n_end; ++n)
+							out[n] += dot_1x1(in, weights + n * in_count, k_begin, k_end);
+					}
+				}
+			}
+		}
+
+		void fully_connected_kernel::run_backward_data_propagation(
+			float * input_errors,
+			const float * output_errors,
+			const float * weights,
+			unsigned int input_neuron_count,
+			unsigned int output_neuron_count,
+			bool add_update_to_destination,
+			unsigned int entry_count,
+			plain_running_configuration::const_ptr plain_config)
+		{
+			const int in_count = input_neuron_count;
+			const int out_count = output_neuron_count;
+			const int input_block_count = (in_count + input_block_size - 1) / input_block_size;
+			const int entry_block_count = (entry_count + entry_block_size - 1) / entry_block_size;
+			const int total_workload = input_block_count * entry_block_count;
+			const int entry_count_int = entry_count;
+
+			#pragma omp parallel for default(none) schedule(runtime) num_threads(plain_config->openmp_thread_count) shared(input_errors,output_errors,weights,add_update_to_destination)
+			for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+			{
+				const int input_block_id = workload_id % input_block_count;
+				const int entry_block_id = workload_id / input_block_count;
+				const int k_begin = input_block_id * input_block_size;
+				const int k_end = std::min(k_begin + input_block_size, in_count);
+				const int e_begin = entry_block_id * entry_block_size;
+				const int e_end = std::min(e_begin + entry_block_size, entry_count_int);
+
+				if (!add_update_to_destination)
+				{
+					for(int e = e_begin; e < e_end; ++e)
+					{
+						float * in_err = input_errors + e * in_count;
+						std::fill(in_err + k_begin, in_err + k_end, 0.0F);
+					}
+				}
+
+				for(int n_begin = 0; n_begin < out_count; n_begin += output_block_size)
+				{
+					const int n_end = std::min(n_begin + output_block_size, out_count);
+
+					for(int e = e_begin; e < e_end; ++e)
+					{
+						float * in_err = input_errors + e * in_count;
+						const float * out_err = output_errors + e * out_count;
+						int n = n_begin;
+						for(; n + 4 <= n_end; n += 4)
+							axpy_4(in_err, weights + n * in_count, in_count, out_err[n], out_err[n + 1], out_err[n + 2], out_err[n + 3], k_begin, k_end);
+						for(; n < n_end; ++n)
+							axpy_1(in_err, weights + n * in_count, out_err[n], k_begin, k_end);
+					}
+				}
+			}
+		}
+
+		void fully_connected_kernel::run_backward_weights_propagation(
+			float * gradient_weights,
+			float * gradient_biases,
+			const float * input,
+			const float * output_errors,
+			unsigned int input_neuron_count,
+			unsigned int output_neuron_count,
+			unsigned int entry_count,
+			plain_running_configuration::const_ptr plain_config)
+		{
+			const int in_count = input_neuron_count;
+			const int out_count = output_neuron_count;
+			const int output_block_count = (out_count + output_block_size - 1) / output_block_size;
+			const int input_block_count = (in_count + input_block_size - 1) / input_block_size;
+			const int total_workload = output_block_count * input_block_count;
+			const int entry_count_int = entry_count;
+
+			#pragma omp parallel for default(none) schedule(runtime) num_threads(plain_config->openmp_thread_count) shared(gradient_weights,gradient_biases,input,output_errors)
+			for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+			{
+				const int input_block_id = workload_id % input_block_count;
+				const int output_block_id = workload_id / input_block_count;
+				const int k_begin = input_block_id * input_block_size;
+				const int k_end = std::min(k_begin + input_block_size, in_count);
+				const int n_begin = output_block_id * output_block_size;
+				const int n_end = std::min(n_begin + output_block_size, out_count);
+
+				int e = 0;
+				for(; e + 4 <= entry_count_int; e += 4)
+				{
+					const float * in0 = input + e * in_count;
+					const float * out_err0 = output_errors + e * out_count;
+					const float * out_err1 = out_err0 + out_count;
+					const float * out_err2 = out_err1 + out_count;
+					const float * out_err3 = out_err2 + out_count;
+					for(int n = n_begin; n < n_end; ++n)
+						axpy_4(gradient_weights + n * in_count, in0, in_count, out_err0[n], out_err1[n], out_err2[n], out_err3[n], k_begin, k_end);
+				}
+				for(; e < entry_count_int; ++e)
+				{
+					const float * in = input + e * in_count;
+					const float * out_err = output_errors + e * out_count;
+					for(int n = n_begin; n < n_end; ++n)
+						axpy_1(gradient_weights + n * in_count, in, out_err[n], k_begin, k_end);
+				}
+
+				if (gradient_biases && (input_block_id == 0))
+				{
+					for(int n = n_begin; n < n_end; ++n)
+					{
+						float sum = 0.0F;
+						for(int e = 0; e < entry_count_int; ++e)
+							sum += output_errors[e * out_count + n];
+						gradient_biases[n] += sum;
+					}
+				}
+			}
+		}
+	}
+}
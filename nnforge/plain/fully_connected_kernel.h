@@ -0,0 +1,82 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "plain_running_configuration.h"
+#include "../convolution_layer.h"
+#include "../layer_configuration_specific.h"
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Fully connected case of the convolution: the window covers the whole input without padding, so each entry
+		// is a single vector of input_neuron_count values and the weights form a output_neuron_count x input_neuron_count row-major matrix.
+		// All the entries of the chunk are processed together as a blocked matrix multiplication:
+		// a tile of weights stays in cache while it is applied to a block of entries, instead of streaming the whole matrix once per entry
+		class fully_connected_kernel
+		{
+		public:
+			static bool is_supported(
+				const convolution_layer& layer_schema,
+				const layer_configuration_specific& input_configuration_specific);
+
+			// output = input * weights^T + biases, biases might be null
+			static void run_forward_propagation(
+				float * output,
+				const float * input,
+				const float * weights,
+				const float * biases,
+				unsigned int input_neuron_count,
+				unsigned int output_neuron_count,
+				unsigned int entry_count,
+				plain_running_configuration::const_ptr plain_config);
+
+			// input_errors (+)= output_errors * weights
+			static void run_backward_data_propagation(
+				float * input_errors,
+				const float * output_errors,
+				const float * weights,
+				unsigned int input_neuron_count,
+				unsigned int output_neuron_count,
+				bool add_update_to_destination,
+				unsigned int entry_count,
+				plain_running_configuration::const_ptr plain_config);
+
+			// gradient_weights += output_errors^T * input, gradient_biases += column sums of output_errors, gradient_biases might be null.
+			// Work is split by blocks of output neurons, each of them owns its rows of the gradient, so no reduction across threads is needed
+			static void run_backward_weights_propagation(
+				float * gradient_weights,
+				float * gradient_biases,
+				const float * input,
+				const float * output_errors,
+				unsigned int input_neuron_count,
+				unsigned int output_neuron_count,
+				unsigned int entry_count,
+				plain_running_configuration::const_ptr plain_config);
+
+		private:
+			// Tile sizes: output_block_size rows of input_block_size weights are reused across entry_block_size entries
+			static const int output_block_size = 32;
+			static const int input_block_size = 1024;
+			static const int entry_block_size = 32;
+
+		private:
+			fully_connected_kernel() = delete;
+		};
+	}
+}
@@ -80,7 +80,7 @@ namespace nnforge
 
 			if (add_update_to_destination)
 			{
-				#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
+				#pragma omp parallel for default(none) schedule(runtime) num_threads(plain_config->openmp_thread_count)
 				for(int i = 0; i < elem_count; ++i)
 				{
 					*(in_err_it + i) += *(out_err_it + i) * scale;
@@ -88,7 +88,7 @@ namespace nnforge
 			}
 			else
 			{
-				#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
+				#pragma omp parallel for default(none) schedule(runtime) num_threads(plain_config->openmp_thread_count)
 				for(int i = 0; i < elem_count; ++i)
 				{
 					*(in_err_it + i) = *(out_err_it + i) * scale;
@@ -0,0 +1,292 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "grouped_convolution_2d_engine.h"
+
+#include <algorithm>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// dst[x] += w * src[x * stride]
+		static inline void accumulate_row(
+			float * dst,
+			const float * src,
+			float w,
+			int x_begin,
+			int x_end,
+			int stride)
+		{
+			if (stride == 1)
+			{
+				for(int x = x_begin; x < x_end; ++x)
+					dst[x] += w * src[x];
+			}
+			else
+			{
+				for(int x = x_begin; x < x_end; ++x)
+					dst[x] += w * src[x * stride];
+			}
+		}
+
+		// dst[x * stride] += w * src[x]
+		static inline void scatter_row(
+			float * dst,
+			const float * src,
+			float w,
+			int x_begin,
+			int x_end,
+			int stride)
+		{
+			if (stride == 1)
+			{
+				for(int x = x_begin; x < x_end; ++x)
+					dst[x] += w * src[x];
+			}
+			else
+			{
+				for(int x = x_begin; x < x_end; ++x)
+					dst[x * stride] += w * src[x];
+			}
+		}
+
+		// sum of src_strided[x * stride] * src[x]
+		static inline float dot_row(
+			const float * src_strided,
+			const float * src,
+			int x_begin,
+			int x_end,
+			int stride)
+		{
+			float sum = 0.0F;
+			if (stride == 1)
+			{
+				for(int x = x_begin; x < x_end; ++x)
+					sum += src_strided[x] * src[x];
+			}
+			else
+			{
+				for(int x = x_begin; x < x_end; ++x)
+					sum += src_strided[x * stride] * src[x];
+			}
+			return sum;
+		}
+
+		bool grouped_convolution_2d_engine::is_supported(const grouped_convolution_layer& layer_schema)
+		{
+			return (layer_schema.window_sizes.size() <= 2);
+		}
+
+		grouped_convolution_2d_engine::grouped_convolution_2d_engine(
+			const grouped_convolution_layer& layer_schema,
+			const layer_configuration_specific& input_configuration_specific,
+			const layer_configuration_specific& output_configuration_specific)
+		{
+			const bool has_x = (layer_schema.window_sizes.size() >= 1);
+			const bool has_y = (layer_schema.window_sizes.size() >= 2);
+			input_width = has_x ? input_configuration_specific.dimension_sizes[0] : 1;
+			input_height = has_y ? input_configuration_specific.dimension_sizes[1] : 1;
+			output_width = has_x ? output_configuration_specific.dimension_sizes[0] : 1;
+			output_height = has_y ? output_configuration_specific.dimension_sizes[1] : 1;
+			window_width = has_x ? layer_schema.window_sizes[0] : 1;
+			window_height = has_y ? layer_schema.window_sizes[1] : 1;
+			stride_x = has_x ? layer_schema.strides[0] : 1;
+			stride_y = has_y ? layer_schema.strides[1] : 1;
+			left_padding_x = has_x ? layer_schema.left_zero_padding[0] : 0;
+			left_padding_y = has_y ? layer_schema.left_zero_padding[1] : 0;
+			input_feature_map_count = input_configuration_specific.feature_map_count;
+			output_feature_map_count = output_configuration_specific.feature_map_count;
+			input_feature_map_count_per_group = layer_schema.get_input_feature_map_count_per_group();
+			output_feature_map_count_per_group = layer_schema.get_output_feature_map_count_per_group();
+
+			// Output x range for which the input x = x * stride_x - left_padding_x + window_x is within the input
+			for(int window_x = 0; window_x < window_width; ++window_x)
+			{
+				int x_begin = 0;
+				if (left_padding_x > window_x)
+					x_begin = (left_padding_x - window_x + stride_x - 1) / stride_x;
+				int x_end = 0;
+				if (input_width - 1 - window_x + left_padding_x >= 0)
+					x_end = std::min(output_width, (input_width - 1 - window_x + left_padding_x) / stride_x + 1);
+				window_x_begin_list.push_back(x_begin);
+				window_x_end_list.push_back(std::max(x_begin, x_end));
+			}
+		}
+
+		void grouped_convolution_2d_engine::run_forward_propagation(
+			float * output,
+			const float * input,
+			const float * weights,
+			const float * biases,
+			unsigned int entry_count,
+			plain_running_configuration::const_ptr plain_config) const
+		{
+			const int input_neuron_count_per_feature_map = input_width * input_height;
+			const int output_neuron_count_per_feature_map = output_width * output_height;
+			const int input_neuron_count = input_neuron_count_per_feature_map * input_feature_map_count;
+			const int output_neuron_count = output_neuron_count_per_feature_map * output_feature_map_count;
+			const int window_elem_count = window_width * window_height;
+			const int total_workload = entry_count * output_feature_map_count;
+
+			#pragma omp parallel for default(none) schedule(runtime) num_threads(plain_config->openmp_thread_count) shared(output,input,weights,biases)
+			for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+			{
+				int entry_id = workload_id / output_feature_map_count;
+				int output_feature_map_id = workload_id - (entry_id * output_feature_map_count);
+				int group_id = output_feature_map_id / output_feature_map_count_per_group;
+
+				float * out_fm_base = output + entry_id * output_neuron_count + output_feature_map_id * output_neuron_count_per_feature_map;
+				const float * in_group_base = input + entry_id * input_neuron_count + group_id * input_feature_map_count_per_group * input_neuron_count_per_feature_map;
+				const float * weights_base = weights + output_feature_map_id * input_feature_map_count_per_group * window_elem_count;
+
+				std::fill_n(out_fm_base, output_neuron_count_per_feature_map, biases ? biases[output_feature_map_id] : 0.0F);
+
+				for(int output_y = 0; output_y < output_height; ++output_y)
+				{
+					float * out_row = out_fm_base + output_y * output_width;
+					for(int local_input_feature_map_id = 0; local_input_feature_map_id < input_feature_map_count_per_group; ++local_input_feature_map_id)
+					{
+						const float * in_fm_base = in_group_base + local_input_feature_map_id * input_neuron_count_per_feature_map;
+						const float * current_weights = weights_base + local_input_feature_map_id * window_elem_count;
+						for(int window_y = 0; window_y < window_height; ++window_y)
+						{
+							int input_y = output_y * stride_y - left_padding_y + window_y;
+							if ((input_y < 0) || (input_y >= input_height))
+								continue;
+							const float * in_row = in_fm_base + input_y * input_width;
+
+							for(int window_x = 0; window_x < window_width; ++window_x)
+								accumulate_row(out_row, in_row + window_x - left_padding_x, current_weights[window_y * window_width + window_x], window_x_begin_list[window_x], window_x_end_list[window_x], stride_x);
+						}
+					}
+				}
+			}
+		}
+
+		void grouped_convolution_2d_engine::run_backward_data_propagation(
+			float * input_errors,
+			const float * output_errors,
+			const float * weights,
+			bool add_update_to_destination,
+			unsigned int entry_count,
+			plain_running_configuration::const_ptr plain_config) const
+		{
+			const int input_neuron_count_per_feature_map = input_width * input_height;
+			const int output_neuron_count_per_feature_map = output_width * output_height;
+			const int input_neuron_count = input_neuron_count_per_feature_map * input_feature_map_count;
+			const int output_neuron_count = output_neuron_count_per_feature_map * output_feature_map_count;
+			const int window_elem_count = window_width * window_height;
+			const int total_workload = entry_count * input_feature_map_count;
+
+			#pragma omp parallel for default(none) schedule(runtime) num_threads(plain_config->openmp_thread_count) shared(input_errors,output_errors,weights,add_update_to_destination)
+			for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+			{
+				int entry_id = workload_id / input_feature_map_count;
+				int input_feature_map_id = workload_id - (entry_id * input_feature_map_count);
+				int group_id = input_feature_map_id / input_feature_map_count_per_group;
+				int local_input_feature_map_id = input_feature_map_id - group_id * input_feature_map_count_per_group;
+
+				float * in_err_fm_base = input_errors + entry_id * input_neuron_count + input_feature_map_id * input_neuron_count_per_feature_map;
+				const float * out_err_group_base = output_errors + entry_id * output_neuron_count + group_id * output_feature_map_count_per_group * output_neuron_count_per_feature_map;
+				if (!add_update_to_destination)
+					std::fill_n(in_err_fm_base, input_neuron_count_per_feature_map, 0.0F);
+
+				for(int output_y = 0; output_y < output_height; ++output_y)
+				{
+					for(int window_y = 0; window_y < window_height; ++window_y)
+					{
+						int input_y = output_y * stride_y - left_padding_y + window_y;
+						if ((input_y < 0) || (input_y >= input_height))
+							continue;
+						float * in_err_row = in_err_fm_base + input_y * input_width;
+
+						for(int local_output_feature_map_id = 0; local_output_feature_map_id < output_feature_map_count_per_group; ++local_output_feature_map_id)
+						{
+							int output_feature_map_id = group_id * output_feature_map_count_per_group + local_output_feature_map_id;
+							const float * out_err_row = out_err_group_base + local_output_feature_map_id * output_neuron_count_per_feature_map + output_y * output_width;
+							const float * current_weights = weights + (output_feature_map_id * input_feature_map_count_per_group + local_input_feature_map_id) * window_elem_count + window_y * window_width;
+
+							for(int window_x = 0; window_x < window_width; ++window_x)
+								scatter_row(in_err_row + window_x - left_padding_x, out_err_row, current_weights[window_x], window_x_begin_list[window_x], window_x_end_list[window_x], stride_x);
+						}
+					}
+				}
+			}
+		}
+
+		void grouped_convolution_2d_engine::run_backward_weights_propagation(
+			float * gradient_weights,
+			float * gradient_biases,
+			const float * input,
+			const float * output_errors,
+			unsigned int entry_count,
+			plain_running_configuration::const_ptr plain_config) const
+		{
+			const int input_neuron_count_per_feature_map = input_width * input_height;
+			const int output_neuron_count_per_feature_map = output_width * output_height;
+			const int input_neuron_count = input_neuron_count_per_feature_map * input_feature_map_count;
+			const int output_neuron_count = output_neuron_count_per_feature_map * output_feature_map_count;
+			const int window_elem_count = window_width * window_height;
+			const int total_workload = output_feature_map_count;
+			const int const_entry_count = entry_count;
+
+			#pragma omp parallel for default(none) schedule(runtime) num_threads(plain_config->openmp_thread_count) shared(gradient_weights,gradient_biases,input,output_errors)
+			for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+			{
+				int output_feature_map_id = workload_id;
+				int group_id = output_feature_map_id / output_feature_map_count_per_group;
+				float * gradient_weights_base = gradient_weights + output_feature_map_id * input_feature_map_count_per_group * window_elem_count;
+
+				float bias_sum = 0.0F;
+				for(int entry_id = 0; entry_id < const_entry_count; ++entry_id)
+				{
+					const float * out_err_fm_base = output_errors + entry_id * output_neuron_count + output_feature_map_id * output_neuron_count_per_feature_map;
+					const float * in_group_base = input + entry_id * input_neuron_count + group_id * input_feature_map_count_per_group * input_neuron_count_per_feature_map;
+
+					if (gradient_biases)
+					{
+						for(int i = 0; i < output_neuron_count_per_feature_map; ++i)
+							bias_sum += out_err_fm_base[i];
+					}
+
+					for(int output_y = 0; output_y < output_height; ++output_y)
+					{
+						const float * out_err_row = out_err_fm_base + output_y * output_width;
+						for(int local_input_feature_map_id = 0; local_input_feature_map_id < input_feature_map_count_per_group; ++local_input_feature_map_id)
+						{
+							const float * in_fm_base = in_group_base + local_input_feature_map_id * input_neuron_count_per_feature_map;
+							float * current_gradient_weights = gradient_weights_base + local_input_feature_map_id * window_elem_count;
+							for(int window_y = 0; window_y < window_height; ++window_y)
+							{
+								int input_y = output_y * stride_y - left_padding_y + window_y;
+								if ((input_y < 0) || (input_y >= input_height))
+									continue;
+								const float * in_row = in_fm_base + input_y * input_width;
+
+								for(int window_x = 0; window_x < window_width; ++window_x)
+									current_gradient_weights[window_y * window_width + window_x] += dot_row(in_row + window_x - left_padding_x, out_err_row, window_x_begin_list[window_x], window_x_end_list[window_x], stride_x);
+							}
+						}
+					}
+				}
+
+				if (gradient_biases)
+					gradient_biases[output_feature_map_id] += bias_sum;
+			}
+		}
+	}
+}
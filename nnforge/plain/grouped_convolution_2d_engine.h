@@ -0,0 +1,88 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "plain_running_configuration.h"
+#include "../grouped_convolution_layer.h"
+#include "../layer_configuration_specific.h"
+
+#include <vector>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Row-wise engine for 0D, 1D and 2D grouped convolutions.
+		// Each output feature map reads only the contiguous block of input feature maps of its group,
+		// work items are whole feature maps and the innermost loops run over the positions of a row, unit stride is handled separately
+		class grouped_convolution_2d_engine
+		{
+		public:
+			static bool is_supported(const grouped_convolution_layer& layer_schema);
+
+			grouped_convolution_2d_engine(
+				const grouped_convolution_layer& layer_schema,
+				const layer_configuration_specific& input_configuration_specific,
+				const layer_configuration_specific& output_configuration_specific);
+
+			void run_forward_propagation(
+				float * output,
+				const float * input,
+				const float * weights,
+				const float * biases,
+				unsigned int entry_count,
+				plain_running_configuration::const_ptr plain_config) const;
+
+			void run_backward_data_propagation(
+				float * input_errors,
+				const float * output_errors,
+				const float * weights,
+				bool add_update_to_destination,
+				unsigned int entry_count,
+				plain_running_configuration::const_ptr plain_config) const;
+
+			// Work is split by output feature maps, each of them owns its weights and bias, so no reduction across threads is needed.
+			// gradient_biases might be null
+			void run_backward_weights_propagation(
+				float * gradient_weights,
+				float * gradient_biases,
+				const float * input,
+				const float * output_errors,
+				unsigned int entry_count,
+				plain_running_configuration::const_ptr plain_config) const;
+
+		private:
+			std::vector<int> window_x_begin_list;
+			std::vector<int> window_x_end_list;
+
+			int input_width;
+			int input_height;
+			int output_width;
+			int output_height;
+			int window_width;
+			int window_height;
+			int stride_x;
+			int stride_y;
+			int left_padding_x;
+			int left_padding_y;
+			int input_feature_map_count;
+			int output_feature_map_count;
+			int input_feature_map_count_per_group;
+			int output_feature_map_count_per_group;
+		};
+	}
+}
@@ -0,0 +1,55 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "grouped_convolution_layer_tester_plain.h"
+
+#include "grouped_convolution_2d_engine.h"
+#include "../grouped_convolution_layer.h"
+#include "../neural_network_exception.h"
+
+#include <boost/format.hpp>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		std::string grouped_convolution_layer_tester_plain::get_type_name() const
+		{
+			return grouped_convolution_layer::layer_type_name;
+		}
+
+		void grouped_convolution_layer_tester_plain::run_forward_propagation(
+			plain_buffer::ptr output_buffer,
+			const std::vector<plain_buffer::const_ptr>& input_buffers,
+			plain_buffer::ptr temporary_working_fixed_buffer,
+			plain_buffer::ptr temporary_working_per_entry_buffer,
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			layer_data::const_ptr data,
+			layer_data_custom::const_ptr data_custom,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific,
+			unsigned int entry_count) const
+		{
+			std::shared_ptr<const grouped_convolution_layer> layer_derived = std::dynamic_pointer_cast<const grouped_convolution_layer>(layer_schema);
+			if (!grouped_convolution_2d_engine::is_supported(*layer_derived))
+				throw neural_network_exception((boost::format("grouped_convolution_layer_tester_plain is not able to run for %1% dimensions") % layer_derived->window_sizes.size()).str());
+
+			grouped_convolution_2d_engine engine(*layer_derived, input_configuration_specific_list[0], output_configuration_specific);
+			engine.run_forward_propagation(*output_buffer, *input_buffers[0], &(*data)[0][0], layer_derived->bias ? &(*data)[1][0] : 0, entry_count, plain_config);
+		}
+	}
+}
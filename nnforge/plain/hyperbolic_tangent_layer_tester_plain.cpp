@@ -16,6 +16,7 @@
 
 #include "hyperbolic_tangent_layer_tester_plain.h"
 
+#include "vector_math.h"
 #include "../hyperbolic_tangent_layer.h"
 
 namespace nnforge
@@ -48,11 +49,11 @@ namespace nnforge
 			const float hyperbolic_tangent_steepness2 = layer_derived->steepness * 2.0F;
 			const float hyperbolic_tangent_major_multiplier = layer_derived->scale;
 
-			#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
+			#pragma omp parallel for default(none) schedule(runtime) num_threads(plain_config->openmp_thread_count)
 			for(int i = 0; i < elem_count; ++i)
 			{
 				float inp = *(in_it + i);
-				float inp2 = expf(inp * hyperbolic_tangent_steepness2);
+				float inp2 = vector_math::exp(inp * hyperbolic_tangent_steepness2);
 				float res = (inp2 - 1.0F) / (inp2 + 1.0F) * hyperbolic_tangent_major_multiplier;
 				*(out_it + i) = res;
 			}
@@ -16,6 +16,7 @@
 
 #include "hyperbolic_tangent_layer_updater_plain.h"
 
+#include "vector_math.h"
 #include "../hyperbolic_tangent_layer.h"
 
 namespace nnforge
@@ -50,11 +51,11 @@ namespace nnforge
 			const float hyperbolic_tangent_steepness2 = layer_derived->steepness * 2.0F;
 			const float hyperbolic_tangent_major_multiplier = layer_derived->scale;
 
-			#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
+			#pragma omp parallel for default(none) schedule(runtime) num_threads(plain_config->openmp_thread_count)
 			for(int i = 0; i < elem_count; ++i)
 			{
 				float inp = *(in_it + i);
-				float inp2 = expf(inp * hyperbolic_tangent_steepness2);
+				float inp2 = vector_math::exp(inp * hyperbolic_tangent_steepness2);
 				float res = (inp2 - 1.0F) / (inp2 + 1.0F) * hyperbolic_tangent_major_multiplier;
 				*(out_it + i) = res;
 			}
@@ -89,7 +90,7 @@ namespace nnforge
 			const float hyperbolic_tangent_steepness3 = layer_derived->steepness * layer_derived->scale;
 			if (add_update_to_destination)
 			{
-				#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
+				#pragma omp parallel for default(none) schedule(runtime) num_threads(plain_config->openmp_thread_count)
 				for(int i = 0; i < elem_count; ++i)
 				{
 					float out_neuron = *(out_it + i);
@@ -100,7 +101,7 @@ namespace nnforge
 			}
 			else
 			{
-				#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
+				#pragma omp parallel for default(none) schedule(runtime) num_threads(plain_config->openmp_thread_count)
 				for(int i = 0; i < elem_count; ++i)
 				{
 					float out_neuron = *(out_it + i);
@@ -166,6 +166,15 @@ namespace nnforge
 				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
 				const layer_configuration_specific& output_configuration_specific) const;
 
+			// Default impl returns true
+			// Layers which might produce different output when forward prop is run again for the same input should return false, they are never recomputed
+			virtual bool is_forward_propagation_repeatable(
+				const std::set<layer_action>& actions,
+				plain_running_configuration::const_ptr plain_config,
+				layer::const_ptr layer_schema,
+				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+				const layer_configuration_specific& output_configuration_specific) const;
+
 		protected:
 			layer_updater_plain() = default;
 
@@ -16,6 +16,7 @@
 
 #include "linear_sampler_layer_tester_plain.h"
 
+#include "bilinear_sampler_2d_kernel.h"
 #include "../linear_sampler_layer.h"
 
 #include <array>
@@ -42,76 +43,14 @@ namespace nnforge
 			const layer_configuration_specific& output_configuration_specific,
 			unsigned int entry_count) const
 		{
-			const float * const in_it_grid_global = *input_buffers[0];
-			const float * const in_it_data_global = *input_buffers[1];
-			float * const out_it_global = *output_buffer;
-			const unsigned int output_width = output_configuration_specific.dimension_sizes[0];
-			const unsigned int output_height = output_configuration_specific.dimension_sizes[1];
-			const unsigned int input_width = input_configuration_specific_list[1].dimension_sizes[0];
-			const unsigned int input_height = input_configuration_specific_list[1].dimension_sizes[1];
-			const unsigned int input_feature_map_count = input_configuration_specific_list[1].feature_map_count;
-			const float denormalize_scale_x = static_cast<float>(input_configuration_specific_list[1].dimension_sizes[0] - 1);
-			const float denormalize_scale_y = static_cast<float>(input_configuration_specific_list[1].dimension_sizes[1] - 1);
-			const unsigned int output_elem_count_per_feature_map = output_configuration_specific.get_neuron_count_per_feature_map();
-			const unsigned int input_elem_count_per_feature_map = input_configuration_specific_list[1].get_neuron_count_per_feature_map();
-			const unsigned int output_elem_count_per_entry = output_configuration_specific.get_neuron_count();
-			const unsigned int input_elem_count_per_entry = input_configuration_specific_list[1].get_neuron_count();
-
-			const int total_workload = entry_count * output_height * output_width;
-
-			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count)
-			{
-				#pragma omp for schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
-				{
-					int entry_id = workload_id / (output_height * output_width);
-					int yx = workload_id - (entry_id * (output_height * output_width));
-					int y = yx / output_width;
-					int x = yx - y * output_width;
-
-					int grid_x_offset = entry_id * output_elem_count_per_feature_map * 2 + y * output_width + x;
-					int grid_y_offset = grid_x_offset + output_elem_count_per_feature_map;
-					float normalized_x_pos = in_it_grid_global[grid_x_offset];
-					float normalized_y_pos = in_it_grid_global[grid_y_offset];
-					float absolute_x_pos = normalized_x_pos * denormalize_scale_x;
-					float absolute_y_pos = normalized_y_pos * denormalize_scale_y;
-					int left_x = static_cast<int>(absolute_x_pos);
-					int top_y = static_cast<int>(absolute_y_pos);
-					int right_x = left_x + 1;
-					int bottom_y = top_y + 1;
-					float right_weight = absolute_x_pos - (float)left_x;
-					float left_weight = 1.0F - right_weight;
-					float bottom_weight = absolute_y_pos - (float)top_y;
-					float top_weight = 1.0F - bottom_weight;
-					float top_left_weight = top_weight * left_weight;
-					float top_right_weight = top_weight * right_weight;
-					float bottom_left_weight = bottom_weight * left_weight;
-					float bottom_right_weight = bottom_weight * right_weight;
-					bool left_in_bounds = (unsigned int)left_x < (unsigned int)input_width;
-					bool right_in_bounds = (unsigned int)right_x < (unsigned int)input_width;
-					bool top_in_bounds = (unsigned int)top_y < (unsigned int)input_height;
-					bool bottom_in_bounds = (unsigned int)bottom_y < (unsigned int)input_height;
-					bool top_left_in_bounds = left_in_bounds && top_in_bounds;
-					bool top_right_in_bounds = right_in_bounds && top_in_bounds;
-					bool bottom_left_in_bounds = left_in_bounds && bottom_in_bounds;
-					bool bottom_right_in_bounds = right_in_bounds && bottom_in_bounds;
-					const float * current_input_data = in_it_data_global + entry_id * input_elem_count_per_entry + top_y * input_width + left_x;
-					float * current_output = out_it_global + entry_id * output_elem_count_per_entry + y * output_width + x;
-					for(int input_feature_map_id = 0; input_feature_map_id < static_cast<int>(input_feature_map_count); ++input_feature_map_id)
-					{
-						float top_left_val = top_left_in_bounds ? *current_input_data : 0.0F;
-						float top_right_val = top_right_in_bounds ? *(current_input_data + 1) : 0.0F;
-						float bottom_left_val = bottom_left_in_bounds ? *(current_input_data + input_width) : 0.0F;
-						float bottom_right_val = bottom_right_in_bounds ? *(current_input_data + input_width + 1) : 0.0F;
-
-						float weighted_sum = top_left_weight * top_left_val + top_right_weight * top_right_val + bottom_left_weight * bottom_left_val + bottom_right_weight * bottom_right_val;
-						*current_output = weighted_sum;
-
-						current_input_data += input_elem_count_per_feature_map;
-						current_output += output_elem_count_per_entry;
-					}
-				}
-			}
+			bilinear_sampler_2d_kernel::run_forward_propagation(
+				*output_buffer,
+				*input_buffers[0],
+				*input_buffers[1],
+				input_configuration_specific_list[1],
+				output_configuration_specific,
+				entry_count,
+				plain_config);
 		}
 	}
 }
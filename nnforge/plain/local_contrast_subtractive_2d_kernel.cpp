@@ -0,0 +1,185 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "local_contrast_subtractive_2d_kernel.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace nnforge
+{
+	namespace plain
+	{
+		size_t local_contrast_subtractive_2d_kernel::get_working_buffer_elem_count(
+			const layer_configuration_specific& configuration_specific,
+			const std::vector<std::vector<float> >& window_weights_list,
+			int thread_count)
+		{
+			size_t padded_width = configuration_specific.dimension_sizes[0] + (window_weights_list[0].size() - 1) * 2;
+			return (configuration_specific.get_neuron_count_per_feature_map() + padded_width) * thread_count;
+		}
+
+		void local_contrast_subtractive_2d_kernel::run(
+			float * output,
+			const float * input,
+			float * working_buffer,
+			const layer_configuration_specific& configuration_specific,
+			const std::vector<std::vector<float> >& window_weights_list,
+			const std::vector<unsigned int>& feature_maps_affected,
+			bool add_update_to_destination,
+			unsigned int entry_count,
+			plain_running_configuration::const_ptr plain_config)
+		{
+			const int width = configuration_specific.dimension_sizes[0];
+			const int height = configuration_specific.dimension_sizes[1];
+			const int neuron_count = configuration_specific.get_neuron_count();
+			const int neuron_count_per_feature_map = configuration_specific.get_neuron_count_per_feature_map();
+			const int padded_width = width + static_cast<int>(window_weights_list[0].size() - 1) * 2;
+			const std::vector<float>& window_weights_x = window_weights_list[0];
+			const std::vector<float>& window_weights_y = window_weights_list[1];
+			const int feature_maps_affected_count = static_cast<int>(feature_maps_affected.size());
+			const int total_workload = entry_count * feature_maps_affected_count;
+			const int openmp_thread_count = plain_config->openmp_thread_count;
+
+			if (total_workload >= openmp_thread_count)
+			{
+				#pragma omp parallel default(none) num_threads(openmp_thread_count) shared(output,input,working_buffer,feature_maps_affected,add_update_to_destination)
+				{
+					int thread_id = 0;
+					#ifdef _OPENMP
+					thread_id = omp_get_thread_num();
+					#endif
+					float * row_pass_output = working_buffer + thread_id * (neuron_count_per_feature_map + padded_width);
+					float * row_buffer = row_pass_output + neuron_count_per_feature_map;
+
+					#pragma omp for schedule(runtime)
+					for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+					{
+						int entry_id = workload_id / feature_maps_affected_count;
+						int affected_feature_map_id = workload_id - (entry_id * feature_maps_affected_count);
+						int offset = entry_id * neuron_count + feature_maps_affected[affected_feature_map_id] * neuron_count_per_feature_map;
+
+						for(int y = 0; y < height; ++y)
+							run_row_pass(row_pass_output + y * width, input + offset + y * width, row_buffer, window_weights_x, width);
+						for(int y = 0; y < height; ++y)
+							run_column_pass(output + offset + y * width, input + offset + y * width, row_pass_output, row_buffer, window_weights_y, y, width, height, add_update_to_destination);
+					}
+				}
+			}
+			else
+			{
+				#pragma omp parallel default(none) num_threads(openmp_thread_count) shared(output,input,working_buffer,feature_maps_affected,add_update_to_destination)
+				{
+					int thread_id = 0;
+					#ifdef _OPENMP
+					thread_id = omp_get_thread_num();
+					#endif
+					float * row_pass_output = working_buffer;
+					float * row_buffer = working_buffer + neuron_count_per_feature_map + thread_id * padded_width;
+
+					for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+					{
+						int entry_id = workload_id / feature_maps_affected_count;
+						int affected_feature_map_id = workload_id - (entry_id * feature_maps_affected_count);
+						int offset = entry_id * neuron_count + feature_maps_affected[affected_feature_map_id] * neuron_count_per_feature_map;
+
+						#pragma omp for schedule(runtime)
+						for(int y = 0; y < height; ++y)
+							run_row_pass(row_pass_output + y * width, input + offset + y * width, row_buffer, window_weights_x, width);
+						#pragma omp for schedule(runtime)
+						for(int y = 0; y < height; ++y)
+							run_column_pass(output + offset + y * width, input + offset + y * width, row_pass_output, row_buffer, window_weights_y, y, width, height, add_update_to_destination);
+					}
+				}
+			}
+		}
+
+		void local_contrast_subtractive_2d_kernel::run_row_pass(
+			float * dst_row,
+			const float * src_row,
+			float * padded_row,
+			const std::vector<float>& window_weights,
+			int width)
+		{
+			const int radius = static_cast<int>(window_weights.size()) - 1;
+
+			// Mirror borders: position -1 maps to 0, position width maps to width - 1
+			float * padded_row_center = padded_row + radius;
+			for(int x = 0; x < width; ++x)
+				padded_row_center[x] = src_row[x];
+			for(int i = 1; i <= radius; ++i)
+			{
+				padded_row_center[-i] = src_row[i - 1];
+				padded_row_center[width - 1 + i] = src_row[width - i];
+			}
+
+			const float w0 = window_weights[0];
+			for(int x = 0; x < width; ++x)
+				dst_row[x] = padded_row_center[x] * w0;
+			for(int i = 1; i <= radius; ++i)
+			{
+				const float w = window_weights[i];
+				const float * forward_it = padded_row_center + i;
+				const float * backward_it = padded_row_center - i;
+				for(int x = 0; x < width; ++x)
+					dst_row[x] += (forward_it[x] + backward_it[x]) * w;
+			}
+		}
+
+		void local_contrast_subtractive_2d_kernel::run_column_pass(
+			float * output_row,
+			const float * input_row,
+			const float * row_pass_output,
+			float * sum_row,
+			const std::vector<float>& window_weights,
+			int y,
+			int width,
+			int height,
+			bool add_update_to_destination)
+		{
+			const int radius = static_cast<int>(window_weights.size()) - 1;
+
+			const float w0 = window_weights[0];
+			const float * center_row = row_pass_output + y * width;
+			for(int x = 0; x < width; ++x)
+				sum_row[x] = center_row[x] * w0;
+			for(int i = 1; i <= radius; ++i)
+			{
+				const float w = window_weights[i];
+				int y_forward = y + i;
+				int y_backward = y - i;
+				y_forward = (y_forward < height) ? y_forward : ((height << 1) - 1 - y_forward);
+				y_backward = (y_backward >= 0) ? y_backward : (-1 - y_backward);
+				const float * forward_row = row_pass_output + y_forward * width;
+				const float * backward_row = row_pass_output + y_backward * width;
+				for(int x = 0; x < width; ++x)
+					sum_row[x] += (forward_row[x] + backward_row[x]) * w;
+			}
+
+			if (add_update_to_destination)
+			{
+				for(int x = 0; x < width; ++x)
+					output_row[x] += input_row[x] - sum_row[x];
+			}
+			else
+			{
+				for(int x = 0; x < width; ++x)
+					output_row[x] = input_row[x] - sum_row[x];
+			}
+		}
+	}
+}
@@ -0,0 +1,76 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "plain_running_configuration.h"
+#include "../layer_configuration_specific.h"
+
+#include <vector>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Subtracts separable symmetric blur with mirrored borders from 2D feature maps: a row pass into the working buffer,
+		// then a column pass which reads whole rows of the row pass output, both vectorized across x.
+		// Feature maps are distributed among threads when there are enough of them, otherwise threads split rows of a single feature map
+		class local_contrast_subtractive_2d_kernel
+		{
+		public:
+			// Returns the number of floats required in working buffer
+			static size_t get_working_buffer_elem_count(
+				const layer_configuration_specific& configuration_specific,
+				const std::vector<std::vector<float> >& window_weights_list,
+				int thread_count);
+
+			// output = input - blur(input) for affected feature maps, output += input - blur(input) when add_update_to_destination is set.
+			// output might be the same as input
+			static void run(
+				float * output,
+				const float * input,
+				float * working_buffer,
+				const layer_configuration_specific& configuration_specific,
+				const std::vector<std::vector<float> >& window_weights_list,
+				const std::vector<unsigned int>& feature_maps_affected,
+				bool add_update_to_destination,
+				unsigned int entry_count,
+				plain_running_configuration::const_ptr plain_config);
+
+		private:
+			static void run_row_pass(
+				float * dst_row,
+				const float * src_row,
+				float * padded_row,
+				const std::vector<float>& window_weights,
+				int width);
+
+			static void run_column_pass(
+				float * output_row,
+				const float * input_row,
+				const float * row_pass_output,
+				float * sum_row,
+				const std::vector<float>& window_weights,
+				int y,
+				int width,
+				int height,
+				bool add_update_to_destination);
+
+		private:
+			local_contrast_subtractive_2d_kernel() = delete;
+		};
+	}
+}
@@ -16,6 +16,8 @@
 
 #include "local_contrast_subtractive_layer_tester_plain.h"
 
+#include "local_contrast_subtractive_2d_kernel.h"
+
 #ifdef _OPENMP
 #include <omp.h>
 #endif
@@ -69,6 +71,21 @@ namespace nnforge
 			if ((feature_maps_affected_count != output_configuration_specific.feature_map_count) && (output_buffer_it != input_buffer_it))
 				memcpy(output_buffer_it, input_buffer_it, output_configuration_specific.get_neuron_count() * entry_count * sizeof(float));
 
+			if (dimension_count == 2)
+			{
+				local_contrast_subtractive_2d_kernel::run(
+					output_buffer_it,
+					input_buffer_it,
+					working_buffer_it,
+					output_configuration_specific,
+					window_weights_list,
+					feature_maps_affected,
+					false,
+					entry_count,
+					plain_config);
+				return;
+			}
+
 			const int total_workload = entry_count * feature_maps_affected_count;
 			const int openmp_thread_count = plain_config->openmp_thread_count;
 			
@@ -84,7 +101,7 @@ namespace nnforge
 				if (dimension_count > 1)
 					local_additional_buffers.push_back(working_buffer_it + (openmp_thread_count + thread_id) * neuron_count_per_feature_map);
 
-				#pragma omp for schedule(guided)
+				#pragma omp for schedule(runtime)
 				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
 				{
 					int entry_id = workload_id / feature_maps_affected_count;
@@ -164,6 +181,12 @@ namespace nnforge
 			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
 			const layer_configuration_specific& output_configuration_specific) const
 		{
+			if (output_configuration_specific.dimension_sizes.size() == 2)
+			{
+				std::shared_ptr<const local_contrast_subtractive_layer> layer_derived = std::dynamic_pointer_cast<const local_contrast_subtractive_layer>(layer_schema);
+				return local_contrast_subtractive_2d_kernel::get_working_buffer_elem_count(output_configuration_specific, layer_derived->window_weights_list, plain_config->openmp_thread_count) * sizeof(float);
+			}
+
 			unsigned int elem_count_per_intermediate_elem = output_configuration_specific.get_neuron_count_per_feature_map();
 			return elem_count_per_intermediate_elem * plain_config->openmp_thread_count * (output_configuration_specific.dimension_sizes.size() > 1 ? 2 : 1) * sizeof(float);
 		}
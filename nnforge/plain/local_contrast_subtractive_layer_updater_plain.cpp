@@ -16,6 +16,8 @@
 
 #include "local_contrast_subtractive_layer_updater_plain.h"
 
+#include "local_contrast_subtractive_2d_kernel.h"
+
 #ifdef _OPENMP
 #include <omp.h>
 #endif
@@ -62,7 +64,7 @@ namespace nnforge
 
 			const std::vector<unsigned int>::const_iterator dimension_sizes_it = output_configuration_specific.dimension_sizes.begin();
 			const unsigned int feature_maps_affected_count = static_cast<unsigned int>(feature_maps_affected.size());
-			const unsigned int feature_maps_unaffected_count = static_cast<unsigned int>(feature_maps_affected.size());
+			const unsigned int feature_maps_unaffected_count = static_cast<unsigned int>(feature_maps_unaffected.size());
 			const std::vector<unsigned int>::const_iterator input_slices_it = input_slices.begin();
 			const std::vector<unsigned int>::const_iterator feature_maps_affected_it = feature_maps_affected.begin();
 			const float * const input_buffer_it = *input_buffers[0];
@@ -70,6 +72,35 @@ namespace nnforge
 			const std::vector<std::vector<float> >::const_iterator window_weights_list_it = window_weights_list.begin();
 			float * const working_buffer_it = *temporary_working_fixed_buffer;
 
+			if ((feature_maps_unaffected_count > 0) && (input_buffer_it != output_buffer_it))
+			{
+				for(unsigned int entry_id = 0; entry_id < entry_count; ++entry_id)
+				{
+					for(std::vector<unsigned int>::const_iterator it = feature_maps_unaffected.begin(); it != feature_maps_unaffected.end(); ++it)
+					{
+						unsigned int feature_map_id = *it;
+						const float * original_in_it = input_buffer_it + (entry_id * neuron_count) + (feature_map_id * neuron_count_per_feature_map);
+						float * out_it = output_buffer_it + (entry_id * neuron_count) + (feature_map_id * neuron_count_per_feature_map);
+						memcpy(out_it, original_in_it, neuron_count_per_feature_map * sizeof(float));
+					}
+				}
+			}
+
+			if (dimension_count == 2)
+			{
+				local_contrast_subtractive_2d_kernel::run(
+					output_buffer_it,
+					input_buffer_it,
+					working_buffer_it,
+					output_configuration_specific,
+					window_weights_list,
+					feature_maps_affected,
+					false,
+					entry_count,
+					plain_config);
+				return;
+			}
+
 			const int total_workload = entry_count * feature_maps_affected_count;
 			const int openmp_thread_count = plain_config->openmp_thread_count;
 			
@@ -85,7 +116,7 @@ namespace nnforge
 				if (dimension_count > 1)
 					local_additional_buffers.push_back(working_buffer_it + (openmp_thread_count + thread_id) * neuron_count_per_feature_map);
 
-				#pragma omp for schedule(guided)
+				#pragma omp for schedule(runtime)
 				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
 				{
 					int entry_id = workload_id / feature_maps_affected_count;
@@ -148,20 +179,6 @@ namespace nnforge
 					}
 				}
 			} // #pragma parallel
-
-			if ((feature_maps_unaffected_count > 0) && (input_buffer_it != output_buffer_it))
-			{
-				for(unsigned int entry_id = 0; entry_id < entry_count; ++entry_id)
-				{
-					for(std::vector<unsigned int>::const_iterator it = feature_maps_unaffected.begin(); it != feature_maps_unaffected.end(); ++it)
-					{
-						unsigned int feature_map_id = *it;
-						const float * original_in_it = input_buffer_it + (entry_id * neuron_count) + (feature_map_id * neuron_count_per_feature_map);
-						float * out_it = output_buffer_it + (entry_id * neuron_count) + (feature_map_id * neuron_count_per_feature_map);
-						memcpy(out_it, original_in_it, neuron_count_per_feature_map * sizeof(float));
-					}
-				}
-			}
 		}
 
 		void local_contrast_subtractive_layer_updater_plain::run_backward_data_propagation(
@@ -197,7 +214,7 @@ namespace nnforge
 
 			const std::vector<unsigned int>::const_iterator dimension_sizes_it = output_configuration_specific.dimension_sizes.begin();
 			const unsigned int feature_maps_affected_count = static_cast<unsigned int>(feature_maps_affected.size());
-			const unsigned int feature_maps_unaffected_count = static_cast<unsigned int>(feature_maps_affected.size());
+			const unsigned int feature_maps_unaffected_count = static_cast<unsigned int>(feature_maps_unaffected.size());
 			const std::vector<unsigned int>::const_iterator input_slices_it = input_slices.begin();
 			const std::vector<unsigned int>::const_iterator feature_maps_affected_it = feature_maps_affected.begin();
 			float * const input_errors_it = *input_errors_buffer;
@@ -205,6 +222,42 @@ namespace nnforge
 			const std::vector<std::vector<float> >::const_iterator window_weights_list_it = window_weights_list.begin();
 			float * const working_buffer_it = *temporary_working_fixed_buffer;
 
+			// Unaffected feature maps are copied in forward, so are their errors
+			if ((feature_maps_unaffected_count > 0) && (input_errors_it != output_errors_it))
+			{
+				for(unsigned int entry_id = 0; entry_id < entry_count; ++entry_id)
+				{
+					for(std::vector<unsigned int>::const_iterator it = feature_maps_unaffected.begin(); it != feature_maps_unaffected.end(); ++it)
+					{
+						unsigned int feature_map_id = *it;
+						const float * orig_it = output_errors_it + (entry_id * neuron_count) + (feature_map_id * neuron_count_per_feature_map);
+						float * out_it = input_errors_it + (entry_id * neuron_count) + (feature_map_id * neuron_count_per_feature_map);
+						if (add_update_to_destination)
+						{
+							for(unsigned int i = 0; i < neuron_count_per_feature_map; ++i)
+								*(out_it + i) += *(orig_it + i);
+						}
+						else
+							memcpy(out_it, orig_it, neuron_count_per_feature_map * sizeof(float));
+					}
+				}
+			}
+
+			if (dimension_count == 2)
+			{
+				local_contrast_subtractive_2d_kernel::run(
+					input_errors_it,
+					output_errors_it,
+					working_buffer_it,
+					output_configuration_specific,
+					window_weights_list,
+					feature_maps_affected,
+					add_update_to_destination,
+					entry_count,
+					plain_config);
+				return;
+			}
+
 			const int total_workload = entry_count * feature_maps_affected_count;
 			const int openmp_thread_count = plain_config->openmp_thread_count;
 			
@@ -220,7 +273,7 @@ namespace nnforge
 				if (dimension_count > 1)
 					local_additional_buffers.push_back(working_buffer_it + (openmp_thread_count + thread_id) * neuron_count_per_feature_map);
 
-				#pragma omp for schedule(guided)
+				#pragma omp for schedule(runtime)
 				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
 				{
 					int entry_id = workload_id / feature_maps_affected_count;
@@ -290,20 +343,6 @@ namespace nnforge
 					}
 				}
 			} // #pragma parallel
-
-			if ((!add_update_to_destination) && (feature_maps_unaffected_count > 0) && (input_errors_it != output_errors_it))
-			{
-				for(unsigned int entry_id = 0; entry_id < entry_count; ++entry_id)
-				{
-					for(std::vector<unsigned int>::const_iterator it = feature_maps_unaffected.begin(); it != feature_maps_unaffected.end(); ++it)
-					{
-						unsigned int feature_map_id = *it;
-						float * out_it = input_errors_it + (entry_id * neuron_count) + (feature_map_id * neuron_count_per_feature_map);
-						for(unsigned int i = 0; i < neuron_count_per_feature_map; ++i)
-							*(out_it + i) = 0.0F;
-					}
-				}
-			}
 		}
 
 		int local_contrast_subtractive_layer_updater_plain::get_input_index_layer_can_write(
@@ -325,6 +364,12 @@ namespace nnforge
 			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
 			const layer_configuration_specific& output_configuration_specific) const
 		{
+			if (output_configuration_specific.dimension_sizes.size() == 2)
+			{
+				std::shared_ptr<const local_contrast_subtractive_layer> layer_derived = std::dynamic_pointer_cast<const local_contrast_subtractive_layer>(layer_schema);
+				return local_contrast_subtractive_2d_kernel::get_working_buffer_elem_count(output_configuration_specific, layer_derived->window_weights_list, plain_config->openmp_thread_count) * sizeof(float);
+			}
+
 			unsigned int elem_count_per_intermediate_elem = output_configuration_specific.get_neuron_count_per_feature_map();
 			return elem_count_per_intermediate_elem * plain_config->openmp_thread_count * (output_configuration_specific.dimension_sizes.size() > 1 ? 2 : 1) * sizeof(float);
 		}
@@ -16,6 +16,7 @@
 
 #include "max_subsampling_layer_tester_plain.h"
 
+#include "subsampling_2d_kernel.h"
 #include "../max_subsampling_layer.h"
 #include "../neural_network_exception.h"
 
@@ -44,27 +45,93 @@ namespace nnforge
 			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
 			const layer_configuration_specific& output_configuration_specific,
 			unsigned int entry_count) const
+		{
+			run(
+				output_buffer,
+				input_buffers[0],
+				plain_config,
+				layer_schema,
+				input_configuration_specific_list[0],
+				output_configuration_specific,
+				entry_count,
+				false);
+		}
+
+		bool max_subsampling_layer_tester_plain::is_relu_fusable(layer::const_ptr layer_schema) const
+		{
+			std::shared_ptr<const max_subsampling_layer> layer_derived = std::dynamic_pointer_cast<const max_subsampling_layer>(layer_schema);
+
+			return !layer_derived->is_min;
+		}
+
+		void max_subsampling_layer_tester_plain::run_forward_propagation_with_relu(
+			plain_buffer::ptr output_buffer,
+			plain_buffer::const_ptr input_buffer,
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const layer_configuration_specific& input_configuration_specific,
+			const layer_configuration_specific& output_configuration_specific,
+			unsigned int entry_count) const
+		{
+			if (!is_relu_fusable(layer_schema))
+				throw neural_network_exception("ReLU cannot be fused into min subsampling");
+
+			run(
+				output_buffer,
+				input_buffer,
+				plain_config,
+				layer_schema,
+				input_configuration_specific,
+				output_configuration_specific,
+				entry_count,
+				true);
+		}
+
+		max_subsampling_layer_tester_plain::kernel_2d_func max_subsampling_layer_tester_plain::get_kernel_2d(
+			unsigned int subsampling_size,
+			unsigned int stride)
+		{
+			if ((subsampling_size == 2) && (stride == 2))
+				return subsampling_2d_kernel<2, 2>::run_max;
+			if ((subsampling_size == 3) && (stride == 2))
+				return subsampling_2d_kernel<3, 2>::run_max;
+			if ((subsampling_size == 3) && (stride == 1))
+				return subsampling_2d_kernel<3, 1>::run_max;
+			return 0;
+		}
+
+		void max_subsampling_layer_tester_plain::run(
+			plain_buffer::ptr output_buffer,
+			plain_buffer::const_ptr input_buffer,
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const layer_configuration_specific& input_configuration_specific,
+			const layer_configuration_specific& output_configuration_specific,
+			unsigned int entry_count,
+			bool relu) const
 		{
 			std::shared_ptr<const max_subsampling_layer> layer_derived = std::dynamic_pointer_cast<const max_subsampling_layer>(layer_schema);
 
 			if (layer_derived->tiling)
 				test_tiling(
 					output_buffer,
-					input_buffers[0],
+					input_buffer,
 					plain_config,
 					layer_schema,
-					input_configuration_specific_list[0],
+					input_configuration_specific,
 					output_configuration_specific,
-					entry_count);
+					entry_count,
+					relu);
 			else
 				test_non_tiling(
 					output_buffer,
-					input_buffers[0],
+					input_buffer,
 					plain_config,
 					layer_schema,
-					input_configuration_specific_list[0],
+					input_configuration_specific,
 					output_configuration_specific,
-					entry_count);
+					entry_count,
+					relu);
 		}
 
 		void max_subsampling_layer_tester_plain::test_tiling(
@@ -74,7 +141,8 @@ namespace nnforge
 			layer::const_ptr layer_schema,
 			const layer_configuration_specific& input_configuration_specific,
 			const layer_configuration_specific& output_configuration_specific,
-			unsigned int entry_count) const
+			unsigned int entry_count,
+			bool relu) const
 		{
 			std::shared_ptr<const max_subsampling_layer> layer_derived = std::dynamic_pointer_cast<const max_subsampling_layer>(layer_schema);
 
@@ -96,6 +164,7 @@ namespace nnforge
 			const unsigned int const_subsampling_elem_count = subsampling_elem_count;
 			const unsigned int feature_map_count = output_configuration_specific.feature_map_count;
 			const bool is_min = layer_derived->is_min;
+			const float initial_value = is_min ? 1.0e37F : (relu ? 0.0F : -1.0e37F);
 
 			std::vector<unsigned int> current_local_input_position(dimension_count, 0);
 			std::vector<unsigned int> offset_list(subsampling_elem_count);
@@ -125,7 +194,7 @@ namespace nnforge
 			{
 				std::array<unsigned int, max_dimension_count> current_output_position;
 
-				#pragma omp for schedule(guided)
+				#pragma omp for schedule(runtime)
 				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
 				{
 					int input_entry_id = workload_id / feature_map_count;
@@ -145,7 +214,7 @@ namespace nnforge
 
 						for(unsigned int j = 0; j < const_subsampling_elem_count; ++j)
 						{
-							float current_max = is_min ? 1.0e37F : -1.0e37F;
+							float current_max = initial_value;
 							const float * in_it2 = in_it + *(offset_list_it + j);
 							for(unsigned int i = 0; i < const_subsampling_elem_count; ++i)
 							{
@@ -174,7 +243,8 @@ namespace nnforge
 			layer::const_ptr layer_schema,
 			const layer_configuration_specific& input_configuration_specific,
 			const layer_configuration_specific& output_configuration_specific,
-			unsigned int entry_count) const
+			unsigned int entry_count,
+			bool relu) const
 		{
 			std::vector<unsigned int> input_dimension_sizes = input_configuration_specific.dimension_sizes;
 			if (input_dimension_sizes.empty())
@@ -189,6 +259,40 @@ namespace nnforge
 				if (*it)
 					throw neural_network_exception("round up is not implemented for max_subsampling_layer_tester_plain");
 
+			// Common 2D shapes are run with the specialized kernels
+			if ((output_configuration_specific.dimension_sizes.size() == 2)
+				&& (layer_derived->feature_map_subsampling_size == 1)
+				&& (layer_derived->entry_subsampling_size == 1)
+				&& (!layer_derived->is_min)
+				&& (layer_derived->subsampling_sizes[0] == layer_derived->subsampling_sizes[1])
+				&& (layer_derived->strides[0] == layer_derived->strides[1]))
+			{
+				const kernel_2d_func kernel = get_kernel_2d(layer_derived->subsampling_sizes[0], layer_derived->strides[0]);
+				if (kernel)
+				{
+					const float * const in_it_global = *input_buffer;
+					float * const out_it_global = *output_buffer;
+					const unsigned int input_neuron_count_per_feature_map = input_configuration_specific.get_neuron_count_per_feature_map();
+					const unsigned int output_neuron_count_per_feature_map = output_configuration_specific.get_neuron_count_per_feature_map();
+					const unsigned int input_width = input_configuration_specific.dimension_sizes[0];
+					const unsigned int output_width = output_configuration_specific.dimension_sizes[0];
+					const unsigned int output_height = output_configuration_specific.dimension_sizes[1];
+					const int total_workload = entry_count * output_configuration_specific.feature_map_count;
+
+					#pragma omp parallel for default(none) schedule(runtime) num_threads(plain_config->openmp_thread_count) shared(relu)
+					for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+						kernel(
+							in_it_global + workload_id * input_neuron_count_per_feature_map,
+							out_it_global + workload_id * output_neuron_count_per_feature_map,
+							input_width,
+							output_width,
+							output_height,
+							relu);
+
+					return;
+				}
+			}
+
 			const float * const in_it_global = *input_buffer;
 			float * const out_it_global = *output_buffer;
 			const unsigned int input_neuron_count = input_configuration_specific.get_neuron_count();
@@ -221,6 +325,7 @@ namespace nnforge
 			const float mult = 1.0F / static_cast<float>(subsampling_elem_count);
 			const unsigned int output_feature_map_count = output_configuration_specific.feature_map_count;
 			const bool is_min = layer_derived->is_min;
+			const float initial_value = is_min ? 1.0e37F : (relu ? 0.0F : -1.0e37F);
 
 			std::vector<unsigned int> current_local_input_position(subsampling_dimension_count, 0);
 			std::vector<unsigned int> offset_list(subsampling_elem_count);
@@ -250,7 +355,7 @@ namespace nnforge
 			{
 				std::array<unsigned int, max_dimension_count> current_output_position;
 
-				#pragma omp for schedule(guided)
+				#pragma omp for schedule(runtime)
 				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
 				{
 					int output_entry_id = workload_id / output_feature_map_count;
@@ -267,7 +372,7 @@ namespace nnforge
 						for(unsigned int i = 0; i < spatial_dimension_count; ++i)
 							in_it += current_output_position[i] * (*(strides_it + i)) * (*(input_slices_it + i));
 
-						float current_max = is_min ? 1.0e37F : -1.0e37F;
+						float current_max = initial_value;
 						for(unsigned int i = 0; i < const_subsampling_elem_count; ++i)
 						{
 							float new_val = *(in_it + (*(offset_list_it + i)));
@@ -44,7 +44,37 @@ namespace nnforge
 				const layer_configuration_specific& output_configuration_specific,
 				unsigned int entry_count) const;
 
+			// ReLU can be fused into max (not min) subsampling only
+			bool is_relu_fusable(layer::const_ptr layer_schema) const;
+
+			// Same as run_forward_propagation with the input passed through ReLU first
+			void run_forward_propagation_with_relu(
+				plain_buffer::ptr output_buffer,
+				plain_buffer::const_ptr input_buffer,
+				plain_running_configuration::const_ptr plain_config,
+				layer::const_ptr layer_schema,
+				const layer_configuration_specific& input_configuration_specific,
+				const layer_configuration_specific& output_configuration_specific,
+				unsigned int entry_count) const;
+
 		private:
+			typedef void (*kernel_2d_func)(const float *, float *, unsigned int, unsigned int, unsigned int, bool);
+
+			// Returns 0 when there is no specialized kernel for the shape
+			static kernel_2d_func get_kernel_2d(
+				unsigned int subsampling_size,
+				unsigned int stride);
+
+			void run(
+				plain_buffer::ptr output_buffer,
+				plain_buffer::const_ptr input_buffer,
+				plain_running_configuration::const_ptr plain_config,
+				layer::const_ptr layer_schema,
+				const layer_configuration_specific& input_configuration_specific,
+				const layer_configuration_specific& output_configuration_specific,
+				unsigned int entry_count,
+				bool relu) const;
+
 			void test_non_tiling(
 				plain_buffer::ptr output_buffer,
 				plain_buffer::const_ptr input_buffer,
@@ -52,7 +82,8 @@ namespace nnforge
 				layer::const_ptr layer_schema,
 				const layer_configuration_specific& input_configuration_specific,
 				const layer_configuration_specific& output_configuration_specific,
-				unsigned int entry_count) const;
+				unsigned int entry_count,
+				bool relu) const;
 
 			void test_tiling(
 				plain_buffer::ptr output_buffer,
@@ -61,7 +92,8 @@ namespace nnforge
 				layer::const_ptr layer_schema,
 				const layer_configuration_specific& input_configuration_specific,
 				const layer_configuration_specific& output_configuration_specific,
-				unsigned int entry_count) const;
+				unsigned int entry_count,
+				bool relu) const;
 
 		private:
 			static const int max_dimension_count;
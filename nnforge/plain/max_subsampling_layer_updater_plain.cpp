@@ -124,7 +124,7 @@ namespace nnforge
 			{
 				std::array<unsigned int, max_dimension_count> current_output_position;
 
-				#pragma omp for schedule(guided)
+				#pragma omp for schedule(runtime)
 				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
 				{
 					int output_entry_id = workload_id / output_feature_map_count;
@@ -199,7 +199,7 @@ namespace nnforge
 			if (!add_update_to_destination)
 			{
 				const int total_clean_workload = entry_count * entry_subsampling_size * input_configuration_specific_list[0].get_neuron_count();
-				#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
+				#pragma omp parallel for default(none) schedule(runtime) num_threads(plain_config->openmp_thread_count)
 				for(int workload_id = 0; workload_id < total_clean_workload; ++workload_id)
 				{
 					*(in_err_it_global + workload_id) = 0.0F;
@@ -210,7 +210,7 @@ namespace nnforge
 
 			if (add_update_to_destination)
 			{
-				#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
+				#pragma omp parallel for default(none) schedule(runtime) num_threads(plain_config->openmp_thread_count)
 				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
 				{
 					unsigned int max_index = *(max_indexes_it_global + workload_id);
@@ -220,7 +220,7 @@ namespace nnforge
 			}
 			else
 			{
-				#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
+				#pragma omp parallel for default(none) schedule(runtime) num_threads(plain_config->openmp_thread_count)
 				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
 				{
 					unsigned int max_index = *(max_indexes_it_global + workload_id);
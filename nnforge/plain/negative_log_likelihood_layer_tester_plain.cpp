@@ -16,6 +16,7 @@
 
 #include "negative_log_likelihood_layer_tester_plain.h"
 
+#include "vector_math.h"
 #include "../negative_log_likelihood_layer.h"
 
 #include <array>
@@ -59,7 +60,7 @@ namespace nnforge
 
 			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count)
 			{
-				#pragma omp for schedule(guided)
+				#pragma omp for schedule(runtime)
 				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
 				{
 					int entry_id = workload_id / output_neuron_count;
@@ -81,7 +82,7 @@ namespace nnforge
 							float predicted_val = *(in_it_base_predicted + feature_map_id * input_neuron_count_per_feature_map);
 							float actual_val = *(in_it_base_actual + feature_map_id * input_neuron_count_per_feature_map);
 							if (actual_val > 0.0F)
-								err -= actual_val * logf(std::max(predicted_val, 1.0e-20F));
+								err -= actual_val * vector_math::log(std::max(predicted_val, 1.0e-20F));
 						}
 						err *= total_scale;
 					}
@@ -16,6 +16,7 @@
 
 #include "negative_log_likelihood_layer_updater_plain.h"
 
+#include "vector_math.h"
 #include "../negative_log_likelihood_layer.h"
 #include "../neural_network_exception.h"
 
@@ -60,7 +61,7 @@ namespace nnforge
 
 			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count)
 			{
-				#pragma omp for schedule(guided)
+				#pragma omp for schedule(runtime)
 				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
 				{
 					int entry_id = workload_id / output_neuron_count;
@@ -82,7 +83,7 @@ namespace nnforge
 							float predicted_val = *(in_it_base_predicted + feature_map_id * input_neuron_count_per_feature_map);
 							float actual_val = *(in_it_base_actual + feature_map_id * input_neuron_count_per_feature_map);
 							if (actual_val > 0.0F)
-								err -= actual_val * logf(std::max(predicted_val, 1.0e-20F));
+								err -= actual_val * vector_math::log(std::max(predicted_val, 1.0e-20F));
 						}
 						err *= total_scale;
 					}
@@ -130,7 +131,7 @@ namespace nnforge
 			const int input_feature_map_count = input_configuration_specific_list[0].feature_map_count;
 
 			const int total_workload = entry_count * neuron_count_per_feature_map;
-			#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
+			#pragma omp parallel for default(none) schedule(runtime) num_threads(plain_config->openmp_thread_count)
 			for(int workload_id = 0; workload_id < total_workload; ++workload_id)
 			{
 				int entry_id = workload_id / neuron_count_per_feature_map;
@@ -161,6 +162,57 @@ namespace nnforge
 			}
 		}
 
+		void negative_log_likelihood_layer_updater_plain::run_backward_data_propagation_through_softmax(
+			plain_buffer::ptr input_errors_buffer,
+			const std::vector<plain_buffer::const_ptr>& input_neurons_buffers,
+			plain_running_configuration::const_ptr plain_config,
+			layer::const_ptr layer_schema,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			unsigned int entry_count) const
+		{
+			float * const in_err_it = *input_errors_buffer;
+			const float * const softmax_output_neurons_it = *input_neurons_buffers[0];
+			const float * const target_input_neurons_it = *input_neurons_buffers[1];
+			const float * scale_mask_it = 0;
+			if (input_neurons_buffers.size() > 2)
+				scale_mask_it = *input_neurons_buffers[2];
+			const float * const const_scale_mask_it = scale_mask_it;
+
+			std::shared_ptr<const negative_log_likelihood_layer> layer_derived = std::dynamic_pointer_cast<const negative_log_likelihood_layer>(layer_schema);
+			const float scale = layer_derived->scale;
+			const int neuron_count_per_feature_map = input_configuration_specific_list[0].get_neuron_count_per_feature_map();
+			const int input_feature_map_count = input_configuration_specific_list[0].feature_map_count;
+
+			// Softmax Jacobian applied to actual / predicted collapses to actual - predicted * sum(actual)
+			const int total_workload = entry_count * neuron_count_per_feature_map;
+			#pragma omp parallel for default(none) schedule(runtime) num_threads(plain_config->openmp_thread_count)
+			for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+			{
+				int entry_id = workload_id / neuron_count_per_feature_map;
+				int neuron_id = workload_id - (entry_id * neuron_count_per_feature_map);
+				int output_offset = entry_id * neuron_count_per_feature_map + neuron_id;
+				float total_scale = scale;
+				if (const_scale_mask_it)
+					total_scale *= *(const_scale_mask_it + output_offset);
+				const int input_offset_base = entry_id * input_feature_map_count * neuron_count_per_feature_map + neuron_id;
+
+				float actual_sum = 0.0F;
+				for(int feature_map_id = 0; feature_map_id < input_feature_map_count; ++feature_map_id)
+				{
+					float actual_val = *(target_input_neurons_it + input_offset_base + feature_map_id * neuron_count_per_feature_map);
+					actual_sum += (actual_val > 0.0F) ? actual_val : 0.0F;
+				}
+
+				for(int feature_map_id = 0; feature_map_id < input_feature_map_count; ++feature_map_id)
+				{
+					int input_offset = input_offset_base + feature_map_id * neuron_count_per_feature_map;
+					float actual_val = *(target_input_neurons_it + input_offset);
+					float predicted_val = *(softmax_output_neurons_it + input_offset);
+					*(in_err_it + input_offset) = total_scale * (((actual_val > 0.0F) ? actual_val : 0.0F) - predicted_val * actual_sum);
+				}
+			}
+		}
+
 		bool negative_log_likelihood_layer_updater_plain::is_backward_data_dependent_on_input_buffer(
 			unsigned int action_input_index,
 			unsigned int data_input_index,
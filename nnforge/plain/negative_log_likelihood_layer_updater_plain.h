@@ -81,6 +81,16 @@ namespace nnforge
 				layer::const_ptr layer_schema,
 				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
 				const layer_configuration_specific& output_configuration_specific) const;
+
+			// Backward data propagation through the softmax layer feeding input 0: input_neurons_buffers[0] holds softmax output,
+			// input_errors_buffer receives errors with respect to softmax input, it is overwritten
+			void run_backward_data_propagation_through_softmax(
+				plain_buffer::ptr input_errors_buffer,
+				const std::vector<plain_buffer::const_ptr>& input_neurons_buffers,
+				plain_running_configuration::const_ptr plain_config,
+				layer::const_ptr layer_schema,
+				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+				unsigned int entry_count) const;
 		};
 	}
 }
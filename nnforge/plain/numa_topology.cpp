@@ -0,0 +1,184 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "numa_topology.h"
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <cstdlib>
+#include <boost/format.hpp>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef __linux__
+#include <sched.h>
+#include <sys/mman.h>
+#endif
+
+namespace nnforge
+{
+	namespace plain
+	{
+		numa_topology::numa_topology()
+		{
+		#ifdef __linux__
+			for(unsigned int node_id = 0; ; ++node_id)
+			{
+				std::ifstream in((boost::format("/sys/devices/system/node/node%1%/cpulist") % node_id).str().c_str());
+				if (!in.is_open())
+					break;
+				std::string cpu_list;
+				std::getline(in, cpu_list);
+				std::vector<int> cpus = parse_cpu_list(cpu_list.c_str());
+				// Memory-only nodes have no CPUs to run threads on
+				if (!cpus.empty())
+					node_cpu_list.push_back(cpus);
+			}
+		#endif
+		}
+
+		const numa_topology& numa_topology::get_singleton()
+		{
+			static numa_topology instance;
+			return instance;
+		}
+
+		std::vector<int> numa_topology::parse_cpu_list(const char * cpu_list)
+		{
+			std::vector<int> res;
+
+			const char * current = cpu_list;
+			while (*current != 0)
+			{
+				char * end;
+				long first_cpu_id = strtol(current, &end, 10);
+				if (end == current)
+					break;
+				long last_cpu_id = first_cpu_id;
+				current = end;
+				if (*current == '-')
+				{
+					++current;
+					last_cpu_id = strtol(current, &end, 10);
+					if (end == current)
+						break;
+					current = end;
+				}
+				for(long cpu_id = first_cpu_id; cpu_id <= last_cpu_id; ++cpu_id)
+					res.push_back(static_cast<int>(cpu_id));
+				if (*current == ',')
+					++current;
+			}
+
+			return res;
+		}
+
+		unsigned int numa_topology::get_node_count() const
+		{
+			return std::max(static_cast<unsigned int>(node_cpu_list.size()), 1U);
+		}
+
+		unsigned int numa_topology::get_node_id(
+			int thread_id,
+			int thread_count) const
+		{
+			return static_cast<unsigned int>(static_cast<long long>(thread_id) * get_node_count() / std::max(thread_count, 1));
+		}
+
+		std::vector<std::vector<int> > numa_topology::bind_openmp_threads(int thread_count) const
+		{
+			std::vector<std::vector<int> > res;
+
+		#if defined(__linux__) && defined(_OPENMP)
+			if (node_cpu_list.size() <= 1)
+				return res;
+
+			res.resize(thread_count);
+			#pragma omp parallel default(none) num_threads(thread_count) shared(thread_count,res)
+			{
+				int thread_id = omp_get_thread_num();
+				cpu_set_t cpu_set;
+				CPU_ZERO(&cpu_set);
+				if (sched_getaffinity(0, sizeof(cpu_set), &cpu_set) == 0)
+				{
+					for(int cpu_id = 0; cpu_id < CPU_SETSIZE; ++cpu_id)
+						if (CPU_ISSET(cpu_id, &cpu_set))
+							res[thread_id].push_back(cpu_id);
+				}
+
+				const std::vector<int>& cpus = node_cpu_list[get_node_id(thread_id, thread_count)];
+				CPU_ZERO(&cpu_set);
+				for(std::vector<int>::const_iterator it = cpus.begin(); it != cpus.end(); ++it)
+					CPU_SET(*it, &cpu_set);
+				// Thread is allowed to migrate within its node, the OS does a fine job there
+				sched_setaffinity(0, sizeof(cpu_set), &cpu_set);
+			}
+		#endif
+
+			return res;
+		}
+
+		void numa_topology::restore_openmp_threads(const std::vector<std::vector<int> >& thread_cpu_list) const
+		{
+		#if defined(__linux__) && defined(_OPENMP)
+			if (thread_cpu_list.empty())
+				return;
+
+			const int thread_count = static_cast<int>(thread_cpu_list.size());
+			#pragma omp parallel default(none) num_threads(thread_count) shared(thread_cpu_list)
+			{
+				const std::vector<int>& cpus = thread_cpu_list[omp_get_thread_num()];
+				if (!cpus.empty())
+				{
+					cpu_set_t cpu_set;
+					CPU_ZERO(&cpu_set);
+					for(std::vector<int>::const_iterator it = cpus.begin(); it != cpus.end(); ++it)
+						CPU_SET(*it, &cpu_set);
+					sched_setaffinity(0, sizeof(cpu_set), &cpu_set);
+				}
+			}
+		#endif
+		}
+
+		void numa_topology::first_touch(
+			void * buf,
+			size_t size,
+			int thread_count) const
+		{
+			const int page_size = 4096;
+			const int page_count = static_cast<int>((size + page_size - 1) / page_size);
+			unsigned char * bytes = static_cast<unsigned char *>(buf);
+
+		#if defined(__linux__) && defined(MADV_DONTNEED)
+			// Pages touched before stay on their nodes, they are dropped so that the touch below faults them in again.
+			// Whole pages only, the buffer doesn't have to start or end at the page boundary
+			{
+				size_t begin = (reinterpret_cast<size_t>(bytes) + page_size - 1) / page_size * page_size;
+				size_t end = (reinterpret_cast<size_t>(bytes) + size) / page_size * page_size;
+				if (end > begin)
+					madvise(reinterpret_cast<void *>(begin), end - begin, MADV_DONTNEED);
+			}
+		#endif
+
+			#pragma omp parallel for default(none) schedule(static) num_threads(thread_count) shared(bytes)
+			for(int page_id = 0; page_id < page_count; ++page_id)
+				bytes[static_cast<size_t>(page_id) * page_size] = 0;
+		}
+	}
+}
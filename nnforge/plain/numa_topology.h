@@ -0,0 +1,69 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// NUMA nodes of the host and the CPUs belonging to them, single node is assumed when the topology is not available
+		class numa_topology
+		{
+		public:
+			static const numa_topology& get_singleton();
+
+			unsigned int get_node_count() const;
+
+			// Threads are spread over nodes in contiguous blocks: thread_id * node_count / thread_count
+			unsigned int get_node_id(
+				int thread_id,
+				int thread_count) const;
+
+			// Pins each thread of the OpenMP team, the calling thread included, to the CPUs of its node.
+			// Returns the CPUs each thread was allowed to run on before, empty when threads were left alone
+			std::vector<std::vector<int> > bind_openmp_threads(int thread_count) const;
+
+			// Gives the threads back the CPUs returned by bind_openmp_threads called with the same thread count
+			void restore_openmp_threads(const std::vector<std::vector<int> >& thread_cpu_list) const;
+
+			// Touches pages of the buffer with the static partitioning across thread_count threads,
+			// so that the part of the buffer each thread works on in static-scheduled loops is placed on its node.
+			// Pages already backed by memory (blocks reused from the buffer pool) are discarded first, the content is lost
+			void first_touch(
+				void * buf,
+				size_t size,
+				int thread_count) const;
+
+		private:
+			numa_topology();
+
+			~numa_topology() = default;
+
+			static std::vector<int> parse_cpu_list(const char * cpu_list);
+
+		private:
+			std::vector<std::vector<int> > node_cpu_list;
+
+		private:
+			numa_topology(const numa_topology&) = delete;
+			numa_topology& operator =(const numa_topology&) = delete;
+		};
+	}
+}
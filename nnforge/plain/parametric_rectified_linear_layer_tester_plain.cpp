@@ -46,9 +46,9 @@ namespace nnforge
 			const unsigned int neuron_count = output_configuration_specific.get_neuron_count();
 			const unsigned int neuron_count_per_feature_map = output_configuration_specific.get_neuron_count_per_feature_map();
 			const unsigned int feature_map_count = output_configuration_specific.feature_map_count;
-			const std::vector<float>::const_iterator weights = (*data)[0].begin();
+			const layer_data_part::const_iterator weights = (*data)[0].begin();
 
-			#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
+			#pragma omp parallel for default(none) schedule(runtime) num_threads(plain_config->openmp_thread_count)
 			for(int workload_id = 0; workload_id < total_workload; ++workload_id)
 			{
 				int entry_id = workload_id / feature_map_count;
@@ -50,9 +50,9 @@ namespace nnforge
 			const int total_workload = static_cast<int>(entry_count * feature_map_count);
 			const float * const in_it = *input_buffers[0];
 			float * const out_it = *output_buffer;
-			const std::vector<float>::const_iterator weights = (*data)[0].begin();
+			const layer_data_part::const_iterator weights = (*data)[0].begin();
 
-			#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
+			#pragma omp parallel for default(none) schedule(runtime) num_threads(plain_config->openmp_thread_count)
 			for(int workload_id = 0; workload_id < total_workload; ++workload_id)
 			{
 				int entry_id = workload_id / feature_map_count;
@@ -99,9 +99,9 @@ namespace nnforge
 			const float * const in_neurons_it = *input_neurons_buffers[0];
 			const float * const out_errors_it = *output_errors_buffer;
 			float * const  in_errors_it = *input_errors_buffer;
-			const std::vector<float>::const_iterator weights = (*data)[0].begin();
+			const layer_data_part::const_iterator weights = (*data)[0].begin();
 
-			#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
+			#pragma omp parallel for default(none) schedule(runtime) num_threads(plain_config->openmp_thread_count)
 			for(int workload_id = 0; workload_id < total_workload; ++workload_id)
 			{
 				int entry_id = workload_id / feature_map_count;
@@ -157,12 +157,12 @@ namespace nnforge
 
 			const float * const in_neurons_it = *input_neurons_buffers[0];
 			const float * const err_it = *output_errors_buffer;
-			const std::vector<float>::iterator gradients = (*gradient)[0].begin();
+			const layer_data_part::iterator gradients = (*gradient)[0].begin();
 
 			const int total_workload = feature_map_count;
 			const int const_updater_count = entry_count;
 
-			#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
+			#pragma omp parallel for default(none) schedule(runtime) num_threads(plain_config->openmp_thread_count)
 			for(int workload_id = 0; workload_id < total_workload; ++workload_id)
 			{
 				int feature_map_id = workload_id;
@@ -16,7 +16,7 @@
 
 #include "plain_buffer.h"
 
-#include <cstdlib>
+#include "plain_buffer_pool.h"
 
 namespace nnforge
 {
@@ -26,13 +26,24 @@ namespace nnforge
 			: buf(0)
 			, size(0)
 		{
-			buf = malloc(size);
+			buf = plain_buffer_pool::get_singleton().allocate(size);
 			this->size = size;
 		}
 
+		plain_buffer::plain_buffer(
+			ptr parent,
+			size_t offset,
+			size_t size)
+			: buf((unsigned char *)(parent->get_buf()) + offset)
+			, size(size)
+			, parent(parent)
+		{
+		}
+
 		plain_buffer::~plain_buffer()
 		{
-			free(buf);
+			if (!parent)
+				plain_buffer_pool::get_singleton().deallocate(buf);
 		}
 
 		void * plain_buffer::get_buf()
@@ -90,6 +101,16 @@ namespace nnforge
 			return (unsigned char *)(get_buf());
 		}
 
+		plain_buffer::operator unsigned short *()
+		{
+			return (unsigned short *)(get_buf());
+		}
+
+		plain_buffer::operator const unsigned short *() const
+		{
+			return (unsigned short *)(get_buf());
+		}
+
 		plain_buffer::operator unsigned int *()
 		{
 			return (unsigned int *)(get_buf());
@@ -31,6 +31,12 @@ namespace nnforge
 
 			plain_buffer(size_t size);
 
+			// View of size bytes starting at offset bytes into the parent buffer, the parent is kept alive while the view exists
+			plain_buffer(
+				ptr parent,
+				size_t offset,
+				size_t size);
+
 			virtual ~plain_buffer();
 
 			// Size in bytes
@@ -52,6 +58,10 @@ namespace nnforge
 
 			operator const unsigned char *() const;
 
+			operator unsigned short *();
+
+			operator const unsigned short *() const;
+
 			operator unsigned int *();
 
 			operator const unsigned int *() const;
@@ -67,6 +77,7 @@ namespace nnforge
 		private:
 			void * buf;
 			size_t size;
+			ptr parent;
 		};
 	}
 }
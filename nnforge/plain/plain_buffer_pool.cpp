@@ -0,0 +1,309 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "plain_buffer_pool.h"
+
+#include "../neural_network_exception.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include <boost/format.hpp>
+
+#ifdef _WIN32
+#include <malloc.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace nnforge
+{
+	namespace plain
+	{
+		const size_t plain_buffer_pool::buffer_alignment = 64;
+		const size_t plain_buffer_pool::huge_page_size = 2 * 1024 * 1024;
+
+		plain_buffer_pool::usage_stats::usage_stats()
+			: allocation_count(0)
+			, reused_allocation_count(0)
+			, system_allocation_count(0)
+			, system_release_count(0)
+			, huge_page_allocation_count(0)
+			, bytes_in_use(0)
+			, peak_bytes_in_use(0)
+			, bytes_cached(0)
+			, bytes_allocated_from_system(0)
+		{
+		}
+
+		plain_buffer_pool::plain_buffer_pool()
+			: mode(huge_pages_none)
+			, max_cached_bytes(0)
+			, max_total_bytes(std::numeric_limits<size_t>::max())
+		{
+		}
+
+		plain_buffer_pool::~plain_buffer_pool()
+		{
+			// Blocks still in use are left alone, their owners might outlive the pool on program exit
+			release_cached_while_above(0);
+		}
+
+		plain_buffer_pool& plain_buffer_pool::get_singleton()
+		{
+			static plain_buffer_pool instance;
+			return instance;
+		}
+
+		plain_buffer_pool::huge_page_mode plain_buffer_pool::get_huge_page_mode(const std::string& huge_page_mode_str)
+		{
+			if (huge_page_mode_str == "none")
+				return huge_pages_none;
+			else if (huge_page_mode_str == "transparent")
+				return huge_pages_transparent;
+			else if (huge_page_mode_str == "explicit")
+				return huge_pages_explicit;
+			else
+				throw neural_network_exception((boost::format("Unknown huge page mode: %1%") % huge_page_mode_str).str());
+		}
+
+		const char * plain_buffer_pool::get_huge_page_mode_str(huge_page_mode mode)
+		{
+			switch (mode)
+			{
+			case huge_pages_none:
+				return "none";
+			case huge_pages_transparent:
+				return "transparent";
+			case huge_pages_explicit:
+				return "explicit";
+			default:
+				return "unknown";
+			}
+		}
+
+		void plain_buffer_pool::configure(
+			huge_page_mode mode,
+			size_t max_cached_bytes,
+			size_t max_total_bytes)
+		{
+			std::lock_guard<std::mutex> lock(pool_mutex);
+
+			if (mode != this->mode)
+				release_cached_while_above(0);
+
+			this->mode = mode;
+			this->max_cached_bytes = max_cached_bytes;
+			this->max_total_bytes = max_total_bytes;
+
+			release_cached_while_above(get_max_bytes_cached());
+		}
+
+		size_t plain_buffer_pool::get_size_class(size_t size)
+		{
+			size_t rounded_size = std::max((size + buffer_alignment - 1) / buffer_alignment * buffer_alignment, buffer_alignment);
+			if (rounded_size <= 64 * 1024)
+				return rounded_size;
+
+			// 8 size classes per power of 2, at most 12.5% of the memory is wasted
+			size_t power_of_2 = 64 * 1024;
+			while (power_of_2 * 2 <= rounded_size)
+				power_of_2 *= 2;
+			size_t step = power_of_2 / 8;
+			return (rounded_size + step - 1) / step * step;
+		}
+
+		void * plain_buffer_pool::allocate(size_t size)
+		{
+			size_t size_class = get_size_class(size);
+
+			std::lock_guard<std::mutex> lock(pool_mutex);
+
+			++stats.allocation_count;
+
+			void * buf;
+			block_info info;
+			std::multimap<size_t, std::pair<void *, block_info> >::iterator cached_it = cached_blocks.find(size_class);
+			if (cached_it != cached_blocks.end())
+			{
+				buf = cached_it->second.first;
+				info = cached_it->second.second;
+				cached_blocks.erase(cached_it);
+				stats.bytes_cached -= info.allocated_size;
+				++stats.reused_allocation_count;
+			}
+			else
+			{
+				buf = allocate_from_system(size_class, info);
+				if (buf == 0)
+				{
+					// Cached blocks of other sizes might be the ones exhausting the memory
+					release_cached_while_above(0);
+					buf = allocate_from_system(size_class, info);
+					if (buf == 0)
+						throw neural_network_exception((boost::format("Failed to allocate %1% bytes for plain buffer") % info.allocated_size).str());
+				}
+			}
+
+			blocks_in_use.insert(std::make_pair(buf, info));
+			stats.bytes_in_use += info.allocated_size;
+			stats.peak_bytes_in_use = std::max(stats.peak_bytes_in_use, stats.bytes_in_use);
+
+			// Blocks in use have grown, the cache gives the memory back to stay within the budget
+			release_cached_while_above(get_max_bytes_cached());
+
+			return buf;
+		}
+
+		void plain_buffer_pool::deallocate(void * buf)
+		{
+			if (buf == 0)
+				return;
+
+			std::lock_guard<std::mutex> lock(pool_mutex);
+
+			std::map<void *, block_info>::iterator it = blocks_in_use.find(buf);
+			if (it == blocks_in_use.end())
+				return;
+			block_info info = it->second;
+			blocks_in_use.erase(it);
+			stats.bytes_in_use -= info.allocated_size;
+
+			size_t max_bytes_cached = get_max_bytes_cached();
+			if (info.allocated_size <= max_bytes_cached)
+			{
+				release_cached_while_above(max_bytes_cached - info.allocated_size);
+				cached_blocks.insert(std::make_pair(info.size_class, std::make_pair(buf, info)));
+				stats.bytes_cached += info.allocated_size;
+			}
+			else
+			{
+				release_to_system(buf, info);
+			}
+		}
+
+		void plain_buffer_pool::release_cached()
+		{
+			std::lock_guard<std::mutex> lock(pool_mutex);
+
+			release_cached_while_above(0);
+		}
+
+		plain_buffer_pool::usage_stats plain_buffer_pool::get_usage_stats() const
+		{
+			std::lock_guard<std::mutex> lock(pool_mutex);
+
+			return stats;
+		}
+
+		void plain_buffer_pool::release_cached_while_above(size_t max_bytes_cached)
+		{
+			// Largest blocks go first, they are the least likely to be reused
+			while ((stats.bytes_cached > max_bytes_cached) && (!cached_blocks.empty()))
+			{
+				std::multimap<size_t, std::pair<void *, block_info> >::iterator it = cached_blocks.end();
+				--it;
+				stats.bytes_cached -= it->second.second.allocated_size;
+				release_to_system(it->second.first, it->second.second);
+				cached_blocks.erase(it);
+			}
+		}
+
+		size_t plain_buffer_pool::get_max_bytes_cached() const
+		{
+			size_t bytes_left = (max_total_bytes > stats.bytes_in_use) ? max_total_bytes - stats.bytes_in_use : 0;
+			return std::min(max_cached_bytes, bytes_left);
+		}
+
+		void * plain_buffer_pool::allocate_from_system(size_t size_class, block_info& info)
+		{
+			info.size_class = size_class;
+			info.allocated_size = size_class;
+			info.mapped = false;
+
+			void * buf = 0;
+		#ifdef _WIN32
+			// Large pages require SeLockMemoryPrivilege on Windows, we stick to regular pages there
+			buf = _aligned_malloc(info.allocated_size, buffer_alignment);
+		#else
+			if ((mode != huge_pages_none) && (size_class >= huge_page_size))
+			{
+				info.allocated_size = (size_class + huge_page_size - 1) / huge_page_size * huge_page_size;
+			#ifdef MAP_HUGETLB
+				if (mode == huge_pages_explicit)
+				{
+					buf = mmap(0, info.allocated_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+					if (buf == MAP_FAILED)
+						buf = 0;
+					else
+						info.mapped = true;
+				}
+			#endif
+				// Fall back to transparent huge pages when explicit ones are not reserved in the system
+				if ((buf == 0) && (posix_memalign(&buf, huge_page_size, info.allocated_size) != 0))
+					buf = 0;
+			#ifdef MADV_HUGEPAGE
+				if ((buf != 0) && (!info.mapped))
+					madvise(buf, info.allocated_size, MADV_HUGEPAGE);
+			#endif
+				if (buf != 0)
+					++stats.huge_page_allocation_count;
+			}
+			else
+			{
+				if (posix_memalign(&buf, buffer_alignment, info.allocated_size) != 0)
+					buf = 0;
+			}
+		#endif
+
+			if (buf != 0)
+			{
+				++stats.system_allocation_count;
+				stats.bytes_allocated_from_system += info.allocated_size;
+			}
+
+			return buf;
+		}
+
+		void plain_buffer_pool::release_to_system(void * buf, const block_info& info)
+		{
+		#ifdef _WIN32
+			_aligned_free(buf);
+		#else
+			if (info.mapped)
+				munmap(buf, info.allocated_size);
+			else
+				free(buf);
+		#endif
+
+			++stats.system_release_count;
+			stats.bytes_allocated_from_system -= info.allocated_size;
+		}
+
+		std::ostream& operator<< (std::ostream& out, const plain_buffer_pool::usage_stats& stats)
+		{
+			out << stats.allocation_count << " allocations";
+			out << " (" << stats.reused_allocation_count << " reused, " << stats.system_allocation_count << " from system, " << stats.huge_page_allocation_count << " on huge pages)";
+			out << ", " << stats.system_release_count << " released to system";
+			out << ", in use " << ((stats.bytes_in_use + 1024 * 1024 - 1) / (1024 * 1024)) << " MB";
+			out << " (peak " << ((stats.peak_bytes_in_use + 1024 * 1024 - 1) / (1024 * 1024)) << " MB)";
+			out << ", cached " << ((stats.bytes_cached + 1024 * 1024 - 1) / (1024 * 1024)) << " MB";
+			out << ", allocated from system " << ((stats.bytes_allocated_from_system + 1024 * 1024 - 1) / (1024 * 1024)) << " MB";
+
+			return out;
+		}
+	}
+}
@@ -0,0 +1,119 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Allocates aligned host memory for plain buffers and keeps released blocks for reuse,
+		// so that buffers allocated on each run don't hit the system allocator and page faults every time
+		class plain_buffer_pool
+		{
+		public:
+			enum huge_page_mode
+			{
+				huge_pages_none = 0,
+				huge_pages_transparent = 1,
+				huge_pages_explicit = 2
+			};
+
+			struct usage_stats
+			{
+				usage_stats();
+
+				unsigned long long allocation_count;
+				unsigned long long reused_allocation_count;
+				unsigned long long system_allocation_count;
+				unsigned long long system_release_count;
+				unsigned long long huge_page_allocation_count;
+				size_t bytes_in_use;
+				size_t peak_bytes_in_use;
+				size_t bytes_cached;
+				size_t bytes_allocated_from_system;
+			};
+
+			static plain_buffer_pool& get_singleton();
+
+			static huge_page_mode get_huge_page_mode(const std::string& huge_page_mode_str);
+
+			static const char * get_huge_page_mode_str(huge_page_mode mode);
+
+			// Cached blocks are limited by max_cached_bytes and by the memory left
+			// from max_total_bytes after the blocks in use, the latter is the global memory budget
+			void configure(
+				huge_page_mode mode,
+				size_t max_cached_bytes,
+				size_t max_total_bytes);
+
+			// Returned memory is aligned to buffer_alignment bytes at least
+			void * allocate(size_t size);
+
+			void deallocate(void * buf);
+
+			// Returns all the cached blocks to the system
+			void release_cached();
+
+			usage_stats get_usage_stats() const;
+
+			static const size_t buffer_alignment;
+			static const size_t huge_page_size;
+
+		private:
+			struct block_info
+			{
+				size_t size_class;
+				size_t allocated_size;
+				bool mapped;
+			};
+
+			plain_buffer_pool();
+
+			~plain_buffer_pool();
+
+			static size_t get_size_class(size_t size);
+
+			void * allocate_from_system(size_t size_class, block_info& info);
+
+			void release_to_system(void * buf, const block_info& info);
+
+			void release_cached_while_above(size_t max_bytes_cached);
+
+			size_t get_max_bytes_cached() const;
+
+		private:
+			mutable std::mutex pool_mutex;
+			huge_page_mode mode;
+			size_t max_cached_bytes;
+			size_t max_total_bytes;
+			std::map<void *, block_info> blocks_in_use;
+			std::multimap<size_t, std::pair<void *, block_info> > cached_blocks;
+			usage_stats stats;
+
+		private:
+			plain_buffer_pool(const plain_buffer_pool&) = delete;
+			plain_buffer_pool& operator =(const plain_buffer_pool&) = delete;
+		};
+
+		std::ostream& operator<< (std::ostream& out, const plain_buffer_pool::usage_stats& stats);
+	}
+}
@@ -0,0 +1,259 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "plain_kernel_tuner.h"
+
+#include "../neural_network_exception.h"
+#include "../proto/nnforge.pb.h"
+
+#include <sstream>
+#include <boost/format.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/algorithm/string.hpp>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace nnforge
+{
+	namespace plain
+	{
+		plain_kernel_tuner::kernel_choice::kernel_choice()
+			: schedule(schedule_guided)
+			, thread_count(1)
+		{
+		}
+
+		plain_kernel_tuner::kernel_choice::kernel_choice(
+			loop_schedule schedule,
+			int thread_count)
+			: schedule(schedule)
+			, thread_count(thread_count)
+		{
+		}
+
+		plain_kernel_tuner::plain_kernel_tuner()
+			: enabled(false)
+			, cpu_model(get_cpu_model())
+		{
+		}
+
+		plain_kernel_tuner& plain_kernel_tuner::get_singleton()
+		{
+			static plain_kernel_tuner instance;
+			return instance;
+		}
+
+		void plain_kernel_tuner::configure(
+			bool enabled,
+			const boost::filesystem::path& cache_file_path)
+		{
+			std::lock_guard<std::mutex> lock(choices_mutex);
+
+			this->enabled = enabled;
+			this->cache_file_path = cache_file_path;
+			layer_signature_to_choice_map.clear();
+			if (enabled)
+				load();
+		}
+
+		bool plain_kernel_tuner::is_enabled() const
+		{
+			return enabled;
+		}
+
+		std::string plain_kernel_tuner::get_layer_signature(
+			layer::const_ptr layer_schema,
+			const layer_action& action,
+			const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+			const layer_configuration_specific& output_configuration_specific,
+			unsigned int entry_count,
+			int max_thread_count) const
+		{
+			// Layer names and inputs don't matter, layer parameters do
+			protobuf::Layer layer_proto;
+			layer_proto.set_type(layer_schema->get_type_name());
+			layer_schema->write_proto(&layer_proto);
+			std::string layer_params = layer_proto.ShortDebugString();
+
+			// Chunks of similar size share the same settings
+			unsigned int entry_count_bucket = 1;
+			while (entry_count_bucket < entry_count)
+				entry_count_bucket *= 2;
+
+			std::stringstream res;
+			res << cpu_model << "|" << max_thread_count << " threads|" << action.str() << "|" << layer_params << "|in";
+			for(std::vector<layer_configuration_specific>::const_iterator it = input_configuration_specific_list.begin(); it != input_configuration_specific_list.end(); ++it)
+			{
+				res << " " << it->feature_map_count;
+				for(std::vector<unsigned int>::const_iterator it2 = it->dimension_sizes.begin(); it2 != it->dimension_sizes.end(); ++it2)
+					res << "x" << *it2;
+			}
+			res << "|out " << output_configuration_specific.feature_map_count;
+			for(std::vector<unsigned int>::const_iterator it = output_configuration_specific.dimension_sizes.begin(); it != output_configuration_specific.dimension_sizes.end(); ++it)
+				res << "x" << *it;
+			res << "|" << entry_count_bucket << " entries";
+
+			return res.str();
+		}
+
+		bool plain_kernel_tuner::find_choice(
+			const std::string& layer_signature,
+			kernel_choice& choice) const
+		{
+			std::lock_guard<std::mutex> lock(choices_mutex);
+
+			std::map<std::string, kernel_choice>::const_iterator it = layer_signature_to_choice_map.find(layer_signature);
+			if (it == layer_signature_to_choice_map.end())
+				return false;
+
+			choice = it->second;
+			return true;
+		}
+
+		void plain_kernel_tuner::set_choice(
+			const std::string& layer_signature,
+			const kernel_choice& choice)
+		{
+			std::lock_guard<std::mutex> lock(choices_mutex);
+
+			layer_signature_to_choice_map[layer_signature] = choice;
+			save();
+		}
+
+		std::vector<plain_kernel_tuner::kernel_choice> plain_kernel_tuner::get_candidates(int max_thread_count)
+		{
+			std::vector<kernel_choice> res;
+
+			std::vector<int> thread_counts(1, max_thread_count);
+			if (max_thread_count >= 4)
+				thread_counts.push_back(max_thread_count / 2);
+
+			for(std::vector<int>::const_iterator it = thread_counts.begin(); it != thread_counts.end(); ++it)
+			{
+				res.push_back(kernel_choice(schedule_guided, *it));
+				res.push_back(kernel_choice(schedule_static, *it));
+				res.push_back(kernel_choice(schedule_dynamic, *it));
+			}
+
+			return res;
+		}
+
+		void plain_kernel_tuner::apply_schedule(loop_schedule schedule)
+		{
+			#if defined(_OPENMP) && (_OPENMP >= 200805)
+			switch (schedule)
+			{
+			case schedule_static:
+				omp_set_schedule(omp_sched_static, 0);
+				break;
+			case schedule_guided:
+				omp_set_schedule(omp_sched_guided, 0);
+				break;
+			case schedule_dynamic:
+				omp_set_schedule(omp_sched_dynamic, 0);
+				break;
+			}
+			#endif
+		}
+
+		const char * plain_kernel_tuner::get_schedule_str(loop_schedule schedule)
+		{
+			switch (schedule)
+			{
+			case schedule_static:
+				return "static";
+			case schedule_guided:
+				return "guided";
+			case schedule_dynamic:
+				return "dynamic";
+			default:
+				return "unknown";
+			}
+		}
+
+		std::string plain_kernel_tuner::get_cpu_model()
+		{
+			std::string res = "unknown CPU";
+
+		#ifdef __linux__
+			std::ifstream in("/proc/cpuinfo");
+			std::string line;
+			while (std::getline(in, line))
+			{
+				if (boost::starts_with(line, "model name"))
+				{
+					std::string::size_type colon_pos = line.find(':');
+					if (colon_pos != std::string::npos)
+					{
+						res = line.substr(colon_pos + 1);
+						boost::trim(res);
+					}
+					break;
+				}
+			}
+		#endif
+
+			boost::replace_all(res, "|", " ");
+			boost::replace_all(res, "\t", " ");
+			return res;
+		}
+
+		void plain_kernel_tuner::load()
+		{
+			if (cache_file_path.empty() || !boost::filesystem::exists(cache_file_path))
+				return;
+
+			boost::filesystem::ifstream in(cache_file_path);
+			std::string line;
+			while (std::getline(in, line))
+			{
+				boost::trim_right(line);
+				if (line.empty())
+					continue;
+
+				std::vector<std::string> strs;
+				boost::split(strs, line, boost::is_any_of("\t"));
+				if (strs.size() != 3)
+					throw neural_network_exception((boost::format("Wrong line in kernel tuning cache %1%: %2%") % cache_file_path.string() % line).str());
+
+				kernel_choice choice;
+				if (strs[1] == "static")
+					choice.schedule = schedule_static;
+				else if (strs[1] == "guided")
+					choice.schedule = schedule_guided;
+				else if (strs[1] == "dynamic")
+					choice.schedule = schedule_dynamic;
+				else
+					throw neural_network_exception((boost::format("Unknown schedule %1% in kernel tuning cache %2%") % strs[1] % cache_file_path.string()).str());
+				choice.thread_count = atol(strs[2].c_str());
+
+				layer_signature_to_choice_map[strs[0]] = choice;
+			}
+		}
+
+		void plain_kernel_tuner::save() const
+		{
+			if (cache_file_path.empty())
+				return;
+
+			boost::filesystem::ofstream out(cache_file_path, std::ios_base::out | std::ios_base::trunc);
+			for(std::map<std::string, kernel_choice>::const_iterator it = layer_signature_to_choice_map.begin(); it != layer_signature_to_choice_map.end(); ++it)
+				out << it->first << "\t" << get_schedule_str(it->second.schedule) << "\t" << it->second.thread_count << std::endl;
+		}
+	}
+}
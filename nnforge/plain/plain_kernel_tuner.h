@@ -0,0 +1,113 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "../layer.h"
+#include "../layer_action.h"
+#include "../layer_configuration_specific.h"
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <boost/filesystem.hpp>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Keeps the fastest kernel settings found for each layer signature, optionally persisted in a cache file.
+		// The cache file is shared between hosts, so CPU model and thread count are part of the key
+		class plain_kernel_tuner
+		{
+		public:
+			enum loop_schedule
+			{
+				schedule_static = 0,
+				schedule_guided = 1,
+				schedule_dynamic = 2
+			};
+
+			struct kernel_choice
+			{
+				kernel_choice();
+
+				kernel_choice(
+					loop_schedule schedule,
+					int thread_count);
+
+				loop_schedule schedule;
+				int thread_count;
+			};
+
+			static plain_kernel_tuner& get_singleton();
+
+			// Empty cache_file_path means winners are kept in memory only
+			void configure(
+				bool enabled,
+				const boost::filesystem::path& cache_file_path);
+
+			bool is_enabled() const;
+
+			std::string get_layer_signature(
+				layer::const_ptr layer_schema,
+				const layer_action& action,
+				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
+				const layer_configuration_specific& output_configuration_specific,
+				unsigned int entry_count,
+				int max_thread_count) const;
+
+			bool find_choice(
+				const std::string& layer_signature,
+				kernel_choice& choice) const;
+
+			// The winner is persisted right away, tuning happens rarely
+			void set_choice(
+				const std::string& layer_signature,
+				const kernel_choice& choice);
+
+			static std::vector<kernel_choice> get_candidates(int max_thread_count);
+
+			// Sets schedule for the loops with schedule(runtime) run from the calling thread
+			static void apply_schedule(loop_schedule schedule);
+
+			static const char * get_schedule_str(loop_schedule schedule);
+
+		private:
+			plain_kernel_tuner();
+
+			~plain_kernel_tuner() = default;
+
+			static std::string get_cpu_model();
+
+			void load();
+
+			void save() const;
+
+		private:
+			mutable std::mutex choices_mutex;
+			bool enabled;
+			boost::filesystem::path cache_file_path;
+			std::string cpu_model;
+			std::map<std::string, kernel_choice> layer_signature_to_choice_map;
+
+		private:
+			plain_kernel_tuner(const plain_kernel_tuner&) = delete;
+			plain_kernel_tuner& operator =(const plain_kernel_tuner&) = delete;
+		};
+	}
+}
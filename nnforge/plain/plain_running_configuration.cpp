@@ -16,6 +16,10 @@
 
 #include "plain_running_configuration.h"
 
+#include "numa_topology.h"
+
+#include <cstdlib>
+
 #ifdef _OPENMP
 #include <omp.h>
 #endif
@@ -24,11 +28,30 @@ namespace nnforge
 {
 	namespace plain
 	{
+		plain_running_configuration::openmp_state::openmp_state()
+			: schedule_kind(0)
+			, schedule_chunk_size(0)
+		{
+		}
+
+		plain_running_configuration::mode_settings::mode_settings()
+			: parallel_branches(false)
+			, recompute_activations(false)
+			, bf16_activations(false)
+			, numa_aware(false)
+		{
+		}
+
 		plain_running_configuration::plain_running_configuration(
 			int openmp_thread_count,
-			float max_memory_usage_gigabytes)
+			float max_memory_usage_gigabytes,
+			const mode_settings& modes)
 			: openmp_thread_count(openmp_thread_count)
 			, max_memory_usage_gigabytes(max_memory_usage_gigabytes)
+			, parallel_branches(modes.parallel_branches)
+			, recompute_activations(modes.recompute_activations)
+			, bf16_activations(modes.bf16_activations)
+			, numa_aware(modes.numa_aware)
 		{
 			#ifndef _OPENMP
 			this->openmp_thread_count = 1;
@@ -48,6 +71,52 @@ namespace nnforge
 			return static_cast<unsigned int>(entry_count_limited_by_global);
 		}
 
+		plain_running_configuration::openmp_state plain_running_configuration::setup_openmp() const
+		{
+			openmp_state res;
+
+			#if defined(_OPENMP) && (_OPENMP >= 200805)
+			omp_sched_t schedule_kind;
+			omp_get_schedule(&schedule_kind, &res.schedule_chunk_size);
+			res.schedule_kind = static_cast<int>(schedule_kind);
+			#endif
+
+			reset_openmp_schedule(res);
+			if (numa_aware)
+				res.thread_cpu_list = numa_topology::get_singleton().bind_openmp_threads(openmp_thread_count);
+
+			return res;
+		}
+
+		void plain_running_configuration::restore_openmp(const openmp_state& state) const
+		{
+			#if defined(_OPENMP) && (_OPENMP >= 200805)
+			omp_set_schedule(static_cast<omp_sched_t>(state.schedule_kind), state.schedule_chunk_size);
+			#endif
+
+			numa_topology::get_singleton().restore_openmp_threads(state.thread_cpu_list);
+		}
+
+		void plain_running_configuration::reset_openmp_schedule(const openmp_state& state) const
+		{
+			#if defined(_OPENMP) && (_OPENMP >= 200805)
+			if (numa_aware)
+				omp_set_schedule(omp_sched_static, 0);
+			else if (getenv("OMP_SCHEDULE") == 0)
+				omp_set_schedule(omp_sched_guided, 0);
+			else
+				omp_set_schedule(static_cast<omp_sched_t>(state.schedule_kind), state.schedule_chunk_size);
+			#endif
+		}
+
+		void plain_running_configuration::first_touch(
+			void * buf,
+			size_t size) const
+		{
+			if (numa_aware)
+				numa_topology::get_singleton().first_touch(buf, size, openmp_thread_count);
+		}
+
 		std::ostream& operator<< (std::ostream& out, const plain_running_configuration& running_configuration)
 		{
 			out << "--- Configuration ---" << std::endl;
@@ -61,6 +130,10 @@ namespace nnforge
 
 			out << "Max memory usage = " << running_configuration.max_memory_usage_gigabytes << " GB" << std::endl;
 			out << "OpenMP thread count = " << running_configuration.openmp_thread_count << std::endl;
+			out << "Parallel branches = " << running_configuration.parallel_branches << std::endl;
+			out << "Recompute activations = " << running_configuration.recompute_activations << std::endl;
+			out << "BF16 activations = " << running_configuration.bf16_activations << std::endl;
+			out << "NUMA aware = " << running_configuration.numa_aware << " (" << numa_topology::get_singleton().get_node_count() << " nodes)" << std::endl;
 
 			return out;
 		}
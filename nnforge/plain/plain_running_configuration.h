@@ -21,6 +21,7 @@
 #include "buffer_plain_size_configuration.h"
 
 #include <memory>
+#include <vector>
 
 namespace nnforge
 {
@@ -31,16 +32,57 @@ namespace nnforge
 		public:
 			typedef std::shared_ptr<const plain_running_configuration> const_ptr;
 
+			// OpenMP settings changed by setup_openmp, to be put back by restore_openmp
+			struct openmp_state
+			{
+				openmp_state();
+
+				int schedule_kind;
+				int schedule_chunk_size;
+				std::vector<std::vector<int> > thread_cpu_list;
+			};
+
+			// Optional modes of the backend, all of them are off by default
+			struct mode_settings
+			{
+				mode_settings();
+
+				bool parallel_branches;
+				bool recompute_activations;
+				bool bf16_activations;
+				bool numa_aware;
+			};
+
 			plain_running_configuration(
 				int openmp_thread_count,
-				float max_memory_usage_gigabytes);
+				float max_memory_usage_gigabytes,
+				const mode_settings& modes = mode_settings());
 
 			unsigned int get_max_entry_count(
 				const buffer_plain_size_configuration& buffers_config,
 				float ratio = 1.0F) const;
 
+			// Should be called by the thread running the propagation before running kernels, the result is passed to restore_openmp when done.
+			// Kernel loops use schedule(runtime): static in NUMA mode, to match the placement done by first_touch,
+			// otherwise the one set with OMP_SCHEDULE is kept, guided is used if the variable is not set
+			openmp_state setup_openmp() const;
+
+			void restore_openmp(const openmp_state& state) const;
+
+			// Restores the schedule set by setup_openmp for kernel loops after it was changed for specific kernels
+			void reset_openmp_schedule(const openmp_state& state) const;
+
+			// Places buffer pages on the NUMA nodes of the threads which will process them, no-op if NUMA mode is off
+			void first_touch(
+				void * buf,
+				size_t size) const;
+
 			float max_memory_usage_gigabytes;
 			int openmp_thread_count;
+			bool parallel_branches;
+			bool recompute_activations;
+			bool bf16_activations;
+			bool numa_aware;
 
 		private:
 			plain_running_configuration() = delete;
@@ -0,0 +1,163 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "prefix_sum_kernel.h"
+
+#include "../neural_network_exception.h"
+
+#include <vector>
+#include <algorithm>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace nnforge
+{
+	namespace plain
+	{
+		void prefix_sum_kernel::run(
+			float * output,
+			const float * input,
+			const layer_configuration_specific& configuration_specific,
+			unsigned int feature_map_segment_length,
+			bool reverse,
+			bool clamp,
+			float clamp_min,
+			float clamp_max,
+			bool add_update_to_destination,
+			unsigned int entry_count,
+			plain_running_configuration::const_ptr plain_config)
+		{
+			if (clamp && add_update_to_destination)
+				throw neural_network_exception("prefix_sum_kernel cannot clamp and add update to destination at the same time");
+
+			const int neuron_count = configuration_specific.get_neuron_count();
+			const int neuron_count_per_feature_map = configuration_specific.get_neuron_count_per_feature_map();
+			const int segment_length = feature_map_segment_length;
+			const int feature_map_segment_count = configuration_specific.feature_map_count / feature_map_segment_length;
+			const int total_workload = entry_count * feature_map_segment_count;
+			const int openmp_thread_count = plain_config->openmp_thread_count;
+			// Rows are visited from the first feature map of the segment to the last one, or the other way round
+			const int row_stride = reverse ? -neuron_count_per_feature_map : neuron_count_per_feature_map;
+			const int first_row_offset = reverse ? (segment_length - 1) * neuron_count_per_feature_map : 0;
+
+			if ((total_workload >= openmp_thread_count) || (segment_length < openmp_thread_count * 2))
+			{
+				#pragma omp parallel default(none) num_threads(openmp_thread_count) shared(output,input,clamp,clamp_min,clamp_max,add_update_to_destination)
+				{
+					std::vector<float> running_sum(neuron_count_per_feature_map);
+
+					#pragma omp for schedule(runtime)
+					for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+					{
+						int entry_id = workload_id / feature_map_segment_count;
+						int feature_map_segment_id = workload_id - entry_id * feature_map_segment_count;
+						int offset = entry_id * neuron_count + feature_map_segment_id * segment_length * neuron_count_per_feature_map + first_row_offset;
+
+						std::fill(running_sum.begin(), running_sum.end(), 0.0F);
+						scan_chunk(output + offset, input + offset, &running_sum[0], segment_length, row_stride, neuron_count_per_feature_map, clamp, clamp_min, clamp_max, add_update_to_destination);
+					}
+				}
+			}
+			else
+			{
+				// Few long segments: split each of them among threads
+				std::vector<float> chunk_sums(openmp_thread_count * neuron_count_per_feature_map);
+
+				#pragma omp parallel default(none) num_threads(openmp_thread_count) shared(output,input,clamp,clamp_min,clamp_max,add_update_to_destination,chunk_sums)
+				{
+					int thread_id = 0;
+					int thread_count = 1;
+					#ifdef _OPENMP
+					thread_id = omp_get_thread_num();
+					thread_count = omp_get_num_threads();
+					#endif
+					const int chunk_begin = segment_length * thread_id / thread_count;
+					const int chunk_end = segment_length * (thread_id + 1) / thread_count;
+					float * const thread_chunk_sum = &chunk_sums[thread_id * neuron_count_per_feature_map];
+					std::vector<float> running_sum(neuron_count_per_feature_map);
+
+					for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+					{
+						int entry_id = workload_id / feature_map_segment_count;
+						int feature_map_segment_id = workload_id - entry_id * feature_map_segment_count;
+						int offset = entry_id * neuron_count + feature_map_segment_id * segment_length * neuron_count_per_feature_map + first_row_offset + chunk_begin * row_stride;
+
+						// Phase 1: sum of the chunk
+						std::fill(thread_chunk_sum, thread_chunk_sum + neuron_count_per_feature_map, 0.0F);
+						const float * in_row = input + offset;
+						for(int i = chunk_begin; i < chunk_end; ++i, in_row += row_stride)
+							for(int x = 0; x < neuron_count_per_feature_map; ++x)
+								thread_chunk_sum[x] += in_row[x];
+
+						#pragma omp barrier
+
+						// Phase 2: the chunk starts from the sum of all the preceding chunks
+						std::fill(running_sum.begin(), running_sum.end(), 0.0F);
+						for(int preceding_thread_id = 0; preceding_thread_id < thread_id; ++preceding_thread_id)
+						{
+							const float * preceding_chunk_sum = &chunk_sums[preceding_thread_id * neuron_count_per_feature_map];
+							for(int x = 0; x < neuron_count_per_feature_map; ++x)
+								running_sum[x] += preceding_chunk_sum[x];
+						}
+
+						// Phase 3
+						scan_chunk(output + offset, input + offset, &running_sum[0], chunk_end - chunk_begin, row_stride, neuron_count_per_feature_map, clamp, clamp_min, clamp_max, add_update_to_destination);
+
+						// Chunk sums are overwritten by the next segment
+						#pragma omp barrier
+					}
+				}
+			}
+		}
+
+		void prefix_sum_kernel::scan_chunk(
+			float * output,
+			const float * input,
+			float * running_sum,
+			int row_count,
+			int row_stride,
+			int neuron_count_per_feature_map,
+			bool clamp,
+			float clamp_min,
+			float clamp_max,
+			bool add_update_to_destination)
+		{
+			for(int i = 0; i < row_count; ++i, input += row_stride, output += row_stride)
+			{
+				for(int x = 0; x < neuron_count_per_feature_map; ++x)
+					running_sum[x] += input[x];
+
+				if (clamp)
+				{
+					for(int x = 0; x < neuron_count_per_feature_map; ++x)
+						output[x] = std::min(std::max(running_sum[x], clamp_min), clamp_max);
+				}
+				else if (add_update_to_destination)
+				{
+					for(int x = 0; x < neuron_count_per_feature_map; ++x)
+						output[x] += running_sum[x];
+				}
+				else
+				{
+					for(int x = 0; x < neuron_count_per_feature_map; ++x)
+						output[x] = running_sum[x];
+				}
+			}
+		}
+	}
+}
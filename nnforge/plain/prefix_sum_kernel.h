@@ -0,0 +1,67 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "plain_running_configuration.h"
+#include "../layer_configuration_specific.h"
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Inclusive prefix sum along feature maps within segments of feature_map_segment_length consecutive feature maps.
+		// All loops run over whole feature maps, which are contiguous, and get vectorized by the compiler.
+		// When there are fewer segments (across all entries) than threads each segment is split into one chunk per thread and scanned in 3 phases:
+		// chunk sums, exclusive scan of chunk sums, rescan of each chunk starting from its offset.
+		// Each phase touches the chunk owned by the thread only, so output might be the same as input
+		class prefix_sum_kernel
+		{
+		public:
+			// reverse: scan from the last feature map of the segment down to the first one, as required by backward propagation.
+			// When clamp is set the output is clamped to [clamp_min, clamp_max], the running sum isn't.
+			// add_update_to_destination and clamp cannot be set at the same time
+			static void run(
+				float * output,
+				const float * input,
+				const layer_configuration_specific& configuration_specific,
+				unsigned int feature_map_segment_length,
+				bool reverse,
+				bool clamp,
+				float clamp_min,
+				float clamp_max,
+				bool add_update_to_destination,
+				unsigned int entry_count,
+				plain_running_configuration::const_ptr plain_config);
+
+		private:
+			static void scan_chunk(
+				float * output,
+				const float * input,
+				float * running_sum,
+				int row_count,
+				int row_stride,
+				int neuron_count_per_feature_map,
+				bool clamp,
+				float clamp_min,
+				float clamp_max,
+				bool add_update_to_destination);
+
+		private:
+			prefix_sum_kernel() = delete;
+		};
+	}
+}
@@ -16,6 +16,7 @@
 
 #include "prefix_sum_layer_updater_plain.h"
 
+#include "prefix_sum_kernel.h"
 #include "../prefix_sum_layer.h"
 
 #include <cstring>
@@ -44,37 +45,20 @@ namespace nnforge
 			const std::set<layer_action>& actions,
 			unsigned int entry_count) const
 		{
-			const float * const in_it_global = *input_buffers[0];
-			float * const out_it_global = *output_buffer;
-			const unsigned int neuron_count = output_configuration_specific.get_neuron_count();
 			std::shared_ptr<const prefix_sum_layer> layer_derived = std::dynamic_pointer_cast<const prefix_sum_layer>(layer_schema);
-			const unsigned int feature_map_segment_length = layer_derived->feature_map_segment_length;
-			const unsigned int feature_map_segment_count = output_configuration_specific.feature_map_count / feature_map_segment_length;
-			const unsigned int neuron_count_per_feature_map = output_configuration_specific.get_neuron_count_per_feature_map();
-			const float clamp_min = layer_derived->clamp_min;
-			const float clamp_max = layer_derived->clamp_max;
-			const int total_workload = entry_count * feature_map_segment_count * neuron_count_per_feature_map;
 
-			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count)
-			{
-				#pragma omp for schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
-				{
-					int entry_id = workload_id / (feature_map_segment_count * neuron_count_per_feature_map);
-					int tt = workload_id - entry_id * feature_map_segment_count * neuron_count_per_feature_map;
-					int feature_map_segment_id = tt / neuron_count_per_feature_map;
-					int neuron_id = tt - feature_map_segment_id * neuron_count_per_feature_map;
-
-					int offset = entry_id * neuron_count + feature_map_segment_id * feature_map_segment_length * neuron_count_per_feature_map + neuron_id;
-
-					float running_sum = 0.0F;
-					for(unsigned int i = 0; i < feature_map_segment_length; ++i, offset += neuron_count_per_feature_map)
-					{
-						running_sum += in_it_global[offset];
-						out_it_global[offset] = std::min(std::max(running_sum, clamp_min), clamp_max);
-					}
-				}
-			}
+			prefix_sum_kernel::run(
+				*output_buffer,
+				*input_buffers[0],
+				output_configuration_specific,
+				layer_derived->feature_map_segment_length,
+				false,
+				true,
+				layer_derived->clamp_min,
+				layer_derived->clamp_max,
+				false,
+				entry_count,
+				plain_config);
 		}
 
 		void prefix_sum_layer_updater_plain::run_backward_data_propagation(
@@ -96,37 +80,20 @@ namespace nnforge
 			const std::set<layer_action>& actions,
 			unsigned int entry_count) const
 		{
-			float * const in_err_it_global = *input_errors_buffer;
-			const float * const out_err_it_global = *output_errors_buffer;
-			const unsigned int neuron_count = output_configuration_specific.get_neuron_count();
 			std::shared_ptr<const prefix_sum_layer> layer_derived = std::dynamic_pointer_cast<const prefix_sum_layer>(layer_schema);
-			const unsigned int feature_map_segment_length = layer_derived->feature_map_segment_length;
-			const unsigned int feature_map_segment_count = output_configuration_specific.feature_map_count / feature_map_segment_length;
-			const unsigned int neuron_count_per_feature_map = output_configuration_specific.get_neuron_count_per_feature_map();
-			const float clamp_min = layer_derived->clamp_min;
-			const float clamp_max = layer_derived->clamp_max;
-			const int total_workload = entry_count * feature_map_segment_count * neuron_count_per_feature_map;
-
-			#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count)
-			{
-				#pragma omp for schedule(guided)
-				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
-				{
-					int entry_id = workload_id / (feature_map_segment_count * neuron_count_per_feature_map);
-					int tt = workload_id - entry_id * feature_map_segment_count * neuron_count_per_feature_map;
-					int feature_map_segment_id = tt / neuron_count_per_feature_map;
-					int neuron_id = tt - feature_map_segment_id * neuron_count_per_feature_map;
-
-					int offset = entry_id * neuron_count + (feature_map_segment_id * feature_map_segment_length + feature_map_segment_length - 1) * neuron_count_per_feature_map + neuron_id;
 
-					float running_sum = 0.0F;
-					for(unsigned int i = 0; i < feature_map_segment_length; ++i, offset -= neuron_count_per_feature_map)
-					{
-						running_sum += out_err_it_global[offset];
-						in_err_it_global[offset] = running_sum;
-					}
-				}
-			}
+			prefix_sum_kernel::run(
+				*input_errors_buffer,
+				*output_errors_buffer,
+				output_configuration_specific,
+				layer_derived->feature_map_segment_length,
+				true,
+				false,
+				0.0F,
+				0.0F,
+				add_update_to_destination,
+				entry_count,
+				plain_config);
 		}
 
 		int prefix_sum_layer_updater_plain::get_input_index_layer_can_write(
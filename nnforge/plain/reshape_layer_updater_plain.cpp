@@ -76,7 +76,7 @@ namespace nnforge
 			{
 				#pragma omp parallel default(none) num_threads(plain_config->openmp_thread_count)
 				{
-					#pragma omp for schedule(guided)
+					#pragma omp for schedule(runtime)
 					for(int workload_id = 0; workload_id < elem_count; ++workload_id)
 					{
 						int elem_id = workload_id;
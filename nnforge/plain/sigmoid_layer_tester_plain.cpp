@@ -16,6 +16,7 @@
 
 #include "sigmoid_layer_tester_plain.h"
 
+#include "vector_math.h"
 #include "../sigmoid_layer.h"
 
 namespace nnforge
@@ -44,11 +45,11 @@ namespace nnforge
 			float * const out_it = *output_buffer;
 			const float * const in_it = *input_buffers[0];
 
-			#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
+			#pragma omp parallel for default(none) schedule(runtime) num_threads(plain_config->openmp_thread_count)
 			for(int i = 0; i < elem_count; ++i)
 			{
 				float inp = *(in_it + i);
-				float res = 1.0F / (expf(-inp) + 1.0F);
+				float res = vector_math::sigmoid(inp);
 				*(out_it + i) = res;
 			}
 		}
@@ -16,6 +16,7 @@
 
 #include "softmax_layer_tester_plain.h"
 
+#include "vector_math.h"
 #ifdef _OPENMP
 #include <omp.h>
 #endif
@@ -61,7 +62,7 @@ namespace nnforge
 				thread_id = omp_get_thread_num();
 				#endif
 
-				#pragma omp for schedule(guided)
+				#pragma omp for schedule(runtime)
 				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
 				{
 					int entry_id = workload_id / neuron_count_per_feature_map;
@@ -79,7 +80,7 @@ namespace nnforge
 					float sum = 0.0F;
 					for(unsigned int feature_map_id = 0; feature_map_id < feature_map_count; ++feature_map_id)
 					{
-						float val = expf((*(in_it + (feature_map_id * neuron_count_per_feature_map))) - max_val);
+						float val = vector_math::exp((*(in_it + (feature_map_id * neuron_count_per_feature_map))) - max_val);
 						sum += val;
 						*(out_it + (feature_map_id * neuron_count_per_feature_map)) = val;
 					}
@@ -16,6 +16,7 @@
 
 #include "softmax_layer_updater_plain.h"
 
+#include "vector_math.h"
 #ifdef _OPENMP
 #include <omp.h>
 #endif
@@ -66,7 +67,7 @@ namespace nnforge
 
 				float * local_additional_buffer = working_buffer_it + thread_id * feature_map_count;
 
-				#pragma omp for schedule(guided)
+				#pragma omp for schedule(runtime)
 				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
 				{
 					int entry_id = workload_id / neuron_count_per_feature_map;
@@ -85,7 +86,7 @@ namespace nnforge
 					float sum = 0.0F;
 					for(unsigned int feature_map_id = 0; feature_map_id < feature_map_count; ++feature_map_id)
 					{
-						float val = expf((*(in_it + (feature_map_id * neuron_count_per_feature_map))) - max_val);
+						float val = vector_math::exp((*(in_it + (feature_map_id * neuron_count_per_feature_map))) - max_val);
 						sum += val;
 						local_additional_buffer[feature_map_id] = val;
 					}
@@ -128,7 +129,7 @@ namespace nnforge
 			
 			#pragma omp parallel default(none) num_threads(openmp_thread_count)
 			{
-				#pragma omp for schedule(guided)
+				#pragma omp for schedule(runtime)
 				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
 				{
 					int entry_id = workload_id / neuron_count_per_feature_map;
@@ -0,0 +1,352 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "sparse_convolution_2d_engine.h"
+
+#include <algorithm>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace nnforge
+{
+	namespace plain
+	{
+		bool sparse_convolution_2d_engine::is_supported(const sparse_convolution_layer& layer_schema)
+		{
+			return (layer_schema.window_sizes.size() == 1) || (layer_schema.window_sizes.size() == 2);
+		}
+
+		sparse_convolution_2d_engine::sparse_convolution_2d_engine(
+			const sparse_convolution_layer& layer_schema,
+			const layer_data_custom& data_custom,
+			const layer_configuration_specific& input_configuration_specific,
+			const layer_configuration_specific& output_configuration_specific)
+		{
+			const bool is_2d = (layer_schema.window_sizes.size() == 2);
+			input_width = input_configuration_specific.dimension_sizes[0];
+			input_height = is_2d ? input_configuration_specific.dimension_sizes[1] : 1;
+			output_width = output_configuration_specific.dimension_sizes[0];
+			output_height = is_2d ? output_configuration_specific.dimension_sizes[1] : 1;
+			window_width = layer_schema.window_sizes[0];
+			window_height = is_2d ? layer_schema.window_sizes[1] : 1;
+			stride_x = layer_schema.strides[0];
+			stride_y = is_2d ? layer_schema.strides[1] : 1;
+			left_padding_x = layer_schema.left_zero_padding[0];
+			left_padding_y = is_2d ? layer_schema.left_zero_padding[1] : 0;
+			input_feature_map_count = input_configuration_specific.feature_map_count;
+			output_feature_map_count = output_configuration_specific.feature_map_count;
+			weight_count = layer_schema.feature_map_connection_count * window_width * window_height;
+
+			const std::vector<int>& column_indices = data_custom[0];
+			const std::vector<int>& row_indices = data_custom[1];
+
+			// Transpose the connection matrix, weights are left in place
+			std::vector<std::vector<std::pair<int, int> > > in_fm_out_fm_weight_offset_list_list(input_feature_map_count);
+			for(int output_feature_map_id = 0; output_feature_map_id < output_feature_map_count; ++output_feature_map_id)
+				for(int column_index = row_indices[output_feature_map_id]; column_index < row_indices[output_feature_map_id + 1]; ++column_index)
+					in_fm_out_fm_weight_offset_list_list[column_indices[column_index]].push_back(std::make_pair(output_feature_map_id, column_index * window_width * window_height));
+
+			input_feature_map_block_offsets.push_back(0);
+			for(std::vector<std::vector<std::pair<int, int> > >::const_iterator it = in_fm_out_fm_weight_offset_list_list.begin(); it != in_fm_out_fm_weight_offset_list_list.end(); ++it)
+			{
+				for(std::vector<std::pair<int, int> >::const_iterator it2 = it->begin(); it2 != it->end(); it2 += std::min(static_cast<int>(it->end() - it2), static_cast<int>(block_size)))
+				{
+					connection_block new_block;
+					new_block.connection_count = std::min(static_cast<int>(it->end() - it2), static_cast<int>(block_size));
+					for(int i = 0; i < block_size; ++i)
+					{
+						new_block.output_feature_map_ids[i] = (i < new_block.connection_count) ? (it2 + i)->first : 0;
+						new_block.weight_offsets[i] = (i < new_block.connection_count) ? (it2 + i)->second : 0;
+					}
+					blocks.push_back(new_block);
+				}
+				input_feature_map_block_offsets.push_back(static_cast<int>(blocks.size()));
+			}
+
+			// Output x range for which the input x = x * stride_x - left_padding_x + window_x is within the input
+			for(int window_x = 0; window_x < window_width; ++window_x)
+			{
+				int x_begin = 0;
+				if (left_padding_x > window_x)
+					x_begin = (left_padding_x - window_x + stride_x - 1) / stride_x;
+				int x_end = 0;
+				if (input_width - 1 - window_x + left_padding_x >= 0)
+					x_end = std::min(output_width, (input_width - 1 - window_x + left_padding_x) / stride_x + 1);
+				window_x_begin_list.push_back(x_begin);
+				window_x_end_list.push_back(std::max(x_begin, x_end));
+			}
+		}
+
+		void sparse_convolution_2d_engine::run_forward_propagation(
+			float * output,
+			const float * input,
+			const float * weights,
+			const float * biases,
+			unsigned int entry_count,
+			plain_running_configuration::const_ptr plain_config) const
+		{
+			const int input_neuron_count_per_feature_map = input_width * input_height;
+			const int output_neuron_count_per_feature_map = output_width * output_height;
+			const int input_neuron_count = input_neuron_count_per_feature_map * input_feature_map_count;
+			const int output_neuron_count = output_neuron_count_per_feature_map * output_feature_map_count;
+			const int total_workload = entry_count * output_height;
+
+			#pragma omp parallel for default(none) schedule(runtime) num_threads(plain_config->openmp_thread_count) shared(output,input,weights,biases)
+			for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+			{
+				int entry_id = workload_id / output_height;
+				int output_y = workload_id - (entry_id * output_height);
+
+				float * out_base = output + entry_id * output_neuron_count + output_y * output_width;
+				for(int output_feature_map_id = 0; output_feature_map_id < output_feature_map_count; ++output_feature_map_id)
+					std::fill_n(out_base + output_feature_map_id * output_neuron_count_per_feature_map, output_width, biases ? biases[output_feature_map_id] : 0.0F);
+
+				for(int input_feature_map_id = 0; input_feature_map_id < input_feature_map_count; ++input_feature_map_id)
+				{
+					const float * in_fm_base = input + entry_id * input_neuron_count + input_feature_map_id * input_neuron_count_per_feature_map;
+					for(int window_y = 0; window_y < window_height; ++window_y)
+					{
+						int input_y = output_y * stride_y - left_padding_y + window_y;
+						if ((input_y < 0) || (input_y >= input_height))
+							continue;
+						const float * in_row = in_fm_base + input_y * input_width;
+
+						for(int block_id = input_feature_map_block_offsets[input_feature_map_id]; block_id < input_feature_map_block_offsets[input_feature_map_id + 1]; ++block_id)
+						{
+							const connection_block& block = blocks[block_id];
+							for(int window_x = 0; window_x < window_width; ++window_x)
+							{
+								const int x_begin = window_x_begin_list[window_x];
+								const int x_end = window_x_end_list[window_x];
+								const int in_offset = window_x - left_padding_x;
+								const int weight_id = window_y * window_width + window_x;
+								if (block.connection_count == block_size)
+								{
+									const float w0 = weights[block.weight_offsets[0] + weight_id];
+									const float w1 = weights[block.weight_offsets[1] + weight_id];
+									const float w2 = weights[block.weight_offsets[2] + weight_id];
+									const float w3 = weights[block.weight_offsets[3] + weight_id];
+									float * out0 = out_base + block.output_feature_map_ids[0] * output_neuron_count_per_feature_map;
+									float * out1 = out_base + block.output_feature_map_ids[1] * output_neuron_count_per_feature_map;
+									float * out2 = out_base + block.output_feature_map_ids[2] * output_neuron_count_per_feature_map;
+									float * out3 = out_base + block.output_feature_map_ids[3] * output_neuron_count_per_feature_map;
+									for(int x = x_begin; x < x_end; ++x)
+									{
+										float in_val = in_row[x * stride_x + in_offset];
+										out0[x] += w0 * in_val;
+										out1[x] += w1 * in_val;
+										out2[x] += w2 * in_val;
+										out3[x] += w3 * in_val;
+									}
+								}
+								else
+								{
+									for(int i = 0; i < block.connection_count; ++i)
+									{
+										const float w = weights[block.weight_offsets[i] + weight_id];
+										float * out = out_base + block.output_feature_map_ids[i] * output_neuron_count_per_feature_map;
+										for(int x = x_begin; x < x_end; ++x)
+											out[x] += w * in_row[x * stride_x + in_offset];
+									}
+								}
+							}
+						}
+					}
+				}
+			}
+		}
+
+		void sparse_convolution_2d_engine::run_backward_data_propagation(
+			float * input_errors,
+			const float * output_errors,
+			const float * weights,
+			bool add_update_to_destination,
+			unsigned int entry_count,
+			plain_running_configuration::const_ptr plain_config) const
+		{
+			const int input_neuron_count_per_feature_map = input_width * input_height;
+			const int output_neuron_count_per_feature_map = output_width * output_height;
+			const int input_neuron_count = input_neuron_count_per_feature_map * input_feature_map_count;
+			const int output_neuron_count = output_neuron_count_per_feature_map * output_feature_map_count;
+			const int total_workload = entry_count * input_feature_map_count;
+
+			#pragma omp parallel for default(none) schedule(runtime) num_threads(plain_config->openmp_thread_count) shared(input_errors,output_errors,weights,add_update_to_destination)
+			for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+			{
+				int entry_id = workload_id / input_feature_map_count;
+				int input_feature_map_id = workload_id - (entry_id * input_feature_map_count);
+
+				float * in_err_fm_base = input_errors + entry_id * input_neuron_count + input_feature_map_id * input_neuron_count_per_feature_map;
+				const float * out_err_entry_base = output_errors + entry_id * output_neuron_count;
+				if (!add_update_to_destination)
+					std::fill_n(in_err_fm_base, input_neuron_count_per_feature_map, 0.0F);
+
+				for(int output_y = 0; output_y < output_height; ++output_y)
+				{
+					const float * out_err_base = out_err_entry_base + output_y * output_width;
+					for(int window_y = 0; window_y < window_height; ++window_y)
+					{
+						int input_y = output_y * stride_y - left_padding_y + window_y;
+						if ((input_y < 0) || (input_y >= input_height))
+							continue;
+						float * in_err_row = in_err_fm_base + input_y * input_width;
+
+						for(int block_id = input_feature_map_block_offsets[input_feature_map_id]; block_id < input_feature_map_block_offsets[input_feature_map_id + 1]; ++block_id)
+						{
+							const connection_block& block = blocks[block_id];
+							for(int window_x = 0; window_x < window_width; ++window_x)
+							{
+								const int x_begin = window_x_begin_list[window_x];
+								const int x_end = window_x_end_list[window_x];
+								const int in_offset = window_x - left_padding_x;
+								const int weight_id = window_y * window_width + window_x;
+								if (block.connection_count == block_size)
+								{
+									const float w0 = weights[block.weight_offsets[0] + weight_id];
+									const float w1 = weights[block.weight_offsets[1] + weight_id];
+									const float w2 = weights[block.weight_offsets[2] + weight_id];
+									const float w3 = weights[block.weight_offsets[3] + weight_id];
+									const float * out_err0 = out_err_base + block.output_feature_map_ids[0] * output_neuron_count_per_feature_map;
+									const float * out_err1 = out_err_base + block.output_feature_map_ids[1] * output_neuron_count_per_feature_map;
+									const float * out_err2 = out_err_base + block.output_feature_map_ids[2] * output_neuron_count_per_feature_map;
+									const float * out_err3 = out_err_base + block.output_feature_map_ids[3] * output_neuron_count_per_feature_map;
+									for(int x = x_begin; x < x_end; ++x)
+										in_err_row[x * stride_x + in_offset] += w0 * out_err0[x] + w1 * out_err1[x] + w2 * out_err2[x] + w3 * out_err3[x];
+								}
+								else
+								{
+									for(int i = 0; i < block.connection_count; ++i)
+									{
+										const float w = weights[block.weight_offsets[i] + weight_id];
+										const float * out_err = out_err_base + block.output_feature_map_ids[i] * output_neuron_count_per_feature_map;
+										for(int x = x_begin; x < x_end; ++x)
+											in_err_row[x * stride_x + in_offset] += w * out_err[x];
+									}
+								}
+							}
+						}
+					}
+				}
+			}
+		}
+
+		void sparse_convolution_2d_engine::run_backward_weights_propagation(
+			float * gradient_weights,
+			const float * input,
+			const float * output_errors,
+			unsigned int entry_count,
+			plain_running_configuration::const_ptr plain_config) const
+		{
+			const int input_neuron_count_per_feature_map = input_width * input_height;
+			const int output_neuron_count_per_feature_map = output_width * output_height;
+			const int input_neuron_count = input_neuron_count_per_feature_map * input_feature_map_count;
+			const int output_neuron_count = output_neuron_count_per_feature_map * output_feature_map_count;
+			const int total_workload = entry_count * output_height;
+			const int thread_count = plain_config->openmp_thread_count;
+			std::vector<std::vector<float> > thread_gradient_weights_list(thread_count);
+
+			#pragma omp parallel default(none) num_threads(thread_count) shared(gradient_weights,input,output_errors,thread_gradient_weights_list)
+			{
+				int thread_id = 0;
+				#ifdef _OPENMP
+				thread_id = omp_get_thread_num();
+				#endif
+				std::vector<float>& thread_gradient_weights = thread_gradient_weights_list[thread_id];
+				thread_gradient_weights.resize(weight_count, 0.0F);
+				float * const gradient_weights_local = &thread_gradient_weights[0];
+
+				#pragma omp for schedule(runtime)
+				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
+				{
+					int entry_id = workload_id / output_height;
+					int output_y = workload_id - (entry_id * output_height);
+
+					const float * out_err_base = output_errors + entry_id * output_neuron_count + output_y * output_width;
+					for(int input_feature_map_id = 0; input_feature_map_id < input_feature_map_count; ++input_feature_map_id)
+					{
+						const float * in_fm_base = input + entry_id * input_neuron_count + input_feature_map_id * input_neuron_count_per_feature_map;
+						for(int window_y = 0; window_y < window_height; ++window_y)
+						{
+							int input_y = output_y * stride_y - left_padding_y + window_y;
+							if ((input_y < 0) || (input_y >= input_height))
+								continue;
+							const float * in_row = in_fm_base + input_y * input_width;
+
+							for(int block_id = input_feature_map_block_offsets[input_feature_map_id]; block_id < input_feature_map_block_offsets[input_feature_map_id + 1]; ++block_id)
+							{
+								const connection_block& block = blocks[block_id];
+								for(int window_x = 0; window_x < window_width; ++window_x)
+								{
+									const int x_begin = window_x_begin_list[window_x];
+									const int x_end = window_x_end_list[window_x];
+									const int in_offset = window_x - left_padding_x;
+									const int weight_id = window_y * window_width + window_x;
+									if (block.connection_count == block_size)
+									{
+										const float * out_err0 = out_err_base + block.output_feature_map_ids[0] * output_neuron_count_per_feature_map;
+										const float * out_err1 = out_err_base + block.output_feature_map_ids[1] * output_neuron_count_per_feature_map;
+										const float * out_err2 = out_err_base + block.output_feature_map_ids[2] * output_neuron_count_per_feature_map;
+										const float * out_err3 = out_err_base + block.output_feature_map_ids[3] * output_neuron_count_per_feature_map;
+										float sum0 = 0.0F;
+										float sum1 = 0.0F;
+										float sum2 = 0.0F;
+										float sum3 = 0.0F;
+										for(int x = x_begin; x < x_end; ++x)
+										{
+											float in_val = in_row[x * stride_x + in_offset];
+											sum0 += in_val * out_err0[x];
+											sum1 += in_val * out_err1[x];
+											sum2 += in_val * out_err2[x];
+											sum3 += in_val * out_err3[x];
+										}
+										gradient_weights_local[block.weight_offsets[0] + weight_id] += sum0;
+										gradient_weights_local[block.weight_offsets[1] + weight_id] += sum1;
+										gradient_weights_local[block.weight_offsets[2] + weight_id] += sum2;
+										gradient_weights_local[block.weight_offsets[3] + weight_id] += sum3;
+									}
+									else
+									{
+										for(int i = 0; i < block.connection_count; ++i)
+										{
+											const float * out_err = out_err_base + block.output_feature_map_ids[i] * output_neuron_count_per_feature_map;
+											float sum = 0.0F;
+											for(int x = x_begin; x < x_end; ++x)
+												sum += in_row[x * stride_x + in_offset] * out_err[x];
+											gradient_weights_local[block.weight_offsets[i] + weight_id] += sum;
+										}
+									}
+								}
+							}
+						}
+					}
+				}
+
+				// Implicit barrier at the end of the loop above guarantees all the thread copies are complete
+				#pragma omp for schedule(static)
+				for(int weight_id = 0; weight_id < weight_count; ++weight_id)
+				{
+					float sum = 0.0F;
+					for(std::vector<std::vector<float> >::const_iterator it = thread_gradient_weights_list.begin(); it != thread_gradient_weights_list.end(); ++it)
+						if (!it->empty())
+							sum += (*it)[weight_id];
+					gradient_weights[weight_id] += sum;
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,100 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "plain_running_configuration.h"
+#include "../sparse_convolution_layer.h"
+#include "../layer_data_custom.h"
+#include "../layer_configuration_specific.h"
+
+#include <vector>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Row-wise engine for 1D and 2D sparse convolutions.
+		// Connections are regrouped by input feature map into blocks of up to block_size output feature maps (CSR by input feature map),
+		// so each input row is loaded once for all output feature maps connected to it and each loaded value is used block_size times.
+		// The innermost loops run over output positions of the row and get vectorized by the compiler
+		class sparse_convolution_2d_engine
+		{
+		public:
+			static bool is_supported(const sparse_convolution_layer& layer_schema);
+
+			sparse_convolution_2d_engine(
+				const sparse_convolution_layer& layer_schema,
+				const layer_data_custom& data_custom,
+				const layer_configuration_specific& input_configuration_specific,
+				const layer_configuration_specific& output_configuration_specific);
+
+			void run_forward_propagation(
+				float * output,
+				const float * input,
+				const float * weights,
+				const float * biases,
+				unsigned int entry_count,
+				plain_running_configuration::const_ptr plain_config) const;
+
+			void run_backward_data_propagation(
+				float * input_errors,
+				const float * output_errors,
+				const float * weights,
+				bool add_update_to_destination,
+				unsigned int entry_count,
+				plain_running_configuration::const_ptr plain_config) const;
+
+			// Each thread accumulates into its own copy of weight gradients, copies are summed up into gradient_weights at the end
+			void run_backward_weights_propagation(
+				float * gradient_weights,
+				const float * input,
+				const float * output_errors,
+				unsigned int entry_count,
+				plain_running_configuration::const_ptr plain_config) const;
+
+		private:
+			static const int block_size = 4;
+
+			struct connection_block
+			{
+				int connection_count;
+				int output_feature_map_ids[block_size];
+				int weight_offsets[block_size];
+			};
+
+		private:
+			std::vector<connection_block> blocks;
+			std::vector<int> input_feature_map_block_offsets;
+			std::vector<int> window_x_begin_list;
+			std::vector<int> window_x_end_list;
+
+			int input_width;
+			int input_height;
+			int output_width;
+			int output_height;
+			int window_width;
+			int window_height;
+			int stride_x;
+			int stride_y;
+			int left_padding_x;
+			int left_padding_y;
+			int input_feature_map_count;
+			int output_feature_map_count;
+			int weight_count;
+		};
+	}
+}
@@ -16,6 +16,7 @@
 
 #include "sparse_convolution_layer_tester_plain.h"
 
+#include "sparse_convolution_2d_engine.h"
 #include "../sparse_convolution_layer.h"
 
 #include <array>
@@ -54,6 +55,13 @@ namespace nnforge
 
 			const bool bias = layer_derived->bias;
 
+			if (sparse_convolution_2d_engine::is_supported(*layer_derived))
+			{
+				sparse_convolution_2d_engine engine(*layer_derived, *data_custom, input_configuration_specific_list[0], output_configuration_specific);
+				engine.run_forward_propagation(out_it_global, in_it_global, &(*data)[0][0], bias ? &(*data)[1][0] : 0, entry_count, plain_config);
+				return;
+			}
+
 			std::vector<unsigned int> window_sizes_extended = layer_derived->window_sizes;
 			window_sizes_extended.resize(max_dimension_count, 1);
 			const std::vector<unsigned int>& window_sizes = window_sizes_extended;
@@ -84,7 +92,7 @@ namespace nnforge
 				window_elem_count *= window_sizes[i];
 			const unsigned int const_window_elem_count = window_elem_count;
 
-			const std::vector<float>::const_iterator weights = (*data)[0].begin();
+			const layer_data_part::const_iterator weights = (*data)[0].begin();
 			const float * const biases = bias ? &(*data)[1][0] : 0;
 
 			const std::vector<int>::const_iterator column_indices = (*data_custom)[0].begin();
@@ -121,7 +129,7 @@ namespace nnforge
 				std::array<unsigned int, max_dimension_count> current_output_position;
 				std::array<int, max_dimension_count> current_input_position;
 
-				#pragma omp for schedule(guided)
+				#pragma omp for schedule(runtime)
 				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
 				{
 					int entry_id = workload_id / output_feature_map_count;
@@ -138,7 +146,7 @@ namespace nnforge
 					for(float * out_it = out_it_base; out_it != out_it_base + output_neuron_count_per_feature_map; ++out_it)
 					{
 						float sum = bias ? *(biases + output_feature_map_id) : 0.0F;
-						std::vector<float>::const_iterator weights_it = weights + start_column_index * const_window_elem_count;
+						layer_data_part::const_iterator weights_it = weights + start_column_index * const_window_elem_count;
 
 						int in_it_offset2 = 0;
 
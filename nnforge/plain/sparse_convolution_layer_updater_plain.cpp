@@ -16,6 +16,7 @@
 
 #include "sparse_convolution_layer_updater_plain.h"
 
+#include "sparse_convolution_2d_engine.h"
 #include "../sparse_convolution_layer.h"
 
 #include <array>
@@ -56,6 +57,13 @@ namespace nnforge
 
 			const bool bias = layer_derived->bias;
 
+			if (sparse_convolution_2d_engine::is_supported(*layer_derived))
+			{
+				sparse_convolution_2d_engine engine(*layer_derived, *data_custom, input_configuration_specific_list[0], output_configuration_specific);
+				engine.run_forward_propagation(out_it_global, in_it_global, &(*data)[0][0], bias ? &(*data)[1][0] : 0, entry_count, plain_config);
+				return;
+			}
+
 			std::vector<unsigned int> window_sizes_extended = layer_derived->window_sizes;
 			window_sizes_extended.resize(max_dimension_count, 1);
 			const std::vector<unsigned int>& window_sizes = window_sizes_extended;
@@ -86,7 +94,7 @@ namespace nnforge
 				window_elem_count *= window_sizes[i];
 			const unsigned int const_window_elem_count = window_elem_count;
 
-			const std::vector<float>::const_iterator weights = (*data)[0].begin();
+			const layer_data_part::const_iterator weights = (*data)[0].begin();
 			const float * const biases = bias ? &(*data)[1][0] : 0;
 
 			const std::vector<int>::const_iterator column_indices = (*data_custom)[0].begin();
@@ -123,7 +131,7 @@ namespace nnforge
 				std::array<unsigned int, max_dimension_count> current_output_position;
 				std::array<int, max_dimension_count> current_input_position;
 
-				#pragma omp for schedule(guided)
+				#pragma omp for schedule(runtime)
 				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
 				{
 					int entry_id = workload_id / output_feature_map_count;
@@ -140,7 +148,7 @@ namespace nnforge
 					for(float * out_it = out_it_base; out_it != out_it_base + output_neuron_count_per_feature_map; ++out_it)
 					{
 						float sum = bias ? *(biases + output_feature_map_id) : 0.0F;
-						std::vector<float>::const_iterator weights_it = weights + start_column_index * const_window_elem_count;
+						layer_data_part::const_iterator weights_it = weights + start_column_index * const_window_elem_count;
 
 						int in_it_offset2 = 0;
 
@@ -220,6 +228,13 @@ namespace nnforge
 			const unsigned int output_neuron_count_per_feature_map = output_configuration_specific.get_neuron_count_per_feature_map();
 			std::shared_ptr<const sparse_convolution_layer> layer_derived = std::dynamic_pointer_cast<const sparse_convolution_layer>(layer_schema);
 
+			if (sparse_convolution_2d_engine::is_supported(*layer_derived))
+			{
+				sparse_convolution_2d_engine engine(*layer_derived, *data_custom, input_configuration_specific_list[0], output_configuration_specific);
+				engine.run_backward_data_propagation(in_err_it_global, out_err_it_global, &(*data)[0][0], add_update_to_destination, entry_count, plain_config);
+				return;
+			}
+
 			std::vector<unsigned int> window_sizes_extended = layer_derived->window_sizes;
 			window_sizes_extended.resize(max_dimension_count, 1);
 			const std::vector<unsigned int>& window_sizes = window_sizes_extended;
@@ -250,7 +265,7 @@ namespace nnforge
 				window_elem_count *= window_sizes[i];
 			const unsigned int const_window_elem_count = window_elem_count;
 
-			const std::vector<float>::const_iterator weights = (*data)[0].begin();
+			const layer_data_part::const_iterator weights = (*data)[0].begin();
 
 			const std::vector<int>::const_iterator column_indices = (*data_custom)[0].begin();
 			const std::vector<int>::const_iterator row_indices = (*data_custom)[1].begin();
@@ -299,7 +314,7 @@ namespace nnforge
 				std::array<unsigned int, max_dimension_count> current_output_position;
 				std::array<int, max_dimension_count> current_input_position;
 
-				#pragma omp for schedule(guided)
+				#pragma omp for schedule(runtime)
 				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
 				{
 					int entry_id = workload_id / input_feature_map_count;
@@ -330,7 +345,7 @@ namespace nnforge
 							int weight_block_id = it->second;
 
 							const float * out_err_it = out_err_it_base2 + (output_feature_map_id * output_neuron_count_per_feature_map);
-							std::vector<float>::const_iterator weights_it = weights + weight_block_id * const_window_elem_count;
+							layer_data_part::const_iterator weights_it = weights + weight_block_id * const_window_elem_count;
 							float current_err = *out_err_it;
 
 							int ind = 0;
@@ -396,6 +411,15 @@ namespace nnforge
 
 			const bool bias = layer_derived->bias;
 
+			if (sparse_convolution_2d_engine::is_supported(*layer_derived))
+			{
+				sparse_convolution_2d_engine engine(*layer_derived, *data_custom, input_configuration_specific_list[0], output_configuration_specific);
+				engine.run_backward_weights_propagation(&(*gradient)[0][0], in_it_global, out_err_it_global, entry_count, plain_config);
+				if (bias)
+					run_backward_bias_propagation(&(*gradient)[1][0], out_err_it_global, output_configuration_specific, entry_count, plain_config);
+				return;
+			}
+
 			std::vector<unsigned int> window_sizes_extended = layer_derived->window_sizes;
 			window_sizes_extended.resize(max_dimension_count, 1);
 			const std::vector<unsigned int>& window_sizes = window_sizes_extended;
@@ -428,7 +452,7 @@ namespace nnforge
 				window_elem_count *= window_sizes[i];
 			const unsigned int const_window_elem_count = window_elem_count;
 
-			const std::vector<float>::iterator gradient_weights = (*gradient)[0].begin();
+			const layer_data_part::iterator gradient_weights = (*gradient)[0].begin();
 
 			const std::vector<int>::const_iterator column_indices = (*data_custom)[0].begin();
 			const std::vector<int>::const_iterator row_indices = (*data_custom)[1].begin();
@@ -466,7 +490,6 @@ namespace nnforge
 				}
 			}
 
-			const unsigned int output_feature_map_count = output_configuration_specific.feature_map_count;
 			const unsigned int input_feature_map_count = input_configuration_specific_list[0].feature_map_count;
 			const int total_workload = feature_map_connection_count;
 			const int const_entry_count = entry_count;
@@ -482,7 +505,7 @@ namespace nnforge
 				std::array<int, max_dimension_count> current_input_position;
 				std::vector<float> weights_local(const_window_elem_count, 0.0F);
 
-				#pragma omp for schedule(guided)
+				#pragma omp for schedule(runtime)
 				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
 				{
 					int weight_block_id = workload_id;
@@ -544,35 +567,45 @@ namespace nnforge
 						}
 					}
 
-					std::vector<float>::iterator gradient_weights_it_base = gradient_weights + weight_block_id * const_window_elem_count;
+					layer_data_part::iterator gradient_weights_it_base = gradient_weights + weight_block_id * const_window_elem_count;
 					std::vector<float>::iterator weights_local_it = weights_local.begin();
-					for(std::vector<float>::iterator it = gradient_weights_it_base; it != gradient_weights_it_base + const_window_elem_count; ++it, ++weights_local_it)
+					for(layer_data_part::iterator it = gradient_weights_it_base; it != gradient_weights_it_base + const_window_elem_count; ++it, ++weights_local_it)
 						*it += *weights_local_it;
 				}
 			}
 
 			if (bias)
-			{
-				const std::vector<float>::iterator gradient_biases = (*gradient)[1].begin();
-				const int total_workload_bias = output_feature_map_count;
-				#pragma omp parallel for default(none) schedule(guided) num_threads(plain_config->openmp_thread_count)
-				for(int workload_id = 0; workload_id < total_workload_bias; ++workload_id)
-				{
-					int output_feature_map_id = workload_id;
+				run_backward_bias_propagation(&(*gradient)[1][0], out_err_it_global, output_configuration_specific, entry_count, plain_config);
+		}
 
-					float sum = 0.0F;
-					for(int entry_id = 0; entry_id < const_entry_count; ++entry_id)
-					{
-						float local_sum = 0.0F;
-						const float * out_err_it_base = out_err_it_global + (entry_id * output_neuron_count) + (output_feature_map_id * output_neuron_count_per_feature_map);
-						for(const float * out_err_it = out_err_it_base; out_err_it != out_err_it_base + output_neuron_count_per_feature_map; ++out_err_it)
-							local_sum += *out_err_it;
+		void sparse_convolution_layer_updater_plain::run_backward_bias_propagation(
+			float * gradient_biases,
+			const float * out_err_it_global,
+			const layer_configuration_specific& output_configuration_specific,
+			unsigned int entry_count,
+			plain_running_configuration::const_ptr plain_config)
+		{
+			const unsigned int output_neuron_count = output_configuration_specific.get_neuron_count();
+			const unsigned int output_neuron_count_per_feature_map = output_configuration_specific.get_neuron_count_per_feature_map();
+			const int total_workload_bias = output_configuration_specific.feature_map_count;
+			const int const_entry_count = entry_count;
+			#pragma omp parallel for default(none) schedule(runtime) num_threads(plain_config->openmp_thread_count) shared(gradient_biases,out_err_it_global)
+			for(int workload_id = 0; workload_id < total_workload_bias; ++workload_id)
+			{
+				int output_feature_map_id = workload_id;
 
-						sum += local_sum;
-					}
+				float sum = 0.0F;
+				for(int entry_id = 0; entry_id < const_entry_count; ++entry_id)
+				{
+					float local_sum = 0.0F;
+					const float * out_err_it_base = out_err_it_global + (entry_id * output_neuron_count) + (output_feature_map_id * output_neuron_count_per_feature_map);
+					for(const float * out_err_it = out_err_it_base; out_err_it != out_err_it_base + output_neuron_count_per_feature_map; ++out_err_it)
+						local_sum += *out_err_it;
 
-					*(gradient_biases + output_feature_map_id) += sum;
+					sum += local_sum;
 				}
+
+				*(gradient_biases + output_feature_map_id) += sum;
 			}
 		}
 
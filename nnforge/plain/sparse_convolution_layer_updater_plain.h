@@ -105,6 +105,14 @@ namespace nnforge
 				const std::vector<layer_configuration_specific>& input_configuration_specific_list,
 				const layer_configuration_specific& output_configuration_specific) const;
 
+		private:
+			static void run_backward_bias_propagation(
+				float * gradient_biases,
+				const float * out_err_it_global,
+				const layer_configuration_specific& output_configuration_specific,
+				unsigned int entry_count,
+				plain_running_configuration::const_ptr plain_config);
+
 		private:
 			static const int max_dimension_count;
 		};
@@ -0,0 +1,101 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Subsampling of a single 2D feature map with window and stride known at compile time.
+		// Each window element is applied to the whole output row at once, the compiler vectorizes these loops across output positions
+		template<unsigned int window_size, unsigned int stride>
+		class subsampling_2d_kernel
+		{
+		public:
+			// Inputs are clamped at zero when relu is set: max(relu(x)) = max(0, max(x))
+			static void run_max(
+				const float * in,
+				float * out,
+				unsigned int input_width,
+				unsigned int output_width,
+				unsigned int output_height,
+				bool relu)
+			{
+				for(unsigned int y = 0; y < output_height; ++y)
+				{
+					const float * in_row = in + y * stride * input_width;
+					float * out_row = out + y * output_width;
+
+					if (relu)
+					{
+						for(unsigned int x = 0; x < output_width; ++x)
+							out_row[x] = 0.0F;
+					}
+					else
+					{
+						for(unsigned int x = 0; x < output_width; ++x)
+							out_row[x] = in_row[x * stride];
+					}
+
+					for(unsigned int window_y = 0; window_y < window_size; ++window_y)
+					{
+						const float * in_window_row = in_row + window_y * input_width;
+						for(unsigned int window_x = 0; window_x < window_size; ++window_x)
+						{
+							for(unsigned int x = 0; x < output_width; ++x)
+							{
+								float new_val = in_window_row[x * stride + window_x];
+								out_row[x] = (out_row[x] < new_val) ? new_val : out_row[x];
+							}
+						}
+					}
+				}
+			}
+
+			static void run_average(
+				const float * in,
+				float * out,
+				unsigned int input_width,
+				unsigned int output_width,
+				unsigned int output_height,
+				float mult)
+			{
+				for(unsigned int y = 0; y < output_height; ++y)
+				{
+					const float * in_row = in + y * stride * input_width;
+					float * out_row = out + y * output_width;
+
+					for(unsigned int x = 0; x < output_width; ++x)
+						out_row[x] = 0.0F;
+
+					for(unsigned int window_y = 0; window_y < window_size; ++window_y)
+					{
+						const float * in_window_row = in_row + window_y * input_width;
+						for(unsigned int window_x = 0; window_x < window_size; ++window_x)
+						{
+							for(unsigned int x = 0; x < output_width; ++x)
+								out_row[x] += in_window_row[x * stride + window_x];
+						}
+					}
+
+					for(unsigned int x = 0; x < output_width; ++x)
+						out_row[x] *= mult;
+				}
+			}
+		};
+	}
+}
@@ -109,7 +109,7 @@ namespace nnforge
 			{
 				std::array<unsigned int, max_dimension_count> current_input_position;
 
-				#pragma omp for schedule(guided)
+				#pragma omp for schedule(runtime)
 				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
 				{
 					int input_entry_id = workload_id / input_feature_map_count;
@@ -225,7 +225,7 @@ namespace nnforge
 			{
 				std::array<unsigned int, max_dimension_count> current_input_position;
 
-				#pragma omp for schedule(guided)
+				#pragma omp for schedule(runtime)
 				for(int workload_id = 0; workload_id < total_workload; ++workload_id)
 				{
 					int input_entry_id = workload_id / input_feature_map_count;
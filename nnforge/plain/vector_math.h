@@ -0,0 +1,128 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <cstring>
+
+namespace nnforge
+{
+	namespace plain
+	{
+		// Polynomial approximations of transcendental functions.
+		// They are branch-free and don't call libm, so loops using them get vectorized by the compiler for the target instruction set.
+		// Relative error is below 1e-6 for log and below 4e-6 for exp and sigmoid, the latter grows with |x| when the compiler reassociates range reduction (-ffast-math).
+		// Absolute error of tanh is below 1e-6, relative one is large near 0.
+		// NaN is detected with integer compare, which -ffast-math cannot fold away, and passed through
+		class vector_math
+		{
+		public:
+			// Input is clamped to [-87.3, 88.7], so the result is a finite normal float for any input except NaN, infinities included
+			static inline float exp(float x)
+			{
+				// Conversion of NaN to int below is undefined, so NaN is replaced with 0 and restored at the end.
+				// Masks are used instead of selects, the latter keep the loop from being vectorized
+				int x_bits = to_bits(x);
+				int nan_mask = -static_cast<int>((x_bits & 0x7FFFFFFF) > 0x7F800000);
+				x = from_bits(x_bits & ~nan_mask);
+				x = (x < -87.3365F) ? -87.3365F : x;
+				x = (x > 88.7228F) ? 88.7228F : x;
+
+				// x = n * ln(2) + r, |r| <= ln(2) / 2
+				float fn = x * 1.44269504089F;
+				int n = static_cast<int>(fn + ((fn >= 0.0F) ? 0.5F : -0.5F));
+				fn = static_cast<float>(n);
+				float r = x - fn * 0.693359375F;
+				r = r + fn * 2.12194440e-4F;
+
+				float p = 1.9875691500e-4F;
+				p = p * r + 1.3981999507e-3F;
+				p = p * r + 8.3334519073e-3F;
+				p = p * r + 4.1665795894e-2F;
+				p = p * r + 1.6666665459e-1F;
+				p = p * r + 5.0000001201e-1F;
+				float res = p * r * r + r + 1.0F;
+
+				// Multiply by 2^n, n is in [-126, 128], 2^128 is split into 2 * 2^127.
+				// Factor 2 is added to the exponent of res with integer arithmetic, two float multiplications would be merged into overflowing one under -ffast-math
+				int n1 = (n > 127) ? 127 : n;
+				res = from_bits(to_bits(res) + (static_cast<int>(n > 127) << 23));
+				res *= from_bits((n1 + 127) << 23);
+				return from_bits((to_bits(res) & ~nan_mask) | (x_bits & nan_mask));
+			}
+
+			// Input should be a positive normal float, +Inf and NaN are passed through
+			static inline float log(float x)
+			{
+				int bits = to_bits(x);
+				int special_mask = -static_cast<int>((bits & 0x7FFFFFFF) >= 0x7F800000);
+				int e = (bits >> 23) - 126;
+				// Mantissa in [0.5, 1)
+				float m = from_bits((bits & 0x007FFFFF) | 0x3F000000);
+
+				bool small_m = (m < 0.707106781186547524F);
+				e = small_m ? (e - 1) : e;
+				m = (small_m ? (m + m) : m) - 1.0F;
+
+				float z = m * m;
+				float p = 7.0376836292e-2F;
+				p = p * m - 1.1514610310e-1F;
+				p = p * m + 1.1676998740e-1F;
+				p = p * m - 1.2420140846e-1F;
+				p = p * m + 1.4249322787e-1F;
+				p = p * m - 1.6668057665e-1F;
+				p = p * m + 2.0000714765e-1F;
+				p = p * m - 2.4999993993e-1F;
+				p = p * m + 3.3333331174e-1F;
+
+				float fe = static_cast<float>(e);
+				float y = m * z * p;
+				y += fe * -2.12194440e-4F;
+				y -= 0.5F * z;
+				float res = m + y + fe * 0.693359375F;
+				return from_bits((to_bits(res) & ~special_mask) | (bits & special_mask));
+			}
+
+			static inline float sigmoid(float x)
+			{
+				return 1.0F / (exp(-x) + 1.0F);
+			}
+
+			// 1 - 2 / (e^(2x) + 1). Under -ffast-math division is done with reciprocal, which is flushed to zero for large x,
+			// this would turn (e^(2x) - 1) / (e^(2x) + 1) into 0 rather than 1
+			static inline float tanh(float x)
+			{
+				float e2x = exp(x * 2.0F);
+				return 1.0F - 2.0F / (e2x + 1.0F);
+			}
+
+		private:
+			static inline int to_bits(float x)
+			{
+				int res;
+				std::memcpy(&res, &x, sizeof(res));
+				return res;
+			}
+
+			static inline float from_bits(int x)
+			{
+				float res;
+				std::memcpy(&res, &x, sizeof(res));
+				return res;
+			}
+		};
+	}
+}
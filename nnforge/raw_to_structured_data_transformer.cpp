@@ -22,4 +22,9 @@ namespace nnforge
 	{
 		return 1;
 	}
+
+	bool raw_to_structured_data_transformer::is_deterministic() const
+	{
+		return false;
+	}
 }
@@ -39,6 +39,9 @@ namespace nnforge
 
 		virtual unsigned int get_sample_count() const;
 
+		// The method should return true in case the output depends on raw data and sample_id only
+		virtual bool is_deterministic() const;
+
 	protected:
 		raw_to_structured_data_transformer() = default;
 
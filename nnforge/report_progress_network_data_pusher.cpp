@@ -47,9 +47,9 @@ namespace nnforge
 					const std::vector<float>& absolute_updates = it2->second;
 					for(int part_id = 0; part_id < layer_data->size(); ++part_id)
 					{
-						const std::vector<float>& weights = layer_data->at(part_id);
+						const layer_data_part& weights = layer_data->at(part_id);
 						double sum = 0.0;
-						for(std::vector<float>::const_iterator it = weights.begin(); it != weights.end(); ++it)
+						for(layer_data_part::const_iterator it = weights.begin(); it != weights.end(); ++it)
 							sum += static_cast<double>(fabsf(*it));
 						float avg_weight = static_cast<float>(sum) / static_cast<float>(weights.size());
 
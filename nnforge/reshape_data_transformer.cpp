@@ -47,4 +47,9 @@ namespace nnforge
 
 		return config;
 	}
+
+	bool reshape_data_transformer::is_deterministic() const
+	{
+		return true;
+	}
 }
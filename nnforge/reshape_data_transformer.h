@@ -35,6 +35,8 @@ namespace nnforge
 
 		virtual layer_configuration_specific get_transformed_configuration(const layer_configuration_specific& original_config) const;
 
+		virtual bool is_deterministic() const;
+
 	protected:
 		layer_configuration_specific config;
 	};
@@ -0,0 +1,236 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "shared_memory_allreducer.h"
+
+#include "neural_network_exception.h"
+
+#include <boost/format.hpp>
+#include <boost/interprocess/exceptions.hpp>
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <chrono>
+
+namespace nnforge
+{
+	const unsigned int shared_memory_allreducer::ready_magic = 0x6E6E4652;
+	const unsigned int shared_memory_allreducer::spin_count_before_sleep = 1000;
+
+	// Payload starts at cache line boundary
+	static const size_t header_size = 64;
+
+	shared_memory_allreducer::shared_memory_allreducer(
+		const std::string& name,
+		const std::string& run_id,
+		unsigned int worker_count,
+		unsigned int worker_rank,
+		float timeout_seconds,
+		unsigned int chunk_element_count)
+		: name(name + "_" + run_id)
+		, worker_count(worker_count)
+		, worker_rank(worker_rank)
+		, chunk_element_count(chunk_element_count)
+		, timeout_seconds(timeout_seconds)
+		, hdr(0)
+		, payload(0)
+	{
+		if (run_id.empty())
+			throw neural_network_exception((boost::format("Run ID for shared_memory_allreducer %1% should be specified, the same for all the workers and unique for each run") % name).str());
+		if (worker_count == 0)
+			throw neural_network_exception("Worker count for shared_memory_allreducer should be positive");
+		if (worker_rank >= worker_count)
+			throw neural_network_exception((boost::format("Worker rank %1% is out of range for %2% workers in shared_memory_allreducer") % worker_rank % worker_count).str());
+		if (chunk_element_count == 0)
+			throw neural_network_exception("Chunk element count for shared_memory_allreducer should be positive");
+
+		const boost::interprocess::offset_t segment_size = static_cast<boost::interprocess::offset_t>(header_size + static_cast<size_t>(worker_count + 1) * chunk_element_count * sizeof(float));
+
+		if (worker_rank == 0)
+		{
+			boost::interprocess::shared_memory_object::remove(this->name.c_str());
+			shm = boost::interprocess::shared_memory_object(boost::interprocess::create_only, this->name.c_str(), boost::interprocess::read_write);
+			shm.truncate(segment_size);
+			region = boost::interprocess::mapped_region(shm, boost::interprocess::read_write);
+
+			hdr = new (region.get_address()) header();
+			hdr->arrived_count.store(0, std::memory_order_relaxed);
+			hdr->generation.store(0, std::memory_order_relaxed);
+			hdr->worker_count = worker_count;
+			hdr->chunk_element_count = chunk_element_count;
+			hdr->ready.store(ready_magic, std::memory_order_release);
+		}
+		else
+		{
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			while (true)
+			{
+				try
+				{
+					shm = boost::interprocess::shared_memory_object(boost::interprocess::open_only, this->name.c_str(), boost::interprocess::read_write);
+					boost::interprocess::offset_t current_size;
+					if (shm.get_size(current_size) && (current_size == segment_size))
+						break;
+				}
+				catch (const boost::interprocess::interprocess_exception&)
+				{
+				}
+				check_timeout(start, "worker 0 to create the segment");
+				std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			}
+			region = boost::interprocess::mapped_region(shm, boost::interprocess::read_write);
+
+			hdr = static_cast<header *>(region.get_address());
+			while (hdr->ready.load(std::memory_order_acquire) != ready_magic)
+			{
+				check_timeout(start, "worker 0 to create the segment");
+				std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			}
+
+			if ((hdr->worker_count != worker_count) || (hdr->chunk_element_count != chunk_element_count))
+				throw neural_network_exception((boost::format("shared_memory_allreducer %1% is created for %2% workers and %3% elements per chunk, while %4% and %5% are requested")
+					% this->name % hdr->worker_count % hdr->chunk_element_count % worker_count % chunk_element_count).str());
+		}
+
+		payload = reinterpret_cast<float *>(static_cast<char *>(region.get_address()) + header_size);
+
+		// Make sure everyone is attached before the segment is used
+		barrier();
+	}
+
+	shared_memory_allreducer::~shared_memory_allreducer()
+	{
+		if (worker_rank == 0)
+			boost::interprocess::shared_memory_object::remove(name.c_str());
+	}
+
+	void shared_memory_allreducer::barrier()
+	{
+		unsigned int current_generation = hdr->generation.load(std::memory_order_acquire);
+		if (hdr->arrived_count.fetch_add(1, std::memory_order_acq_rel) == worker_count - 1)
+		{
+			hdr->arrived_count.store(0, std::memory_order_relaxed);
+			hdr->generation.fetch_add(1, std::memory_order_release);
+		}
+		else
+		{
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			unsigned int spin_count = 0;
+			while (hdr->generation.load(std::memory_order_acquire) == current_generation)
+			{
+				if (spin_count < spin_count_before_sleep)
+				{
+					++spin_count;
+					std::this_thread::yield();
+				}
+				else
+				{
+					check_timeout(start, "other workers at barrier");
+					std::this_thread::sleep_for(std::chrono::microseconds(100));
+				}
+			}
+		}
+	}
+
+	void shared_memory_allreducer::check_timeout(
+		std::chrono::steady_clock::time_point start,
+		const char * waiting_for) const
+	{
+		std::chrono::duration<float> sec = std::chrono::steady_clock::now() - start;
+		if (sec.count() > timeout_seconds)
+			throw neural_network_exception((boost::format("Worker %1% of shared_memory_allreducer %2% timed out after %3% seconds waiting for %4%")
+				% worker_rank % name % timeout_seconds % waiting_for).str());
+	}
+
+	float * shared_memory_allreducer::get_slot(unsigned int worker_rank) const
+	{
+		return payload + static_cast<size_t>(worker_rank) * chunk_element_count;
+	}
+
+	float * shared_memory_allreducer::get_result() const
+	{
+		return payload + static_cast<size_t>(worker_count) * chunk_element_count;
+	}
+
+	void shared_memory_allreducer::allreduce(
+		float * data,
+		size_t element_count)
+	{
+		if (worker_count == 1)
+			return;
+
+		float * result = get_result();
+		for(size_t offset = 0; offset < element_count; offset += chunk_element_count)
+		{
+			const size_t current_element_count = std::min(static_cast<size_t>(chunk_element_count), element_count - offset);
+			memcpy(get_slot(worker_rank), data + offset, current_element_count * sizeof(float));
+
+			barrier();
+
+			const size_t begin = current_element_count * worker_rank / worker_count;
+			const size_t end = current_element_count * (worker_rank + 1) / worker_count;
+			const float * slot = get_slot(0);
+			std::copy(slot + begin, slot + end, result + begin);
+			for(unsigned int i = 1; i < worker_count; ++i)
+			{
+				slot = get_slot(i);
+				for(size_t j = begin; j < end; ++j)
+					result[j] += slot[j];
+			}
+
+			barrier();
+
+			memcpy(data + offset, result, current_element_count * sizeof(float));
+
+			// Nobody starts reducing the next chunk until everyone is done with the result of this one
+			barrier();
+		}
+	}
+
+	void shared_memory_allreducer::broadcast(
+		float * data,
+		size_t element_count)
+	{
+		if (worker_count == 1)
+			return;
+
+		float * result = get_result();
+		for(size_t offset = 0; offset < element_count; offset += chunk_element_count)
+		{
+			const size_t current_element_count = std::min(static_cast<size_t>(chunk_element_count), element_count - offset);
+			if (worker_rank == 0)
+				memcpy(result, data + offset, current_element_count * sizeof(float));
+
+			barrier();
+
+			if (worker_rank != 0)
+				memcpy(data + offset, result, current_element_count * sizeof(float));
+
+			barrier();
+		}
+	}
+
+	unsigned int shared_memory_allreducer::get_worker_count() const
+	{
+		return worker_count;
+	}
+
+	unsigned int shared_memory_allreducer::get_worker_rank() const
+	{
+		return worker_rank;
+	}
+}
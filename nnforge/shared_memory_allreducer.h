@@ -0,0 +1,108 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <boost/interprocess/shared_memory_object.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <string>
+#include <memory>
+#include <atomic>
+#include <chrono>
+
+namespace nnforge
+{
+	// Sums float arrays across worker processes running on the same host, through a named shared memory segment.
+	// All the workers should call the same sequence of allreduce and broadcast with the same sizes.
+	// Each call is a reduce-scatter followed by all-gather: every worker reduces its own 1/worker_count part of the chunk,
+	// summing the contributions in worker rank order, and then all the workers copy the complete result.
+	// Each element is thus reduced exactly once in a fixed order, and all the workers get bitwise identical results.
+	// Worker with rank 0 creates the segment (removing the stale one with the same name, if any) and removes it on destruction,
+	// other workers wait for it to appear.
+	// The segment is named by both name and run_id, the latter should be the same for all the workers and unique for each run:
+	// the segment left by a crashed run might be attached to by other workers before worker 0 replaces it, otherwise.
+	// Waiting for other workers, when attaching and in each collective, throws once timeout_seconds have passed
+	class shared_memory_allreducer
+	{
+	public:
+		typedef std::shared_ptr<shared_memory_allreducer> ptr;
+
+		shared_memory_allreducer(
+			const std::string& name,
+			const std::string& run_id,
+			unsigned int worker_count,
+			unsigned int worker_rank,
+			float timeout_seconds = 600.0F,
+			unsigned int chunk_element_count = 1024 * 1024);
+
+		~shared_memory_allreducer();
+
+		// data is replaced with the sum of data across all workers
+		void allreduce(
+			float * data,
+			size_t element_count);
+
+		// data is replaced with the data of the worker with rank 0
+		void broadcast(
+			float * data,
+			size_t element_count);
+
+		unsigned int get_worker_count() const;
+
+		unsigned int get_worker_rank() const;
+
+	private:
+		struct header
+		{
+			std::atomic<unsigned int> ready;
+			std::atomic<unsigned int> arrived_count;
+			std::atomic<unsigned int> generation;
+			unsigned int worker_count;
+			unsigned int chunk_element_count;
+		};
+
+		void barrier();
+
+		// Throws if the timeout has passed since start
+		void check_timeout(
+			std::chrono::steady_clock::time_point start,
+			const char * waiting_for) const;
+
+		float * get_slot(unsigned int worker_rank) const;
+
+		float * get_result() const;
+
+	private:
+		std::string name;
+		unsigned int worker_count;
+		unsigned int worker_rank;
+		unsigned int chunk_element_count;
+		float timeout_seconds;
+
+		boost::interprocess::shared_memory_object shm;
+		boost::interprocess::mapped_region region;
+		header * hdr;
+		float * payload;
+
+		static const unsigned int ready_magic;
+		static const unsigned int spin_count_before_sleep;
+
+	private:
+		shared_memory_allreducer(const shared_memory_allreducer&) = delete;
+		shared_memory_allreducer& operator =(const shared_memory_allreducer&) = delete;
+	};
+}
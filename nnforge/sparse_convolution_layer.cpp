@@ -633,4 +633,13 @@ namespace nnforge
 
 		return res;
 	}
+
+	bool sparse_convolution_layer::get_window_geometry_list(std::vector<window_geometry>& window_geometry_list) const
+	{
+		window_geometry_list.clear();
+		for(unsigned int i = 0; i < window_sizes.size(); ++i)
+			window_geometry_list.push_back(window_geometry(window_sizes[i], strides[i], left_zero_padding[i]));
+
+		return true;
+	}
 }
@@ -0,0 +1,141 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "structured_data_bunch_pad_reader.h"
+
+#include "neural_network_exception.h"
+
+#include <boost/format.hpp>
+#include <vector>
+#include <algorithm>
+
+namespace nnforge
+{
+	structured_data_bunch_pad_reader::structured_data_bunch_pad_reader(
+		structured_data_bunch_reader::ptr original_reader,
+		const std::map<std::string, layer_configuration_specific>& padded_config_map)
+		: original_reader(original_reader)
+	{
+		std::map<std::string, layer_configuration_specific> original_config_map = original_reader->get_config_map();
+		for(std::map<std::string, layer_configuration_specific>::const_iterator it = padded_config_map.begin(); it != padded_config_map.end(); ++it)
+		{
+			std::map<std::string, layer_configuration_specific>::const_iterator original_it = original_config_map.find(it->first);
+			if (original_it == original_config_map.end())
+				continue;
+
+			const layer_configuration_specific& original_config = original_it->second;
+			const layer_configuration_specific& padded_config = it->second;
+			bool compatible = (original_config.feature_map_count == padded_config.feature_map_count) && (original_config.dimension_sizes.size() == padded_config.dimension_sizes.size());
+			for(unsigned int i = 0; compatible && (i < static_cast<unsigned int>(original_config.dimension_sizes.size())); ++i)
+				compatible = (original_config.dimension_sizes[i] <= padded_config.dimension_sizes[i]);
+			if (!compatible)
+				throw neural_network_exception((boost::format("Cannot pad layer %1% from %2% to %3%") % it->first % original_config.get_neuron_count() % padded_config.get_neuron_count()).str());
+
+			if (original_config != padded_config)
+				layer_name_to_original_and_padded_config_map.insert(std::make_pair(it->first, std::make_pair(original_config, padded_config)));
+		}
+	}
+
+	void structured_data_bunch_pad_reader::set_epoch(unsigned int epoch_id)
+	{
+		original_reader->set_epoch(epoch_id);
+	}
+
+	bool structured_data_bunch_pad_reader::read(
+		unsigned int entry_id,
+		const std::map<std::string, float *>& data_map)
+	{
+		std::map<std::string, std::vector<float> > original_data_map;
+		std::map<std::string, float *> data_map_to_read;
+		for(std::map<std::string, float *>::const_iterator it = data_map.begin(); it != data_map.end(); ++it)
+		{
+			std::map<std::string, std::pair<layer_configuration_specific, layer_configuration_specific> >::const_iterator config_it = layer_name_to_original_and_padded_config_map.find(it->first);
+			if (config_it == layer_name_to_original_and_padded_config_map.end())
+				data_map_to_read.insert(*it);
+			else
+			{
+				std::vector<float>& original_data = original_data_map[it->first];
+				original_data.resize(config_it->second.first.get_neuron_count());
+				data_map_to_read.insert(std::make_pair(it->first, &original_data[0]));
+			}
+		}
+
+		if (!original_reader->read(entry_id, data_map_to_read))
+			return false;
+
+		for(std::map<std::string, std::vector<float> >::const_iterator it = original_data_map.begin(); it != original_data_map.end(); ++it)
+		{
+			const std::pair<layer_configuration_specific, layer_configuration_specific>& configs = layer_name_to_original_and_padded_config_map.find(it->first)->second;
+			const layer_configuration_specific& original_config = configs.first;
+			const layer_configuration_specific& padded_config = configs.second;
+			float * dst = data_map.find(it->first)->second;
+			std::fill_n(dst, padded_config.get_neuron_count(), 0.0F);
+
+			// Rows along the 1st dimension are copied one by one, pos holds the coordinates of the row along the other dimensions
+			unsigned int dimension_count = static_cast<unsigned int>(original_config.dimension_sizes.size());
+			unsigned int row_length = (dimension_count > 0) ? original_config.dimension_sizes[0] : 1;
+			unsigned int row_count = original_config.get_neuron_count() / row_length;
+			std::vector<unsigned int> pos(dimension_count + 1, 0);
+			const float * src = &it->second[0];
+			for(unsigned int row_id = 0; row_id < row_count; ++row_id, src += row_length)
+			{
+				size_t dst_offset = pos[dimension_count];
+				for(int i = static_cast<int>(dimension_count) - 1; i >= 1; --i)
+					dst_offset = dst_offset * padded_config.dimension_sizes[i] + pos[i];
+				if (dimension_count > 0)
+					dst_offset *= padded_config.dimension_sizes[0];
+				std::copy(src, src + row_length, dst + dst_offset);
+
+				for(unsigned int i = 1; i <= dimension_count; ++i)
+				{
+					unsigned int size = (i < dimension_count) ? original_config.dimension_sizes[i] : original_config.feature_map_count;
+					if (++pos[i] < size)
+						break;
+					pos[i] = 0;
+				}
+			}
+		}
+
+		return true;
+	}
+
+	int structured_data_bunch_pad_reader::get_entry_count() const
+	{
+		return original_reader->get_entry_count();
+	}
+
+	std::map<std::string, layer_configuration_specific> structured_data_bunch_pad_reader::get_config_map() const
+	{
+		std::map<std::string, layer_configuration_specific> res = original_reader->get_config_map();
+		for(std::map<std::string, std::pair<layer_configuration_specific, layer_configuration_specific> >::const_iterator it = layer_name_to_original_and_padded_config_map.begin(); it != layer_name_to_original_and_padded_config_map.end(); ++it)
+			res[it->first] = it->second.second;
+		return res;
+	}
+
+	structured_data_bunch_reader::ptr structured_data_bunch_pad_reader::get_narrow_reader(const std::set<std::string>& layer_names) const
+	{
+		structured_data_bunch_reader::ptr new_original_reader = original_reader->get_narrow_reader(layer_names);
+
+		if (!new_original_reader)
+			return structured_data_bunch_reader::ptr();
+
+		std::map<std::string, layer_configuration_specific> padded_config_map;
+		for(std::map<std::string, std::pair<layer_configuration_specific, layer_configuration_specific> >::const_iterator it = layer_name_to_original_and_padded_config_map.begin(); it != layer_name_to_original_and_padded_config_map.end(); ++it)
+			padded_config_map.insert(std::make_pair(it->first, it->second.second));
+
+		return structured_data_bunch_reader::ptr(new structured_data_bunch_pad_reader(new_original_reader, padded_config_map));
+	}
+}
@@ -0,0 +1,52 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "structured_data_bunch_reader.h"
+
+namespace nnforge
+{
+	// Zero-pads layers from padded_config_map at the end of each dimension.
+	// Padded configurations should have the same feature map and dimension counts as the original ones, and be at least as large
+	class structured_data_bunch_pad_reader : public structured_data_bunch_reader
+	{
+	public:
+		typedef std::shared_ptr<structured_data_bunch_pad_reader> ptr;
+
+		structured_data_bunch_pad_reader(
+			structured_data_bunch_reader::ptr original_reader,
+			const std::map<std::string, layer_configuration_specific>& padded_config_map);
+
+		~structured_data_bunch_pad_reader() = default;
+
+		virtual std::map<std::string, layer_configuration_specific> get_config_map() const;
+
+		virtual bool read(
+			unsigned int entry_id,
+			const std::map<std::string, float *>& data_map);
+
+		virtual int get_entry_count() const;
+
+		virtual structured_data_bunch_reader::ptr get_narrow_reader(const std::set<std::string>& layer_names) const;
+
+		virtual void set_epoch(unsigned int epoch_id);
+
+	protected:
+		structured_data_bunch_reader::ptr original_reader;
+		std::map<std::string, std::pair<layer_configuration_specific, layer_configuration_specific> > layer_name_to_original_and_padded_config_map;
+	};
+}
@@ -0,0 +1,71 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "structured_data_bunch_range_reader.h"
+
+#include <algorithm>
+
+namespace nnforge
+{
+	structured_data_bunch_range_reader::structured_data_bunch_range_reader(
+		structured_data_bunch_reader::ptr original_reader,
+		unsigned int start_entry_id,
+		unsigned int entry_count)
+		: original_reader(original_reader)
+		, start_entry_id(start_entry_id)
+		, entry_count(entry_count)
+	{
+	}
+
+	void structured_data_bunch_range_reader::set_epoch(unsigned int epoch_id)
+	{
+		original_reader->set_epoch(epoch_id);
+	}
+
+	bool structured_data_bunch_range_reader::read(
+		unsigned int entry_id,
+		const std::map<std::string, float *>& data_map)
+	{
+		if (entry_id >= entry_count)
+			return false;
+
+		return original_reader->read(start_entry_id + entry_id, data_map);
+	}
+
+	int structured_data_bunch_range_reader::get_entry_count() const
+	{
+		int original_entry_count = original_reader->get_entry_count();
+		if (original_entry_count < 0)
+			return static_cast<int>(entry_count);
+
+		return std::max(std::min(original_entry_count - static_cast<int>(start_entry_id), static_cast<int>(entry_count)), 0);
+	}
+
+	std::map<std::string, layer_configuration_specific> structured_data_bunch_range_reader::get_config_map() const
+	{
+		return original_reader->get_config_map();
+	}
+
+	structured_data_bunch_reader::ptr structured_data_bunch_range_reader::get_narrow_reader(const std::set<std::string>& layer_names) const
+	{
+		structured_data_bunch_reader::ptr new_original_reader = original_reader->get_narrow_reader(layer_names);
+
+		if (!new_original_reader)
+			return structured_data_bunch_reader::ptr();
+
+		return structured_data_bunch_reader::ptr(new structured_data_bunch_range_reader(new_original_reader, start_entry_id, entry_count));
+	}
+}
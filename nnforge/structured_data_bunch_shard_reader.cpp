@@ -0,0 +1,73 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "structured_data_bunch_shard_reader.h"
+
+#include "neural_network_exception.h"
+
+#include <boost/format.hpp>
+
+namespace nnforge
+{
+	structured_data_bunch_shard_reader::structured_data_bunch_shard_reader(
+		structured_data_bunch_reader::ptr original_reader,
+		unsigned int shard_count,
+		unsigned int shard_id)
+		: original_reader(original_reader)
+		, shard_count(shard_count)
+		, shard_id(shard_id)
+	{
+		if (shard_id >= shard_count)
+			throw neural_network_exception((boost::format("Shard id %1% is out of range for %2% shards in structured_data_bunch_shard_reader") % shard_id % shard_count).str());
+		if (original_reader->get_entry_count() < 0)
+			throw neural_network_exception("structured_data_bunch_shard_reader cannot function with unknown original_reader entry_count");
+	}
+
+	void structured_data_bunch_shard_reader::set_epoch(unsigned int epoch_id)
+	{
+		original_reader->set_epoch(epoch_id);
+	}
+
+	bool structured_data_bunch_shard_reader::read(
+		unsigned int entry_id,
+		const std::map<std::string, float *>& data_map)
+	{
+		if (static_cast<int>(entry_id) >= get_entry_count())
+			return false;
+
+		return original_reader->read(entry_id * shard_count + shard_id, data_map);
+	}
+
+	int structured_data_bunch_shard_reader::get_entry_count() const
+	{
+		return original_reader->get_entry_count() / static_cast<int>(shard_count);
+	}
+
+	std::map<std::string, layer_configuration_specific> structured_data_bunch_shard_reader::get_config_map() const
+	{
+		return original_reader->get_config_map();
+	}
+
+	structured_data_bunch_reader::ptr structured_data_bunch_shard_reader::get_narrow_reader(const std::set<std::string>& layer_names) const
+	{
+		structured_data_bunch_reader::ptr new_original_reader = original_reader->get_narrow_reader(layer_names);
+
+		if (!new_original_reader)
+			return structured_data_bunch_reader::ptr();
+
+		return structured_data_bunch_reader::ptr(new structured_data_bunch_shard_reader(new_original_reader, shard_count, shard_id));
+	}
+}
@@ -58,4 +58,9 @@ namespace nnforge
 	{
 		throw std::runtime_error("get_writer not implemented for structured_data_constant_reader");
 	}
+
+	bool structured_data_constant_reader::is_deterministic() const
+	{
+		return true;
+	}
 }
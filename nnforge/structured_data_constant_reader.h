@@ -45,6 +45,8 @@ namespace nnforge
 
 		virtual raw_data_writer::ptr get_writer(std::shared_ptr<std::ostream> out) const;
 
+		virtual bool is_deterministic() const;
+
 	protected:
 		float val;
 		layer_configuration_specific config;
@@ -31,4 +31,9 @@ namespace nnforge
 		all_elems.resize(get_configuration().get_neuron_count() * sizeof(float));
 		return read(entry_id, (float *)(&all_elems[0]));
 	}
+
+	bool structured_data_reader::is_deterministic() const
+	{
+		return false;
+	}
 }
@@ -40,6 +40,9 @@ namespace nnforge
 
 		virtual layer_configuration_specific get_configuration() const = 0;
 
+		// The method should return true in case reading the same entry always yields the same data
+		virtual bool is_deterministic() const;
+
 	protected:
 		structured_data_reader() = default;
 
@@ -0,0 +1,52 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "layer_configuration_specific.h"
+
+#include <vector>
+#include <memory>
+
+namespace nnforge
+{
+	// Provides random access to rectangular regions of (possibly huge) entries
+	class structured_data_region_reader
+	{
+	public:
+		typedef std::shared_ptr<structured_data_region_reader> ptr;
+
+		virtual ~structured_data_region_reader() = default;
+
+		// Reads all the feature maps of the region [offsets, offsets + sizes) of the entry, in the layout of the entry
+		virtual void read(
+			unsigned int entry_id,
+			const std::vector<unsigned int>& offsets,
+			const std::vector<unsigned int>& sizes,
+			float * data) = 0;
+
+		virtual layer_configuration_specific get_configuration() const = 0;
+
+		virtual int get_entry_count() const = 0;
+
+	protected:
+		structured_data_region_reader() = default;
+
+	private:
+		structured_data_region_reader(const structured_data_region_reader&) = delete;
+		structured_data_region_reader& operator =(const structured_data_region_reader&) = delete;
+	};
+}
@@ -0,0 +1,48 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "layer_configuration_specific.h"
+
+#include <vector>
+#include <memory>
+
+namespace nnforge
+{
+	// Accepts rectangular regions of (possibly huge) entries in any order
+	class structured_data_region_writer
+	{
+	public:
+		typedef std::shared_ptr<structured_data_region_writer> ptr;
+
+		virtual ~structured_data_region_writer() = default;
+
+		// Writes all the feature maps of the region [offsets, offsets + sizes) of the entry, in the layout of the entry
+		virtual void write(
+			unsigned int entry_id,
+			const std::vector<unsigned int>& offsets,
+			const std::vector<unsigned int>& sizes,
+			const float * data) = 0;
+
+	protected:
+		structured_data_region_writer() = default;
+
+	private:
+		structured_data_region_writer(const structured_data_region_writer&) = delete;
+		structured_data_region_writer& operator =(const structured_data_region_writer&) = delete;
+	};
+}
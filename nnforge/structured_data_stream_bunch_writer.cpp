@@ -0,0 +1,174 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "structured_data_stream_bunch_writer.h"
+
+#include "neural_network_exception.h"
+
+#include <boost/format.hpp>
+#include <algorithm>
+
+namespace nnforge
+{
+	const unsigned int structured_data_stream_bunch_writer::max_queued_block_count = 2;
+
+	structured_data_stream_bunch_writer::structured_data_stream_bunch_writer(
+		const std::map<std::string, std::shared_ptr<std::ostream> >& layer_name_to_stream_map,
+		unsigned int block_entry_count)
+		: layer_name_to_stream_map(layer_name_to_stream_map)
+		, block_entry_count(std::max(block_entry_count, 1U))
+		, block_being_written(false)
+		, stop_requested(false)
+	{
+		writer_thread = std::thread(&structured_data_stream_bunch_writer::write_blocks, this);
+	}
+
+	structured_data_stream_bunch_writer::~structured_data_stream_bunch_writer()
+	{
+		try
+		{
+			flush();
+		}
+		catch (...)
+		{
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(queue_mutex);
+			stop_requested = true;
+		}
+		queue_condition.notify_all();
+		writer_thread.join();
+
+		// Stream writers update entry counts on destruction
+		layer_name_to_writer_and_neuron_count_map.clear();
+	}
+
+	void structured_data_stream_bunch_writer::set_config_map(const std::map<std::string, layer_configuration_specific> config_map)
+	{
+		if (!layer_name_to_writer_and_neuron_count_map.empty())
+			throw neural_network_exception("structured_data_stream_bunch_writer cannot be configured twice");
+
+		for(std::map<std::string, std::shared_ptr<std::ostream> >::const_iterator it = layer_name_to_stream_map.begin(); it != layer_name_to_stream_map.end(); ++it)
+		{
+			std::map<std::string, layer_configuration_specific>::const_iterator config_it = config_map.find(it->first);
+			if (config_it == config_map.end())
+				throw neural_network_exception((boost::format("No config specified for layer %1% in structured_data_stream_bunch_writer") % it->first).str());
+
+			layer_name_to_writer_and_neuron_count_map.insert(std::make_pair(
+				it->first,
+				std::make_pair(
+					structured_data_stream_writer::ptr(new structured_data_stream_writer(it->second, config_it->second)),
+					config_it->second.get_neuron_count())));
+		}
+	}
+
+	void structured_data_stream_bunch_writer::write(
+		unsigned int entry_id,
+		const std::map<std::string, const float *>& data_map)
+	{
+		if (!current_block)
+		{
+			current_block = std::shared_ptr<block>(new block());
+			current_block->first_entry_id = entry_id;
+			current_block->entry_count = 0;
+			for(std::map<std::string, std::pair<structured_data_stream_writer::ptr, unsigned int> >::const_iterator it = layer_name_to_writer_and_neuron_count_map.begin(); it != layer_name_to_writer_and_neuron_count_map.end(); ++it)
+				current_block->layer_name_to_data_map[it->first].reserve(static_cast<size_t>(block_entry_count) * it->second.second);
+		}
+
+		if (entry_id != current_block->first_entry_id + current_block->entry_count)
+			throw neural_network_exception((boost::format("structured_data_stream_bunch_writer cannot write entry %1% out of order") % entry_id).str());
+
+		for(std::map<std::string, std::pair<structured_data_stream_writer::ptr, unsigned int> >::const_iterator it = layer_name_to_writer_and_neuron_count_map.begin(); it != layer_name_to_writer_and_neuron_count_map.end(); ++it)
+		{
+			std::map<std::string, const float *>::const_iterator data_it = data_map.find(it->first);
+			if (data_it == data_map.end())
+				throw neural_network_exception((boost::format("No data for layer %1% passed to structured_data_stream_bunch_writer") % it->first).str());
+
+			std::vector<float>& dst = current_block->layer_name_to_data_map[it->first];
+			dst.insert(dst.end(), data_it->second, data_it->second + it->second.second);
+		}
+		++current_block->entry_count;
+
+		if (current_block->entry_count >= block_entry_count)
+			enqueue_current_block();
+	}
+
+	void structured_data_stream_bunch_writer::enqueue_current_block()
+	{
+		std::unique_lock<std::mutex> lock(queue_mutex);
+		while ((queue.size() >= max_queued_block_count) && !error)
+			queue_condition.wait(lock);
+		if (error)
+			std::rethrow_exception(error);
+
+		queue.push_back(current_block);
+		current_block.reset();
+		lock.unlock();
+		queue_condition.notify_all();
+	}
+
+	void structured_data_stream_bunch_writer::flush()
+	{
+		if (current_block)
+			enqueue_current_block();
+
+		std::unique_lock<std::mutex> lock(queue_mutex);
+		while ((!queue.empty() || block_being_written) && !error)
+			queue_condition.wait(lock);
+		if (error)
+			std::rethrow_exception(error);
+	}
+
+	void structured_data_stream_bunch_writer::write_blocks()
+	{
+		while (true)
+		{
+			std::shared_ptr<block> current;
+			{
+				std::unique_lock<std::mutex> lock(queue_mutex);
+				while (queue.empty() && !stop_requested)
+					queue_condition.wait(lock);
+				if (queue.empty())
+					return;
+				current = queue.front();
+				queue.pop_front();
+				block_being_written = true;
+			}
+
+			try
+			{
+				for(std::map<std::string, std::pair<structured_data_stream_writer::ptr, unsigned int> >::const_iterator it = layer_name_to_writer_and_neuron_count_map.begin(); it != layer_name_to_writer_and_neuron_count_map.end(); ++it)
+				{
+					const float * src = &current->layer_name_to_data_map[it->first][0];
+					for(unsigned int i = 0; i < current->entry_count; ++i, src += it->second.second)
+						it->second.first->write(current->first_entry_id + i, src);
+				}
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> lock(queue_mutex);
+				error = std::current_exception();
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(queue_mutex);
+				block_being_written = false;
+			}
+			queue_condition.notify_all();
+		}
+	}
+}
@@ -0,0 +1,93 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "structured_data_bunch_writer.h"
+#include "structured_data_stream_writer.h"
+
+#include <vector>
+#include <deque>
+#include <map>
+#include <string>
+#include <ostream>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+namespace nnforge
+{
+	// Writes each layer from layer_name_to_stream_map to its own structured data stream, other layers are ignored.
+	// Entries are collected into blocks of block_entry_count and written by the background thread,
+	// at most 2 complete blocks are kept in memory, so the caller waits for disk only when it is ahead of it.
+	// Entries should be written in order, starting with 0
+	class structured_data_stream_bunch_writer : public structured_data_bunch_writer
+	{
+	public:
+		typedef std::shared_ptr<structured_data_stream_bunch_writer> ptr;
+
+		structured_data_stream_bunch_writer(
+			const std::map<std::string, std::shared_ptr<std::ostream> >& layer_name_to_stream_map,
+			unsigned int block_entry_count);
+
+		~structured_data_stream_bunch_writer();
+
+		virtual void set_config_map(const std::map<std::string, layer_configuration_specific> config_map);
+
+		virtual void write(
+			unsigned int entry_id,
+			const std::map<std::string, const float *>& data_map);
+
+		// Waits for all the entries written so far to reach the streams
+		// Rethrows the error encountered by the background thread, if any
+		void flush();
+
+	private:
+		struct block
+		{
+			unsigned int first_entry_id;
+			unsigned int entry_count;
+			std::map<std::string, std::vector<float> > layer_name_to_data_map;
+		};
+
+		void enqueue_current_block();
+
+		void write_blocks();
+
+	private:
+		std::map<std::string, std::shared_ptr<std::ostream> > layer_name_to_stream_map;
+		unsigned int block_entry_count;
+
+		std::map<std::string, std::pair<structured_data_stream_writer::ptr, unsigned int> > layer_name_to_writer_and_neuron_count_map;
+		std::shared_ptr<block> current_block;
+
+		std::mutex queue_mutex;
+		std::condition_variable queue_condition;
+		std::deque<std::shared_ptr<block> > queue;
+		bool block_being_written;
+		bool stop_requested;
+		std::exception_ptr error;
+		std::thread writer_thread;
+
+		static const unsigned int max_queued_block_count;
+
+	private:
+		structured_data_stream_bunch_writer(const structured_data_stream_bunch_writer&) = delete;
+		structured_data_stream_bunch_writer& operator =(const structured_data_stream_bunch_writer&) = delete;
+	};
+}
@@ -74,4 +74,9 @@ namespace nnforge
 	{
 		return raw_data_writer::ptr(new structured_data_stream_writer(out, get_configuration()));
 	}
+
+	bool structured_data_stream_reader::is_deterministic() const
+	{
+		return true;
+	}
 }
@@ -45,6 +45,8 @@ namespace nnforge
 
 		virtual raw_data_writer::ptr get_writer(std::shared_ptr<std::ostream> out) const;
 
+		virtual bool is_deterministic() const;
+
 	protected:
 		std::shared_ptr<std::istream> in_stream;
 		unsigned int input_neuron_count;
@@ -0,0 +1,102 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "structured_data_stream_region_reader.h"
+
+#include "neural_network_exception.h"
+#include "structured_data_stream_schema.h"
+
+#include <boost/uuid/uuid_io.hpp>
+#include <boost/format.hpp>
+
+namespace nnforge
+{
+	structured_data_stream_region_reader::structured_data_stream_region_reader(std::shared_ptr<std::istream> input_stream)
+		: in_stream(input_stream)
+	{
+		in_stream->exceptions(std::ostream::eofbit | std::ostream::failbit | std::ostream::badbit);
+
+		boost::uuids::uuid guid_read;
+		in_stream->read(reinterpret_cast<char*>(guid_read.data), sizeof(guid_read.data));
+		if (guid_read != structured_data_stream_schema::structured_data_stream_guid)
+			throw neural_network_exception((boost::format("Unknown structured data GUID encountered in input stream: %1%") % guid_read).str());
+
+		input_configuration.read(*in_stream);
+
+		in_stream->read(reinterpret_cast<char*>(&entry_count), sizeof(entry_count));
+
+		reset_pos = in_stream->tellg();
+	}
+
+	void structured_data_stream_region_reader::read(
+		unsigned int entry_id,
+		const std::vector<unsigned int>& offsets,
+		const std::vector<unsigned int>& sizes,
+		float * data)
+	{
+		if (entry_id >= entry_count)
+			throw neural_network_exception((boost::format("Entry %1% requested while there are %2% entries only") % entry_id % entry_count).str());
+
+		unsigned int dimension_count = input_configuration.get_dimension_count();
+		if ((offsets.size() != dimension_count) || (sizes.size() != dimension_count))
+			throw neural_network_exception((boost::format("Region with %1% dimensions requested from the entry with %2% dimensions") % sizes.size() % dimension_count).str());
+		for(unsigned int i = 0; i < dimension_count; ++i)
+			if (offsets[i] + sizes[i] > input_configuration.dimension_sizes[i])
+				throw neural_network_exception((boost::format("Region [%1%, %2%) is out of bounds for dimension %3% of size %4%") % offsets[i] % (offsets[i] + sizes[i]) % i % input_configuration.dimension_sizes[i]).str());
+
+		// Contiguous runs along the 1st dimension are read one by one
+		unsigned int run_length = (dimension_count > 0) ? sizes[0] : 1;
+		unsigned int run_count = input_configuration.feature_map_count;
+		for(unsigned int i = 1; i < dimension_count; ++i)
+			run_count *= sizes[i];
+		std::istream::off_type entry_offset = reset_pos + (std::istream::off_type)entry_id * (std::istream::off_type)(sizeof(float) * input_configuration.get_neuron_count());
+
+		std::lock_guard<std::mutex> lock(read_data_from_stream_mutex);
+
+		std::vector<unsigned int> position(dimension_count, 0);
+		unsigned int feature_map_id = 0;
+		for(unsigned int run_id = 0; run_id < run_count; ++run_id)
+		{
+			std::istream::off_type elem_offset = feature_map_id;
+			for(int i = static_cast<int>(dimension_count) - 1; i >= 0; --i)
+				elem_offset = elem_offset * input_configuration.dimension_sizes[i] + offsets[i] + position[i];
+
+			in_stream->seekg(entry_offset + elem_offset * (std::istream::off_type)sizeof(float), std::ios::beg);
+			in_stream->read(reinterpret_cast<char*>(data), sizeof(float) * run_length);
+			data += run_length;
+
+			unsigned int i = 1;
+			for(; i < dimension_count; ++i)
+			{
+				if ((++position[i]) < sizes[i])
+					break;
+				position[i] = 0;
+			}
+			if (i >= dimension_count)
+				++feature_map_id;
+		}
+	}
+
+	layer_configuration_specific structured_data_stream_region_reader::get_configuration() const
+	{
+		return input_configuration;
+	}
+
+	int structured_data_stream_region_reader::get_entry_count() const
+	{
+		return entry_count;
+	}
+}
@@ -0,0 +1,54 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "structured_data_region_reader.h"
+
+#include <istream>
+#include <mutex>
+
+namespace nnforge
+{
+	// Reads regions of the entries stored in the structured data stream format (.dt) without loading the entries whole
+	class structured_data_stream_region_reader : public structured_data_region_reader
+	{
+	public:
+		typedef std::shared_ptr<structured_data_stream_region_reader> ptr;
+
+		// The constructor modifies input_stream to throw exceptions in case of failure
+		structured_data_stream_region_reader(std::shared_ptr<std::istream> input_stream);
+
+		virtual ~structured_data_stream_region_reader() = default;
+
+		virtual void read(
+			unsigned int entry_id,
+			const std::vector<unsigned int>& offsets,
+			const std::vector<unsigned int>& sizes,
+			float * data);
+
+		virtual layer_configuration_specific get_configuration() const;
+
+		virtual int get_entry_count() const;
+
+	protected:
+		std::shared_ptr<std::istream> in_stream;
+		layer_configuration_specific input_configuration;
+		unsigned int entry_count;
+		std::istream::pos_type reset_pos;
+		std::mutex read_data_from_stream_mutex;
+	};
+}
@@ -0,0 +1,106 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "structured_data_stream_region_writer.h"
+
+#include "neural_network_exception.h"
+#include "structured_data_stream_schema.h"
+
+#include <boost/format.hpp>
+
+namespace nnforge
+{
+	structured_data_stream_region_writer::structured_data_stream_region_writer(
+		std::shared_ptr<std::ostream> output_stream,
+		const layer_configuration_specific& config,
+		unsigned int entry_count)
+		: out_stream(output_stream)
+		, output_configuration(config)
+		, entry_count(entry_count)
+	{
+		out_stream->exceptions(std::ostream::failbit | std::ostream::badbit);
+
+		out_stream->write(reinterpret_cast<const char*>(structured_data_stream_schema::structured_data_stream_guid.data), sizeof(structured_data_stream_schema::structured_data_stream_guid.data));
+
+		output_configuration.write(*out_stream);
+
+		out_stream->write(reinterpret_cast<const char*>(&entry_count), sizeof(entry_count));
+
+		reset_pos = out_stream->tellp();
+
+		// Regions not written are left zero
+		std::ostream::off_type total_size = (std::ostream::off_type)entry_count * (std::ostream::off_type)(sizeof(float) * output_configuration.get_neuron_count());
+		if (total_size > 0)
+		{
+			out_stream->seekp(reset_pos + (total_size - 1), std::ios::beg);
+			out_stream->put(0);
+		}
+	}
+
+	structured_data_stream_region_writer::~structured_data_stream_region_writer()
+	{
+		out_stream->flush();
+	}
+
+	void structured_data_stream_region_writer::write(
+		unsigned int entry_id,
+		const std::vector<unsigned int>& offsets,
+		const std::vector<unsigned int>& sizes,
+		const float * data)
+	{
+		if (entry_id >= entry_count)
+			throw neural_network_exception((boost::format("Entry %1% written while there are %2% entries only") % entry_id % entry_count).str());
+
+		unsigned int dimension_count = output_configuration.get_dimension_count();
+		if ((offsets.size() != dimension_count) || (sizes.size() != dimension_count))
+			throw neural_network_exception((boost::format("Region with %1% dimensions written to the entry with %2% dimensions") % sizes.size() % dimension_count).str());
+		for(unsigned int i = 0; i < dimension_count; ++i)
+			if (offsets[i] + sizes[i] > output_configuration.dimension_sizes[i])
+				throw neural_network_exception((boost::format("Region [%1%, %2%) is out of bounds for dimension %3% of size %4%") % offsets[i] % (offsets[i] + sizes[i]) % i % output_configuration.dimension_sizes[i]).str());
+
+		// Contiguous runs along the 1st dimension are written one by one
+		unsigned int run_length = (dimension_count > 0) ? sizes[0] : 1;
+		unsigned int run_count = output_configuration.feature_map_count;
+		for(unsigned int i = 1; i < dimension_count; ++i)
+			run_count *= sizes[i];
+		std::ostream::off_type entry_offset = reset_pos + (std::ostream::off_type)entry_id * (std::ostream::off_type)(sizeof(float) * output_configuration.get_neuron_count());
+
+		std::lock_guard<std::mutex> lock(write_data_to_stream_mutex);
+
+		std::vector<unsigned int> position(dimension_count, 0);
+		unsigned int feature_map_id = 0;
+		for(unsigned int run_id = 0; run_id < run_count; ++run_id)
+		{
+			std::ostream::off_type elem_offset = feature_map_id;
+			for(int i = static_cast<int>(dimension_count) - 1; i >= 0; --i)
+				elem_offset = elem_offset * output_configuration.dimension_sizes[i] + offsets[i] + position[i];
+
+			out_stream->seekp(entry_offset + elem_offset * (std::ostream::off_type)sizeof(float), std::ios::beg);
+			out_stream->write(reinterpret_cast<const char*>(data), sizeof(float) * run_length);
+			data += run_length;
+
+			unsigned int i = 1;
+			for(; i < dimension_count; ++i)
+			{
+				if ((++position[i]) < sizes[i])
+					break;
+				position[i] = 0;
+			}
+			if (i >= dimension_count)
+				++feature_map_id;
+		}
+	}
+}
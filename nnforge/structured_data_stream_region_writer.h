@@ -0,0 +1,54 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "structured_data_region_writer.h"
+
+#include <ostream>
+#include <mutex>
+
+namespace nnforge
+{
+	// Writes regions of the entries in the structured data stream format (.dt),
+	// the stream should be seekable and is extended to the full size in constructor
+	class structured_data_stream_region_writer : public structured_data_region_writer
+	{
+	public:
+		typedef std::shared_ptr<structured_data_stream_region_writer> ptr;
+
+		// The constructor modifies output_stream to throw exceptions in case of failure
+		structured_data_stream_region_writer(
+			std::shared_ptr<std::ostream> output_stream,
+			const layer_configuration_specific& config,
+			unsigned int entry_count);
+
+		virtual ~structured_data_stream_region_writer();
+
+		virtual void write(
+			unsigned int entry_id,
+			const std::vector<unsigned int>& offsets,
+			const std::vector<unsigned int>& sizes,
+			const float * data);
+
+	protected:
+		std::shared_ptr<std::ostream> out_stream;
+		layer_configuration_specific output_configuration;
+		unsigned int entry_count;
+		std::ostream::pos_type reset_pos;
+		std::mutex write_data_to_stream_mutex;
+	};
+}
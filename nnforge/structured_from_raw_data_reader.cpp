@@ -16,15 +16,25 @@
 
 #include "structured_from_raw_data_reader.h"
 
+#include "neural_network_exception.h"
+
 namespace nnforge
 {
 	structured_from_raw_data_reader::structured_from_raw_data_reader(
 		raw_data_reader::ptr raw_reader,
-		raw_to_structured_data_transformer::ptr transformer)
+		raw_to_structured_data_transformer::ptr transformer,
+		decoded_image_cache::ptr decoded_cache)
 		: raw_reader(raw_reader)
 		, transformer(transformer)
 		, transformer_sample_count(transformer->get_sample_count())
+		, decoded_cache(decoded_cache)
 	{
+		if (decoded_cache)
+		{
+			image_transformer = std::dynamic_pointer_cast<image_raw_to_structured_data_transformer>(transformer);
+			if (!image_transformer)
+				throw neural_network_exception("structured_from_raw_data_reader cannot use decoded image cache with transformer which is not image_raw_to_structured_data_transformer");
+		}
 	}
 
 	bool structured_from_raw_data_reader::read(
@@ -32,12 +42,28 @@ namespace nnforge
 		float * data)
 	{
 		unsigned int original_entry_id = entry_id / transformer_sample_count;
+		unsigned int sample_id = entry_id - original_entry_id * transformer_sample_count;
+
+		if (decoded_cache)
+		{
+			cv::Mat3b image;
+			if (!decoded_cache->find(original_entry_id, image))
+			{
+				std::vector<unsigned char> raw_data;
+				if (!raw_reader->raw_read(original_entry_id, raw_data))
+					return false;
+
+				image = decoded_cache->insert(original_entry_id, image_raw_to_structured_data_transformer::decode(raw_data));
+			}
+
+			image_transformer->transform_decoded(sample_id, image, data);
+			return true;
+		}
 
 		std::vector<unsigned char> raw_data;
 		if (!raw_reader->raw_read(original_entry_id, raw_data))
 			return false;
 
-		unsigned int sample_id = entry_id - original_entry_id * transformer_sample_count;
 		transformer->transform(sample_id, raw_data, data);
 		return true;
 	}
@@ -63,4 +89,9 @@ namespace nnforge
 	{
 		return raw_reader->get_writer(out);
 	}
+
+	bool structured_from_raw_data_reader::is_deterministic() const
+	{
+		return transformer->is_deterministic();
+	}
 }
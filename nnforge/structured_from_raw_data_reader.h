@@ -19,6 +19,8 @@
 #include "structured_data_reader.h"
 #include "raw_data_reader.h"
 #include "raw_to_structured_data_transformer.h"
+#include "image_raw_to_structured_data_transformer.h"
+#include "decoded_image_cache.h"
 
 namespace nnforge
 {
@@ -27,9 +29,12 @@ namespace nnforge
 	public:
 		typedef std::shared_ptr<structured_from_raw_data_reader> ptr;
 
+		// When decoded_cache is specified the transformer should be image_raw_to_structured_data_transformer,
+		// raw data is then read and decoded only for images which are not in the cache
 		structured_from_raw_data_reader(
 			raw_data_reader::ptr raw_reader,
-			raw_to_structured_data_transformer::ptr transformer);
+			raw_to_structured_data_transformer::ptr transformer,
+			decoded_image_cache::ptr decoded_cache = decoded_image_cache::ptr());
 
 		virtual ~structured_from_raw_data_reader() = default;
 
@@ -47,10 +52,14 @@ namespace nnforge
 
 		virtual raw_data_writer::ptr get_writer(std::shared_ptr<std::ostream> out) const;
 
+		virtual bool is_deterministic() const;
+
 	protected:
 		raw_data_reader::ptr raw_reader;
 		raw_to_structured_data_transformer::ptr transformer;
 		unsigned int transformer_sample_count;
+		decoded_image_cache::ptr decoded_cache;
+		image_raw_to_structured_data_transformer::ptr image_transformer;
 
 	protected:
 		structured_from_raw_data_reader() = default;
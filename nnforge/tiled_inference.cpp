@@ -0,0 +1,332 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "tiled_inference.h"
+
+#include "neural_network_exception.h"
+#include "neuron_value_set_data_bunch_reader.h"
+#include "neuron_value_set_data_bunch_writer.h"
+
+#include <algorithm>
+#include <boost/format.hpp>
+
+namespace nnforge
+{
+	tiled_inference::tiled_inference(
+		forward_propagation::ptr forward_prop,
+		const network_schema& schema,
+		const std::string& output_layer_name,
+		unsigned int tile_size,
+		unsigned int tile_batch_size)
+		: forward_prop(forward_prop)
+		, output_layer_name(output_layer_name)
+		, tile_size(tile_size)
+		, tile_batch_size(tile_batch_size)
+	{
+		if (tile_size == 0)
+			throw neural_network_exception("Tile size cannot be 0 for tiled inference");
+		if (tile_batch_size == 0)
+			throw neural_network_exception("Tile batch size cannot be 0 for tiled inference");
+
+		this->schema = network_schema::ptr(new network_schema(schema.get_required_layers(std::vector<std::string>(1, output_layer_name))));
+
+		std::vector<layer::const_ptr> data_layers = this->schema->get_data_layers();
+		if (data_layers.size() != 1)
+			throw neural_network_exception((boost::format("Tiled inference requires layer %1% to depend on a single data layer, while it depends on %2%") % output_layer_name % data_layers.size()).str());
+		input_layer_name = data_layers.front()->instance_name;
+
+		std::map<std::string, unsigned int> cumulative_tiling_factor_map = this->schema->get_cumulative_tiling_factor_map();
+		for(std::map<std::string, unsigned int>::const_iterator it = cumulative_tiling_factor_map.begin(); it != cumulative_tiling_factor_map.end(); ++it)
+			if (it->second != 1)
+				throw neural_network_exception((boost::format("Tiled inference is not supported for layer %1% with tiling factor %2%") % it->first % it->second).str());
+
+		std::vector<layer::const_ptr> layers = this->schema->get_layers();
+		for(std::vector<layer::const_ptr>::const_iterator it = layers.begin(); it != layers.end(); ++it)
+		{
+			std::vector<window_geometry> window_geometry_list;
+			if (!(*it)->get_window_geometry_list(window_geometry_list))
+				throw neural_network_exception((boost::format("Tiled inference is not supported for layer %1% of type %2%, its output is not local") % (*it)->instance_name % (*it)->get_type_name()).str());
+		}
+	}
+
+	std::string tiled_inference::get_input_layer_name() const
+	{
+		return input_layer_name;
+	}
+
+	layer_configuration_specific tiled_inference::get_output_configuration_specific(const layer_configuration_specific& input_configuration_specific) const
+	{
+		std::map<std::string, layer_configuration_specific> input_configuration_specific_map;
+		input_configuration_specific_map.insert(std::make_pair(input_layer_name, input_configuration_specific));
+		return schema->get_layer_configuration_specific_map(input_configuration_specific_map)[output_layer_name];
+	}
+
+	std::vector<tiled_inference::receptive_field> tiled_inference::get_receptive_field_list(const std::map<std::string, layer_configuration_specific>& layer_config_map) const
+	{
+		std::map<std::string, std::vector<receptive_field> > receptive_field_map;
+
+		std::vector<layer::const_ptr> layers_ordered = schema->get_layers_in_forward_propagation_order();
+		for(std::vector<layer::const_ptr>::const_iterator it = layers_ordered.begin(); it != layers_ordered.end(); ++it)
+		{
+			layer::const_ptr l = *it;
+			const layer_configuration_specific& output_config = layer_config_map.find(l->instance_name)->second;
+
+			std::vector<receptive_field> res;
+			if (l->input_layer_instance_names.empty())
+			{
+				receptive_field identity;
+				identity.stride = 1;
+				identity.start = 0;
+				identity.end = 1;
+				res.resize(output_config.get_dimension_count(), identity);
+				receptive_field_map.insert(std::make_pair(l->instance_name, res));
+				continue;
+			}
+
+			for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2)
+			{
+				const std::vector<receptive_field>& input_receptive_field_list = receptive_field_map.find(*it2)->second;
+				if (it2 == l->input_layer_instance_names.begin())
+				{
+					res = input_receptive_field_list;
+					continue;
+				}
+
+				if (input_receptive_field_list.size() != res.size())
+					throw neural_network_exception((boost::format("Tiled inference: inputs of layer %1% have different dimension counts") % l->instance_name).str());
+				for(unsigned int i = 0; i < res.size(); ++i)
+				{
+					if (input_receptive_field_list[i].stride != res[i].stride)
+						throw neural_network_exception((boost::format("Tiled inference: inputs of layer %1% have different strides %2% and %3% in dimension %4%") % l->instance_name % res[i].stride % input_receptive_field_list[i].stride % i).str());
+					res[i].start = std::min(res[i].start, input_receptive_field_list[i].start);
+					res[i].end = std::max(res[i].end, input_receptive_field_list[i].end);
+				}
+			}
+
+			std::vector<window_geometry> window_geometry_list;
+			l->get_window_geometry_list(window_geometry_list);
+			if (window_geometry_list.empty())
+			{
+				// Positions are mapped one to one, unless the layer changes spatial sizes
+				for(std::vector<std::string>::const_iterator it2 = l->input_layer_instance_names.begin(); it2 != l->input_layer_instance_names.end(); ++it2)
+					if (layer_config_map.find(*it2)->second.dimension_sizes != output_config.dimension_sizes)
+						throw neural_network_exception((boost::format("Tiled inference is not supported for layer %1% of type %2%, it changes spatial sizes") % l->instance_name % l->get_type_name()).str());
+			}
+			else
+			{
+				if (window_geometry_list.size() != res.size())
+					throw neural_network_exception((boost::format("Tiled inference: window geometry of layer %1% has %2% dimensions while its input has %3%") % l->instance_name % window_geometry_list.size() % res.size()).str());
+				for(unsigned int i = 0; i < res.size(); ++i)
+				{
+					const window_geometry& geometry = window_geometry_list[i];
+					int input_stride = static_cast<int>(res[i].stride);
+					res[i].start -= static_cast<int>(geometry.left_padding) * input_stride;
+					res[i].end += (static_cast<int>(geometry.window) - 1 - static_cast<int>(geometry.left_padding)) * input_stride;
+					res[i].stride *= geometry.stride;
+				}
+			}
+
+			receptive_field_map.insert(std::make_pair(l->instance_name, res));
+		}
+
+		return receptive_field_map[output_layer_name];
+	}
+
+	forward_propagation::stat tiled_inference::run(
+		structured_data_region_reader& reader,
+		structured_data_region_writer& writer,
+		const std::vector<network_data::const_ptr>& data_list)
+	{
+		layer_configuration_specific input_config = reader.get_configuration();
+		unsigned int dimension_count = input_config.get_dimension_count();
+		if (dimension_count == 0)
+			throw neural_network_exception((boost::format("Tiled inference requires input layer %1% to have spatial dimensions") % input_layer_name).str());
+
+		std::map<std::string, layer_configuration_specific> layer_config_map;
+		{
+			std::map<std::string, layer_configuration_specific> input_configuration_specific_map;
+			input_configuration_specific_map.insert(std::make_pair(input_layer_name, input_config));
+			layer_config_map = schema->get_layer_configuration_specific_map(input_configuration_specific_map);
+		}
+		const layer_configuration_specific& output_config = layer_config_map[output_layer_name];
+		std::vector<receptive_field> receptive_field_list = get_receptive_field_list(layer_config_map);
+
+		// Split each dimension: tile input starts at a multiple of the cumulative stride,
+		// so that tile output positions are aligned with the ones of the whole entry,
+		// and covers the receptive field of all the tile outputs, clipped to the entry boundaries,
+		// where the tile is zero padded the same way the whole entry is
+		std::vector<std::vector<dimension_split> > dimension_split_list(dimension_count);
+		for(unsigned int i = 0; i < dimension_count; ++i)
+		{
+			int stride = static_cast<int>(receptive_field_list[i].stride);
+			int input_size = static_cast<int>(input_config.dimension_sizes[i]);
+			for(unsigned int output_start = 0; output_start < output_config.dimension_sizes[i]; output_start += tile_size)
+			{
+				unsigned int output_end = std::min(output_start + tile_size, output_config.dimension_sizes[i]);
+				int input_start = static_cast<int>(output_start) * stride + receptive_field_list[i].start;
+				input_start = (input_start <= 0) ? 0 : input_start / stride * stride;
+				int input_end = std::min(static_cast<int>(output_end - 1) * stride + receptive_field_list[i].end, input_size);
+
+				dimension_split split;
+				split.input_offset = static_cast<unsigned int>(input_start);
+				split.input_size = static_cast<unsigned int>(input_end - input_start);
+				split.output_offset = output_start;
+				split.output_size = output_end - output_start;
+				split.local_output_offset = output_start - static_cast<unsigned int>(input_start / stride);
+				dimension_split_list[i].push_back(split);
+			}
+		}
+
+		// Tiles of the same input size are batched together, there are at most 3 distinct sizes per dimension
+		std::map<std::vector<unsigned int>, std::vector<tile> > input_sizes_to_tile_list_map;
+		{
+			std::vector<unsigned int> split_ids(dimension_count, 0);
+			while (true)
+			{
+				tile t;
+				std::vector<unsigned int> input_sizes;
+				for(unsigned int i = 0; i < dimension_count; ++i)
+				{
+					const dimension_split& split = dimension_split_list[i][split_ids[i]];
+					t.input_offsets.push_back(split.input_offset);
+					t.output_offsets.push_back(split.output_offset);
+					t.output_sizes.push_back(split.output_size);
+					t.local_output_offsets.push_back(split.local_output_offset);
+					input_sizes.push_back(split.input_size);
+				}
+				input_sizes_to_tile_list_map[input_sizes].push_back(t);
+
+				unsigned int i = 0;
+				for(; i < dimension_count; ++i)
+				{
+					if ((++split_ids[i]) < dimension_split_list[i].size())
+						break;
+					split_ids[i] = 0;
+				}
+				if (i >= dimension_count)
+					break;
+			}
+		}
+
+		// Keep plans for all tile shapes, they are reused for each entry
+		forward_prop->set_plan_cache_size(static_cast<unsigned int>(input_sizes_to_tile_list_map.size()));
+		if (data_list.size() == 1)
+			forward_prop->set_data(*data_list.front());
+
+		forward_propagation::stat res;
+		res.entry_processed_count = 0;
+		res.flops_per_entry = 0.0F;
+		res.total_seconds = 0.0F;
+
+		int entry_count = reader.get_entry_count();
+		for(unsigned int entry_id = 0; entry_id < static_cast<unsigned int>(entry_count); ++entry_id)
+		{
+			for(std::map<std::vector<unsigned int>, std::vector<tile> >::const_iterator it = input_sizes_to_tile_list_map.begin(); it != input_sizes_to_tile_list_map.end(); ++it)
+			{
+				layer_configuration_specific tile_input_config(input_config.feature_map_count, it->first);
+				layer_configuration_specific tile_output_config = get_output_configuration_specific(tile_input_config);
+				for(std::vector<tile>::const_iterator it2 = it->second.begin(); it2 != it->second.end(); ++it2)
+					for(unsigned int i = 0; i < dimension_count; ++i)
+						if (it2->local_output_offsets[i] + it2->output_sizes[i] > tile_output_config.dimension_sizes[i])
+							throw neural_network_exception((boost::format("Tiled inference: tile of size %1% in dimension %2% produces %3% outputs, while %4% are required") % it->first[i] % i % tile_output_config.dimension_sizes[i] % (it2->local_output_offsets[i] + it2->output_sizes[i])).str());
+
+				for(unsigned int batch_start = 0; batch_start < it->second.size(); batch_start += tile_batch_size)
+				{
+					unsigned int batch_size = std::min(tile_batch_size, static_cast<unsigned int>(it->second.size()) - batch_start);
+
+					neuron_value_set::ptr input_set(new neuron_value_set(tile_input_config.get_neuron_count(), batch_size));
+					for(unsigned int tile_id = 0; tile_id < batch_size; ++tile_id)
+						reader.read(entry_id, it->second[batch_start + tile_id].input_offsets, it->first, &input_set->neuron_value_list[tile_id]->at(0));
+					std::map<std::string, std::pair<layer_configuration_specific, neuron_value_set::ptr> > input_map;
+					input_map.insert(std::make_pair(input_layer_name, std::make_pair(tile_input_config, input_set)));
+					neuron_value_set_data_bunch_reader tile_reader(input_map);
+
+					neuron_value_set::ptr average_output_set;
+					for(unsigned int net_id = 0; net_id < std::max(static_cast<unsigned int>(data_list.size()), 1U); ++net_id)
+					{
+						if (data_list.size() > 1)
+							forward_prop->set_data(*data_list[net_id]);
+
+						neuron_value_set_data_bunch_writer tile_writer;
+						forward_propagation::stat st = forward_prop->run(tile_reader, tile_writer);
+						if (st.entry_processed_count != batch_size)
+							throw neural_network_exception((boost::format("Tiled inference: %1% tiles propagated while %2% expected") % st.entry_processed_count % batch_size).str());
+						if (net_id == 0)
+							res.entry_processed_count += st.entry_processed_count;
+						res.flops_per_entry = st.flops_per_entry;
+						res.total_seconds += st.total_seconds;
+
+						neuron_value_set::ptr output_set = tile_writer.layer_name_to_config_and_value_set_map[output_layer_name].second;
+						if (net_id == 0)
+							average_output_set = output_set;
+						else
+							average_output_set->add(*output_set, static_cast<float>(net_id) / static_cast<float>(net_id + 1), 1.0F / static_cast<float>(net_id + 1));
+					}
+
+					std::vector<float> output_buffer;
+					for(unsigned int tile_id = 0; tile_id < batch_size; ++tile_id)
+					{
+						const tile& t = it->second[batch_start + tile_id];
+						unsigned int output_neuron_count = output_config.feature_map_count;
+						for(unsigned int i = 0; i < dimension_count; ++i)
+							output_neuron_count *= t.output_sizes[i];
+						output_buffer.resize(output_neuron_count);
+						copy_region(tile_output_config, t.local_output_offsets, t.output_sizes, &average_output_set->neuron_value_list[tile_id]->at(0), &output_buffer[0]);
+						writer.write(entry_id, t.output_offsets, t.output_sizes, &output_buffer[0]);
+					}
+				}
+			}
+		}
+
+		return res;
+	}
+
+	void tiled_inference::copy_region(
+		const layer_configuration_specific& config,
+		const std::vector<unsigned int>& offsets,
+		const std::vector<unsigned int>& sizes,
+		const float * src,
+		float * dst)
+	{
+		unsigned int dimension_count = config.get_dimension_count();
+		unsigned int run_length = sizes[0];
+		unsigned int run_count = config.feature_map_count;
+		for(unsigned int i = 1; i < dimension_count; ++i)
+			run_count *= sizes[i];
+
+		std::vector<unsigned int> position(dimension_count, 0);
+		unsigned int feature_map_id = 0;
+		for(unsigned int run_id = 0; run_id < run_count; ++run_id)
+		{
+			size_t elem_offset = feature_map_id;
+			for(int i = static_cast<int>(dimension_count) - 1; i >= 0; --i)
+				elem_offset = elem_offset * config.dimension_sizes[i] + offsets[i] + position[i];
+
+			std::copy(src + elem_offset, src + elem_offset + run_length, dst);
+			dst += run_length;
+
+			unsigned int i = 1;
+			for(; i < dimension_count; ++i)
+			{
+				if ((++position[i]) < sizes[i])
+					break;
+				position[i] = 0;
+			}
+			if (i >= dimension_count)
+				++feature_map_id;
+		}
+	}
+}
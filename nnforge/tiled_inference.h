@@ -0,0 +1,113 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include "forward_propagation.h"
+#include "network_schema.h"
+#include "network_data.h"
+#include "structured_data_region_reader.h"
+#include "structured_data_region_writer.h"
+
+#include <vector>
+#include <string>
+#include <map>
+#include <memory>
+
+namespace nnforge
+{
+	// Runs dense inference on entries too large to be propagated whole:
+	// the output is split into tiles, input of each tile is extended by the receptive field of the output
+	// (derived from window geometry of the layers), tiles are propagated in batches and stitched into the output.
+	// Output is the same as the one of the whole entry propagated at once
+	class tiled_inference
+	{
+	public:
+		typedef std::shared_ptr<tiled_inference> ptr;
+
+		// tile_size is the number of output positions along each dimension computed by a single tile,
+		// tile_batch_size is the number of tiles propagated at once and bounds the memory used
+		tiled_inference(
+			forward_propagation::ptr forward_prop,
+			const network_schema& schema,
+			const std::string& output_layer_name,
+			unsigned int tile_size,
+			unsigned int tile_batch_size);
+
+		~tiled_inference() = default;
+
+		std::string get_input_layer_name() const;
+
+		layer_configuration_specific get_output_configuration_specific(const layer_configuration_specific& input_configuration_specific) const;
+
+		// Output is averaged across networks in data_list, empty list means the data is set in forward_prop already.
+		// Each tile is counted as an entry in the stat returned
+		forward_propagation::stat run(
+			structured_data_region_reader& reader,
+			structured_data_region_writer& writer,
+			const std::vector<network_data::const_ptr>& data_list);
+
+	private:
+		// Output position i depends on input positions [i * stride + start, i * stride + end)
+		struct receptive_field
+		{
+			unsigned int stride;
+			int start;
+			int end;
+		};
+
+		struct dimension_split
+		{
+			unsigned int input_offset;
+			unsigned int input_size;
+			unsigned int output_offset;
+			unsigned int output_size;
+			// Offset of the 1st output position in the output of the tile
+			unsigned int local_output_offset;
+		};
+
+		struct tile
+		{
+			std::vector<unsigned int> input_offsets;
+			std::vector<unsigned int> output_offsets;
+			std::vector<unsigned int> output_sizes;
+			std::vector<unsigned int> local_output_offsets;
+		};
+
+		std::vector<receptive_field> get_receptive_field_list(const std::map<std::string, layer_configuration_specific>& layer_config_map) const;
+
+		// Copies the region [offsets, offsets + sizes) of src with configuration config to dst densely
+		static void copy_region(
+			const layer_configuration_specific& config,
+			const std::vector<unsigned int>& offsets,
+			const std::vector<unsigned int>& sizes,
+			const float * src,
+			float * dst);
+
+	private:
+		forward_propagation::ptr forward_prop;
+		network_schema::ptr schema;
+		std::string input_layer_name;
+		std::string output_layer_name;
+		unsigned int tile_size;
+		unsigned int tile_batch_size;
+
+	private:
+		tiled_inference() = delete;
+		tiled_inference(const tiled_inference&) = delete;
+		tiled_inference& operator =(const tiled_inference&) = delete;
+	};
+}
@@ -40,14 +40,25 @@
 #include "structured_data_bunch_stream_reader.h"
 #include "data_visualizer.h"
 #include "transformed_structured_data_reader.h"
+#include "materialized_structured_data_reader.h"
 #include "structured_data_constant_reader.h"
 #include "structured_data_bunch_mix_reader.h"
+#include "structured_data_bunch_shard_reader.h"
+#include "structured_data_bunch_range_reader.h"
+#include "structured_data_stream_bunch_writer.h"
+#include "structured_data_stream_region_reader.h"
+#include "structured_data_stream_region_writer.h"
+#include "tiled_inference.h"
+#include "shared_memory_allreducer.h"
 #include "neuron_value_set_data_bunch_reader.h"
 #include "exponential_learning_rate_decay_policy.h"
 #include "step_learning_rate_decay_policy.h"
 #include "batch_norm_layer.h"
+#include "dropout_layer.h"
+#include "convolution_layer.h"
 #include "stat_data_bunch_writer.h"
 #include "training_data_util.h"
+#include "convolution_pruner.h"
 
 namespace nnforge
 {
@@ -117,6 +128,10 @@ namespace nnforge
 		{
 			update_bn_weights();
 		}
+		else if (!action.compare("prune"))
+		{
+			prune();
+		}
 		else
 		{
 			do_custom_action();
@@ -267,6 +282,8 @@ namespace nnforge
 		}
 
 		boost::filesystem::path logfile_path = get_working_data_folder() / logfile_name;
+		if (training_worker_rank > 0)
+			logfile_path.replace_extension((boost::format("worker%1%.txt") % training_worker_rank).str());
 		if (log_mode == "redirect")
 		{
 			out_to_log_redirector = std::shared_ptr<stream_redirector>(new stream_redirector(logfile_path));
@@ -326,14 +343,14 @@ namespace nnforge
 	{
 		std::vector<string_option> res;
 
-		res.push_back(string_option("action", &action, get_default_action().c_str(), "run action (info, prepare_training_data, prepare_testing_data, shuffle_data, dump_data, dump_schema, create_normalizer, inference, train, save_random_weights, update_bn_weights)"));
+		res.push_back(string_option("action", &action, get_default_action().c_str(), "run action (info, prepare_training_data, prepare_testing_data, shuffle_data, dump_data, dump_schema, create_normalizer, inference, train, save_random_weights, update_bn_weights, prune)"));
 		res.push_back(string_option("schema", &schema_filename, "schema.txt", "Name of the file with schema of the network, in protobuf format"));
 		res.push_back(string_option("inference_dataset_name", &inference_dataset_name, "validating", "Name of the dataset to be used for inference"));
 		res.push_back(string_option("training_dataset_name", &training_dataset_name, "training", "Name of the dataset to be used for training"));
 		res.push_back(string_option("shuffle_dataset_name", &shuffle_dataset_name, "training", "Name of the dataset to be shuffled"));
 		res.push_back(string_option("training_algo", &training_algo, "", "Training algorithm (sgd)"));
 		res.push_back(string_option("momentum_type", &momentum_type_str, "vanilla", "Type of the momentum to use (none, vanilla, nesterov, adam)"));
-		res.push_back(string_option("inference_mode", &inference_mode, "report_average_per_entry", "What to do with inference_output_layer_name (report_average_per_nn, dump_average_across_nets)"));
+		res.push_back(string_option("inference_mode", &inference_mode, "report_average_per_entry", "What to do with inference_output_layer_name (report_average_per_nn, dump_average_across_nets, stream_average_across_nets, tiled_average_across_nets)"));
 		res.push_back(string_option("inference_output_dataset_name", &inference_output_dataset_name, "", "Name of the dataset dumped during inference, empty value means using inference_dataset_name"));
 		res.push_back(string_option("dump_dataset_name", &dump_dataset_name, "training", "Name of the dataset to dump data from"));
 		res.push_back(string_option("dump_layer_name", &dump_layer_name, "", "Name of the layer to dump data from"));
@@ -344,8 +361,12 @@ namespace nnforge
 		res.push_back(string_option("normalizer_layer_name", &normalizer_layer_name, "", "Name of the layer to create normalizer for"));
 		res.push_back(string_option("log_mode", &log_mode, "duplicate", "Duplicate or redirect output to log file (duplicate, redirect)"));
 		res.push_back(string_option("check_gradient_weights", &check_gradient_weights, "::", "The set of weights to check for gradient, in the form Layer:WeightSet:WeightID"));
+		res.push_back(string_option("check_gradient_mode", &check_gradient_mode, "per_weight", "How to check gradient (per_weight, directional)"));
 		res.push_back(string_option("learning_rate_policy", &learning_rate_policy, "exponential", "Learning rate decay policy (exponential, step)"));
 		res.push_back(string_option("step_learning_rate_epochs_and_rates", &step_learning_rate_epochs_and_rates, "", "List of start epoch and decay for step learining rate policy, for example 30:0.1:60:0.01"));
+		res.push_back(string_option("training_allreduce_name", &training_allreduce_name, "nnforge_allreduce", "Name of the shared memory segment data-parallel training workers sum gradients through"));
+		res.push_back(string_option("training_run_id", &training_run_id, "", "ID of data-parallel training run, the same for all the workers and unique for each run, launch timestamp for example"));
+		res.push_back(string_option("cache_spill_folder", &cache_spill_folder, "", "Local folder for decoded image cache and materialized data files, empty value means system temporary folder"));
 
 		return res;
 	}
@@ -359,6 +380,8 @@ namespace nnforge
 		res.push_back(multi_string_option("training_output_layer_name", &training_output_layer_names, "Names of the output layers when doing training"));
 		res.push_back(multi_string_option("training_error_source_layer_name", &training_error_source_layer_names, "Names of the error sources for training"));
 		res.push_back(multi_string_option("training_exclude_data_update_layer_name", &training_exclude_data_update_layer_names, "Names of layers which shouldn't be trained"));
+		res.push_back(multi_string_option("prune_layer_name", &prune_layer_names, "Names of the convolution layers to prune, all of them are pruned if none specified"));
+		res.push_back(multi_string_option("decoded_image_cache", &decoded_image_cache_list, "Decoded image cache for the dataset, in the form Dataset:RAM_MB:Disk_MB:MaxSide, for example training:8192:32768:512 (0 disk disables spilling, 0 max side disables downscaling)"));
 
 		return res;
 	}
@@ -383,6 +406,7 @@ namespace nnforge
 		res.push_back(bool_option("resume_from_snapshot,R", &resume_from_snapshot, false, "Continue neural network training starting from saved snapshot"));
 		res.push_back(bool_option("dump_snapshot", &dump_snapshot, true, "Dump neural network data after each epoch"));
 		res.push_back(bool_option("dump_data_rgb", &dump_data_rgb, true, "Treat 3 feature map data layer as RGB"));
+		res.push_back(bool_option("materialize_deterministic_data", &materialize_deterministic_data, false, "Compute deterministic part of data transformation once and re-use it across epochs"));
 
 		return res;
 	}
@@ -400,6 +424,9 @@ namespace nnforge
 		res.push_back(float_option("check_gradient_base_step", &check_gradient_base_step, 1.0e-2F, "Base step size for gradient check"));
 		res.push_back(float_option("check_gradient_relative_threshold_warning", &check_gradient_relative_threshold_warning, 0.2F, "Threshold for gradient check"));
 		res.push_back(float_option("check_gradient_relative_threshold_error", &check_gradient_relative_threshold_error, 1.0F, "Threshold for gradient check"));
+		res.push_back(float_option("prune_sparsity", &prune_sparsity, 0.5F, "Part of feature map connections removed from each convolution layer pruned"));
+		res.push_back(float_option("training_allreduce_timeout", &training_allreduce_timeout, 600.0F, "Seconds data-parallel training workers wait for each other before failing"));
+		res.push_back(float_option("prune_flops_ratio", &prune_flops_ratio, 0.0F, "Inference flops of the pruned network relative to the dense one, overrides prune_sparsity when positive"));
 
 		return res;
 	}
@@ -420,9 +447,16 @@ namespace nnforge
 		res.push_back(int_option("epoch_count_in_training_dataset", &epoch_count_in_training_dataset, 1, "The whole training dataset should be split in this amount of epochs"));
 		res.push_back(int_option("epoch_count_in_validating_dataset", &epoch_count_in_validating_dataset, 1, "Splitting validating dataset in multiple chunks, effectively the first chunk only will be used for inference"));
 		res.push_back(int_option("dump_compact_samples", &dump_compact_samples, 1, "Compact (average) results acrioss samples for inference of type dump_average_across_nets"));
+		res.push_back(int_option("inference_stream_chunk_size", &inference_stream_chunk_size, 65536, "Entries processed by all the networks at once for inference of type stream_average_across_nets"));
+		res.push_back(int_option("inference_tile_size", &inference_tile_size, 256, "Output positions along each dimension computed by a single tile for inference of type tiled_average_across_nets"));
+		res.push_back(int_option("inference_tile_batch_size", &inference_tile_batch_size, 4, "Tiles processed at once for inference of type tiled_average_across_nets"));
 		res.push_back(int_option("shuffle_block_size", &shuffle_block_size, 0, "The size of contiguous blocks when shuffling training data, 0 indicates no shuffling"));
 		res.push_back(int_option("check_gradient_max_weights_per_set", &check_gradient_max_weights_per_set, 20, "The maximum amount of weights to check in the set"));
+		res.push_back(int_option("check_gradient_direction_count", &check_gradient_direction_count, 8, "The amount of random directions to check in the set for gradient check of type directional"));
 		res.push_back(int_option("keep_snapshots_frequency", &keep_snapshots_frequency, 10, "Keep every Nth snapshot"));
+		res.push_back(int_option("training_worker_count", &training_worker_count, 1, "Amount of data-parallel training processes on this host, each one is run with its own training_worker_rank"));
+		res.push_back(int_option("training_worker_rank", &training_worker_rank, 0, "Rank of this data-parallel training process, the one with rank 0 saves snapshots and validates"));
+		res.push_back(int_option("materialized_data_ram_limit", &materialized_data_ram_limit, 1024, "Materialized data larger than this amount of MB is kept in a file in the cache spill folder"));
 
 		return res;
 	}
@@ -548,6 +582,11 @@ namespace nnforge
 
 	std::map<unsigned int, std::map<std::string, std::pair<layer_configuration_specific, std::vector<double> > > > toolset::run_inference()
 	{
+		if (inference_mode == "stream_average_across_nets")
+			return run_inference_streaming();
+		if (inference_mode == "tiled_average_across_nets")
+			return run_inference_tiled();
+
 		std::map<unsigned int, std::map<std::string, std::pair<layer_configuration_specific, std::vector<double> > > > res;
 
 		network_schema::ptr schema = get_schema(schema_usage_inference);
@@ -652,6 +691,52 @@ namespace nnforge
 		return res;
 	}
 
+	decoded_image_cache::ptr toolset::get_decoded_image_cache(
+		const std::string& dataset_name,
+		const std::string& layer_name) const
+	{
+		std::string key = dataset_name + "_" + layer_name;
+		std::map<std::string, decoded_image_cache::ptr>::const_iterator cache_it = decoded_image_caches.find(key);
+		if (cache_it != decoded_image_caches.end())
+			return cache_it->second;
+
+		for(std::vector<std::string>::const_iterator it = decoded_image_cache_list.begin(); it != decoded_image_cache_list.end(); ++it)
+		{
+			std::vector<std::string> strs;
+			boost::split(strs, *it, boost::is_any_of(":"));
+			if ((strs.size() < 2) || (strs.size() > 4))
+				throw neural_network_exception((boost::format("Invalid decoded image cache setting: %1%") % *it).str());
+
+			if (strs[0] != dataset_name)
+				continue;
+
+			size_t ram_budget_bytes = static_cast<size_t>(atol(strs[1].c_str())) << 20;
+			size_t disk_budget_bytes = (strs.size() > 2) ? (static_cast<size_t>(atol(strs[2].c_str())) << 20) : 0;
+			unsigned int max_side = (strs.size() > 3) ? static_cast<unsigned int>(atol(strs[3].c_str())) : 0;
+
+			boost::filesystem::path spill_file_path = get_cache_spill_file_path(key);
+
+			std::cout << "Caching decoded images of " << key << ": " << (ram_budget_bytes >> 20) << " MB RAM, " << (disk_budget_bytes >> 20) << " MB disk";
+			if (disk_budget_bytes > 0)
+				std::cout << " at " << spill_file_path.string();
+			if (max_side > 0)
+				std::cout << ", max side " << max_side;
+			std::cout << std::endl;
+
+			decoded_image_cache::ptr res(new decoded_image_cache(ram_budget_bytes, disk_budget_bytes, spill_file_path, max_side));
+			decoded_image_caches.insert(std::make_pair(key, res));
+			return res;
+		}
+
+		return decoded_image_cache::ptr();
+	}
+
+	boost::filesystem::path toolset::get_cache_spill_file_path(const std::string& prefix) const
+	{
+		boost::filesystem::path spill_folder = cache_spill_folder.empty() ? boost::filesystem::temp_directory_path() : boost::filesystem::path(cache_spill_folder);
+		return spill_folder / boost::filesystem::unique_path((boost::format("nnforge_%1%_%%%%%%%%.cache") % prefix).str());
+	}
+
 	structured_data_bunch_reader::ptr toolset::get_structured_data_bunch_reader(
 		const std::string& dataset_name,
 		dataset_usage usage,
@@ -685,6 +770,190 @@ namespace nnforge
 		else return 0.0F;
 	}
 
+	std::map<unsigned int, std::map<std::string, std::pair<layer_configuration_specific, std::vector<double> > > > toolset::run_inference_streaming()
+	{
+		network_schema::ptr schema = get_schema(schema_usage_inference);
+		forward_propagation::ptr forward_prop = forward_prop_factory->create(*schema, inference_output_layer_names, debug, profile);
+		structured_data_bunch_reader::ptr reader = get_structured_data_bunch_reader(inference_dataset_name, dataset_usage_inference, epoch_count_in_validating_dataset, 0);
+
+		// Network data is small compared to the output, so all the networks are kept in memory
+		std::vector<std::pair<unsigned int, network_data::ptr> > ann_index_and_data_list;
+		if (forward_prop->is_schema_with_weights())
+		{
+			std::vector<std::pair<unsigned int, boost::filesystem::path> > ann_data_name_and_folderpath_list = get_ann_data_index_and_folderpath_list();
+			for(std::vector<std::pair<unsigned int, boost::filesystem::path> >::const_iterator it = ann_data_name_and_folderpath_list.begin(); it != ann_data_name_and_folderpath_list.end(); ++it)
+			{
+				network_data::ptr data(new network_data());
+				data->read(it->second);
+				ann_index_and_data_list.push_back(std::make_pair(it->first, data));
+			}
+		}
+		else
+		{
+			ann_index_and_data_list.push_back(std::make_pair(0, network_data::ptr(new network_data())));
+		}
+		std::cout << "Running streaming inference for " << ann_index_and_data_list.size() << " networks..." << std::endl;
+
+		unsigned int compact_sample_count = static_cast<unsigned int>(std::max(dump_compact_samples, 1));
+		unsigned int chunk_entry_count = (static_cast<unsigned int>(std::max(inference_stream_chunk_size, 1)) + compact_sample_count - 1) / compact_sample_count * compact_sample_count;
+
+		std::string dataset_name = inference_output_dataset_name.empty() ? inference_dataset_name : inference_output_dataset_name;
+		std::map<std::string, std::shared_ptr<std::ostream> > layer_name_to_stream_map;
+		for(std::vector<std::string>::const_iterator it = inference_output_layer_names.begin(); it != inference_output_layer_names.end(); ++it)
+		{
+			std::string file_name = (boost::format("%1%_%2%.dt") % dataset_name % *it).str();
+			boost::filesystem::path file_path = get_working_data_folder() / file_name;
+			std::cout << "Writing " << file_path.string() << std::endl;
+			layer_name_to_stream_map.insert(std::make_pair(*it, std::shared_ptr<std::ostream>(new boost::filesystem::ofstream(file_path, std::ios_base::out | std::ios_base::trunc | std::ios_base::binary))));
+		}
+		structured_data_stream_bunch_writer output_writer(layer_name_to_stream_map, chunk_entry_count / compact_sample_count);
+
+		std::vector<forward_propagation::stat> stat_list(ann_index_and_data_list.size());
+		for(std::vector<forward_propagation::stat>::iterator it = stat_list.begin(); it != stat_list.end(); ++it)
+		{
+			it->entry_processed_count = 0;
+			it->flops_per_entry = 0.0F;
+			it->total_seconds = 0.0F;
+		}
+		std::vector<std::map<std::string, std::pair<layer_configuration_specific, std::vector<double> > > > sum_list(ann_index_and_data_list.size());
+
+		unsigned int output_entry_id = 0;
+		for(unsigned int start_entry_id = 0; ; start_entry_id += chunk_entry_count)
+		{
+			structured_data_bunch_reader::ptr chunk_reader(new structured_data_bunch_range_reader(reader, start_entry_id, chunk_entry_count));
+
+			std::map<std::string, std::pair<layer_configuration_specific, neuron_value_set::ptr> > average_layer_name_to_config_and_value_set_map;
+			unsigned int chunk_entry_processed_count = 0;
+			for(unsigned int ann_id = 0; ann_id < ann_index_and_data_list.size(); ++ann_id)
+			{
+				forward_prop->set_data(*ann_index_and_data_list[ann_id].second);
+
+				neuron_value_set_data_bunch_writer writer;
+				forward_propagation::stat st = forward_prop->run(*chunk_reader, writer);
+				chunk_entry_processed_count = st.entry_processed_count;
+				stat_list[ann_id].entry_processed_count += st.entry_processed_count;
+				stat_list[ann_id].flops_per_entry = st.flops_per_entry;
+				stat_list[ann_id].total_seconds += st.total_seconds;
+				if (st.entry_processed_count == 0)
+					break;
+
+				for(std::map<std::string, std::pair<layer_configuration_specific, neuron_value_set::ptr> >::iterator it = writer.layer_name_to_config_and_value_set_map.begin(); it != writer.layer_name_to_config_and_value_set_map.end(); ++it)
+				{
+					std::shared_ptr<std::vector<double> > average_list = it->second.second->get_average();
+					std::vector<double>& sums = sum_list[ann_id].insert(std::make_pair(it->first, std::make_pair(it->second.first, std::vector<double>(average_list->size(), 0.0)))).first->second.second;
+					for(unsigned int i = 0; i < average_list->size(); ++i)
+						sums[i] += average_list->at(i) * static_cast<double>(st.entry_processed_count);
+
+					it->second.second->compact(compact_sample_count);
+
+					if (ann_id == 0)
+						average_layer_name_to_config_and_value_set_map.insert(*it);
+					else
+					{
+						float alpha = 1.0F / static_cast<float>(ann_id + 1);
+						float beta = 1.0F - alpha;
+						average_layer_name_to_config_and_value_set_map[it->first].second->add(*it->second.second, alpha, beta);
+					}
+				}
+			}
+
+			if (chunk_entry_processed_count == 0)
+				break;
+
+			if (start_entry_id == 0)
+			{
+				std::map<std::string, layer_configuration_specific> config_map;
+				for(std::map<std::string, std::pair<layer_configuration_specific, neuron_value_set::ptr> >::const_iterator it = average_layer_name_to_config_and_value_set_map.begin(); it != average_layer_name_to_config_and_value_set_map.end(); ++it)
+					config_map.insert(std::make_pair(it->first, it->second.first));
+				output_writer.set_config_map(config_map);
+			}
+
+			unsigned int chunk_output_entry_count = chunk_entry_processed_count / compact_sample_count;
+			for(unsigned int entry_id = 0; entry_id < chunk_output_entry_count; ++entry_id, ++output_entry_id)
+			{
+				std::map<std::string, const float *> data_map;
+				for(std::map<std::string, std::pair<layer_configuration_specific, neuron_value_set::ptr> >::const_iterator it = average_layer_name_to_config_and_value_set_map.begin(); it != average_layer_name_to_config_and_value_set_map.end(); ++it)
+					data_map.insert(std::make_pair(it->first, &(*it->second.second->neuron_value_list[entry_id])[0]));
+				output_writer.write(output_entry_id, data_map);
+			}
+
+			std::cout << output_entry_id << " entries written" << std::endl;
+
+			if (chunk_entry_processed_count < chunk_entry_count)
+				break;
+		}
+
+		output_writer.flush();
+
+		std::map<unsigned int, std::map<std::string, std::pair<layer_configuration_specific, std::vector<double> > > > res;
+		for(unsigned int ann_id = 0; ann_id < ann_index_and_data_list.size(); ++ann_id)
+		{
+			if (forward_prop->is_schema_with_weights())
+				std::cout << "NN # " << ann_index_and_data_list[ann_id].first << " - " << stat_list[ann_id] << std::endl;
+			else
+				std::cout << "NN <no weights uniform> - " << stat_list[ann_id] << std::endl;
+
+			for(std::map<std::string, std::pair<layer_configuration_specific, std::vector<double> > >::iterator it = sum_list[ann_id].begin(); it != sum_list[ann_id].end(); ++it)
+			{
+				double mult = 1.0 / static_cast<double>(std::max(stat_list[ann_id].entry_processed_count, 1U));
+				for(std::vector<double>::iterator it2 = it->second.second.begin(); it2 != it->second.second.end(); ++it2)
+					*it2 *= mult;
+			}
+			res.insert(std::make_pair(ann_index_and_data_list[ann_id].first, sum_list[ann_id]));
+		}
+
+		return res;
+	}
+
+	std::map<unsigned int, std::map<std::string, std::pair<layer_configuration_specific, std::vector<double> > > > toolset::run_inference_tiled()
+	{
+		network_schema::ptr schema = get_schema(schema_usage_inference);
+
+		std::vector<network_data::const_ptr> data_list;
+		{
+			forward_propagation::ptr forward_prop = forward_prop_factory->create(*schema, inference_output_layer_names, debug, profile);
+			if (forward_prop->is_schema_with_weights())
+			{
+				std::vector<std::pair<unsigned int, boost::filesystem::path> > ann_data_name_and_folderpath_list = get_ann_data_index_and_folderpath_list();
+				for(std::vector<std::pair<unsigned int, boost::filesystem::path> >::const_iterator it = ann_data_name_and_folderpath_list.begin(); it != ann_data_name_and_folderpath_list.end(); ++it)
+				{
+					network_data::ptr data(new network_data());
+					data->read(it->second);
+					data_list.push_back(data);
+				}
+			}
+			else
+			{
+				data_list.push_back(network_data::ptr(new network_data()));
+			}
+		}
+		std::cout << "Running tiled inference for " << data_list.size() << " networks..." << std::endl;
+
+		std::string dataset_name = inference_output_dataset_name.empty() ? inference_dataset_name : inference_output_dataset_name;
+		for(std::vector<std::string>::const_iterator it = inference_output_layer_names.begin(); it != inference_output_layer_names.end(); ++it)
+		{
+			forward_propagation::ptr forward_prop = forward_prop_factory->create(*schema, std::vector<std::string>(1, *it), debug, profile);
+			tiled_inference inference(forward_prop, *schema, *it, static_cast<unsigned int>(std::max(inference_tile_size, 1)), static_cast<unsigned int>(std::max(inference_tile_batch_size, 1)));
+
+			boost::filesystem::path input_file_path = get_working_data_folder() / (boost::format("%1%_%2%.dt") % inference_dataset_name % inference.get_input_layer_name()).str();
+			if (!boost::filesystem::exists(input_file_path))
+				throw neural_network_exception((boost::format("Error running tiled inference, file not found: %1%") % input_file_path.string()).str());
+			structured_data_stream_region_reader reader(std::shared_ptr<std::istream>(new boost::filesystem::ifstream(input_file_path, std::ios_base::in | std::ios_base::binary)));
+
+			boost::filesystem::path output_file_path = get_working_data_folder() / (boost::format("%1%_%2%.dt") % dataset_name % *it).str();
+			std::cout << "Writing " << output_file_path.string() << std::endl;
+			structured_data_stream_region_writer writer(
+				std::shared_ptr<std::ostream>(new boost::filesystem::ofstream(output_file_path, std::ios_base::out | std::ios_base::trunc | std::ios_base::binary)),
+				inference.get_output_configuration_specific(reader.get_configuration()),
+				reader.get_entry_count());
+
+			forward_propagation::stat st = inference.run(reader, writer, data_list);
+			std::cout << *it << " - " << st << std::endl;
+		}
+
+		return std::map<unsigned int, std::map<std::string, std::pair<layer_configuration_specific, std::vector<double> > > >();
+	}
+
 	boost::filesystem::path toolset::get_ann_subfolder_name() const
 	{
 		return ann_subfolder_name;
@@ -747,6 +1016,9 @@ namespace nnforge
 			starting_index = std::max(starting_index, it->index + 1);
 		std::shared_ptr<network_data_peeker> peeker = std::shared_ptr<network_data_peeker>(new network_data_peeker_random(ann_count, starting_index, leading_tasks));
 
+		// Data-parallel workers other than the leading one train on their shards only, without touching the snapshot folder
+		bool is_leading_worker = (training_worker_rank == 0);
+
 		complex_network_data_pusher progress;
 
 		progress.push_back(network_data_pusher::ptr(new report_progress_network_data_pusher()));
@@ -754,20 +1026,25 @@ namespace nnforge
 		std::vector<network_data_pusher::ptr> train_modifiers_before_snapshot = get_train_modifiers_before_snapshot(get_schema(schema_usage_train));
 		progress.insert(progress.end(), train_modifiers_before_snapshot.begin(), train_modifiers_before_snapshot.end());
 
-		if (dump_snapshot)
+		if (dump_snapshot && is_leading_worker)
 		{
 			progress.push_back(network_data_pusher::ptr(new save_snapshot_network_data_pusher(batch_snapshot_folder)));
 		}
 
-		if (keep_snapshots_frequency > 1)
+		if ((keep_snapshots_frequency > 1) && is_leading_worker)
 		{
 			progress.push_back(network_data_pusher::ptr(new clean_snapshots_network_data_pusher(batch_snapshot_folder, keep_snapshots_frequency)));
 		}
 
-		std::vector<network_data_pusher::ptr> validators_for_training = get_validators_for_training(get_schema(schema_usage_validate_when_train));
-		progress.insert(progress.end(), validators_for_training.begin(), validators_for_training.end());
+		if (is_leading_worker)
+		{
+			std::vector<network_data_pusher::ptr> validators_for_training = get_validators_for_training(get_schema(schema_usage_validate_when_train));
+			progress.insert(progress.end(), validators_for_training.begin(), validators_for_training.end());
+		}
 
-		summarize_network_data_pusher res(batch_folder);
+		complex_network_data_pusher res;
+		if (is_leading_worker)
+			res.push_back(network_data_pusher::ptr(new summarize_network_data_pusher(batch_folder)));
 
 		structured_data_bunch_reader::ptr reader = get_structured_data_bunch_reader(training_dataset_name, dataset_usage_train, epoch_count_in_training_dataset, shuffle_block_size);
 
@@ -777,6 +1054,9 @@ namespace nnforge
 			reader = structured_data_bunch_reader::ptr(new structured_data_bunch_mix_reader(reader, validating_reader, training_mix_validating_ratio));
 		}
 
+		if (training_worker_count > 1)
+			reader = structured_data_bunch_reader::ptr(new structured_data_bunch_shard_reader(reader, training_worker_count, training_worker_rank));
+
 		trainer->train(
 			*reader,
 			*peeker,
@@ -967,6 +1247,9 @@ namespace nnforge
 			debug,
 			profile);
 
+		if (training_worker_count > 1)
+			backprop->set_gradient_allreducer(shared_memory_allreducer::ptr(new shared_memory_allreducer(training_allreduce_name, training_run_id, training_worker_count, training_worker_rank, training_allreduce_timeout)));
+
 		if (training_algo == "sgd")
 		{
 			network_trainer_sgd::ptr typed_res(
@@ -1231,11 +1514,33 @@ namespace nnforge
 		structured_data_reader::ptr original_reader,
 		const std::vector<data_transformer::ptr>& data_transformer_list) const
 	{
+		// Output of the leading deterministic transformers is computed once, in case the original reader is deterministic as well
+		unsigned int deterministic_transformer_count = 0;
+		if (materialize_deterministic_data && original_reader->is_deterministic() && (original_reader->get_entry_count() >= 0))
+		{
+			while ((deterministic_transformer_count < data_transformer_list.size()) && data_transformer_list[deterministic_transformer_count]->is_deterministic())
+				++deterministic_transformer_count;
+		}
+
 		structured_data_reader::ptr current_reader = original_reader;
-		for(std::vector<data_transformer::ptr>::const_iterator it = data_transformer_list.begin(); it != data_transformer_list.end(); ++it)
+		for(unsigned int i = 0; i < data_transformer_list.size(); ++i)
 		{
-			structured_data_reader::ptr new_reader(new transformed_structured_data_reader(current_reader, *it));
+			structured_data_reader::ptr new_reader(new transformed_structured_data_reader(current_reader, data_transformer_list[i]));
 			current_reader = new_reader;
+
+			if (i + 1 == deterministic_transformer_count)
+			{
+				size_t ram_limit_bytes = static_cast<size_t>(materialized_data_ram_limit) << 20;
+				boost::filesystem::path spill_file_path = get_cache_spill_file_path("materialized");
+				size_t total_bytes = static_cast<size_t>(current_reader->get_entry_count()) * current_reader->get_configuration().get_neuron_count() * sizeof(float);
+				std::cout << "Materializing output of " << deterministic_transformer_count << " deterministic data transformers, " << (total_bytes >> 20) << " MB";
+				if (total_bytes > ram_limit_bytes)
+					std::cout << " at " << spill_file_path.string();
+				std::cout << std::endl;
+
+				structured_data_reader::ptr materialized_reader(new materialized_structured_data_reader(current_reader, ram_limit_bytes, spill_file_path));
+				current_reader = materialized_reader;
+			}
 		}
 		return current_reader;
 	}
@@ -1296,6 +1601,9 @@ namespace nnforge
 		if (!check_gradient_weight_params[2].empty())
 			param_weight_id = atol(check_gradient_weight_params[2].c_str());
 
+		if ((check_gradient_mode != "per_weight") && (check_gradient_mode != "directional"))
+			throw neural_network_exception((boost::format("Unknown check_gradient_mode specified: %1%") % check_gradient_mode).str());
+
 		network_schema::ptr schema = get_schema(schema_usage_train);
 		std::vector<layer::const_ptr> schema_data_layers = schema->get_data_layers();
 		std::set<std::string> training_data_layer_names_set;
@@ -1350,6 +1658,12 @@ namespace nnforge
 		network_data data;
 		data.read(data_path);
 
+		if (check_gradient_mode == "directional")
+		{
+			check_gradient_directional(*schema, *reader, *backprop, data, param_layer_name, param_weight_set);
+			return;
+		}
+
 		std::map<std::string, std::vector<float> > learning_rates;
 		std::vector<std::string> weights_layer_names = data.data_list.get_data_layer_name_list();
 		std::set<std::string> weights_layer_names_set(weights_layer_names.begin(), weights_layer_names.end());
@@ -1377,7 +1691,7 @@ namespace nnforge
 				unsigned int warning_count = 0;
 				unsigned int total_weight_count = 0;
 
-				std::vector<float>& weight_list = dt->at(weight_set);
+				layer_data_part& weight_list = dt->at(weight_set);
 				std::vector<int> weight_id_list;
 				if (param_weight_id != -1)
 				{
@@ -1406,7 +1720,7 @@ namespace nnforge
 				float& learning_rate = learning_rates[layer_name][weight_set];
 				learning_rate = 1.0e+6F;
 
-				std::vector<float> original_weights = weight_list;
+				std::vector<float> original_weights(weight_list.begin(), weight_list.end());
 				double original_error = 0.0;
 				std::vector<float> gradient_backprops(weight_id_list.size());
 				{
@@ -1527,6 +1841,223 @@ namespace nnforge
 			std::cout << *it << std::endl;
 	}
 
+	void toolset::check_gradient_directional(
+		const network_schema& schema,
+		structured_data_bunch_reader& reader,
+		backward_propagation& backprop,
+		network_data& data,
+		const std::string& param_layer_name,
+		int param_weight_set)
+	{
+		std::vector<std::string> weights_layer_names = data.data_list.get_data_layer_name_list();
+		std::set<std::string> weights_layer_names_set(weights_layer_names.begin(), weights_layer_names.end());
+
+		// Gradient for all the weights checked is obtained with a single backward prop run, from the update with huge learning rate
+		const float learning_rate = 1.0e+6F;
+		std::map<std::string, std::vector<float> > learning_rates;
+		std::map<std::string, std::vector<std::pair<int, std::vector<float> > > > layer_name_to_original_weights_map;
+		for(std::set<std::string>::const_iterator it = weights_layer_names_set.begin(); it != weights_layer_names_set.end(); ++it)
+		{
+			layer_data::ptr dt = data.data_list.get(*it);
+			std::vector<float>& layer_learning_rates = learning_rates.insert(std::make_pair(*it, std::vector<float>(dt->size(), 0.0F))).first->second;
+			if (!param_layer_name.empty() && (*it != param_layer_name))
+				continue;
+
+			std::vector<std::pair<int, std::vector<float> > >& original_weights_list = layer_name_to_original_weights_map.insert(std::make_pair(*it, std::vector<std::pair<int, std::vector<float> > >())).first->second;
+			for(int weight_set = 0; weight_set < static_cast<int>(dt->size()); ++weight_set)
+			{
+				if ((param_weight_set != -1) && (weight_set != param_weight_set))
+					continue;
+				if (dt->at(weight_set).empty())
+					continue;
+				layer_learning_rates[weight_set] = learning_rate;
+				original_weights_list.push_back(std::make_pair(weight_set, std::vector<float>(dt->at(weight_set).begin(), dt->at(weight_set).end())));
+			}
+		}
+
+		double original_error = 0.0;
+		{
+			neuron_value_set_data_bunch_writer writer;
+			backprop.run(
+				reader,
+				writer,
+				data,
+				network_data::ptr(),
+				network_data::ptr(),
+				learning_rates,
+				batch_size,
+				0.0F,
+				training_momentum(training_momentum::no_momentum),
+				0);
+			for(std::vector<std::string>::const_iterator it = training_error_source_layer_names.begin(); it != training_error_source_layer_names.end(); ++it)
+			{
+				std::shared_ptr<std::vector<double> > averages = writer.layer_name_to_config_and_value_set_map.find(*it)->second.second->get_average();
+				original_error += std::accumulate(averages->begin(), averages->end(), 0.0);
+			}
+		}
+
+		std::map<std::string, std::vector<std::vector<float> > > layer_name_to_gradients_map;
+		for(std::map<std::string, std::vector<std::pair<int, std::vector<float> > > >::const_iterator it = layer_name_to_original_weights_map.begin(); it != layer_name_to_original_weights_map.end(); ++it)
+		{
+			layer_data::ptr dt = data.data_list.get(it->first);
+			std::vector<std::vector<float> >& gradients = layer_name_to_gradients_map.insert(std::make_pair(it->first, std::vector<std::vector<float> >())).first->second;
+			for(std::vector<std::pair<int, std::vector<float> > >::const_iterator it2 = it->second.begin(); it2 != it->second.end(); ++it2)
+			{
+				layer_data_part& weight_list = dt->at(it2->first);
+				const std::vector<float>& original_weights = it2->second;
+				gradients.push_back(std::vector<float>(weight_list.size()));
+				std::vector<float>& gradient = gradients.back();
+				for(unsigned int weight_id = 0; weight_id < static_cast<unsigned int>(weight_list.size()); ++weight_id)
+					gradient[weight_id] = -(weight_list[weight_id] - original_weights[weight_id]) / learning_rate;
+				std::copy(original_weights.begin(), original_weights.end(), weight_list.begin());
+			}
+		}
+		std::cout << "Error = " << original_error << std::endl;
+
+		// Perturbed errors are obtained with 2 runs per direction. Forward prop is used unless the schema has layers behaving
+		// differently in training and inference (dropout, batch norm), backward prop with zero learning rates then matches the backprop gradient
+		forward_propagation::ptr forward_prop;
+		{
+			bool training_mode_required = false;
+			std::vector<layer::const_ptr> layers = schema.get_layers();
+			for(std::vector<layer::const_ptr>::const_iterator it = layers.begin(); it != layers.end(); ++it)
+			{
+				if (((*it)->get_type_name() == dropout_layer::layer_type_name) || ((*it)->get_type_name() == batch_norm_layer::layer_type_name))
+				{
+					training_mode_required = true;
+					break;
+				}
+			}
+			if (!training_mode_required)
+				forward_prop = forward_prop_factory->create(schema, training_error_source_layer_names, debug, profile);
+		}
+		std::map<std::string, std::vector<float> > zero_learning_rates;
+		for(std::map<std::string, std::vector<float> >::const_iterator it = learning_rates.begin(); it != learning_rates.end(); ++it)
+			zero_learning_rates.insert(std::make_pair(it->first, std::vector<float>(it->second.size(), 0.0F)));
+
+		random_generator direction_gen = rnd::get_random_generator(637463);
+		std::normal_distribution<float> direction_dist(0.0F, 1.0F);
+		std::vector<layer::const_ptr> layers_ordered = schema.get_layers_in_forward_propagation_order();
+		std::vector<std::string> summary_messages;
+		for(std::vector<layer::const_ptr>::const_reverse_iterator layer_it = layers_ordered.rbegin(); layer_it != layers_ordered.rend(); ++layer_it)
+		{
+			const std::string& layer_name = (*layer_it)->instance_name;
+			std::map<std::string, std::vector<std::pair<int, std::vector<float> > > >::const_iterator original_weights_it = layer_name_to_original_weights_map.find(layer_name);
+			if (original_weights_it == layer_name_to_original_weights_map.end())
+				continue;
+
+			layer_data::ptr dt = data.data_list.get(layer_name);
+			const std::vector<std::vector<float> >& gradients = layer_name_to_gradients_map[layer_name];
+			for(unsigned int i = 0; i < static_cast<unsigned int>(original_weights_it->second.size()); ++i)
+			{
+				int weight_set = original_weights_it->second[i].first;
+				const std::vector<float>& original_weights = original_weights_it->second[i].second;
+				const std::vector<float>& gradient = gradients[i];
+				layer_data_part& weight_list = dt->at(weight_set);
+
+				unsigned int error_count = 0;
+				unsigned int warning_count = 0;
+				unsigned int total_direction_count = 0;
+
+				std::vector<float> direction(weight_list.size());
+				for(int direction_id = 0; direction_id < check_gradient_direction_count; ++direction_id)
+				{
+					std::cout << layer_name << ":" << weight_set << ": direction " << direction_id << " ";
+
+					// Unit length random direction, the checked derivative is then of the same scale as the gradient components
+					double direction_norm_squared = 0.0;
+					for(std::vector<float>::iterator it = direction.begin(); it != direction.end(); ++it)
+					{
+						*it = direction_dist(direction_gen);
+						direction_norm_squared += static_cast<double>(*it) * static_cast<double>(*it);
+					}
+					float direction_mult = (direction_norm_squared > 0.0) ? static_cast<float>(1.0 / sqrt(direction_norm_squared)) : 0.0F;
+					double gradient_backprop_double = 0.0;
+					for(unsigned int weight_id = 0; weight_id < static_cast<unsigned int>(direction.size()); ++weight_id)
+					{
+						direction[weight_id] *= direction_mult;
+						gradient_backprop_double += static_cast<double>(gradient[weight_id]) * static_cast<double>(direction[weight_id]);
+					}
+					float gradient_backprop = static_cast<float>(gradient_backprop_double);
+
+					double minus_error = 0.0;
+					double plus_error = 0.0;
+					for(int sign = -1; sign <= 1; sign += 2)
+					{
+						for(unsigned int weight_id = 0; weight_id < static_cast<unsigned int>(weight_list.size()); ++weight_id)
+							weight_list[weight_id] = original_weights[weight_id] + static_cast<float>(sign) * check_gradient_base_step * direction[weight_id];
+						neuron_value_set_data_bunch_writer writer;
+						if (forward_prop)
+						{
+							// Forward prop works on its own copy of the weights
+							forward_prop->set_data(data);
+							forward_prop->run(reader, writer);
+						}
+						else
+						{
+							backprop.run(
+								reader,
+								writer,
+								data,
+								network_data::ptr(),
+								network_data::ptr(),
+								zero_learning_rates,
+								batch_size,
+								0.0F,
+								training_momentum(training_momentum::no_momentum),
+								0);
+						}
+						double& error = (sign < 0) ? minus_error : plus_error;
+						for(std::vector<std::string>::const_iterator it = training_error_source_layer_names.begin(); it != training_error_source_layer_names.end(); ++it)
+						{
+							std::shared_ptr<std::vector<double> > averages = writer.layer_name_to_config_and_value_set_map.find(*it)->second.second->get_average();
+							error += std::accumulate(averages->begin(), averages->end(), 0.0);
+						}
+					}
+					std::copy(original_weights.begin(), original_weights.end(), weight_list.begin());
+
+					float gradient_checked = static_cast<float>(plus_error - minus_error) / (2.0F * check_gradient_base_step);
+
+					float error_original_relative_diff = (gradient_checked == 0.0F) ? check_gradient_relative_threshold_warning : std::max(static_cast<float>(plus_error), static_cast<float>(minus_error)) / 16777216.0F / fabsf(static_cast<float>(plus_error - minus_error));
+					float error_relative_diff = std::max(error_original_relative_diff, check_gradient_relative_threshold_warning);
+
+					float base = std::max(fabsf(gradient_checked), fabsf(gradient_backprop));
+					float absolute_diff = fabsf(gradient_checked - gradient_backprop);
+					float relative_diff;
+					if (base == 0.0F)
+						relative_diff = (absolute_diff == 0.0F) ? 0.0F : error_relative_diff;
+					else
+						relative_diff = absolute_diff / base;
+
+					if (relative_diff >= check_gradient_relative_threshold_error)
+					{
+						std::cout << "ERROR: ";
+						++error_count;
+					}
+					else if (relative_diff >= error_relative_diff)
+					{
+						std::cout << "WARNING: ";
+						++warning_count;
+					}
+					std::cout << "relative_diff=" << relative_diff << ", absolute_diff=" << absolute_diff << ", gradient_backprop=" << gradient_backprop << ", gradient_check=" << gradient_checked << ", error_original_error_relative_diff=" << error_original_relative_diff;
+
+					++total_direction_count;
+
+					std::cout << std::endl;
+				}
+
+				std::stringstream ss;
+				ss << layer_name << ":" << weight_set << ": " << error_count << " errors " << (boost::format("(%|1$.2f|%%)") % (static_cast<float>(error_count) * 100.0F / static_cast<float>(std::max(total_direction_count, 1U)))).str()
+					<< " and " << warning_count << " " << (boost::format("(%|1$.2f|%%)") % (static_cast<float>(warning_count) * 100.0F / static_cast<float>(std::max(total_direction_count, 1U)))).str() << " warnings encountered in " << total_direction_count << " directions ";
+				std::cout << ss.str() << std::endl;
+				summary_messages.push_back(ss.str());
+			}
+		}
+		std::cout << "############## Summary ##############" << std::endl;
+		for(std::vector<std::string>::const_iterator it = summary_messages.begin(); it != summary_messages.end(); ++it)
+			std::cout << *it << std::endl;
+	}
+
 	void toolset::save_random_weights()
 	{
 		network_schema::ptr schema = get_schema(schema_usage_train);
@@ -1590,8 +2121,8 @@ namespace nnforge
 				forward_propagation::ptr forward_prop = forward_prop_factory->create(*schema, std::vector<std::string>(1, layer_name), debug, profile);
 
 				layer_data::ptr dt = data.data_list.get(layer_name);
-				std::vector<float> gamma_saved = dt->at(0);
-				std::vector<float> beta_saved = dt->at(1);
+				std::vector<float> gamma_saved(dt->at(0).begin(), dt->at(0).end());
+				std::vector<float> beta_saved(dt->at(1).begin(), dt->at(1).end());
 				std::fill_n(dt->at(0).begin(), dt->at(0).size(), 1.0F);
 				std::fill_n(dt->at(1).begin(), dt->at(1).size(), 0.0F);
 
@@ -1622,4 +2153,54 @@ namespace nnforge
 			data.write(it->second);
 		}
 	}
+
+	void toolset::prune()
+	{
+		network_schema::ptr schema = load_schema();
+		std::vector<std::string> layer_names = convolution_pruner::get_convolution_layer_names(*schema, prune_layer_names);
+		if (layer_names.empty())
+			throw neural_network_exception("No convolution layers to prune");
+
+		std::map<std::string, unsigned int> connection_counts;
+		if (prune_flops_ratio > 0.0F)
+		{
+			structured_data_bunch_reader::ptr reader = get_structured_data_bunch_reader(inference_dataset_name, dataset_usage_inference, 1, 0);
+			connection_counts = convolution_pruner::get_connection_counts_for_flops(*schema, layer_names, prune_flops_ratio, reader->get_config_map());
+		}
+		else
+		{
+			connection_counts = convolution_pruner::get_connection_counts_for_sparsity(*schema, layer_names, prune_sparsity);
+		}
+
+		std::cout << "Pruning feature map connections of these layers:" << std::endl;
+		for(std::map<std::string, unsigned int>::const_iterator it = connection_counts.begin(); it != connection_counts.end(); ++it)
+		{
+			std::shared_ptr<const convolution_layer> layer_derived = std::dynamic_pointer_cast<const convolution_layer>(schema->get_layer(it->first));
+			std::cout << it->first << ": " << it->second << " out of " << (layer_derived->input_feature_map_count * layer_derived->output_feature_map_count) << std::endl;
+		}
+
+		convolution_pruner pruner(connection_counts);
+		network_schema pruned_schema(pruner.get_pruned_layers(*schema));
+
+		// Networks are pruned before anything is written, so that failure doesn't leave the schema and weights inconsistent
+		std::vector<std::pair<unsigned int, boost::filesystem::path> > ann_data_name_and_folderpath_list = get_ann_data_index_and_folderpath_list();
+		std::cout << "Pruning " << ann_data_name_and_folderpath_list.size() << " networks..." << std::endl;
+		std::vector<network_data::ptr> pruned_data_list;
+		for(std::vector<std::pair<unsigned int, boost::filesystem::path> >::const_iterator it = ann_data_name_and_folderpath_list.begin(); it != ann_data_name_and_folderpath_list.end(); ++it)
+		{
+			network_data data;
+			data.read(it->second);
+			data.check_network_data_consistency(schema->get_layers());
+
+			pruned_data_list.push_back(pruner.get_pruned_data(*schema, data));
+		}
+
+		for(unsigned int i = 0; i < static_cast<unsigned int>(ann_data_name_and_folderpath_list.size()); ++i)
+			pruned_data_list[i]->write(ann_data_name_and_folderpath_list[i].second);
+
+		boost::filesystem::path schema_file_path = get_working_data_folder() / schema_filename;
+		std::cout << "Writing " << schema_file_path.string() << std::endl;
+		boost::filesystem::ofstream out(schema_file_path, std::ios_base::out | std::ios_base::trunc);
+		pruned_schema.write_proto(out);
+	}
 }
@@ -23,6 +23,7 @@
 #include "structured_data_stream_reader.h"
 #include "data_transformer.h"
 #include "normalize_data_transformer.h"
+#include "decoded_image_cache.h"
 
 #include <vector>
 #include <string>
@@ -91,6 +92,14 @@ namespace nnforge
 
 		virtual std::map<unsigned int, std::map<std::string, std::pair<layer_configuration_specific, std::vector<double> > > > run_inference();
 
+		// Runs all the networks chunk by chunk, writing averaged output of each chunk to .dt files as it is ready
+		// Peak memory is independent of the dataset size
+		std::map<unsigned int, std::map<std::string, std::pair<layer_configuration_specific, std::vector<double> > > > run_inference_streaming();
+
+		// Runs all the networks on overlapping tiles of each entry, stitching averaged output into .dt files
+		// Peak memory is independent of the entry size
+		std::map<unsigned int, std::map<std::string, std::pair<layer_configuration_specific, std::vector<double> > > > run_inference_tiled();
+
 		virtual void dump_schema_gv();
 
 		virtual void train();
@@ -121,10 +130,24 @@ namespace nnforge
 
 		virtual void check_gradient();
 
+		// Compares the directional derivative along random directions in the space of each weight set,
+		// computed with central differences by forward prop runs (training mode runs with zero learning rates for schemas with dropout or batch norm),
+		// against the one obtained from the gradient
+		void check_gradient_directional(
+			const network_schema& schema,
+			structured_data_bunch_reader& reader,
+			backward_propagation& backprop,
+			network_data& data,
+			const std::string& param_layer_name,
+			int param_weight_set);
+
 		virtual void save_random_weights();
 
 		virtual void update_bn_weights();
 
+		// Replaces convolution layers with sparse ones, rewriting the schema and the weights of all the networks
+		virtual void prune();
+
 		virtual structured_data_bunch_reader::ptr get_structured_data_bunch_reader(
 			const std::string& dataset_name,
 			dataset_usage usage,
@@ -163,6 +186,15 @@ namespace nnforge
 		// Returns empty smart pointer if no normalize_data_transformer exists for the layer specified
 		normalize_data_transformer::ptr get_normalize_data_transformer(const std::string& layer_name) const;
 
+		// Returns empty smart pointer if no decoded image cache is configured for the dataset.
+		// The cache is shared by all the readers of the layer of the dataset, so it survives across epochs
+		decoded_image_cache::ptr get_decoded_image_cache(
+			const std::string& dataset_name,
+			const std::string& layer_name) const;
+
+		// Returns unique path of a temporary file in the cache spill folder
+		boost::filesystem::path get_cache_spill_file_path(const std::string& prefix) const;
+
 	private:
 		void dump_settings();
 
@@ -189,6 +221,8 @@ namespace nnforge
 		std::shared_ptr<stream_duplicator> out_to_log_duplicator;
 		std::shared_ptr<stream_redirector> out_to_log_redirector;
 
+		mutable std::map<std::string, decoded_image_cache::ptr> decoded_image_caches;
+
 	protected:
 		std::string action;
 		boost::filesystem::path config_file_path;
@@ -238,15 +272,32 @@ namespace nnforge
 		int epoch_count_in_training_dataset;
 		int epoch_count_in_validating_dataset;
 		int dump_compact_samples;
+		int inference_stream_chunk_size;
+		int inference_tile_size;
+		int inference_tile_batch_size;
 		std::string log_mode;
 		float training_mix_validating_ratio;
 		std::string dump_format;
 		int shuffle_block_size;
 		std::string check_gradient_weights;
+		std::string check_gradient_mode;
 		int check_gradient_max_weights_per_set;
+		int check_gradient_direction_count;
 		float check_gradient_base_step;
 		float check_gradient_relative_threshold_warning;
 		float check_gradient_relative_threshold_error;
+		int training_worker_count;
+		int training_worker_rank;
+		std::string training_allreduce_name;
+		std::string training_run_id;
+		float training_allreduce_timeout;
+		std::vector<std::string> decoded_image_cache_list;
+		std::string cache_spill_folder;
+		bool materialize_deterministic_data;
+		int materialized_data_ram_limit;
+		std::vector<std::string> prune_layer_names;
+		float prune_sparsity;
+		float prune_flops_ratio;
 
 		debug_state::ptr debug;
 		profile_state::ptr profile;
@@ -32,18 +32,32 @@ namespace nnforge
 		unsigned int entry_id,
 		float * data)
 	{
-		std::vector<float> original_data(original_config.get_neuron_count());
+		std::shared_ptr<std::vector<float> > original_data;
+		{
+			std::lock_guard<std::mutex> lock(buffer_pool_mutex);
+			if (!buffer_pool.empty())
+			{
+				original_data = buffer_pool.back();
+				buffer_pool.pop_back();
+			}
+		}
+		if (!original_data)
+			original_data = std::shared_ptr<std::vector<float> >(new std::vector<float>(original_config.get_neuron_count()));
 
-		if (!original_reader->read(entry_id / transformer_sample_count, &original_data[0]))
-			return false;
+		bool res = original_reader->read(entry_id / transformer_sample_count, &(*original_data)[0]);
+		if (res)
+			transformer->transform(
+				&(*original_data)[0],
+				data,
+				original_config,
+				entry_id % transformer_sample_count);
 
-		transformer->transform(
-			&original_data[0],
-			data,
-			original_config,
-			entry_id % transformer_sample_count);
+		{
+			std::lock_guard<std::mutex> lock(buffer_pool_mutex);
+			buffer_pool.push_back(original_data);
+		}
 
-		return true;
+		return res;
 	}
 
 	layer_configuration_specific transformed_structured_data_reader::get_configuration() const
@@ -67,4 +81,9 @@ namespace nnforge
 	{
 		throw std::runtime_error("get_writer not implemented for transformed_structured_data_reader");
 	}
+
+	bool transformed_structured_data_reader::is_deterministic() const
+	{
+		return original_reader->is_deterministic() && transformer->is_deterministic();
+	}
 }
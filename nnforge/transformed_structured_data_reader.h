@@ -20,6 +20,8 @@
 #include "data_transformer.h"
 
 #include <memory>
+#include <vector>
+#include <mutex>
 
 namespace nnforge
 {
@@ -46,6 +48,8 @@ namespace nnforge
 
 		virtual raw_data_writer::ptr get_writer(std::shared_ptr<std::ostream> out) const;
 
+		virtual bool is_deterministic() const;
+
 	protected:
 		transformed_structured_data_reader() = default;
 
@@ -55,6 +59,10 @@ namespace nnforge
 		unsigned int transformer_sample_count;
 		layer_configuration_specific original_config;
 
+		// Buffers for original data are re-used across reads
+		std::mutex buffer_pool_mutex;
+		std::vector<std::shared_ptr<std::vector<float> > > buffer_pool;
+
 	private:
 		transformed_structured_data_reader(const transformed_structured_data_reader&) = delete;
 		transformed_structured_data_reader& operator =(const transformed_structured_data_reader&) = delete;
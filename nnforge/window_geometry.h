@@ -0,0 +1,39 @@
+/*
+ *  Copyright 2011-2016 Maxim Milakov
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+namespace nnforge
+{
+	// Output position i along the dimension is computed from input positions
+	// [i * stride - left_padding, i * stride - left_padding + window)
+	struct window_geometry
+	{
+		window_geometry(
+			unsigned int window = 1,
+			unsigned int stride = 1,
+			unsigned int left_padding = 0)
+			: window(window)
+			, stride(stride)
+			, left_padding(left_padding)
+		{
+		}
+
+		unsigned int window;
+		unsigned int stride;
+		unsigned int left_padding;
+	};
+}